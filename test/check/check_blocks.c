@@ -0,0 +1,66 @@
+// Runs random programs with the block cache and compares registers, memory and the instruction count with
+// rel32i_step_instruction. The small caches flush while blocks are chained to each other.
+//   gcc -O2 -Wall -Wextra -Wno-unused-parameter -o check_blocks check_blocks.c ../rel_risc_v_emulator.c -lm
+//   ./check_blocks [program count]
+
+#include <stdio.h>
+#include <string.h>
+#include "rea_check.h"
+
+#define REA_CHECK_PROGRAM_SIZE 64
+#define REA_CHECK_MAX_INSTRUCTION_COUNT 3000
+
+static const size_t rea_block_cache_capacity_table[] = { REL32I_MAX_BLOCK_SIZE + 1, 200, 0x1000 };
+
+int main(int argc, char** argv)
+{
+	static uint8_t initial_memory[REA_CHECK_PROGRAM_MEMORY_SIZE];
+	static uint8_t reference_memory[REA_CHECK_PROGRAM_MEMORY_SIZE];
+	static uint8_t memory[REA_CHECK_PROGRAM_MEMORY_SIZE];
+	const uint32_t code_size = (REA_CHECK_PROGRAM_SIZE + REA_CHECK_PROGRAM_PADDING) * 4;
+	const size_t capacity_count = sizeof(rea_block_cache_capacity_table) / sizeof(*rea_block_cache_capacity_table);
+	int program_count = (argc > 1) ? atoi(argv[1]) : 2000;
+	uint32_t random_state = 7;
+	int failure_count = 0;
+	int run_count = 0;
+	for (int program = 0; program != program_count; ++program)
+	{
+		for (size_t i = 0; i != sizeof(initial_memory); ++i)
+			initial_memory[i] = (uint8_t)rea_check_random(&random_state);
+		rea_check_generate_program(&random_state, REA_CHECK_PROGRAM_SIZE, (uint32_t*)initial_memory);
+		rel32i_register_set_t initial_register_set;
+		rea_check_initialize_program_registers(&random_state, &initial_register_set);
+
+		memcpy(reference_memory, initial_memory, sizeof(reference_memory));
+		rel32i_register_set_t reference_register_set = initial_register_set;
+		uint64_t instruction_count = rea_check_step_program(reference_memory, &reference_register_set, REA_CHECK_MAX_INSTRUCTION_COUNT);
+
+		for (int engine = REA_CHECK_ENGINE_BLOCKS; engine <= REA_CHECK_ENGINE_UNFUSED_BLOCKS; ++engine)
+			for (size_t i = 0; i != capacity_count; ++i)
+			{
+				memcpy(memory, initial_memory, sizeof(memory));
+				rel32i_register_set_t register_set = initial_register_set;
+				rea_check_hart_t check;
+				int error = rea_check_create_hart(engine, rea_block_cache_capacity_table[i], memory, code_size, &register_set, &check);
+				if (error)
+				{
+					printf("creating the %s engine failed with error %d\n", rea_check_get_engine_name(engine), error);
+					return 1;
+				}
+				uint64_t run_instruction_count = rea_check_run_program(&random_state, &check.hart, instruction_count);
+				rea_check_destroy_hart(&check);
+
+				++run_count;
+				if (run_instruction_count != instruction_count || memcmp(&register_set, &reference_register_set, sizeof(register_set)) || memcmp(memory, reference_memory, sizeof(memory)))
+				{
+					if (failure_count < 8)
+						printf("program %d with %s and %zu instructions: %llu of %llu instructions run, pc 0x%08X, expected 0x%08X\n",
+							program, rea_check_get_engine_name(engine), rea_block_cache_capacity_table[i],
+							(unsigned long long)run_instruction_count, (unsigned long long)instruction_count, register_set.pc, reference_register_set.pc);
+					++failure_count;
+				}
+			}
+	}
+	printf("%d of %d block cache runs differ from stepping\n", failure_count, run_count);
+	return failure_count ? 1 : 0;
+}
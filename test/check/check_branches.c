@@ -0,0 +1,100 @@
+// Runs every conditional branch on pairs of edge values with each engine and compares the outcome with C.
+// bge and bgeu have to branch when the operands are equal.
+//   gcc -O2 -Wall -Wextra -Wno-unused-parameter -o check_branches check_branches.c ../rel_risc_v_emulator.c -lm
+// Add -DREL32I_INTERPRETER_CORE=0, 1 or 2 to check the switch, computed goto or tail call core, the last one needs clang.
+
+#include <stdio.h>
+#include <string.h>
+#include "rea_check.h"
+
+#define REA_CHECK_MEMORY_SIZE 0x1000
+
+static const char* rea_branch_name_table[8] = { "beq", "bne", 0, 0, "blt", "bge", "bltu", "bgeu" };
+
+static const uint32_t rea_branch_value_table[] = { 0x00000000, 0x00000001, 0x00000002, 0x7FFFFFFF, 0x80000000, 0x80000001, 0xFFFFFFFE, 0xFFFFFFFF };
+
+static int rea_is_branch_taken(int funct3, uint32_t a, uint32_t b)
+{
+	switch (funct3)
+	{
+		case 0:
+			return a == b;
+		case 1:
+			return a != b;
+		case 4:
+			return (int32_t)a < (int32_t)b;
+		case 5:
+			return (int32_t)a >= (int32_t)b;
+		case 6:
+			return a < b;
+		default:
+			return a >= b;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	static uint8_t memory[REA_CHECK_MEMORY_SIZE];
+	const size_t value_count = sizeof(rea_branch_value_table) / sizeof(*rea_branch_value_table);
+	int failure_count = 0;
+	int check_count = 0;
+	for (int funct3 = 0; funct3 != 8; ++funct3)
+	{
+		if (!rea_branch_name_table[funct3])
+			continue;
+
+		// a taken branch skips the instruction that sets x3
+		uint32_t code[3] = { REA_CHECK_ENCODE_B(8, 2, 1, funct3), REA_CHECK_ADDI(3, 0, 1), REA_CHECK_EBREAK };
+		memcpy(memory, code, sizeof(code));
+		for (size_t i = 0; i != value_count; ++i)
+			for (size_t j = 0; j != value_count; ++j)
+			{
+				uint32_t a = rea_branch_value_table[i];
+				uint32_t b = rea_branch_value_table[j];
+				uint32_t expected_x3 = rea_is_branch_taken(funct3, a, b) ? 0 : 1;
+
+				rel32i_register_set_t register_set = { 0 };
+				register_set.x1_x31[0] = a;
+				register_set.x1_x31[1] = b;
+				while (*(const uint32_t*)(memory + register_set.pc) != REA_CHECK_EBREAK)
+					rel32i_step_instruction(memory, memory, &register_set);
+				++check_count;
+				if (register_set.x1_x31[2] != expected_x3)
+				{
+					printf("%s 0x%08X, 0x%08X: step sets x3 to %u, expected %u\n", rea_branch_name_table[funct3], a, b, register_set.x1_x31[2], expected_x3);
+					++failure_count;
+				}
+
+				for (int engine = 0; engine != REA_CHECK_ENGINE_COUNT; ++engine)
+				{
+					memset(&register_set, 0, sizeof(register_set));
+					register_set.x1_x31[0] = a;
+					register_set.x1_x31[1] = b;
+					rea_check_hart_t check;
+					int error = rea_check_create_hart(engine, (engine == REA_CHECK_ENGINE_JIT) ? 0x10000 : 0x100, memory, sizeof(code), &register_set, &check);
+					if (error == ENOSYS)
+					{
+						rea_check_destroy_hart(&check);
+						continue;
+					}
+					if (error)
+					{
+						printf("creating the %s engine failed with error %d\n", rea_check_get_engine_name(engine), error);
+						return 1;
+					}
+					uint64_t retired_instruction_count = 0;
+					int stop_reason = rel32i_run(&check.hart, 16, REL32I_STOP_EBREAK, &retired_instruction_count);
+					rea_check_destroy_hart(&check);
+					++check_count;
+					if (stop_reason != REL32I_STOP_EBREAK || register_set.pc != 8 || register_set.x1_x31[2] != expected_x3)
+					{
+						printf("%s 0x%08X, 0x%08X: %s engine stops with %d at 0x%08X and sets x3 to %u, expected %u\n",
+							rea_branch_name_table[funct3], a, b, rea_check_get_engine_name(engine), stop_reason, register_set.pc, register_set.x1_x31[2], expected_x3);
+						++failure_count;
+					}
+				}
+			}
+	}
+	printf("%d of %d branch checks failed\n", failure_count, check_count);
+	return failure_count ? 1 : 0;
+}
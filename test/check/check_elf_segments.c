@@ -0,0 +1,267 @@
+// Loads random ELF files whose segments share pages and checks the segments rea32_open_elf_file makes of them.
+// Segments with a page in common, directly or through others, have to end up as one page aligned segment with
+// the access of all of them, and every byte of every segment has to read as the file gives it.
+//   gcc -O2 -Wall -Wextra -Wno-unused-parameter -o check_elf_segments check_elf_segments.c ../rea_file.c ../rel_risc_v_emulator.c -lm -lpthread
+//   ./check_elf_segments [file count] [temporary file name]
+
+#include <stdio.h>
+#include <string.h>
+#include "rea_check.h"
+#include "../rea_file.h"
+
+#define REA_CHECK_PAGE_SIZE 0x1000
+#define REA_CHECK_MAX_SEGMENT_COUNT 7
+#define REA_CHECK_MAX_FILE_SIZE 0x40000
+
+typedef struct rea_check_segment_t
+{
+	uint32_t address;
+	uint32_t memory_size;
+	uint32_t file_size;
+	uint32_t flags;
+	uint32_t offset;
+	int group;
+} rea_check_segment_t;
+
+static void rea_write_word(uint8_t* write, uint32_t value)
+{
+	for (int i = 0; i != 4; ++i)
+		write[i] = (uint8_t)(value >> (i * 8));
+}
+
+static void rea_write_half(uint8_t* write, uint32_t value)
+{
+	write[0] = (uint8_t)value;
+	write[1] = (uint8_t)(value >> 8);
+}
+
+static int rea_generate_segments(uint32_t* random_state, rea_check_segment_t* segment_table)
+{
+	static const uint32_t base_address_table[3] = { 0x00010000, 0x20000000, 0xFFFF0000 - 0x8000 };
+	uint32_t base_address = base_address_table[rea_check_random(random_state) % 3];
+	int wanted_segment_count = 1 + (int)(rea_check_random(random_state) % REA_CHECK_MAX_SEGMENT_COUNT);
+	int segment_count = 0;
+	for (int attempt = 0; attempt != 100 && segment_count != wanted_segment_count; ++attempt)
+	{
+		rea_check_segment_t segment;
+		segment.address = base_address + rea_check_random(random_state) % 0x6001;
+		if (rea_check_random(random_state) % 10 < 3)
+			segment.address &= ~(uint32_t)(REA_CHECK_PAGE_SIZE - 1);
+		segment.memory_size = 1 + ((rea_check_random(random_state) & 1) ? rea_check_random(random_state) % 0x40 : rea_check_random(random_state) % 0x3000);
+		if ((uint64_t)segment.address + segment.memory_size > ((uint64_t)1 << 32))
+			continue;
+
+		// segments may share pages but not bytes
+		int overlaps = 0;
+		for (int i = 0; i != segment_count; ++i)
+			if (segment.address < segment_table[i].address + segment_table[i].memory_size && segment_table[i].address < segment.address + segment.memory_size)
+				overlaps = 1;
+		if (overlaps)
+			continue;
+
+		switch (rea_check_random(random_state) % 3)
+		{
+			case 0:
+				segment.file_size = 0;
+				break;
+			case 1:
+				segment.file_size = segment.memory_size;
+				break;
+			default:
+				segment.file_size = rea_check_random(random_state) % (segment.memory_size + 1);
+				break;
+		}
+		segment.flags = 1 + rea_check_random(random_state) % 7;
+		segment.offset = 0;
+		segment.group = segment_count;
+		segment_table[segment_count++] = segment;
+	}
+	return segment_count;
+}
+
+static size_t rea_generate_elf_file(uint32_t* random_state, int segment_count, rea_check_segment_t* segment_table, uint8_t* file)
+{
+	// the first page holds the ELF header, the data of most segments starts at an offset congruent to its address
+	size_t file_size = REA_CHECK_PAGE_SIZE;
+	memset(file, 0, file_size);
+	for (int i = 0; i != segment_count; ++i)
+	{
+		rea_check_segment_t* segment = segment_table + i;
+		size_t offset = file_size;
+		if (rea_check_random(random_state) % 10 < 8)
+			offset = ((file_size + (REA_CHECK_PAGE_SIZE - 1)) & ~(size_t)(REA_CHECK_PAGE_SIZE - 1)) + (segment->address & (REA_CHECK_PAGE_SIZE - 1));
+		memset(file + file_size, 0, offset - file_size);
+		segment->offset = (uint32_t)offset;
+		for (uint32_t j = 0; j != segment->file_size; ++j)
+			file[offset + j] = (uint8_t)rea_check_random(random_state);
+		file_size = offset + segment->file_size;
+	}
+
+	uint32_t program_header_offset = (uint32_t)file_size;
+	for (int i = 0; i != segment_count; ++i)
+	{
+		uint8_t* program_header = file + file_size;
+		rea_write_word(program_header + 0, 1);
+		rea_write_word(program_header + 4, segment_table[i].offset);
+		rea_write_word(program_header + 8, segment_table[i].address);
+		rea_write_word(program_header + 12, segment_table[i].address);
+		rea_write_word(program_header + 16, segment_table[i].file_size);
+		rea_write_word(program_header + 20, segment_table[i].memory_size);
+		rea_write_word(program_header + 24, segment_table[i].flags);
+		rea_write_word(program_header + 28, REA_CHECK_PAGE_SIZE);
+		file_size += 32;
+	}
+
+	static const uint8_t identification[16] = { 0x7F, 'E', 'L', 'F', 1, 1, 1 };
+	memcpy(file, identification, sizeof(identification));
+	rea_write_half(file + 16, 2);
+	rea_write_half(file + 18, 243);
+	rea_write_word(file + 20, 1);
+	rea_write_word(file + 24, segment_table[0].address);
+	rea_write_word(file + 28, program_header_offset);
+	rea_write_half(file + 40, 52);
+	rea_write_half(file + 42, 32);
+	rea_write_half(file + 44, (uint32_t)segment_count);
+	rea_write_half(file + 46, 40);
+	return file_size;
+}
+
+static uint64_t rea_get_page_address(uint64_t address)
+{
+	return address & ~(uint64_t)(REA_CHECK_PAGE_SIZE - 1);
+}
+
+static uint64_t rea_get_page_end_address(const rea_check_segment_t* segment)
+{
+	return ((uint64_t)segment->address + segment->memory_size + (REA_CHECK_PAGE_SIZE - 1)) & ~(uint64_t)(REA_CHECK_PAGE_SIZE - 1);
+}
+
+// Gives segments that share a page, directly or through others, the same group and returns the group count.
+static int rea_group_segments(int segment_count, rea_check_segment_t* segment_table)
+{
+	for (int merging = 1; merging;)
+	{
+		merging = 0;
+		for (int i = 0; i != segment_count; ++i)
+			for (int j = 0; j != segment_count; ++j)
+				if (segment_table[i].group != segment_table[j].group &&
+					rea_get_page_address(segment_table[i].address) < rea_get_page_end_address(segment_table + j) &&
+					rea_get_page_address(segment_table[j].address) < rea_get_page_end_address(segment_table + i))
+				{
+					int group = segment_table[j].group;
+					for (int k = 0; k != segment_count; ++k)
+						if (segment_table[k].group == group)
+							segment_table[k].group = segment_table[i].group;
+					merging = 1;
+				}
+	}
+
+	int group_count = 0;
+	for (int i = 0; i != segment_count; ++i)
+	{
+		int is_first = 1;
+		for (int j = 0; j != i; ++j)
+			if (segment_table[j].group == segment_table[i].group)
+				is_first = 0;
+		group_count += is_first;
+	}
+	return group_count;
+}
+
+static int rea_check_loaded_segment(int segment_count, const rea_check_segment_t* segment_table, const uint8_t* file, const rel32_elf_segment_t* loaded_segment)
+{
+	int group = -1;
+	uint64_t address = (uint64_t)1 << 32;
+	uint64_t end_address = 0;
+	int access = 0;
+	for (int i = 0; i != segment_count; ++i)
+	{
+		const rea_check_segment_t* segment = segment_table + i;
+		if (segment->address < loaded_segment->address || (uint64_t)segment->address >= (uint64_t)loaded_segment->address + loaded_segment->size)
+			continue;
+		if (group != -1 && group != segment->group)
+			return 0;
+		group = segment->group;
+	}
+	if (group == -1)
+		return 0;
+
+	for (int i = 0; i != segment_count; ++i)
+	{
+		const rea_check_segment_t* segment = segment_table + i;
+		if (segment->group != group)
+			continue;
+		if (rea_get_page_address(segment->address) < address)
+			address = rea_get_page_address(segment->address);
+		if (rea_get_page_end_address(segment) > end_address)
+			end_address = rea_get_page_end_address(segment);
+		access |= ((segment->flags & 4) ? REL32I_ACCESS_READ : 0) | ((segment->flags & 2) ? REL32I_ACCESS_WRITE : 0) | ((segment->flags & 1) ? REL32I_ACCESS_EXECUTE : 0);
+	}
+	if (loaded_segment->address != address || (uint64_t)loaded_segment->size != end_address - address || loaded_segment->access != access || loaded_segment->file_backed_size > loaded_segment->size)
+		return 0;
+
+	for (int i = 0; i != segment_count; ++i)
+	{
+		const rea_check_segment_t* segment = segment_table + i;
+		if (segment->group != group)
+			continue;
+		for (uint32_t j = 0; j != segment->memory_size; ++j)
+		{
+			uint32_t offset = segment->address + j - loaded_segment->address;
+			uint8_t value = (offset < loaded_segment->file_backed_size) ?
+				((const uint8_t*)loaded_segment->file_data)[offset] :
+				((const uint8_t*)loaded_segment->zero_fill_data)[offset - loaded_segment->file_backed_size];
+			uint8_t expected_value = (j < segment->file_size) ? file[segment->offset + j] : 0;
+			if (value != expected_value)
+				return 0;
+		}
+	}
+	return 1;
+}
+
+int main(int argc, char** argv)
+{
+	static uint8_t file[REA_CHECK_MAX_FILE_SIZE];
+	int file_count = (argc > 1) ? atoi(argv[1]) : 3000;
+	const char* file_name = (argc > 2) ? argv[2] : "check_elf_segments.elf";
+	int failure_count = 0;
+	int merged_file_count = 0;
+	for (int iteration = 0; iteration != file_count; ++iteration)
+	{
+		uint32_t random_state = 0x9E3779B9 ^ (uint32_t)iteration;
+		rea_check_segment_t segment_table[REA_CHECK_MAX_SEGMENT_COUNT];
+		int segment_count = rea_generate_segments(&random_state, segment_table);
+		size_t file_size = rea_generate_elf_file(&random_state, segment_count, segment_table, file);
+		int group_count = rea_group_segments(segment_count, segment_table);
+		merged_file_count += (group_count != segment_count);
+
+		FILE* handle = fopen(file_name, "wb");
+		if (!handle || fwrite(file, 1, file_size, handle) != file_size || fclose(handle))
+		{
+			printf("writing %s failed\n", file_name);
+			return 1;
+		}
+
+		rel32_elf_t* elf;
+		int error = rea32_open_elf_file(REA_IGNORE_DIRECTORY, file_name, &elf);
+		int is_correct = !error && (int)elf->segment_count == group_count;
+		for (size_t i = 0; is_correct && i != elf->segment_count; ++i)
+			is_correct = rea_check_loaded_segment(segment_count, segment_table, file, elf->segment_table + i);
+		if (!is_correct)
+		{
+			if (failure_count < 8)
+			{
+				printf("file %d with error %d:", iteration, error);
+				for (int i = 0; i != segment_count; ++i)
+					printf(" [0x%08X, 0x%X, file 0x%X, flags %u]", segment_table[i].address, segment_table[i].memory_size, segment_table[i].file_size, segment_table[i].flags);
+				printf("\n");
+			}
+			++failure_count;
+		}
+		if (!error)
+			rea32_close_elf_file(elf);
+	}
+	remove(file_name);
+	printf("%d of %d files load wrong, %d of them have merged segments\n", failure_count, file_count, merged_file_count);
+	return failure_count ? 1 : 0;
+}
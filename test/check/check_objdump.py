@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+# Disassembles a random RV32IMAFDC ELF file with rea-objdump --objdump and with llvm-objdump, with and
+# without aliases, and compares the two line by line after normalising the syntax both tools may choose.
+# Lines only differ in the known classes below, anything else makes the check exit with 1.
+#   gcc -O2 -o rea-objdump ../rea_objdump.c ../rea_file.c ../rel_risc_v_emulator.c -lm -lpthread
+#   python3 check_objdump.py [--rea-objdump ./rea-objdump] [--llvm-objdump llvm-objdump] [--count 200000] [--seed 1]
+
+import argparse
+import collections
+import os
+import random
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+TEXT_ADDRESS = 0x10000
+TEXT_OFFSET = 0x1000
+
+MAJOR_OPCODES = [0x03, 0x07, 0x0F, 0x13, 0x17, 0x1B, 0x23, 0x27, 0x2F, 0x33, 0x37, 0x3B, 0x43, 0x47, 0x4B, 0x4F, 0x53, 0x63, 0x67, 0x6F, 0x73]
+
+TOKEN = re.compile(r'-?0x[0-9a-f]+|-?\d+|[A-Za-z_.][\w.]*')
+NUMBER = re.compile(r'-?0x[0-9a-f]+|-?\d+')
+
+
+def generate_text(count, seed):
+	# mostly 32-bit words with a real major opcode, a quarter compressed halves
+	generator = random.Random(seed)
+	text = bytearray()
+	for _ in range(count):
+		if generator.random() < 0.25:
+			half = generator.getrandbits(16)
+			while half & 3 == 3:
+				half = generator.getrandbits(16)
+			text += struct.pack('<H', half)
+		else:
+			text += struct.pack('<I', (generator.getrandbits(32) & ~0x7F) | generator.choice(MAJOR_OPCODES))
+	return bytes(text)
+
+
+def build_elf(text):
+	# one loadable segment, and the section headers both tools need to find .text
+	section_names = b'\0.text\0.shstrtab\0'
+	names_offset = TEXT_OFFSET + len(text)
+	section_header_offset = (names_offset + len(section_names) + 3) & ~3
+	header = b'\x7fELF' + bytes([1, 1, 1, 0]) + bytes(8) + struct.pack('<HHIIIIIHHHHHH', 2, 243, 1, TEXT_ADDRESS, 52, section_header_offset, 0, 52, 32, 1, 40, 3, 2)
+	program_header = struct.pack('<8I', 1, TEXT_OFFSET, TEXT_ADDRESS, TEXT_ADDRESS, len(text), len(text), 5, 0x1000)
+	file = bytearray(section_header_offset)
+	file[0:len(header)] = header
+	file[52:52 + len(program_header)] = program_header
+	file[TEXT_OFFSET:TEXT_OFFSET + len(text)] = text
+	file[names_offset:names_offset + len(section_names)] = section_names
+	file += bytes(40)
+	file += struct.pack('<10I', 1, 1, 6, TEXT_ADDRESS, TEXT_OFFSET, len(text), 0, 0, 2, 0)
+	file += struct.pack('<10I', 7, 3, 0, 0, names_offset, len(section_names), 0, 0, 1, 0)
+	return bytes(file)
+
+
+def parse(output, is_llvm):
+	lines = {}
+	for line in output.splitlines():
+		match = re.match(r'\s*([0-9a-f]+):\s', line)
+		if not match:
+			continue
+		fields = line.split('\t')
+		# llvm-objdump without raw bytes has address and instruction, rea-objdump has the raw column between them
+		body = '\t'.join(fields[1:] if is_llvm else fields[2:]).strip()
+		if body.startswith('<unknown>') or body.startswith('.2byte') or body.startswith('.4byte'):
+			body = 'unknown'
+		body = re.sub(r'\s*<[^>]*>', '', body)
+		# binutils prints jump and branch targets as hex without 0x
+		if not is_llvm and re.match(r'(c\.)?(j|jal|b[a-z]+)\t', body):
+			head, separator, target = body.rpartition(',')
+			if not separator:
+				head, separator, target = body.rpartition('\t')
+			body = head + separator + str(int(target.strip(), 16))
+		lines[int(match.group(1), 16)] = [int(token, 0) if NUMBER.fullmatch(token) else token for token in TOKEN.findall(body)]
+	return lines
+
+
+def classify(rea_tokens, llvm_tokens):
+	# the known differences, anything else is a failure
+	if rea_tokens == ['unknown'] or llvm_tokens == ['unknown']:
+		# llvm rejects reserved fields that binutils accepts, and the RV64 forms
+		if rea_tokens[0] in ('fence', 'fence.i', 'slli', 'srli', 'srai', 'c.slli', 'c.srli', 'c.srai'):
+			return 'reserved fields'
+		if rea_tokens == ['unknown'] and llvm_tokens[0] in ('slli', 'srli', 'srai', 'c.slli', 'c.srli', 'c.srai'):
+			return 'rv64 shift amounts'
+		# binutils names reserved rounding modes unknown, the exact conversions print without one
+		if llvm_tokens == ['unknown'] and (rea_tokens[-1] == 'unknown' or rea_tokens[0] in ('fcvt.d.s', 'fcvt.d.w', 'fcvt.d.wu')):
+			return 'reserved rounding modes'
+		# llvm takes a c.lui with a zero immediate, which is reserved
+		if rea_tokens == ['unknown'] and llvm_tokens[0] in ('c.lui', 'lui') and llvm_tokens[-1] == 0:
+			return 'reserved fields'
+		return None
+	# llvm prints the dynamic rounding mode with -M no-aliases, binutils leaves it out
+	if llvm_tokens == rea_tokens + ['dyn']:
+		return 'dynamic rounding mode'
+	# llvm prints the immediate of the c.lui hints signed
+	if rea_tokens[:2] == ['c.lui', 'zero'] and llvm_tokens[:2] == ['c.lui', 'zero'] and rea_tokens[2] == llvm_tokens[2] & 0xFFFFF:
+		return 'c.lui hint immediates'
+	if rea_tokens[0] == llvm_tokens[0] and rea_tokens[0].startswith('csr') and len(rea_tokens) == len(llvm_tokens):
+		# CSRs of extensions outside the privileged spec, one tool prints a name where the other prints a number
+		different_index_list = [i for i in range(len(rea_tokens)) if rea_tokens[i] != llvm_tokens[i]]
+		if len(different_index_list) == 1 and (isinstance(rea_tokens[different_index_list[0]], int) or isinstance(llvm_tokens[different_index_list[0]], int)):
+			return 'extension csr names'
+	return None
+
+
+def compare(rea_lines, llvm_lines):
+	known = collections.Counter()
+	unknown = collections.Counter()
+	examples = {}
+	for address, llvm_tokens in llvm_lines.items():
+		rea_tokens = rea_lines.get(address)
+		if rea_tokens is None or rea_tokens == llvm_tokens:
+			continue
+		kind = classify(rea_tokens, llvm_tokens)
+		if kind:
+			known[kind] += 1
+		else:
+			key = str(llvm_tokens[0])
+			unknown[key] += 1
+			examples.setdefault(key, (hex(address), rea_tokens, llvm_tokens))
+	return known, unknown, examples
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument('--rea-objdump', default='./rea-objdump')
+	parser.add_argument('--llvm-objdump', default='llvm-objdump')
+	parser.add_argument('--count', type=int, default=200000)
+	parser.add_argument('--seed', type=int, default=1)
+	arguments = parser.parse_args()
+
+	failure_count = 0
+	with tempfile.TemporaryDirectory() as directory:
+		file_name = os.path.join(directory, 'check_objdump.elf')
+		with open(file_name, 'wb') as file:
+			file.write(build_elf(generate_text(arguments.count, arguments.seed)))
+		for use_aliases in (False, True):
+			rea_command = [arguments.rea_objdump, '--objdump'] + (['-M', 'aliases'] if use_aliases else []) + [file_name]
+			llvm_command = [arguments.llvm_objdump, '-d', '--no-show-raw-insn', '--mattr=+m,+a,+f,+d,+c'] + ([] if use_aliases else ['-M', 'no-aliases']) + [file_name]
+			rea_lines = parse(subprocess.run(rea_command, check=True, capture_output=True, text=True).stdout, False)
+			llvm_lines = parse(subprocess.run(llvm_command, check=True, capture_output=True, text=True).stdout, True)
+			known, unknown, examples = compare(rea_lines, llvm_lines)
+			mode = 'aliases' if use_aliases else 'no aliases'
+			print('%s: %d lines, %d with known differences %s, %d with other differences' % (mode, len(llvm_lines), sum(known.values()), dict(known), sum(unknown.values())))
+			for key, count in unknown.most_common():
+				address, rea_tokens, llvm_tokens = examples[key]
+				print('  %d x %s, at %s rea-objdump %s, llvm-objdump %s' % (count, key, address, rea_tokens, llvm_tokens))
+			failure_count += sum(unknown.values())
+	return 1 if failure_count else 0
+
+
+if __name__ == '__main__':
+	sys.exit(main())
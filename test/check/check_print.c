@@ -0,0 +1,75 @@
+// Compares the number printing helpers with snprintf on edge and random values, for every digit count of
+// rel32_print_hex_digits from 0 to 16, and checks that none of them writes past the text it returns.
+//   gcc -O2 -Wall -Wextra -Wno-unused-parameter -o check_print check_print.c ../rel_risc_v_emulator.c -lm
+// An alarm ends the program if a helper does not return, which is how the digit counts above 8 used to fail.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "rea_check.h"
+
+#define REA_CHECK_BUFFER_SIZE 64
+#define REA_CHECK_CANARY 0x5A
+
+static const uint32_t rea_print_value_table[] = { 0x00000000, 0x00000001, 0x00000009, 0x0000000A, 0x0000000F, 0x00000010, 0x00000063, 0x00000064,
+	0x000003E7, 0x000003E8, 0x0000FFFF, 0x05F5E0FF, 0x05F5E100, 0x3B9AC9FF, 0x3B9ACA00, 0x7FFFFFFF, 0x80000000, 0x80000001, 0xFFFFFFFE, 0xFFFFFFFF };
+
+static int rea_check_text(const char* name, uint32_t value, int digit_count, const char* buffer, size_t size, const char* expected_text)
+{
+	size_t expected_size = strlen(expected_text);
+	int is_correct = size == expected_size && !memcmp(buffer, expected_text, size);
+	for (size_t i = size; is_correct && i != REA_CHECK_BUFFER_SIZE; ++i)
+		is_correct = (uint8_t)buffer[i] == REA_CHECK_CANARY;
+	if (!is_correct)
+		printf("%s(%d, 0x%08X) gives \"%.*s\", expected \"%s\"\n", name, digit_count, value, (int)((size < REA_CHECK_BUFFER_SIZE) ? size : REA_CHECK_BUFFER_SIZE), buffer, expected_text);
+	return is_correct;
+}
+
+static int rea_check_value(uint32_t value)
+{
+	char buffer[REA_CHECK_BUFFER_SIZE];
+	char expected_text[REA_CHECK_BUFFER_SIZE];
+	int failure_count = 0;
+
+	memset(buffer, REA_CHECK_CANARY, sizeof(buffer));
+	snprintf(expected_text, sizeof(expected_text), "%08X", value);
+	failure_count += !rea_check_text("rel32_print_hex", value, 8, buffer, rel32_print_hex(value, buffer), expected_text);
+
+	// fewer than 8 digits keep the low ones, more are padded with zeros
+	for (int digit_count = 0; digit_count <= 16; ++digit_count)
+	{
+		memset(buffer, REA_CHECK_CANARY, sizeof(buffer));
+		char full_text[REA_CHECK_BUFFER_SIZE];
+		snprintf(full_text, sizeof(full_text), "%0*X", digit_count > 8 ? digit_count : 8, value);
+		snprintf(expected_text, sizeof(expected_text), "%s", full_text + ((digit_count < 8) ? 8 - digit_count : 0));
+		failure_count += !rea_check_text("rel32_print_hex_digits", value, digit_count, buffer, rel32_print_hex_digits(digit_count, value, buffer), expected_text);
+	}
+
+	memset(buffer, REA_CHECK_CANARY, sizeof(buffer));
+	snprintf(expected_text, sizeof(expected_text), "%u", value);
+	failure_count += !rea_check_text("rel32_print_unsigned", value, 0, buffer, rel32_print_unsigned(value, buffer), expected_text);
+
+	memset(buffer, REA_CHECK_CANARY, sizeof(buffer));
+	snprintf(expected_text, sizeof(expected_text), "%d", (int)(int32_t)value);
+	failure_count += !rea_check_text("rel32_print_signed", value, 0, buffer, rel32_print_signed((int32_t)value, buffer), expected_text);
+	return failure_count;
+}
+
+int main(int argc, char** argv)
+{
+	alarm(10);
+	int failure_count = 0;
+	int value_count = 0;
+	for (size_t i = 0; i != sizeof(rea_print_value_table) / sizeof(*rea_print_value_table); ++i, ++value_count)
+		failure_count += rea_check_value(rea_print_value_table[i]);
+
+	uint32_t random_state = 1;
+	for (int i = 0; i != 100000; ++i, ++value_count)
+	{
+		// random values of every magnitude
+		uint32_t value = rea_check_random(&random_state) >> (rea_check_random(&random_state) & 31);
+		failure_count += rea_check_value(value);
+	}
+	printf("%d failures printing %d values\n", failure_count, value_count);
+	return failure_count ? 1 : 0;
+}
@@ -0,0 +1,360 @@
+#!/usr/bin/env python3
+# Runs a set of small programs with every rea-run engine, as flat images and as ELF files, and checks that
+# all of them give the expected output, exit code and retired instruction count.
+# The programs are assembled with llvm-mc, with compressed instructions, and need no linker.
+#   gcc -O2 -o rea-run ../rea_run.c ../rea_file.c ../rea_linux.c ../rea_semihosting.c ../rel_risc_v_emulator.c -lm -lpthread
+#   python3 check_rea_run.py [--rea-run ./rea-run] [--llvm-mc llvm-mc] [--llvm-objcopy llvm-objcopy]
+
+import argparse
+import math
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+ENGINES = ['jit', 'blocks', 'predecode', 'interpreter', 'paged']
+ELF_ADDRESS = 0x10000
+
+# _start calls main and exits with what it returns, print_hex writes a0 as 8 hex digits and a newline
+PRELUDE = '''
+	.text
+_start:
+	call main
+	li a7, 93
+	ecall
+print_hex:
+	la t0, hex_buffer
+	li t1, 8
+1:
+	srli t2, a0, 28
+	slli a0, a0, 4
+	li t3, 10
+	blt t2, t3, 2f
+	addi t2, t2, 'a' - 10
+	j 3f
+2:
+	addi t2, t2, '0'
+3:
+	sb t2, 0(t0)
+	addi t0, t0, 1
+	addi t1, t1, -1
+	bnez t1, 1b
+	li t2, 10
+	sb t2, 0(t0)
+	li a0, 1
+	la a1, hex_buffer
+	li a2, 9
+	li a7, 64
+	ecall
+	ret
+	.p2align 2
+hex_buffer:
+	.space 12
+'''
+
+HELLO = '''
+main:
+	li a0, 1
+	la a1, message
+	li a2, 6
+	li a7, 64
+	ecall
+	li a0, 0
+	ret
+message:
+	.ascii "hello\\n"
+	.p2align 2
+'''
+
+CHECKSUM = '''
+main:
+	addi sp, sp, -16
+	sw ra, 12(sp)
+	li s0, 12345
+	li s1, 0
+	li s2, 20000
+	la s3, table
+	li s4, 1103515245
+	li s5, 1000
+1:
+	mul s0, s0, s4
+	addi s0, s0, 1234
+	srli t1, s0, 16
+	andi t1, t1, 255
+	slli t1, t1, 2
+	add t1, t1, s3
+	lw t2, 0(t1)
+	add t2, t2, s0
+	sw t2, 0(t1)
+	remu t3, s0, s5
+	xor s1, s1, t3
+	divu t4, s0, s5
+	add s1, s1, t4
+	slli t5, s1, 5
+	srli t6, s1, 27
+	or s1, t5, t6
+	mulhu t5, s0, s1
+	sub s1, s1, t5
+	addi s2, s2, -1
+	bnez s2, 1b
+	li t0, 256
+	mv t1, s3
+2:
+	lw t2, 0(t1)
+	add s1, s1, t2
+	addi t1, t1, 4
+	addi t0, t0, -1
+	bnez t0, 2b
+	mv a0, s1
+	call print_hex
+	andi a0, s1, 127
+	lw ra, 12(sp)
+	addi sp, sp, 16
+	ret
+	.p2align 2
+table:
+	.space 1024
+'''
+
+FLOAT = '''
+main:
+	addi sp, sp, -16
+	sw ra, 12(sp)
+	fcvt.d.w fa0, zero
+	fcvt.s.w fa3, zero
+	li t0, 1
+	fcvt.s.w fa4, t0
+	li s0, 1
+	li s1, 1001
+1:
+	fcvt.d.w fa1, s0
+	fsqrt.d fa1, fa1
+	fadd.d fa0, fa0, fa1
+	fcvt.s.w fa5, s0
+	fdiv.s fa5, fa4, fa5
+	fadd.s fa3, fa3, fa5
+	addi s0, s0, 1
+	blt s0, s1, 1b
+	li t0, 1000
+	fcvt.d.w fa2, t0
+	fmul.d fa0, fa0, fa2
+	fcvt.w.d a0, fa0, rtz
+	call print_hex
+	fmv.x.w a0, fa3
+	call print_hex
+	frflags a0
+	call print_hex
+	li a0, 0
+	lw ra, 12(sp)
+	addi sp, sp, 16
+	ret
+'''
+
+ATOMIC = '''
+main:
+	addi sp, sp, -16
+	sw ra, 12(sp)
+	la s0, counter
+	li s1, 1000
+1:
+	li t0, 3
+	amoadd.w t1, t0, (s0)
+	addi s1, s1, -1
+	bnez s1, 1b
+	li s1, 100
+2:
+	lr.w t0, (s0)
+	addi t0, t0, 1
+	sc.w t1, t0, (s0)
+	bnez t1, 2b
+	addi s1, s1, -1
+	bnez s1, 2b
+	li t0, -5
+	amomin.w t1, t0, (s0)
+	li t0, 7
+	amomaxu.w t2, t0, (s0)
+	lw a0, 0(s0)
+	add a0, a0, t1
+	call print_hex
+	li a0, 0
+	lw ra, 12(sp)
+	addi sp, sp, 16
+	ret
+	.p2align 2
+counter:
+	.word 0
+'''
+
+# value is called, rewritten to return 42 and called again
+SELF_MODIFYING = '''
+main:
+	addi sp, sp, -16
+	sw ra, 12(sp)
+	call value
+	mv s0, a0
+	la t0, value
+	la t1, replacement
+	lw t2, 0(t1)
+	sw t2, 0(t0)
+	fence.i
+	call value
+	add a0, a0, s0
+	lw ra, 12(sp)
+	addi sp, sp, 16
+	ret
+	.option push
+	.option norvc
+value:
+	li a0, 1
+	ret
+replacement:
+	li a0, 42
+	.option pop
+'''
+
+EBREAK = '''
+main:
+	ebreak
+'''
+
+ILLEGAL = '''
+main:
+	.2byte 0
+'''
+
+ACCESS_FAULT = '''
+main:
+	li t0, 0xF0000000
+	lw a0, 0(t0)
+	ret
+'''
+
+ENDLESS = '''
+main:
+	addi a0, a0, 1
+	j main
+'''
+
+
+def checksum_output():
+	x = 12345
+	total = 0
+	table = [0] * 256
+	for _ in range(20000):
+		x = (x * 1103515245 + 1234) & 0xFFFFFFFF
+		index = (x >> 16) & 255
+		table[index] = (table[index] + x) & 0xFFFFFFFF
+		total ^= x % 1000
+		total = (total + x // 1000) & 0xFFFFFFFF
+		total = ((total << 5) | (total >> 27)) & 0xFFFFFFFF
+		total = (total - ((x * total) >> 32)) & 0xFFFFFFFF
+	for value in table:
+		total = (total + value) & 0xFFFFFFFF
+	return '%08x\n' % total, total & 127
+
+
+def to_single(value):
+	return struct.unpack('<f', struct.pack('<f', value))[0]
+
+
+def float_output():
+	# float operations computed in double and rounded once are correctly rounded
+	total = 0.0
+	single_total = 0.0
+	for i in range(1, 1001):
+		total += math.sqrt(i)
+		single_total = to_single(single_total + to_single(1.0 / i))
+	single_bits = struct.unpack('<I', struct.pack('<f', single_total))[0]
+	# only inexact is raised
+	return '%08x\n%08x\n%08x\n' % (int(total * 1000) & 0xFFFFFFFF, single_bits, 1), 0
+
+
+def atomic_output():
+	# the counter ends at 3100, amomin returns it and leaves -5, which amomaxu keeps as the larger unsigned value
+	return '%08x\n' % ((-5 + 3100) & 0xFFFFFFFF), 0
+
+
+# name, source, expected output, expected exit code, extra rea-run options
+PROGRAMS = [
+	('hello', HELLO, 'hello\n', 0, []),
+	('checksum',) + (CHECKSUM,) + checksum_output() + ([],),
+	('float',) + (FLOAT,) + float_output() + ([],),
+	('atomic',) + (ATOMIC,) + atomic_output() + ([],),
+	('self-modifying', SELF_MODIFYING, '', 43, []),
+	('ebreak', EBREAK, '', 133, []),
+	('illegal', ILLEGAL, '', 132, []),
+	('access fault', ACCESS_FAULT, '', 139, ['--memory=0x100000']),
+	('instruction limit', ENDLESS, '', 1, ['--max-instructions=100000']),
+]
+
+
+def assemble(arguments, directory, name, source):
+	source_name = os.path.join(directory, name.replace(' ', '_') + '.s')
+	object_name = source_name[:-2] + '.o'
+	image_name = source_name[:-2] + '.bin'
+	with open(source_name, 'w') as file:
+		file.write(PRELUDE + source)
+	subprocess.run([arguments.llvm_mc, '--triple=riscv32', '-mattr=+m,+a,+f,+d,+c,-relax', '-filetype=obj', source_name, '-o', object_name], check=True)
+	subprocess.run([arguments.llvm_objcopy, '-O', 'binary', '--only-section=.text', object_name, image_name], check=True)
+	with open(image_name, 'rb') as file:
+		return image_name, file.read()
+
+
+def write_elf(file_name, image):
+	# the code only uses pc relative addresses, so the same bytes run at ELF_ADDRESS in one writable segment
+	header = b'\x7fELF' + bytes([1, 1, 1, 0]) + bytes(8) + struct.pack('<HHIIIIIHHHHHH', 2, 243, 1, ELF_ADDRESS, 52, 0, 0, 52, 32, 1, 40, 0, 0)
+	program_header = struct.pack('<8I', 1, 0x1000, ELF_ADDRESS, ELF_ADDRESS, len(image), len(image) + 0x1000, 7, 0x1000)
+	file = bytearray(0x1000)
+	file[0:len(header)] = header
+	file[52:52 + len(program_header)] = program_header
+	file += image
+	with open(file_name, 'wb') as handle:
+		handle.write(file)
+
+
+def run(arguments, engine, file_name, is_binary, options):
+	command = [arguments.rea_run, '--engine=' + engine] + (['-b'] if is_binary else []) + options + [file_name]
+	result = subprocess.run(command, capture_output=True, text=True, timeout=60)
+	match = re.search(r'rea-run: (\d+) instructions retired', result.stderr)
+	return result.stdout, result.returncode, int(match.group(1)) if match else None, result.stderr
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument('--rea-run', default='./rea-run')
+	parser.add_argument('--llvm-mc', default='llvm-mc')
+	parser.add_argument('--llvm-objcopy', default='llvm-objcopy')
+	arguments = parser.parse_args()
+
+	failure_count = 0
+	run_count = 0
+	with tempfile.TemporaryDirectory() as directory:
+		for name, source, expected_output, expected_exit_code, options in PROGRAMS:
+			image_name, image = assemble(arguments, directory, name, source)
+			elf_name = image_name[:-4] + '.elf'
+			write_elf(elf_name, image)
+			for file_name, is_binary in ((image_name, True), (elf_name, False)):
+				kind = 'flat image' if is_binary else 'ELF file'
+				instruction_counts = {}
+				for engine in ENGINES:
+					output, exit_code, instruction_count, errors = run(arguments, engine, file_name, is_binary, options)
+					if 'not supported on this host' in errors:
+						continue
+					run_count += 1
+					instruction_counts[engine] = instruction_count
+					if output != expected_output or exit_code != expected_exit_code or instruction_count is None:
+						print('%s as %s with %s: exit code %d and output %r, expected %d and %r' % (name, kind, engine, exit_code, output, expected_exit_code, expected_output))
+						if errors:
+							print('  ' + errors.strip().replace('\n', '\n  '))
+						failure_count += 1
+				if len(set(instruction_counts.values())) > 1:
+					print('%s as %s: the engines retire different instruction counts %s' % (name, kind, instruction_counts))
+					failure_count += 1
+	print('%d failures in %d runs' % (failure_count, run_count))
+	return 1 if failure_count else 0
+
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -0,0 +1,295 @@
+#ifndef REL_RISC_V_APPLICATION_CHECK_H
+#define REL_RISC_V_APPLICATION_CHECK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "../rel_risc_v_emulator.h"
+
+// Shared by the programs in this directory. Each of them is built on its own from the command in its
+// first comment and exits with a nonzero code when a check fails.
+
+#define REA_CHECK_ENCODE_R(funct7, rs2, rs1, funct3, rd, opcode) (((uint32_t)(funct7) << 25) | ((uint32_t)(rs2) << 20) | ((uint32_t)(rs1) << 15) | ((uint32_t)(funct3) << 12) | ((uint32_t)(rd) << 7) | (uint32_t)(opcode))
+#define REA_CHECK_ENCODE_I(immediate, rs1, funct3, rd, opcode) ((((uint32_t)(immediate) & 0xFFF) << 20) | ((uint32_t)(rs1) << 15) | ((uint32_t)(funct3) << 12) | ((uint32_t)(rd) << 7) | (uint32_t)(opcode))
+#define REA_CHECK_ENCODE_S(immediate, rs2, rs1, funct3) (((((uint32_t)(immediate) >> 5) & 0x7F) << 25) | ((uint32_t)(rs2) << 20) | ((uint32_t)(rs1) << 15) | ((uint32_t)(funct3) << 12) | (((uint32_t)(immediate) & 0x1F) << 7) | 0x23)
+#define REA_CHECK_ENCODE_B(immediate, rs2, rs1, funct3) (((((uint32_t)(immediate) >> 12) & 1) << 31) | ((((uint32_t)(immediate) >> 5) & 0x3F) << 25) | ((uint32_t)(rs2) << 20) | ((uint32_t)(rs1) << 15) | ((uint32_t)(funct3) << 12) | ((((uint32_t)(immediate) >> 1) & 0xF) << 8) | ((((uint32_t)(immediate) >> 11) & 1) << 7) | 0x63)
+#define REA_CHECK_ENCODE_U(immediate, rd, opcode) (((uint32_t)(immediate) & 0xFFFFF000) | ((uint32_t)(rd) << 7) | (uint32_t)(opcode))
+
+#define REA_CHECK_ADDI(rd, rs1, immediate) REA_CHECK_ENCODE_I(immediate, rs1, 0, rd, 0x13)
+#define REA_CHECK_LW(rd, rs1, immediate) REA_CHECK_ENCODE_I(immediate, rs1, 2, rd, 0x03)
+#define REA_CHECK_SW(rs2, rs1, immediate) REA_CHECK_ENCODE_S(immediate, rs2, rs1, 2)
+#define REA_CHECK_LUI(rd, immediate) REA_CHECK_ENCODE_U(immediate, rd, 0x37)
+#define REA_CHECK_AUIPC(rd, immediate) REA_CHECK_ENCODE_U(immediate, rd, 0x17)
+#define REA_CHECK_JALR(rd, rs1, immediate) REA_CHECK_ENCODE_I(immediate, rs1, 0, rd, 0x67)
+#define REA_CHECK_ECALL 0x00000073
+#define REA_CHECK_EBREAK 0x00100073
+#define REA_CHECK_FENCE_I 0x0000100F
+
+#define REA_CHECK_ENGINE_INTERPRETER 0
+#define REA_CHECK_ENGINE_PREDECODE 1
+#define REA_CHECK_ENGINE_BLOCKS 2
+#define REA_CHECK_ENGINE_UNFUSED_BLOCKS 3
+#define REA_CHECK_ENGINE_JIT 4
+#define REA_CHECK_ENGINE_COUNT 5
+
+typedef struct rea_check_hart_t
+{
+	rel32i_hart_t hart;
+	void* cache_buffer;
+	rel32i_jit_t* jit;
+} rea_check_hart_t;
+
+static inline const char* rea_check_get_engine_name(int engine)
+{
+	static const char* engine_name_table[REA_CHECK_ENGINE_COUNT] = { "interpreter", "predecode", "blocks", "unfused blocks", "jit" };
+	return engine_name_table[engine];
+}
+
+static inline uint32_t rea_check_random(uint32_t* state)
+{
+	uint32_t value = *state;
+	value ^= value << 13;
+	value ^= value >> 17;
+	value ^= value << 5;
+	*state = value;
+	return value;
+}
+
+// Code and data share the memory from address 0. The capacity is the instruction capacity of a block
+// cache or the native code capacity of the JIT, small ones make the caches flush while blocks are chained.
+static inline int rea_check_create_hart(int engine, size_t capacity, void* memory, uint32_t code_size, rel32i_register_set_t* register_set, rea_check_hart_t* check)
+{
+	rel32i_hart_t hart = { 0 };
+	hart.code_base_address = memory;
+	hart.data_base_address = memory;
+	hart.register_set = register_set;
+	check->hart = hart;
+	check->cache_buffer = 0;
+	check->jit = 0;
+
+	if (engine == REA_CHECK_ENGINE_PREDECODE)
+	{
+		size_t predecode_cache_size = rel32i_get_predecode_cache_size(code_size);
+		check->cache_buffer = malloc(predecode_cache_size);
+		if (!check->cache_buffer)
+			return ENOMEM;
+		int error = rel32i_create_predecode_cache(code_size, predecode_cache_size, check->cache_buffer, &check->hart.predecode_cache);
+		if (error)
+			return error;
+		rel32i_fill_predecode_cache(memory, check->hart.predecode_cache, 0, code_size);
+	}
+	else if (engine == REA_CHECK_ENGINE_BLOCKS || engine == REA_CHECK_ENGINE_UNFUSED_BLOCKS)
+	{
+		size_t block_cache_size = rel32i_get_block_cache_size(code_size, capacity);
+		check->cache_buffer = malloc(block_cache_size);
+		if (!check->cache_buffer)
+			return ENOMEM;
+		int error = rel32i_create_block_cache(code_size, capacity, block_cache_size, check->cache_buffer, &check->hart.block_cache);
+		if (error)
+			return error;
+		if (engine == REA_CHECK_ENGINE_UNFUSED_BLOCKS)
+			check->hart.block_cache->flags &= ~REL32I_BLOCK_CACHE_FUSE_INSTRUCTIONS;
+	}
+	else if (engine == REA_CHECK_ENGINE_JIT)
+	{
+		int error = rel32i_create_jit(code_size, capacity, &check->jit);
+		if (error)
+			return error;
+		check->hart.jit = check->jit;
+	}
+	return 0;
+}
+
+static inline void rea_check_destroy_hart(rea_check_hart_t* check)
+{
+	if (check->jit)
+		rel32i_destroy_jit(check->jit);
+	free(check->cache_buffer);
+}
+
+static inline uint32_t rea_check_random_register(uint32_t* random_state)
+{
+	// sp and x27 to x31 are left to the instruction pairs that need them
+	uint32_t number;
+	do
+		number = rea_check_random(random_state) & 31;
+	while (number == 2 || number >= 27);
+	return number;
+}
+
+// Fills code with instruction_count random instructions followed by REA_CHECK_PROGRAM_PADDING ebreaks.
+// Branches and jumps stay inside the program and stores stay above REA_CHECK_PROGRAM_DATA_ADDRESS, with
+// sp starting at REA_CHECK_PROGRAM_STACK_ADDRESS. Loops are left in, so runs have to be limited.
+#define REA_CHECK_PROGRAM_PADDING 16
+#define REA_CHECK_PROGRAM_DATA_ADDRESS 0x400
+#define REA_CHECK_PROGRAM_STACK_ADDRESS 0x8000
+#define REA_CHECK_PROGRAM_MEMORY_SIZE 0x10000
+
+static inline void rea_check_generate_program(uint32_t* random_state, int instruction_count, uint32_t* code)
+{
+	static const uint32_t load_funct3_table[5] = { 0, 1, 2, 4, 5 };
+	static const uint32_t branch_funct3_table[6] = { 0, 1, 4, 5, 6, 7 };
+	for (int i = 0; i != instruction_count;)
+	{
+		uint32_t rd = rea_check_random_register(random_state);
+		uint32_t rs1 = rea_check_random(random_state) & 31;
+		uint32_t rs2 = rea_check_random(random_state) & 31;
+		uint32_t scratch = 28 + (rea_check_random(random_state) & 3);
+		int32_t immediate = (int32_t)(rea_check_random(random_state) % 4096) - 2048;
+
+		// pairs of instructions that the block cache fuses or that end blocks with computed targets
+		if (i + 1 != instruction_count)
+		{
+			int pair = (int)(rea_check_random(random_state) % 8);
+			if (pair == 0)
+			{
+				code[i++] = REA_CHECK_LUI(rd, rea_check_random(random_state));
+				code[i++] = REA_CHECK_ADDI(rd, rd, immediate);
+				continue;
+			}
+			if (pair == 1)
+			{
+				code[i++] = REA_CHECK_AUIPC(scratch, 0);
+				code[i++] = REA_CHECK_JALR(rea_check_random_register(random_state), scratch, 4 * (rea_check_random(random_state) % 5));
+				continue;
+			}
+			if (pair == 2)
+			{
+				code[i++] = REA_CHECK_AUIPC(scratch, 0);
+				code[i++] = REA_CHECK_LW(rea_check_random_register(random_state), scratch, REA_CHECK_PROGRAM_DATA_ADDRESS + rea_check_random(random_state) % 1000);
+				continue;
+			}
+			if (pair == 3)
+			{
+				int offset = (int)(rea_check_random(random_state) % 9) - 4;
+				if (!offset || i + 1 + offset < 0 || i + 1 + offset >= instruction_count)
+					offset = 1;
+				switch (rea_check_random(random_state) & 3)
+				{
+					case 0:
+						code[i++] = REA_CHECK_ENCODE_R(0, rs2, rs1, 2, rd, 0x33);
+						break;
+					case 1:
+						code[i++] = REA_CHECK_ENCODE_R(0, rs2, rs1, 3, rd, 0x33);
+						break;
+					case 2:
+						code[i++] = REA_CHECK_ENCODE_I(immediate, rs1, 2, rd, 0x13);
+						break;
+					default:
+						code[i++] = REA_CHECK_ENCODE_I(immediate, rs1, 3, rd, 0x13);
+						break;
+				}
+				code[i++] = REA_CHECK_ENCODE_B(4 * offset, 0, rd, rea_check_random(random_state) & 1);
+				continue;
+			}
+			if (pair == 4)
+			{
+				code[i++] = REA_CHECK_ADDI(2, 2, (rea_check_random(random_state) & 1) ? -16 : 16);
+				code[i++] = REA_CHECK_SW(rs2, 2, 4 * (rea_check_random(random_state) & 3));
+				continue;
+			}
+			if (pair == 5 && i + 2 != instruction_count)
+			{
+				// code starts at address 0, so each time the group runs it jumps to the next of the four
+				// instructions after it and the block ending there has more successors than it can chain
+				code[i++] = REA_CHECK_ADDI(27, 27, 4);
+				code[i++] = REA_CHECK_ENCODE_I(12, 27, 7, 27, 0x13);
+				code[i] = REA_CHECK_JALR(rd, 27, 4 * (i + 1));
+				++i;
+				continue;
+			}
+		}
+
+		switch (rea_check_random(random_state) % 8)
+		{
+			case 0:
+				code[i] = REA_CHECK_ENCODE_R((rea_check_random(random_state) & 1) ? 0x20 : 0, rs2, rs1, rea_check_random(random_state) & 7, rd, 0x33);
+				break;
+			case 1:
+				code[i] = REA_CHECK_ADDI(rd, rs1, immediate);
+				break;
+			case 2:
+				code[i] = REA_CHECK_ENCODE_I(rea_check_random(random_state) % 2040, 0, load_funct3_table[rea_check_random(random_state) % 5], rd, 0x03);
+				break;
+			case 3:
+				code[i] = REA_CHECK_SW(0, 0, REA_CHECK_PROGRAM_DATA_ADDRESS + 4 * (rea_check_random(random_state) % 64));
+				break;
+			case 4:
+			{
+				int offset = (int)(rea_check_random(random_state) % 9) - 4;
+				if (!offset || i + offset < 0 || i + offset >= instruction_count)
+					offset = 1;
+				code[i] = REA_CHECK_ENCODE_B(4 * offset, rs2, rs1, branch_funct3_table[rea_check_random(random_state) % 6]);
+				break;
+			}
+			case 5:
+				code[i] = (rea_check_random(random_state) & 1) ? REA_CHECK_ECALL : REA_CHECK_FENCE_I;
+				break;
+			case 6:
+				code[i] = REA_CHECK_SW(rs2, 0, REA_CHECK_PROGRAM_DATA_ADDRESS + rea_check_random(random_state) % 256);
+				break;
+			default:
+				code[i] = REA_CHECK_LUI(rd, rea_check_random(random_state));
+				break;
+		}
+		++i;
+	}
+	for (int i = 0; i != REA_CHECK_PROGRAM_PADDING; ++i)
+		code[instruction_count + i] = REA_CHECK_EBREAK;
+}
+
+static inline void rea_check_initialize_program_registers(uint32_t* random_state, rel32i_register_set_t* register_set)
+{
+	rel32i_register_set_t initial_register_set = { 0 };
+	*register_set = initial_register_set;
+	for (int i = 0; i != 26; ++i)
+		register_set->x1_x31[i] = rea_check_random(random_state);
+	register_set->x1_x31[1] = REA_CHECK_PROGRAM_STACK_ADDRESS;
+}
+
+// Steps the program from pc 0 to its first ebreak, at most max_instruction_count times, and returns the count.
+static inline uint64_t rea_check_step_program(void* memory, rel32i_register_set_t* register_set, uint64_t max_instruction_count)
+{
+	uint64_t instruction_count = 0;
+	while (instruction_count != max_instruction_count && *(const uint32_t*)((uintptr_t)memory + register_set->pc) != REA_CHECK_EBREAK)
+	{
+		rel32i_step_instruction(memory, memory, register_set);
+		++instruction_count;
+	}
+	return instruction_count;
+}
+
+// Runs instruction_count instructions in rel32i_run calls with random limits, so that some calls stop
+// inside blocks, and steps over ecalls the way rel32i_step_instruction does. Returns the count it ran.
+static inline uint64_t rea_check_run_program(uint32_t* random_state, rel32i_hart_t* hart, uint64_t instruction_count)
+{
+	uint64_t run_instruction_count = 0;
+	while (run_instruction_count != instruction_count)
+	{
+		uint64_t limit = instruction_count - run_instruction_count;
+		if (!(rea_check_random(random_state) % 3) && limit > 50)
+			limit = 1 + rea_check_random(random_state) % 50;
+		uint64_t retired_instruction_count = 0;
+		int stop_reason = rel32i_run(hart, limit, REL32I_STOP_EBREAK | REL32I_STOP_ECALL, &retired_instruction_count);
+		run_instruction_count += retired_instruction_count;
+		if (stop_reason == REL32I_STOP_ECALL)
+		{
+			hart->register_set->pc += 4;
+			++run_instruction_count;
+		}
+		else if (stop_reason != REL32I_STOP_INSTRUCTION_LIMIT)
+			break;
+	}
+	return run_instruction_count;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // REL_RISC_V_APPLICATION_CHECK_H
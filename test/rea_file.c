@@ -6,6 +6,10 @@
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 static int rea_win32_get_working_directory_path(size_t path_buffer_size, size_t* path_size, char* path_buffer)
 {
@@ -128,170 +132,1560 @@ int rea_get_special_directory_path(int special_directory, size_t path_buffer_siz
 	}
 }
 
+static int rea_map_path(const char* path, size_t* file_size, void** file_data)
+{
+	int path_length = MultiByteToWideChar(CP_UTF8, 0, path, -1, 0, 0);
+	if (!path_length)
+		return EBADMSG;
+
+	HANDLE heap = GetProcessHeap();
+	if (!heap)
+		return ENOMEM;
+
+	WCHAR* wide_path = (WCHAR*)HeapAlloc(heap, 0, (size_t)path_length * sizeof(WCHAR));
+	if (!wide_path)
+		return ENOMEM;
+
+	if (MultiByteToWideChar(CP_UTF8, 0, path, -1, wide_path, path_length) != path_length)
+	{
+		HeapFree(heap, 0, wide_path);
+		return EBADMSG;
+	}
+
+	HANDLE file_handle = CreateFileW(wide_path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	HeapFree(heap, 0, wide_path);
+	if (file_handle == INVALID_HANDLE_VALUE)
+		return ENOENT;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file_handle, &size) || (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX)
+	{
+		CloseHandle(file_handle);
+		return EIO;
+	}
+
+	*file_size = (size_t)size.QuadPart;
+	if (!size.QuadPart)
+	{
+		CloseHandle(file_handle);
+		*file_data = 0;
+		return 0;
+	}
+
+	// the view keeps the file open, the handles are not needed after mapping it
+	HANDLE mapping_handle = CreateFileMappingW(file_handle, 0, PAGE_WRITECOPY, 0, 0, 0);
+	CloseHandle(file_handle);
+	if (!mapping_handle)
+		return EIO;
+
+	void* data = MapViewOfFile(mapping_handle, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(mapping_handle);
+	if (!data)
+		return ENOMEM;
+
+	*file_data = data;
+	return 0;
+}
+
+void rea_unmap_file(size_t file_size, void* file_data)
+{
+	if (file_data)
+		UnmapViewOfFile(file_data);
+}
+
+static void* rea_allocate_zero_pages(size_t size)
+{
+	return VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+static void rea_free_zero_pages(size_t size, void* pages)
+{
+	VirtualFree(pages, 0, MEM_RELEASE);
+}
+
+typedef struct rea_thread_t
+{
+	void (*procedure)(void* parameter);
+	void* parameter;
+	HANDLE handle;
+} rea_thread_t;
+
+static DWORD WINAPI rea_win32_thread_procedure(LPVOID parameter)
+{
+	rea_thread_t* thread = (rea_thread_t*)parameter;
+	thread->procedure(thread->parameter);
+	return 0;
+}
+
+static int rea_start_thread(rea_thread_t* thread, void (*procedure)(void* parameter), void* parameter)
+{
+	thread->procedure = procedure;
+	thread->parameter = parameter;
+	thread->handle = CreateThread(0, 0, rea_win32_thread_procedure, thread, 0, 0);
+	return thread->handle ? 0 : EAGAIN;
+}
+
+static void rea_join_thread(rea_thread_t* thread)
+{
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+}
+
+typedef CRITICAL_SECTION rea_mutex_t;
+typedef CONDITION_VARIABLE rea_condition_t;
+
+static void rea_create_mutex(rea_mutex_t* mutex)
+{
+	InitializeCriticalSection(mutex);
+}
+
+static void rea_destroy_mutex(rea_mutex_t* mutex)
+{
+	DeleteCriticalSection(mutex);
+}
+
+static void rea_lock_mutex(rea_mutex_t* mutex)
+{
+	EnterCriticalSection(mutex);
+}
+
+static void rea_unlock_mutex(rea_mutex_t* mutex)
+{
+	LeaveCriticalSection(mutex);
+}
+
+static void rea_create_condition(rea_condition_t* condition)
+{
+	InitializeConditionVariable(condition);
+}
+
+static void rea_destroy_condition(rea_condition_t* condition)
+{
+}
+
+static void rea_wait_condition(rea_condition_t* condition, rea_mutex_t* mutex)
+{
+	SleepConditionVariableCS(condition, mutex, INFINITE);
+}
+
+static void rea_wake_condition(rea_condition_t* condition)
+{
+	WakeConditionVariable(condition);
+}
+
+static void rea_wake_all_condition(rea_condition_t* condition)
+{
+	WakeAllConditionVariable(condition);
+}
+
+size_t rea_get_processor_count(void)
+{
+	SYSTEM_INFO system_info;
+	GetSystemInfo(&system_info);
+	return system_info.dwNumberOfProcessors ? (size_t)system_info.dwNumberOfProcessors : 1;
+}
+
+int rea_open_host_file(const char* path, int flags, uint32_t mode, int* file_descriptor)
+{
+	WCHAR wide_path[REA_MAX_HOST_PATH_SIZE];
+	if (!MultiByteToWideChar(CP_UTF8, 0, path, -1, wide_path, REA_MAX_HOST_PATH_SIZE))
+		return ENAMETOOLONG;
+	static const int access_mode_table[4] = { _O_RDONLY, _O_RDONLY, _O_WRONLY, _O_RDWR };
+	int host_flags = access_mode_table[flags & (REA_OPEN_READ | REA_OPEN_WRITE)] | _O_BINARY |
+		((flags & REA_OPEN_CREATE) ? _O_CREAT : 0) | ((flags & REA_OPEN_EXCLUSIVE) ? _O_EXCL : 0) |
+		((flags & REA_OPEN_TRUNCATE) ? _O_TRUNC : 0) | ((flags & REA_OPEN_APPEND) ? _O_APPEND : 0);
+	int file = _wopen(wide_path, host_flags, ((mode & 0444) ? _S_IREAD : 0) | ((mode & 0222) ? _S_IWRITE : 0));
+	if (file == -1)
+		return errno;
+	*file_descriptor = file;
+	return 0;
+}
+
+int rea_read_host_file(int file_descriptor, void* buffer, uint32_t size, uint32_t* transferred_size)
+{
+	int result = _read(file_descriptor, buffer, (size <= INT32_MAX) ? size : INT32_MAX);
+	if (result == -1)
+		return errno;
+	*transferred_size = (uint32_t)result;
+	return 0;
+}
+
+int rea_write_host_file(int file_descriptor, const void* buffer, uint32_t size, uint32_t* transferred_size)
+{
+	int result = _write(file_descriptor, buffer, (size <= INT32_MAX) ? size : INT32_MAX);
+	if (result == -1)
+		return errno;
+	*transferred_size = (uint32_t)result;
+	return 0;
+}
+
+int rea_close_host_file(int file_descriptor)
+{
+	return _close(file_descriptor) ? errno : 0;
+}
+
+int rea_seek_host_file(int file_descriptor, int64_t offset, int origin, int64_t* position)
+{
+	static const int origin_table[3] = { SEEK_SET, SEEK_CUR, SEEK_END };
+	if (origin < REA_SEEK_SET || origin > REA_SEEK_END)
+		return EINVAL;
+	__int64 result = _lseeki64(file_descriptor, offset, origin_table[origin]);
+	if (result == -1)
+		return errno;
+	*position = (int64_t)result;
+	return 0;
+}
+
+static void rea_copy_host_file_status(const struct _stat64* host_status, rel32_file_status_t* status)
+{
+	status->device = (uint64_t)host_status->st_dev;
+	status->inode = (uint64_t)host_status->st_ino;
+	status->mode = (uint32_t)host_status->st_mode;
+	status->link_count = (uint32_t)host_status->st_nlink;
+	status->size = (uint64_t)host_status->st_size;
+	status->access_time = (int64_t)host_status->st_atime;
+	status->modification_time = (int64_t)host_status->st_mtime;
+	status->change_time = (int64_t)host_status->st_ctime;
+}
+
+int rea_get_host_file_status(int file_descriptor, rel32_file_status_t* status)
+{
+	struct _stat64 host_status;
+	if (_fstat64(file_descriptor, &host_status))
+		return errno;
+	rea_copy_host_file_status(&host_status, status);
+	return 0;
+}
+
+int rea_get_host_path_status(const char* path, rel32_file_status_t* status)
+{
+	WCHAR wide_path[REA_MAX_HOST_PATH_SIZE];
+	if (!MultiByteToWideChar(CP_UTF8, 0, path, -1, wide_path, REA_MAX_HOST_PATH_SIZE))
+		return ENAMETOOLONG;
+	struct _stat64 host_status;
+	if (_wstat64(wide_path, &host_status))
+		return errno;
+	rea_copy_host_file_status(&host_status, status);
+	return 0;
+}
+
+int rea_is_host_terminal(int file_descriptor)
+{
+	return _isatty(file_descriptor);
+}
+
+uint64_t rea_get_monotonic_time(void)
+{
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return ((uint64_t)counter.QuadPart / (uint64_t)frequency.QuadPart) * 1000000000ull + (((uint64_t)counter.QuadPart % (uint64_t)frequency.QuadPart) * 1000000000ull) / (uint64_t)frequency.QuadPart;
+}
+
+void rea_get_real_time(int64_t* seconds, uint32_t* nanoseconds)
+{
+	// FILETIME counts 100 ns intervals from 1601
+	FILETIME file_time;
+	GetSystemTimePreciseAsFileTime(&file_time);
+	uint64_t time = (((uint64_t)file_time.dwHighDateTime << 32) | (uint64_t)file_time.dwLowDateTime) - 116444736000000000ull;
+	*seconds = (int64_t)(time / 10000000);
+	*nanoseconds = (uint32_t)(time % 10000000) * 100;
+}
+
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+
+static int rea_posix_append_directory_path(const char* path, size_t path_length, size_t path_buffer_size, size_t* path_size, char* path_buffer)
+{
+	int append_slash = !path_length || path[path_length - 1] != '/';
+
+	*path_size = path_length + (size_t)append_slash;
+	if (path_length + (size_t)append_slash > path_buffer_size)
+		return ENOBUFS;
+
+	memcpy(path_buffer, path, path_length);
+	if (append_slash)
+		path_buffer[path_length] = '/';
+
+	return 0;
+}
+
+static int rea_posix_get_working_directory_path(size_t path_buffer_size, size_t* path_size, char* path_buffer)
+{
+	char* path = (char*)malloc(PATH_MAX);
+	if (!path)
+		return ENOMEM;
+
+	if (!getcwd(path, PATH_MAX))
+	{
+		int error = errno;
+		free(path);
+		return error;
+	}
+
+	int error = rea_posix_append_directory_path(path, strlen(path), path_buffer_size, path_size, path_buffer);
+	free(path);
+	return error;
+}
+
+static int rea_get_program_directory_path(size_t path_buffer_size, size_t* path_size, char* path_buffer)
+{
+	char* path = (char*)malloc(PATH_MAX);
+	if (!path)
+		return ENOMEM;
+
+	ssize_t path_length = readlink("/proc/self/exe", path, PATH_MAX);
+	if (path_length <= 0 || path_length == PATH_MAX)
+	{
+		free(path);
+		return EIO;
+	}
+
+	while (path_length && path[path_length - 1] != '/')
+		--path_length;
+
+	*path_size = (size_t)path_length;
+	int error = ((size_t)path_length > path_buffer_size) ? ENOBUFS : 0;
+	if (!error)
+		memcpy(path_buffer, path, (size_t)path_length);
+	free(path);
+	return error;
+}
+
+int rea_get_special_directory_path(int special_directory, size_t path_buffer_size, size_t* path_size, char* path_buffer)
+{
+	switch (special_directory)
+	{
+		case REA_IGNORE_DIRECTORY :
+			*path_size = 0;
+			return 0;
+		case REA_WORKING_DIRECTORY :
+			return rea_posix_get_working_directory_path(path_buffer_size, path_size, path_buffer);
+		case REA_PROGRAM_DIRECTORY :
+			return rea_get_program_directory_path(path_buffer_size, path_size, path_buffer);
+		default:
+			return ENOENT;
+	}
+}
+
+static int rea_map_path(const char* path, size_t* file_size, void** file_data)
+{
+	int file_descriptor = open(path, O_RDONLY | O_CLOEXEC);
+	if (file_descriptor == -1)
+		return errno;
+
+	struct stat file_status;
+	if (fstat(file_descriptor, &file_status))
+	{
+		int error = errno;
+		close(file_descriptor);
+		return error;
+	}
+
+	*file_size = (size_t)file_status.st_size;
+	if (!file_status.st_size)
+	{
+		close(file_descriptor);
+		*file_data = 0;
+		return 0;
+	}
+
+	// a private writable mapping lets guest stores to data segments copy pages instead of changing the file
+	void* data = mmap(0, (size_t)file_status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file_descriptor, 0);
+	int error = (data == MAP_FAILED) ? errno : 0;
+	close(file_descriptor);
+	if (error)
+		return error;
+
+	*file_data = data;
+	return 0;
+}
+
+void rea_unmap_file(size_t file_size, void* file_data)
+{
+	if (file_data)
+		munmap(file_data, file_size);
+}
+
+static void* rea_allocate_zero_pages(size_t size)
+{
+	void* pages = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return (pages != MAP_FAILED) ? pages : 0;
+}
+
+static void rea_free_zero_pages(size_t size, void* pages)
+{
+	munmap(pages, size);
+}
+
+typedef struct rea_thread_t
+{
+	void (*procedure)(void* parameter);
+	void* parameter;
+	pthread_t handle;
+} rea_thread_t;
+
+static void* rea_posix_thread_procedure(void* parameter)
+{
+	rea_thread_t* thread = (rea_thread_t*)parameter;
+	thread->procedure(thread->parameter);
+	return 0;
+}
+
+static int rea_start_thread(rea_thread_t* thread, void (*procedure)(void* parameter), void* parameter)
+{
+	thread->procedure = procedure;
+	thread->parameter = parameter;
+	return pthread_create(&thread->handle, 0, rea_posix_thread_procedure, thread);
+}
+
+static void rea_join_thread(rea_thread_t* thread)
+{
+	pthread_join(thread->handle, 0);
+}
+
+typedef pthread_mutex_t rea_mutex_t;
+typedef pthread_cond_t rea_condition_t;
+
+static void rea_create_mutex(rea_mutex_t* mutex)
+{
+	pthread_mutex_init(mutex, 0);
+}
+
+static void rea_destroy_mutex(rea_mutex_t* mutex)
+{
+	pthread_mutex_destroy(mutex);
+}
+
+static void rea_lock_mutex(rea_mutex_t* mutex)
+{
+	pthread_mutex_lock(mutex);
+}
+
+static void rea_unlock_mutex(rea_mutex_t* mutex)
+{
+	pthread_mutex_unlock(mutex);
+}
+
+static void rea_create_condition(rea_condition_t* condition)
+{
+	pthread_cond_init(condition, 0);
+}
+
+static void rea_destroy_condition(rea_condition_t* condition)
+{
+	pthread_cond_destroy(condition);
+}
+
+static void rea_wait_condition(rea_condition_t* condition, rea_mutex_t* mutex)
+{
+	pthread_cond_wait(condition, mutex);
+}
+
+static void rea_wake_condition(rea_condition_t* condition)
+{
+	pthread_cond_signal(condition);
+}
+
+static void rea_wake_all_condition(rea_condition_t* condition)
+{
+	pthread_cond_broadcast(condition);
+}
+
+size_t rea_get_processor_count(void)
+{
+	long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (processor_count > 0) ? (size_t)processor_count : 1;
+}
+
+int rea_open_host_file(const char* path, int flags, uint32_t mode, int* file_descriptor)
+{
+	static const int access_mode_table[4] = { O_RDONLY, O_RDONLY, O_WRONLY, O_RDWR };
+	int host_flags = access_mode_table[flags & (REA_OPEN_READ | REA_OPEN_WRITE)] | O_CLOEXEC |
+		((flags & REA_OPEN_CREATE) ? O_CREAT : 0) | ((flags & REA_OPEN_EXCLUSIVE) ? O_EXCL : 0) |
+		((flags & REA_OPEN_TRUNCATE) ? O_TRUNC : 0) | ((flags & REA_OPEN_APPEND) ? O_APPEND : 0);
+	int file = open(path, host_flags, (mode_t)(mode & 07777));
+	if (file == -1)
+		return errno;
+	*file_descriptor = file;
+	return 0;
+}
+
+int rea_read_host_file(int file_descriptor, void* buffer, uint32_t size, uint32_t* transferred_size)
+{
+	ssize_t result = read(file_descriptor, buffer, (size_t)size);
+	if (result == -1)
+		return errno;
+	*transferred_size = (uint32_t)result;
+	return 0;
+}
+
+int rea_write_host_file(int file_descriptor, const void* buffer, uint32_t size, uint32_t* transferred_size)
+{
+	ssize_t result = write(file_descriptor, buffer, (size_t)size);
+	if (result == -1)
+		return errno;
+	*transferred_size = (uint32_t)result;
+	return 0;
+}
+
+int rea_close_host_file(int file_descriptor)
+{
+	return close(file_descriptor) ? errno : 0;
+}
+
+int rea_seek_host_file(int file_descriptor, int64_t offset, int origin, int64_t* position)
+{
+	static const int origin_table[3] = { SEEK_SET, SEEK_CUR, SEEK_END };
+	if (origin < REA_SEEK_SET || origin > REA_SEEK_END)
+		return EINVAL;
+	off_t result = lseek(file_descriptor, (off_t)offset, origin_table[origin]);
+	if (result == (off_t)-1)
+		return errno;
+	*position = (int64_t)result;
+	return 0;
+}
+
+static void rea_copy_host_file_status(const struct stat* host_status, rel32_file_status_t* status)
+{
+	status->device = (uint64_t)host_status->st_dev;
+	status->inode = (uint64_t)host_status->st_ino;
+	status->mode = (uint32_t)host_status->st_mode;
+	status->link_count = (uint32_t)host_status->st_nlink;
+	status->size = (uint64_t)host_status->st_size;
+	status->access_time = (int64_t)host_status->st_atime;
+	status->modification_time = (int64_t)host_status->st_mtime;
+	status->change_time = (int64_t)host_status->st_ctime;
+}
+
+int rea_get_host_file_status(int file_descriptor, rel32_file_status_t* status)
+{
+	struct stat host_status;
+	if (fstat(file_descriptor, &host_status))
+		return errno;
+	rea_copy_host_file_status(&host_status, status);
+	return 0;
+}
+
+int rea_get_host_path_status(const char* path, rel32_file_status_t* status)
+{
+	struct stat host_status;
+	if (stat(path, &host_status))
+		return errno;
+	rea_copy_host_file_status(&host_status, status);
+	return 0;
+}
+
+int rea_is_host_terminal(int file_descriptor)
+{
+	return isatty(file_descriptor);
+}
+
+uint64_t rea_get_monotonic_time(void)
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+}
+
+void rea_get_real_time(int64_t* seconds, uint32_t* nanoseconds)
+{
+	struct timespec time;
+	clock_gettime(CLOCK_REALTIME, &time);
+	*seconds = (int64_t)time.tv_sec;
+	*nanoseconds = (uint32_t)time.tv_nsec;
+}
+
 #endif // _WIN32
 
-int rea_load_file(int special_directory, const char* file_name, size_t file_data_buffer_size, size_t* file_size, void* file_data_buffer)
+static int rea_create_file_path(int special_directory, const char* file_name, char** path)
 {
 	size_t directore_path_size;
 	int error = rea_get_special_directory_path(special_directory, 0, &directore_path_size, 0);
 	if (error && error != ENOBUFS)
 		return error;
 
-	size_t end_path_size = strlen(file_name);
+	size_t end_path_size = strlen(file_name);
+
+	char* name = (char*)malloc(directore_path_size + end_path_size + 1);
+	if (!name)
+		return ENOMEM;
+
+	size_t final_directore_path_size;
+	error = rea_get_special_directory_path(special_directory, directore_path_size, &final_directore_path_size, name);
+	if (!error && final_directore_path_size != directore_path_size)
+		error = EIO;
+	if (error)
+	{
+		free(name);
+		return error;
+	}
+	memcpy(name + directore_path_size, file_name, end_path_size + 1);
+
+	*path = name;
+	return 0;
+}
+
+int rea_map_file(int special_directory, const char* file_name, size_t* file_size, void** file_data)
+{
+	char* path;
+	int error = rea_create_file_path(special_directory, file_name, &path);
+	if (error)
+		return error;
+	error = rea_map_path(path, file_size, file_data);
+	free(path);
+	return error;
+}
+
+int rea_load_file(int special_directory, const char* file_name, size_t file_data_buffer_size, size_t* file_size, void* file_data_buffer)
+{
+	char* name;
+	int error = rea_create_file_path(special_directory, file_name, &name);
+	if (error)
+		return error;
+
+	FILE* handle = fopen(name, "rb");
+	if (!handle)
+		error = errno;
+	free(name);
+	if (error)
+		return error;
+
+	if (fseek(handle, 0, SEEK_END))
+	{
+		error = ferror(handle);
+		fclose(handle);
+		return error;
+	}
+	size_t size = (size_t)ftell(handle);
+	if (size == (size_t)-1)
+	{
+		error = errno;
+		fclose(handle);
+		return error;
+	}
+
+	*file_size = size;
+	if (size > file_data_buffer_size)
+	{
+		error = ENOBUFS;
+		fclose(handle);
+		return error;
+	}
+
+	if (fseek(handle, 0, SEEK_SET))
+	{
+		error = ferror(handle);
+		fclose(handle);
+		return error;
+	}
+
+	for (size_t index = 0; index != size;)
+	{
+		size_t read = fread((void*)((uintptr_t)file_data_buffer + index), 1, size - index, handle);
+		if (!read)
+		{
+			error = ferror(handle);
+			if (!error)
+				error = EIO;
+			fclose(handle);
+			return error;
+		}
+		index += read;
+	}
+
+	fclose(handle);
+	return 0;
+}
+
+int rea_store_file(int special_directory, const char* file_name, size_t file_size, void* file_data_buffer)
+{
+	return ENOSYS;
+}
+
+#define REA32_DISASSEMBLY_BATCH_LINE_COUNT 0x4000
+#define REA32_DISASSEMBLY_MAX_THREAD_COUNT 64
+#define REA32_DISASSEMBLY_INDEX_BATCH_SIZE 256
+
+static size_t rea32_index_disassembly_lines(const void* base_address, uint32_t address, uint32_t size, uint32_t* line_address_table)
+{
+	// only the sizes are asked for, which the batch decoder gets from the low bits of each word without decoding further
+	uint8_t size_table[2][REA32_DISASSEMBLY_INDEX_BATCH_SIZE];
+	rel32_instruction_batch_t batch = { 0 };
+
+	// an instruction cut off by the end of the range is left out
+	size_t line_count = 0;
+	uint64_t end_address = (uint64_t)address + (uint64_t)size;
+	uint64_t line_address = address;
+	while (line_address + 4 <= end_address)
+	{
+		// the batch decoder steps 4 bytes, a window is decoded from both of its first two halfwords and each line reads its size
+		// from the pass its address falls on
+		uint64_t window_address = line_address;
+		size_t word_count_table[2];
+		for (int pass = 0; pass != 2; ++pass)
+		{
+			uint64_t pass_address = window_address + (uint64_t)(pass * 2);
+			word_count_table[pass] = (pass_address + 4 <= end_address) ? (size_t)((end_address - pass_address) / 4) : 0;
+			if (word_count_table[pass] > REA32_DISASSEMBLY_INDEX_BATCH_SIZE)
+				word_count_table[pass] = REA32_DISASSEMBLY_INDEX_BATCH_SIZE;
+			batch.size = size_table[pass];
+			rel32_decode_instruction_batch((const void*)((uintptr_t)base_address + (uintptr_t)pass_address), word_count_table[pass], &batch);
+		}
+		uint32_t offset = 0;
+		for (; (size_t)(offset >> 2) < word_count_table[(offset >> 1) & 1]; offset += size_table[(offset >> 1) & 1][offset >> 2])
+			line_address_table[line_count++] = (uint32_t)(window_address + offset);
+		line_address = window_address + offset;
+	}
+	// a compressed instruction fits in the last halfword, the decoder would read past the range for it
+	if (line_address + 2 <= end_address && (*(const uint8_t*)((uintptr_t)base_address + (uintptr_t)line_address) & 3) != 3)
+		line_address_table[line_count++] = (uint32_t)line_address;
+	return line_count;
+}
+
+int rea32_create_disassembly(int flags, size_t range_count, const rel32_disassembly_range_t* range_table, rel32_disassembly_t** pointer_to_disassembly)
+{
+	if (range_count > REA32_DISASSEMBLY_MAX_RANGE_COUNT)
+		return EINVAL;
+
+	rel32_disassembly_t* disassembly = (rel32_disassembly_t*)malloc(sizeof(rel32_disassembly_t));
+	if (!disassembly)
+		return ENOMEM;
+
+	disassembly->flags = flags;
+	disassembly->range_count = range_count;
+	disassembly->line_count = 0;
+
+	// sized for all halfwords and shrunk afterwards, which saves a separate counting pass
+	size_t max_line_count = 1;
+	for (size_t i = 0; i != range_count; ++i)
+		max_line_count += (size_t)(range_table[i].size / 2);
+	disassembly->line_address_table = (uint32_t*)malloc(max_line_count * sizeof(uint32_t));
+	if (!disassembly->line_address_table)
+	{
+		free(disassembly);
+		return ENOMEM;
+	}
+	for (size_t i = 0; i != range_count; ++i)
+	{
+		disassembly->range_table[i].base_address = range_table[i].base_address;
+		disassembly->range_table[i].address = range_table[i].address;
+		disassembly->range_table[i].size = range_table[i].size;
+		disassembly->range_table[i].first_line = disassembly->line_count;
+		disassembly->line_count += rea32_index_disassembly_lines(range_table[i].base_address, range_table[i].address, range_table[i].size, disassembly->line_address_table + disassembly->line_count);
+	}
+	uint32_t* line_address_table = (uint32_t*)realloc(disassembly->line_address_table, (disassembly->line_count ? disassembly->line_count : 1) * sizeof(uint32_t));
+	if (line_address_table)
+		disassembly->line_address_table = line_address_table;
+
+	// pages of the cache are only touched once chunks land in them
+	disassembly->chunk_cache = (rel32_disassembly_chunk_t*)malloc(REA32_DISASSEMBLY_CACHE_CHUNK_COUNT * sizeof(rel32_disassembly_chunk_t));
+	if (!disassembly->chunk_cache)
+	{
+		free(disassembly->line_address_table);
+		free(disassembly);
+		return ENOMEM;
+	}
+	for (size_t i = 0; i != REA32_DISASSEMBLY_CACHE_CHUNK_COUNT; ++i)
+		disassembly->chunk_cache[i].chunk_index = SIZE_MAX;
+
+	*pointer_to_disassembly = disassembly;
+	return 0;
+}
+
+void rea32_destroy_disassembly(rel32_disassembly_t* disassembly)
+{
+	free(disassembly->chunk_cache);
+	free(disassembly->line_address_table);
+	free(disassembly);
+}
+
+static int rea32_format_disassembly_lines(const rel32_disassembly_t* disassembly, size_t first_line, size_t line_count, uint32_t* line_offset_table, size_t* text_length, char* text)
+{
+	// text must have room for REA32_DISASSEMBLY_MAX_LINE_SIZE bytes per line
+	size_t range_index = 0;
+	size_t length = 0;
+	for (size_t line = first_line; line != first_line + line_count;)
+	{
+		while (range_index + 1 != disassembly->range_count && disassembly->range_table[range_index + 1].first_line <= line)
+			++range_index;
+		const rel32_disassembly_range_t* range = disassembly->range_table + range_index;
+
+		if (line_offset_table)
+		{
+			size_t line_size;
+			line_offset_table[line - first_line] = (uint32_t)length;
+			int error = rel32_disassemble_instruction(disassembly->flags, range->base_address, disassembly->line_address_table[line], REA32_DISASSEMBLY_MAX_LINE_SIZE, &line_size, text + length);
+			if (error)
+				return error;
+			length += line_size;
+			++line;
+			continue;
+		}
 
-	char* name = (char*)malloc(directore_path_size + end_path_size + 1);
-	if (!name)
-		return ENOMEM;
+		// without per line offsets the lines of a range are formatted in one run
+		size_t end_line = (range_index + 1 != disassembly->range_count) ? disassembly->range_table[range_index + 1].first_line : disassembly->line_count;
+		if (end_line > first_line + line_count)
+			end_line = first_line + line_count;
+		uint32_t end_address = (end_line != disassembly->line_count && (range_index + 1 == disassembly->range_count || end_line != disassembly->range_table[range_index + 1].first_line)) ?
+			disassembly->line_address_table[end_line] : (range->address + range->size);
+		uint32_t next_address;
+		size_t written;
+		int error = rel32_disassemble_range(disassembly->flags, range->base_address, disassembly->line_address_table[line], end_address, text + length, (end_line - line) * REA32_DISASSEMBLY_MAX_LINE_SIZE, &next_address, &written);
+		if (error)
+			return error;
+		length += written;
+		line = end_line;
+	}
+	if (line_offset_table)
+		line_offset_table[line_count] = (uint32_t)length;
+	*text_length = length;
+	return 0;
+}
 
-	size_t final_directore_path_size;
-	error = rea_get_special_directory_path(special_directory, directore_path_size, &final_directore_path_size, name);
-	if (!error && final_directore_path_size != directore_path_size)
-		error = EIO;
-	if (error)
+static int rea32_get_disassembly_chunk(rel32_disassembly_t* disassembly, size_t chunk_index, const rel32_disassembly_chunk_t** pointer_to_chunk)
+{
+	rel32_disassembly_chunk_t* chunk = disassembly->chunk_cache + (chunk_index % REA32_DISASSEMBLY_CACHE_CHUNK_COUNT);
+	if (chunk->chunk_index == chunk_index)
 	{
-		free(name);
-		return error;
+		*pointer_to_chunk = chunk;
+		return 0;
 	}
-	memcpy(name + directore_path_size, file_name, end_path_size + 1);
 
-	FILE* handle = fopen(name, "rb");
-	if (!handle)
-		error = errno;
-	free(name);
+	size_t first_line = chunk_index * REA32_DISASSEMBLY_CHUNK_LINE_COUNT;
+	size_t line_count = disassembly->line_count - first_line;
+	if (line_count > REA32_DISASSEMBLY_CHUNK_LINE_COUNT)
+		line_count = REA32_DISASSEMBLY_CHUNK_LINE_COUNT;
+
+	chunk->chunk_index = SIZE_MAX;
+	size_t text_length;
+	int error = rea32_format_disassembly_lines(disassembly, first_line, line_count, chunk->line_offset_table, &text_length, chunk->text);
 	if (error)
 		return error;
+	chunk->line_count = line_count;
+	chunk->chunk_index = chunk_index;
 
-	if (fseek(handle, 0, SEEK_END))
+	*pointer_to_chunk = chunk;
+	return 0;
+}
+
+int rea32_get_disassembly_lines(rel32_disassembly_t* disassembly, size_t first_line, size_t line_count, size_t buffer_size, size_t* text_length, char* buffer)
+{
+	if (first_line > disassembly->line_count || line_count > disassembly->line_count - first_line)
+		return EINVAL;
+
+	size_t length = 0;
+	for (size_t line = first_line; line != first_line + line_count;)
 	{
-		error = ferror(handle);
-		fclose(handle);
-		return error;
+		const rel32_disassembly_chunk_t* chunk;
+		int error = rea32_get_disassembly_chunk(disassembly, line / REA32_DISASSEMBLY_CHUNK_LINE_COUNT, &chunk);
+		if (error)
+			return error;
+
+		size_t chunk_first_line = line % REA32_DISASSEMBLY_CHUNK_LINE_COUNT;
+		size_t chunk_line_count = first_line + line_count - line;
+		if (chunk_line_count > chunk->line_count - chunk_first_line)
+			chunk_line_count = chunk->line_count - chunk_first_line;
+
+		// past the end of the buffer only the length is counted
+		size_t part_size = (size_t)(chunk->line_offset_table[chunk_first_line + chunk_line_count] - chunk->line_offset_table[chunk_first_line]);
+		if (length + part_size <= buffer_size)
+			memcpy(buffer + length, chunk->text + chunk->line_offset_table[chunk_first_line], part_size);
+		length += part_size;
+		line += chunk_line_count;
 	}
-	size_t size = (size_t)ftell(handle);
-	if (size == (size_t)-1)
+
+	*text_length = length;
+	return (length > buffer_size) ? ENOBUFS : 0;
+}
+
+typedef struct rea32_disassembly_batch_t
+{
+	// the batch whose text the slot holds, SIZE_MAX while it is being formatted
+	size_t batch_index;
+	size_t text_length;
+	char* text;
+	int error;
+} rea32_disassembly_batch_t;
+
+// a fixed set of workers takes batches in order, each into the slot of its index, and waits while that slot has not been written out yet
+typedef struct rea32_disassembly_pool_t
+{
+	const rel32_disassembly_t* disassembly;
+	size_t first_line;
+	size_t end_line;
+	size_t batch_count;
+	size_t next_batch_index;
+	size_t written_batch_count;
+	size_t slot_count;
+	int stop;
+	rea_mutex_t mutex;
+	rea_condition_t slot_free_condition;
+	rea_condition_t batch_done_condition;
+	rea32_disassembly_batch_t slot_table[2 * REA32_DISASSEMBLY_MAX_THREAD_COUNT];
+	rea_thread_t thread_table[REA32_DISASSEMBLY_MAX_THREAD_COUNT];
+} rea32_disassembly_pool_t;
+
+static int rea32_format_disassembly_batch(const rea32_disassembly_pool_t* pool, size_t batch_index, rea32_disassembly_batch_t* batch)
+{
+	size_t first_line = pool->first_line + batch_index * REA32_DISASSEMBLY_BATCH_LINE_COUNT;
+	size_t line_count = (pool->end_line - first_line < REA32_DISASSEMBLY_BATCH_LINE_COUNT) ? (pool->end_line - first_line) : REA32_DISASSEMBLY_BATCH_LINE_COUNT;
+	return rea32_format_disassembly_lines(pool->disassembly, first_line, line_count, 0, &batch->text_length, batch->text);
+}
+
+static void rea32_run_disassembly_worker(void* parameter)
+{
+	rea32_disassembly_pool_t* pool = (rea32_disassembly_pool_t*)parameter;
+	rea_lock_mutex(&pool->mutex);
+	for (;;)
 	{
-		error = errno;
-		fclose(handle);
-		return error;
+		while (!pool->stop && pool->next_batch_index != pool->batch_count && pool->next_batch_index - pool->written_batch_count == pool->slot_count)
+			rea_wait_condition(&pool->slot_free_condition, &pool->mutex);
+		if (pool->stop || pool->next_batch_index == pool->batch_count)
+			break;
+		size_t batch_index = pool->next_batch_index++;
+		rea32_disassembly_batch_t* batch = pool->slot_table + batch_index % pool->slot_count;
+		rea_unlock_mutex(&pool->mutex);
+
+		int error = rea32_format_disassembly_batch(pool, batch_index, batch);
+
+		rea_lock_mutex(&pool->mutex);
+		batch->error = error;
+		batch->batch_index = batch_index;
+		rea_wake_condition(&pool->batch_done_condition);
 	}
+	rea_unlock_mutex(&pool->mutex);
+}
 
-	*file_size = size;
-	if (size > file_data_buffer_size)
+int rea32_write_disassembly(rel32_disassembly_t* disassembly, size_t first_line, size_t line_count, size_t thread_count, rea32_disassembly_writer_t write, void* context)
+{
+	if (first_line > disassembly->line_count || line_count > disassembly->line_count - first_line)
+		return EINVAL;
+	if (!line_count)
+		return 0;
+
+	size_t batch_count = (line_count + (REA32_DISASSEMBLY_BATCH_LINE_COUNT - 1)) / REA32_DISASSEMBLY_BATCH_LINE_COUNT;
+	if (!thread_count)
+		thread_count = rea_get_processor_count();
+	if (thread_count > REA32_DISASSEMBLY_MAX_THREAD_COUNT)
+		thread_count = REA32_DISASSEMBLY_MAX_THREAD_COUNT;
+	if (thread_count > batch_count)
+		thread_count = batch_count;
+
+	rea32_disassembly_pool_t* pool = (rea32_disassembly_pool_t*)malloc(sizeof(rea32_disassembly_pool_t));
+	if (!pool)
+		return ENOMEM;
+	pool->disassembly = disassembly;
+	pool->first_line = first_line;
+	pool->end_line = first_line + line_count;
+	pool->batch_count = batch_count;
+	pool->next_batch_index = 0;
+	pool->written_batch_count = 0;
+	// two slots per worker, so a worker has a batch to go on with while the writer is busy with its last one
+	pool->slot_count = (batch_count > thread_count) ? (2 * thread_count) : thread_count;
+	pool->stop = 0;
+
+	const size_t batch_text_size = REA32_DISASSEMBLY_BATCH_LINE_COUNT * REA32_DISASSEMBLY_MAX_LINE_SIZE;
+	char* text_buffer = (char*)malloc(pool->slot_count * batch_text_size);
+	if (!text_buffer)
 	{
-		error = ENOBUFS;
-		fclose(handle);
-		return error;
+		free(pool);
+		return ENOMEM;
+	}
+	for (size_t i = 0; i != pool->slot_count; ++i)
+	{
+		pool->slot_table[i].batch_index = SIZE_MAX;
+		pool->slot_table[i].text = text_buffer + i * batch_text_size;
 	}
 
-	if (fseek(handle, 0, SEEK_SET))
+	rea_create_mutex(&pool->mutex);
+	rea_create_condition(&pool->slot_free_condition);
+	rea_create_condition(&pool->batch_done_condition);
+	size_t started_thread_count = 0;
+	// with a single thread, or when no worker starts, the caller formats the batches itself
+	if (thread_count > 1)
 	{
-		error = ferror(handle);
-		fclose(handle);
-		return error;
+		// formatting the first line builds the decode and format tables, so the workers never wait on each other for them
+		size_t range_index = 0;
+		while (range_index + 1 != disassembly->range_count && disassembly->range_table[range_index + 1].first_line <= first_line)
+			++range_index;
+		char line_text[REA32_DISASSEMBLY_MAX_LINE_SIZE];
+		size_t line_size;
+		rel32_disassemble_instruction(disassembly->flags, disassembly->range_table[range_index].base_address, disassembly->line_address_table[first_line], sizeof(line_text), &line_size, line_text);
+		while (started_thread_count != thread_count && !rea_start_thread(pool->thread_table + started_thread_count, rea32_run_disassembly_worker, pool))
+			++started_thread_count;
 	}
 
-	for (size_t index = 0; index != size;)
+	int error = 0;
+	for (size_t batch_index = 0; !error && batch_index != batch_count; ++batch_index)
 	{
-		size_t read = fread((void*)((uintptr_t)file_data_buffer + index), 1, size - index, handle);
-		if (!read)
+		rea32_disassembly_batch_t* batch = pool->slot_table + batch_index % pool->slot_count;
+		if (started_thread_count)
 		{
-			error = ferror(handle);
-			if (!error)
-				error = EIO;
-			fclose(handle);
-			return error;
+			rea_lock_mutex(&pool->mutex);
+			while (batch->batch_index != batch_index)
+				rea_wait_condition(&pool->batch_done_condition, &pool->mutex);
+			rea_unlock_mutex(&pool->mutex);
 		}
-		index += read;
+		else
+			batch->error = rea32_format_disassembly_batch(pool, batch_index, batch);
+
+		error = batch->error;
+		if (!error)
+			error = write(context, batch->text_length, batch->text);
+
+		rea_lock_mutex(&pool->mutex);
+		pool->written_batch_count = batch_index + 1;
+		pool->stop = error;
+		rea_wake_all_condition(&pool->slot_free_condition);
+		rea_unlock_mutex(&pool->mutex);
 	}
 
-	fclose(handle);
-	return 0;
+	for (size_t i = 0; i != started_thread_count; ++i)
+		rea_join_thread(pool->thread_table + i);
+	rea_destroy_condition(&pool->batch_done_condition);
+	rea_destroy_condition(&pool->slot_free_condition);
+	rea_destroy_mutex(&pool->mutex);
+	free(text_buffer);
+	free(pool);
+	return error;
 }
 
-int rea_store_file(int special_directory, const char* file_name, size_t file_size, void* file_data_buffer)
+int rea32_find_disassembly_line(const rel32_disassembly_t* disassembly, uint32_t address, size_t* line)
 {
-	return ENOSYS;
+	for (size_t i = 0; i != disassembly->range_count; ++i)
+	{
+		const rel32_disassembly_range_t* range = disassembly->range_table + i;
+		if (address < range->address || address - range->address >= range->size)
+			continue;
+
+		size_t end_line = (i + 1 != disassembly->range_count) ? disassembly->range_table[i + 1].first_line : disassembly->line_count;
+		size_t low = range->first_line;
+		size_t high = end_line;
+		while (low != high)
+		{
+			size_t middle = low + (high - low) / 2;
+			if (disassembly->line_address_table[middle] <= address)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		if (low == range->first_line)
+			return ENOENT;
+		*line = low - 1;
+		return 0;
+	}
+	return ENOENT;
 }
 
 int rea32_load_binary_file(int special_directory, const char* file_name, rel32_binary_t** pointer_to_binary)
 {
-	const size_t max_line_size = 128;
 	const size_t header_size = ((sizeof(rel32_binary_t) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1));
 	size_t file_name_length = strlen(file_name);
 	size_t file_name_size = (file_name_length & (sizeof(void*) - 1)) ? (((file_name_length + 1) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1)) : (file_name_length + sizeof(void*));
 	size_t file_size;
-	int error = rea_load_file(special_directory, file_name, 0, &file_size, 0);
-	rel32_binary_t* binary = (rel32_binary_t*)malloc(header_size + file_name_size + file_size);
+	void* file_data;
+	int error = rea_map_file(special_directory, file_name, &file_size, &file_data);
+	if (error)
+		return error;
+	if ((uint64_t)file_size > (uint64_t)UINT32_MAX)
+	{
+		rea_unmap_file(file_size, file_data);
+		return EFBIG;
+	}
+	rel32_binary_t* binary = (rel32_binary_t*)malloc(header_size + file_name_size);
 	if (!binary)
+	{
+		rea_unmap_file(file_size, file_data);
 		return ENOMEM;
-	size_t binary_size;
+	}
 	memcpy((void*)((uintptr_t)binary + header_size), file_name, file_name_length + 1);
-	error = rea_load_file(special_directory, file_name, file_size, &binary_size, (void*)((uintptr_t)binary + header_size + file_name_size));
+	binary->file_name = (char*)((uintptr_t)binary + header_size);
+	binary->size = file_size;
+	// the mapping is copy-on-write, so the guest stores into its own pages and the file stays as it is
+	binary->data = (uint32_t*)file_data;
+	rel32_disassembly_range_t range = { binary->data, 0, (uint32_t)file_size, 0 };
+	error = rea32_create_disassembly(REL_DISASSEMBLE_MACHINE_CODE | REL_DISASSEMBLE_NEW_LINE | REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, 1, &range, &binary->disassembly);
 	if (error)
 	{
+		rea_unmap_file(file_size, file_data);
 		free(binary);
-		return EIO;
+		return error;
 	}
-	else if (binary_size != file_size)
+	binary->instruction_count = binary->disassembly->line_count;
+	*pointer_to_binary = binary;
+	return 0;
+}
+
+void rea32_close_binary_file(rel32_binary_t* binary)
+{
+	rea32_destroy_disassembly(binary->disassembly);
+	rea_unmap_file(binary->size, binary->data);
+	free(binary);
+}
+
+#define REA32_ELF_HEADER_SIZE 52
+#define REA32_ELF_PROGRAM_HEADER_SIZE 32
+#define REA32_ELF_SECTION_HEADER_SIZE 40
+#define REA32_ELF_SYMBOL_SIZE 16
+#define REA32_ELF_MACHINE_RISC_V 243
+#define REA32_ELF_PT_LOAD 1
+#define REA32_ELF_PT_PHDR 6
+#define REA32_ELF_SHT_SYMTAB 2
+#define REA32_ELF_SHT_NOBITS 8
+#define REA32_ELF_SHN_XINDEX 0xFFFF
+#define REA32_ELF_PAGE_SIZE 0x1000
+
+static uint16_t rea32_read_elf_half(const void* data)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	return (uint16_t)((uint16_t)bytes[0] | ((uint16_t)bytes[1] << 8));
+}
+
+static uint32_t rea32_read_elf_word(const void* data)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static int rea32_is_in_elf_file(size_t file_size, uint64_t offset, uint64_t size)
+{
+	return offset <= (uint64_t)file_size && size <= (uint64_t)file_size - offset;
+}
+
+static void rea32_free_elf(rel32_elf_t* elf)
+{
+	for (size_t i = 0; i != elf->segment_count; ++i)
+		if (elf->segment_table[i].zero_fill_data)
+			rea_free_zero_pages((size_t)(elf->segment_table[i].size - elf->segment_table[i].file_backed_size), elf->segment_table[i].zero_fill_data);
+	if (elf->disassembly)
+		rea32_destroy_disassembly(elf->disassembly);
+	rea_unmap_file(elf->file_size, elf->file_data);
+	free(elf);
+}
+
+// copies the bytes of a loaded segment from address up to its end
+static void rea32_copy_elf_segment_data(const rel32_elf_segment_t* segment, uint32_t address, void* destination)
+{
+	uint32_t file_backed_end_address = segment->address + segment->file_backed_size;
+	uint32_t end_address = segment->address + segment->size;
+	if (address < file_backed_end_address)
 	{
-		free(binary);
-		return EBUSY;
+		memcpy(destination, (const void*)((uintptr_t)segment->file_data + (uintptr_t)(address - segment->address)), (size_t)(file_backed_end_address - address));
+		destination = (void*)((uintptr_t)destination + (uintptr_t)(file_backed_end_address - address));
+		address = file_backed_end_address;
 	}
-	size_t instruction_count = binary_size / sizeof(uint32_t);
-	size_t disassembly_buffer_size = instruction_count * max_line_size;
-	size_t disassembly_length = 0;
-	char* disassembly_buffer = (char*)malloc(disassembly_buffer_size);
-	if (!disassembly_buffer)
+	if (address < end_address)
+		memcpy(destination, (const void*)((uintptr_t)segment->zero_fill_data + (uintptr_t)(address - file_backed_end_address)), (size_t)(end_address - address));
+}
+
+static int rea32_load_elf_segment(rel32_elf_t* elf, const uint8_t* program_header)
+{
+	uint32_t offset = rea32_read_elf_word(program_header + 4);
+	uint32_t address = rea32_read_elf_word(program_header + 8);
+	uint32_t file_size = rea32_read_elf_word(program_header + 16);
+	uint32_t memory_size = rea32_read_elf_word(program_header + 20);
+	uint32_t flags = rea32_read_elf_word(program_header + 24);
+	if (!memory_size)
+		return 0;
+	if (file_size > memory_size || !rea32_is_in_elf_file(elf->file_size, offset, file_size) || (uint64_t)address + (uint64_t)memory_size > ((uint64_t)1 << 32))
+		return EBADMSG;
+
+	uint32_t lead_size = address & (REA32_ELF_PAGE_SIZE - 1);
+	uint32_t page_address = address - lead_size;
+	uint64_t end_address = ((uint64_t)address + (uint64_t)memory_size + (REA32_ELF_PAGE_SIZE - 1)) & ~(uint64_t)(REA32_ELF_PAGE_SIZE - 1);
+	uint32_t file_end_address = address + file_size;
+
+	// whole pages come straight from the file, the page holding the end of the file data is copied so the rest of it reads as zero
+	uint32_t file_backed_end_address = (offset >= lead_size) ? (file_end_address & ~(uint32_t)(REA32_ELF_PAGE_SIZE - 1)) : page_address;
+	if (file_backed_end_address < page_address)
+		file_backed_end_address = page_address;
+
+	// loaded segments sharing a page with this one are merged into it, the merged range can reach further segments
+	uint64_t merged_address = page_address;
+	uint64_t merged_end_address = end_address;
+	uint32_t merged_mask = 0;
+	for (int merging = 1; merging;)
 	{
-		free(binary);
-		return ENOMEM;
+		merging = 0;
+		for (size_t i = 0; i != elf->segment_count; ++i)
+		{
+			const rel32_elf_segment_t* other = elf->segment_table + i;
+			if (!(merged_mask & ((uint32_t)1 << i)) && (uint64_t)other->address < merged_end_address && (uint64_t)other->address + (uint64_t)other->size > merged_address)
+			{
+				merged_mask |= (uint32_t)1 << i;
+				if ((uint64_t)other->address < merged_address)
+					merged_address = other->address;
+				if ((uint64_t)other->address + (uint64_t)other->size > merged_end_address)
+					merged_end_address = (uint64_t)other->address + (uint64_t)other->size;
+				merging = 1;
+			}
+		}
+	}
+	if (!merged_mask && elf->segment_count == REA32_ELF_MAX_SEGMENT_COUNT)
+		return ENOBUFS;
+
+	rel32_elf_segment_t merged_segment;
+	merged_segment.address = (uint32_t)merged_address;
+	merged_segment.size = (uint32_t)(merged_end_address - merged_address);
+	merged_segment.file_backed_size = file_backed_end_address - page_address;
+	merged_segment.access = ((flags & 4) ? REL32I_ACCESS_READ : 0) | ((flags & 2) ? REL32I_ACCESS_WRITE : 0) | ((flags & 1) ? REL32I_ACCESS_EXECUTE : 0);
+	merged_segment.file_data = (void*)((uintptr_t)elf->file_data + (uintptr_t)offset - (uintptr_t)lead_size);
+	merged_segment.zero_fill_data = 0;
+
+	// of the merged segments only the one at the lowest address keeps its file pages, up to the first page another one uses
+	if (merged_mask)
+	{
+		uint64_t shared_address = (page_address != merged_address) ? page_address : merged_end_address;
+		const rel32_elf_segment_t* lowest_segment = 0;
+		for (size_t i = 0; i != elf->segment_count; ++i)
+		{
+			const rel32_elf_segment_t* other = elf->segment_table + i;
+			if (!(merged_mask & ((uint32_t)1 << i)))
+				continue;
+			merged_segment.access |= other->access;
+			if (other->address == merged_address && page_address != merged_address)
+				lowest_segment = other;
+			else if (other->address < shared_address)
+				shared_address = other->address;
+		}
+		if (lowest_segment)
+		{
+			merged_segment.file_backed_size = lowest_segment->file_backed_size;
+			merged_segment.file_data = lowest_segment->file_data;
+		}
+		if ((uint64_t)merged_segment.address + (uint64_t)merged_segment.file_backed_size > shared_address)
+			merged_segment.file_backed_size = (uint32_t)(shared_address - merged_address);
 	}
-	for (size_t pc = 0; pc != instruction_count * 4; pc += 4)
+	if (!merged_segment.file_backed_size)
+		merged_segment.file_data = 0;
+
+	uint32_t zero_fill_address = merged_segment.address + merged_segment.file_backed_size;
+	size_t zero_fill_size = (size_t)(merged_end_address - (uint64_t)zero_fill_address);
+	if (zero_fill_size)
 	{
-		if (disassembly_buffer_size - disassembly_length < max_line_size)
+		merged_segment.zero_fill_data = rea_allocate_zero_pages(zero_fill_size);
+		if (!merged_segment.zero_fill_data)
+			return ENOMEM;
+		for (size_t i = 0; i != elf->segment_count; ++i)
 		{
-			disassembly_buffer_size += max_line_size;
-			char* new_disassembly_buffer = (char*)realloc(disassembly_buffer, disassembly_buffer_size);
-			if (!new_disassembly_buffer)
+			const rel32_elf_segment_t* other = elf->segment_table + i;
+			if (merged_mask & ((uint32_t)1 << i))
 			{
-				free(disassembly_buffer);
-				free(binary);
-				return ENOMEM;
+				uint32_t copy_address = (other->address > zero_fill_address) ? other->address : zero_fill_address;
+				rea32_copy_elf_segment_data(other, copy_address, (void*)((uintptr_t)merged_segment.zero_fill_data + (uintptr_t)(copy_address - zero_fill_address)));
 			}
-			disassembly_buffer = new_disassembly_buffer;
 		}
-		size_t line_size = 0;
-		error = rel32_disassemble_instruction(
-			REL_DISASSEMBLE_MACHINE_CODE | REL_DISASSEMBLE_NEW_LINE | REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS,
-			(void*)((uintptr_t)binary + header_size + file_name_size),
-			(uint32_t)pc, disassembly_buffer_size - disassembly_length,
-			&line_size, disassembly_buffer + disassembly_length);
-		if (error)
+		// the bytes of this segment go over the zeros that pad the pages of the others
+		uint32_t copy_address = (zero_fill_address > address) ? zero_fill_address : address;
+		if (merged_mask && (uint64_t)address + (uint64_t)memory_size > (uint64_t)copy_address)
+			memset((void*)((uintptr_t)merged_segment.zero_fill_data + (uintptr_t)(copy_address - zero_fill_address)), 0, (size_t)((uint64_t)address + (uint64_t)memory_size - (uint64_t)copy_address));
+		if (file_end_address > copy_address)
+			memcpy((void*)((uintptr_t)merged_segment.zero_fill_data + (uintptr_t)(copy_address - zero_fill_address)), (const void*)((uintptr_t)elf->file_data + (uintptr_t)offset + (uintptr_t)(copy_address - address)), (size_t)(file_end_address - copy_address));
+	}
+
+	size_t segment_count = 0;
+	for (size_t i = 0; i != elf->segment_count; ++i)
+	{
+		if (merged_mask & ((uint32_t)1 << i))
 		{
-			free(disassembly_buffer);
-			free(binary);
-			return error;
+			if (elf->segment_table[i].zero_fill_data)
+				rea_free_zero_pages((size_t)(elf->segment_table[i].size - elf->segment_table[i].file_backed_size), elf->segment_table[i].zero_fill_data);
 		}
-		disassembly_length += line_size;
+		else
+			elf->segment_table[segment_count++] = elf->segment_table[i];
+	}
+	elf->segment_table[segment_count] = merged_segment;
+	elf->segment_count = segment_count + 1;
+	return 0;
+}
+
+static int rea32_load_elf_sections(rel32_elf_t* elf, const uint8_t* header)
+{
+	uint32_t section_header_offset = rea32_read_elf_word(header + 32);
+	uint32_t section_header_size = rea32_read_elf_half(header + 46);
+	uint32_t section_count = rea32_read_elf_half(header + 48);
+	uint32_t section_name_table_index = rea32_read_elf_half(header + 50);
+	if (!section_header_offset)
+		return 0;
+	if (section_header_size < REA32_ELF_SECTION_HEADER_SIZE || !rea32_is_in_elf_file(elf->file_size, section_header_offset, section_header_size))
+		return EBADMSG;
+
+	// with extended numbering the count and the name table index are kept in the first section header
+	const uint8_t* section_header_table = (const uint8_t*)elf->file_data + section_header_offset;
+	if (!section_count)
+		section_count = rea32_read_elf_word(section_header_table + 20);
+	if (section_name_table_index == REA32_ELF_SHN_XINDEX)
+		section_name_table_index = rea32_read_elf_word(section_header_table + 24);
+	if (!rea32_is_in_elf_file(elf->file_size, section_header_offset, (uint64_t)section_count * (uint64_t)section_header_size))
+		return EBADMSG;
+
+	elf->section_count = section_count;
+	elf->section_header_size = section_header_size;
+	elf->section_header_table = section_header_table;
+	if (section_name_table_index && section_name_table_index < section_count)
+	{
+		const uint8_t* name_section_header = section_header_table + (size_t)section_name_table_index * section_header_size;
+		uint32_t name_table_offset = rea32_read_elf_word(name_section_header + 16);
+		uint32_t name_table_size = rea32_read_elf_word(name_section_header + 20);
+		if (!rea32_is_in_elf_file(elf->file_size, name_table_offset, name_table_size))
+			return EBADMSG;
+		elf->section_name_table_size = name_table_size;
+		elf->section_name_table = (const char*)((uintptr_t)elf->file_data + name_table_offset);
 	}
-	size_t disassembly_size = (disassembly_length & (sizeof(void*) - 1)) ? (((disassembly_length + 1) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1)) : (disassembly_length + sizeof(void*));
-	rel32_binary_t* new_binary = (rel32_binary_t*)realloc(binary, header_size + file_name_size + file_size + disassembly_size);
-	if (!new_binary)
+
+	for (uint32_t i = 0; i != section_count; ++i)
 	{
-		free(disassembly_buffer);
-		free(binary);
+		const uint8_t* section_header = section_header_table + (size_t)i * section_header_size;
+		if (rea32_read_elf_word(section_header + 4) != REA32_ELF_SHT_SYMTAB)
+			continue;
+
+		uint32_t symbol_table_offset = rea32_read_elf_word(section_header + 16);
+		uint32_t symbol_table_size = rea32_read_elf_word(section_header + 20);
+		uint32_t string_table_index = rea32_read_elf_word(section_header + 24);
+		if (!rea32_is_in_elf_file(elf->file_size, symbol_table_offset, symbol_table_size) || string_table_index >= section_count)
+			return EBADMSG;
+
+		const uint8_t* string_section_header = section_header_table + (size_t)string_table_index * section_header_size;
+		uint32_t string_table_offset = rea32_read_elf_word(string_section_header + 16);
+		uint32_t string_table_size = rea32_read_elf_word(string_section_header + 20);
+		if (!rea32_is_in_elf_file(elf->file_size, string_table_offset, string_table_size))
+			return EBADMSG;
+
+		elf->symbol_count = symbol_table_size / REA32_ELF_SYMBOL_SIZE;
+		elf->symbol_table = (const void*)((uintptr_t)elf->file_data + symbol_table_offset);
+		elf->string_table_size = string_table_size;
+		elf->string_table = (const char*)((uintptr_t)elf->file_data + string_table_offset);
+		return 0;
+	}
+	return 0;
+}
+
+int rea32_open_elf_file(int special_directory, const char* file_name, rel32_elf_t** pointer_to_elf)
+{
+	const size_t header_size = ((sizeof(rel32_elf_t) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1));
+	size_t file_name_length = strlen(file_name);
+	size_t file_size;
+	void* file_data;
+	int error = rea_map_file(special_directory, file_name, &file_size, &file_data);
+	if (error)
+		return error;
+
+	const uint8_t* header = (const uint8_t*)file_data;
+	if (file_size < REA32_ELF_HEADER_SIZE || header[0] != 0x7F || header[1] != 'E' || header[2] != 'L' || header[3] != 'F' ||
+		header[4] != 1 || header[5] != 1 || rea32_read_elf_half(header + 18) != REA32_ELF_MACHINE_RISC_V)
+	{
+		rea_unmap_file(file_size, file_data);
+		return ENOEXEC;
+	}
+
+	rel32_elf_t* elf = (rel32_elf_t*)malloc(header_size + file_name_length + 1);
+	if (!elf)
+	{
+		rea_unmap_file(file_size, file_data);
 		return ENOMEM;
 	}
-	binary = new_binary;
-	memcpy((void*)((uintptr_t)binary + header_size + file_name_size + binary_size), disassembly_buffer, disassembly_length);
-	*(char*)((uintptr_t)binary + header_size + file_name_size + binary_size + disassembly_length) = 0;
-	free(disassembly_buffer);
-	binary->file_name = (char*)((uintptr_t)binary + header_size);
-	binary->size = binary_size;
-	binary->instruction_count = instruction_count;
-	binary->data = (void*)((uintptr_t)binary + header_size + file_name_size);
-	binary->disassembly_length = disassembly_length;
-	binary->disassembly = (char*)((uintptr_t)binary + header_size + file_name_size + binary_size);
-	*pointer_to_binary = binary;
+	elf->file_name = (char*)((uintptr_t)elf + header_size);
+	memcpy(elf->file_name, file_name, file_name_length + 1);
+	elf->file_size = file_size;
+	elf->file_data = file_data;
+	elf->entry_point = rea32_read_elf_word(header + 24);
+	elf->segment_count = 0;
+	elf->program_header_address = 0;
+	elf->program_header_count = 0;
+	elf->program_header_size = 0;
+	elf->section_count = 0;
+	elf->section_header_size = 0;
+	elf->section_header_table = 0;
+	elf->section_name_table_size = 0;
+	elf->section_name_table = 0;
+	elf->symbol_count = 0;
+	elf->symbol_table = 0;
+	elf->string_table_size = 0;
+	elf->string_table = 0;
+	elf->disassembly = 0;
+
+	uint32_t program_header_offset = rea32_read_elf_word(header + 28);
+	uint32_t program_header_size = rea32_read_elf_half(header + 42);
+	uint32_t program_header_count = rea32_read_elf_half(header + 44);
+	if (program_header_count && (program_header_size < REA32_ELF_PROGRAM_HEADER_SIZE || !rea32_is_in_elf_file(file_size, program_header_offset, (uint64_t)program_header_count * (uint64_t)program_header_size)))
+		error = EBADMSG;
+	for (uint32_t i = 0; !error && i != program_header_count; ++i)
+	{
+		const uint8_t* program_header = header + program_header_offset + (size_t)i * program_header_size;
+		uint32_t type = rea32_read_elf_word(program_header);
+		uint32_t offset = rea32_read_elf_word(program_header + 4);
+		if (type == REA32_ELF_PT_LOAD)
+			error = rea32_load_elf_segment(elf, program_header);
+		// without a PT_PHDR entry the program headers are found inside the loaded segment that holds them
+		if (type == REA32_ELF_PT_PHDR || (type == REA32_ELF_PT_LOAD && !elf->program_header_count && program_header_offset >= offset && program_header_offset - offset < rea32_read_elf_word(program_header + 16)))
+		{
+			elf->program_header_address = rea32_read_elf_word(program_header + 8) + (program_header_offset - ((type == REA32_ELF_PT_LOAD) ? offset : program_header_offset));
+			elf->program_header_count = program_header_count;
+			elf->program_header_size = program_header_size;
+		}
+	}
+	if (!error)
+		error = rea32_load_elf_sections(elf, header);
+	if (error)
+	{
+		rea32_free_elf(elf);
+		return error;
+	}
+
+	*pointer_to_elf = elf;
+	return 0;
+}
+
+void rea32_close_elf_file(rel32_elf_t* elf)
+{
+	rea32_free_elf(elf);
+}
+
+size_t rea32_get_elf_leaf_table_count(const rel32_elf_t* elf)
+{
+	const uint32_t leaf_size = REL32I_MEMORY_PAGE_SIZE * REL32I_MEMORY_LEAF_PAGE_COUNT;
+	uint8_t leaf_map[((((uint64_t)1 << 32) / (REL32I_MEMORY_PAGE_SIZE * REL32I_MEMORY_LEAF_PAGE_COUNT)) + 7) / 8] = { 0 };
+	size_t leaf_table_count = 0;
+	for (size_t i = 0; i != elf->segment_count; ++i)
+	{
+		const rel32_elf_segment_t* segment = elf->segment_table + i;
+		for (uint64_t leaf_address = segment->address & ~(leaf_size - 1); leaf_address < (uint64_t)segment->address + (uint64_t)segment->size; leaf_address += leaf_size)
+		{
+			size_t leaf_index = (size_t)(leaf_address / leaf_size);
+			if (!(leaf_map[leaf_index / 8] & (1 << (leaf_index % 8))))
+			{
+				leaf_map[leaf_index / 8] |= (uint8_t)(1 << (leaf_index % 8));
+				++leaf_table_count;
+			}
+		}
+	}
+	return leaf_table_count;
+}
+
+int rea32_map_elf_segments(const rel32_elf_t* elf, rel32i_memory_t* memory)
+{
+	for (size_t i = 0; i != elf->segment_count; ++i)
+	{
+		const rel32_elf_segment_t* segment = elf->segment_table + i;
+		if (segment->file_backed_size)
+		{
+			int error = rel32i_map_memory(memory, segment->address, segment->file_backed_size, REL32I_MEMORY_RAM, segment->access, segment->file_data);
+			if (error)
+				return error;
+		}
+		if (segment->size != segment->file_backed_size)
+		{
+			int error = rel32i_map_memory(memory, segment->address + segment->file_backed_size, segment->size - segment->file_backed_size, REL32I_MEMORY_RAM, segment->access, segment->zero_fill_data);
+			if (error)
+				return error;
+		}
+	}
+	return 0;
+}
+
+int rea32_get_elf_section(const rel32_elf_t* elf, size_t index, rel32_elf_section_t* section)
+{
+	if (index >= elf->section_count)
+		return ENOENT;
+
+	const uint8_t* section_header = (const uint8_t*)elf->section_header_table + index * elf->section_header_size;
+	uint32_t name_offset = rea32_read_elf_word(section_header);
+	uint32_t type = rea32_read_elf_word(section_header + 4);
+	uint32_t offset = rea32_read_elf_word(section_header + 16);
+	uint32_t size = rea32_read_elf_word(section_header + 20);
+	if (name_offset >= elf->section_name_table_size || !memchr(elf->section_name_table + name_offset, 0, elf->section_name_table_size - name_offset))
+		section->name = "";
+	else
+		section->name = elf->section_name_table + name_offset;
+	if (type != REA32_ELF_SHT_NOBITS && !rea32_is_in_elf_file(elf->file_size, offset, size))
+		return EBADMSG;
+
+	section->type = (int)type;
+	section->flags = rea32_read_elf_word(section_header + 8);
+	section->address = rea32_read_elf_word(section_header + 12);
+	section->size = size;
+	section->file_data = (type != REA32_ELF_SHT_NOBITS) ? (const void*)((uintptr_t)elf->file_data + offset) : 0;
+	return 0;
+}
+
+int rea32_get_elf_symbol(const rel32_elf_t* elf, size_t index, rel32_elf_symbol_t* symbol)
+{
+	if (index >= elf->symbol_count)
+		return ENOENT;
+
+	const uint8_t* elf_symbol = (const uint8_t*)elf->symbol_table + index * REA32_ELF_SYMBOL_SIZE;
+	uint32_t name_offset = rea32_read_elf_word(elf_symbol);
+	if (name_offset >= elf->string_table_size || !memchr(elf->string_table + name_offset, 0, elf->string_table_size - name_offset))
+		return EBADMSG;
+
+	symbol->name = elf->string_table + name_offset;
+	symbol->address = rea32_read_elf_word(elf_symbol + 4);
+	symbol->size = rea32_read_elf_word(elf_symbol + 8);
+	symbol->type = elf_symbol[12] & 0xF;
+	return 0;
+}
+
+int rea32_find_elf_symbol(const rel32_elf_t* elf, const char* name, rel32_elf_symbol_t* symbol)
+{
+	for (size_t i = 0; i != elf->symbol_count; ++i)
+		if (!rea32_get_elf_symbol(elf, i, symbol) && !strcmp(symbol->name, name))
+			return 0;
+	return ENOENT;
+}
+
+int rea32_get_elf_code_ranges(const rel32_elf_t* elf, size_t range_table_size, size_t* range_count, rel32_disassembly_range_t* range_table)
+{
+	const uint8_t* header = (const uint8_t*)elf->file_data;
+	uint32_t program_header_offset = rea32_read_elf_word(header + 28);
+	uint32_t program_header_size = rea32_read_elf_half(header + 42);
+	uint32_t program_header_count = rea32_read_elf_half(header + 44);
+	size_t count = 0;
+
+	// the program headers were validated when the file was opened
+	for (uint32_t i = 0; i != program_header_count; ++i)
+	{
+		const uint8_t* program_header = header + program_header_offset + (size_t)i * program_header_size;
+		if (rea32_read_elf_word(program_header) != REA32_ELF_PT_LOAD || !(rea32_read_elf_word(program_header + 24) & 1) || !rea32_read_elf_word(program_header + 16))
+			continue;
+		if (count == range_table_size)
+			return ENOBUFS;
+
+		uint32_t offset = rea32_read_elf_word(program_header + 4);
+		uint32_t address = rea32_read_elf_word(program_header + 8);
+		range_table[count].base_address = (const void*)((uintptr_t)elf->file_data + (uintptr_t)offset - (uintptr_t)address);
+		range_table[count].address = address;
+		range_table[count].size = rea32_read_elf_word(program_header + 16);
+		range_table[count].first_line = 0;
+		++count;
+	}
+
+	*range_count = count;
+	return 0;
+}
+
+int rea32_disassemble_elf_file(rel32_elf_t* elf)
+{
+	size_t range_count;
+	rel32_disassembly_range_t range_table[REA32_DISASSEMBLY_MAX_RANGE_COUNT];
+	int error = rea32_get_elf_code_ranges(elf, REA32_DISASSEMBLY_MAX_RANGE_COUNT, &range_count, range_table);
+	if (error)
+		return error;
+
+	rel32_disassembly_t* disassembly;
+	error = rea32_create_disassembly(REL_DISASSEMBLE_ADDRESS | REL_DISASSEMBLE_MACHINE_CODE | REL_DISASSEMBLE_NEW_LINE | REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, range_count, range_table, &disassembly);
+	if (error)
+		return error;
+	if (elf->disassembly)
+		rea32_destroy_disassembly(elf->disassembly);
+	elf->disassembly = disassembly;
 	return 0;
-}
\ No newline at end of file
+}
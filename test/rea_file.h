@@ -15,24 +15,206 @@ extern "C" {
 #define REA_PROGRAM_DIRECTORY 2
 #define REA_SPECIAL_DIRECTORY_COUNT 3
 
+#define REA_OPEN_READ 0x01
+#define REA_OPEN_WRITE 0x02
+#define REA_OPEN_CREATE 0x04
+#define REA_OPEN_EXCLUSIVE 0x08
+#define REA_OPEN_TRUNCATE 0x10
+#define REA_OPEN_APPEND 0x20
+#define REA_MAX_HOST_PATH_SIZE 0x1000
+
+#define REA_SEEK_SET 0
+#define REA_SEEK_CURRENT 1
+#define REA_SEEK_END 2
+
+#define REA32_ELF_MAX_SEGMENT_COUNT 16
+
+#define REA32_DISASSEMBLY_MAX_LINE_SIZE REL_DISASSEMBLE_MAX_LINE_SIZE
+#define REA32_DISASSEMBLY_CHUNK_LINE_COUNT 256
+#define REA32_DISASSEMBLY_CACHE_CHUNK_COUNT 64
+#define REA32_DISASSEMBLY_MAX_RANGE_COUNT REA32_ELF_MAX_SEGMENT_COUNT
+
+typedef struct rel32_file_status_t
+{
+	uint64_t device;
+	uint64_t inode;
+	uint32_t mode;
+	uint32_t link_count;
+	uint64_t size;
+	int64_t access_time;
+	int64_t modification_time;
+	int64_t change_time;
+} rel32_file_status_t;
+
+typedef struct rel32_disassembly_range_t
+{
+	const void* base_address;
+	uint32_t address;
+	uint32_t size;
+	size_t first_line;
+} rel32_disassembly_range_t;
+
+typedef struct rel32_disassembly_chunk_t
+{
+	size_t chunk_index;
+	size_t line_count;
+	uint32_t line_offset_table[REA32_DISASSEMBLY_CHUNK_LINE_COUNT + 1];
+	char text[REA32_DISASSEMBLY_CHUNK_LINE_COUNT * REA32_DISASSEMBLY_MAX_LINE_SIZE];
+} rel32_disassembly_chunk_t;
+
+typedef struct rel32_disassembly_t
+{
+	int flags;
+	size_t range_count;
+	rel32_disassembly_range_t range_table[REA32_DISASSEMBLY_MAX_RANGE_COUNT];
+	size_t line_count;
+	uint32_t* line_address_table;
+	rel32_disassembly_chunk_t* chunk_cache;
+} rel32_disassembly_t;
+
 typedef struct rel32_binary_t
 {
 	char* file_name;
 	size_t size;
 	size_t instruction_count;
 	uint32_t* data;
-	size_t disassembly_length;
-	char* disassembly;
+	rel32_disassembly_t* disassembly;
 } rel32_binary_t;
 
+typedef struct rel32_elf_segment_t
+{
+	uint32_t address;
+	uint32_t size;
+	uint32_t file_backed_size;
+	int access;
+	void* file_data;
+	void* zero_fill_data;
+} rel32_elf_segment_t;
+
+typedef struct rel32_elf_symbol_t
+{
+	const char* name;
+	uint32_t address;
+	uint32_t size;
+	int type;
+} rel32_elf_symbol_t;
+
+typedef struct rel32_elf_section_t
+{
+	const char* name;
+	int type;
+	uint32_t flags;
+	uint32_t address;
+	uint32_t size;
+	const void* file_data;
+} rel32_elf_section_t;
+
+typedef struct rel32_elf_t
+{
+	char* file_name;
+	size_t file_size;
+	void* file_data;
+	uint32_t entry_point;
+	size_t segment_count;
+	rel32_elf_segment_t segment_table[REA32_ELF_MAX_SEGMENT_COUNT];
+	uint32_t program_header_address;
+	size_t program_header_count;
+	size_t program_header_size;
+	size_t section_count;
+	size_t section_header_size;
+	const void* section_header_table;
+	size_t section_name_table_size;
+	const char* section_name_table;
+	size_t symbol_count;
+	const void* symbol_table;
+	size_t string_table_size;
+	const char* string_table;
+	rel32_disassembly_t* disassembly;
+} rel32_elf_t;
+
 int rea_get_special_directory_path(int special_directory, size_t path_buffer_size, size_t* path_size, char* path_buffer);
 
 int rea_load_file(int special_directory, const char* file_name, size_t file_data_buffer_size, size_t* file_size, void* file_data_buffer);
 
 int rea_store_file(int special_directory, const char* file_name, size_t file_size, void* file_data_buffer);
 
+// The whole file is mapped copy-on-write, an empty file gives a null file_data.
+int rea_map_file(int special_directory, const char* file_name, size_t* file_size, void** file_data);
+
+void rea_unmap_file(size_t file_size, void* file_data);
+
+size_t rea_get_processor_count(void);
+
+// Host file descriptors for guests that do their own I/O. Paths are UTF-8, flags are REA_OPEN_* and mode holds the POSIX permission bits for a created file.
+int rea_open_host_file(const char* path, int flags, uint32_t mode, int* file_descriptor);
+
+int rea_read_host_file(int file_descriptor, void* buffer, uint32_t size, uint32_t* transferred_size);
+
+int rea_write_host_file(int file_descriptor, const void* buffer, uint32_t size, uint32_t* transferred_size);
+
+int rea_close_host_file(int file_descriptor);
+
+// origin is one of REA_SEEK_*.
+int rea_seek_host_file(int file_descriptor, int64_t offset, int origin, int64_t* position);
+
+// mode has the POSIX S_IF* file type bits.
+int rea_get_host_file_status(int file_descriptor, rel32_file_status_t* status);
+
+int rea_get_host_path_status(const char* path, rel32_file_status_t* status);
+
+int rea_is_host_terminal(int file_descriptor);
+
+// Nanoseconds from an arbitrary point, never going backwards.
+uint64_t rea_get_monotonic_time(void);
+
+void rea_get_real_time(int64_t* seconds, uint32_t* nanoseconds);
+
+// Only the base_address, address and size of each range are used. Nothing is formatted until lines are requested.
+int rea32_create_disassembly(int flags, size_t range_count, const rel32_disassembly_range_t* range_table, rel32_disassembly_t** pointer_to_disassembly);
+
+void rea32_destroy_disassembly(rel32_disassembly_t* disassembly);
+
+// Formats the lines through the chunk cache. On ENOBUFS text_length is the size the lines need.
+int rea32_get_disassembly_lines(rel32_disassembly_t* disassembly, size_t first_line, size_t line_count, size_t buffer_size, size_t* text_length, char* buffer);
+
+int rea32_find_disassembly_line(const rel32_disassembly_t* disassembly, uint32_t address, size_t* line);
+
+typedef int (*rea32_disassembly_writer_t)(void* context, size_t text_length, const char* text);
+
+// Formats the lines in batches on a pool of thread_count threads, 0 meaning one per processor, and hands the text to write in line order.
+// Batches start on indexed line boundaries, so a compressed instruction is never split. A nonzero return from write stops and is returned.
+int rea32_write_disassembly(rel32_disassembly_t* disassembly, size_t first_line, size_t line_count, size_t thread_count, rea32_disassembly_writer_t write, void* context);
+
+// The file is mapped copy-on-write and data points into the mapping. The disassembly is produced on demand through binary->disassembly.
 int rea32_load_binary_file(int special_directory, const char* file_name, rel32_binary_t** pointer_to_binary);
 
+void rea32_close_binary_file(rel32_binary_t* binary);
+
+// The file is mapped copy-on-write and only its headers and symbol table are read. Returns ENOEXEC when the file is not a little endian RISC-V ELF32 image.
+// Loadable segments that share a page become one segment with the access of all of them, its pages holding the bytes of each.
+int rea32_open_elf_file(int special_directory, const char* file_name, rel32_elf_t** pointer_to_elf);
+
+void rea32_close_elf_file(rel32_elf_t* elf);
+
+// Number of leaf tables a rel32i_memory_t needs to map all loadable segments.
+size_t rea32_get_elf_leaf_table_count(const rel32_elf_t* elf);
+
+// Segment pages are mapped straight from the file, BSS is backed by pages the host zero fills on first touch.
+int rea32_map_elf_segments(const rel32_elf_t* elf, rel32i_memory_t* memory);
+
+// file_data is null for sections that take no space in the file. An unnamed section gets an empty name.
+int rea32_get_elf_section(const rel32_elf_t* elf, size_t index, rel32_elf_section_t* section);
+
+int rea32_get_elf_symbol(const rel32_elf_t* elf, size_t index, rel32_elf_symbol_t* symbol);
+
+int rea32_find_elf_symbol(const rel32_elf_t* elf, const char* name, rel32_elf_symbol_t* symbol);
+
+// The file contents of the executable segments, with base_address pointing into the file mapping.
+int rea32_get_elf_code_ranges(const rel32_elf_t* elf, size_t range_table_size, size_t* range_count, rel32_disassembly_range_t* range_table);
+
+// Sets up elf->disassembly over the file contents of the executable segments.
+int rea32_disassemble_elf_file(rel32_elf_t* elf);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
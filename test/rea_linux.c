@@ -0,0 +1,840 @@
+#include "rea_linux.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define REA32_LINUX_SYS_IOCTL 29
+#define REA32_LINUX_SYS_OPENAT 56
+#define REA32_LINUX_SYS_CLOSE 57
+#define REA32_LINUX_SYS_LSEEK 62
+#define REA32_LINUX_SYS_READ 63
+#define REA32_LINUX_SYS_WRITE 64
+#define REA32_LINUX_SYS_READV 65
+#define REA32_LINUX_SYS_WRITEV 66
+#define REA32_LINUX_SYS_FSTATAT 79
+#define REA32_LINUX_SYS_FSTAT 80
+#define REA32_LINUX_SYS_EXIT 93
+#define REA32_LINUX_SYS_EXIT_GROUP 94
+#define REA32_LINUX_SYS_SET_TID_ADDRESS 96
+#define REA32_LINUX_SYS_SET_ROBUST_LIST 99
+#define REA32_LINUX_SYS_CLOCK_GETTIME 113
+#define REA32_LINUX_SYS_RT_SIGACTION 134
+#define REA32_LINUX_SYS_RT_SIGPROCMASK 135
+#define REA32_LINUX_SYS_TIMES 153
+#define REA32_LINUX_SYS_UNAME 160
+#define REA32_LINUX_SYS_GETTIMEOFDAY 169
+#define REA32_LINUX_SYS_GETPID 172
+#define REA32_LINUX_SYS_GETPPID 173
+#define REA32_LINUX_SYS_GETUID 174
+#define REA32_LINUX_SYS_GETEUID 175
+#define REA32_LINUX_SYS_GETGID 176
+#define REA32_LINUX_SYS_GETEGID 177
+#define REA32_LINUX_SYS_GETTID 178
+#define REA32_LINUX_SYS_BRK 214
+#define REA32_LINUX_SYS_MUNMAP 215
+#define REA32_LINUX_SYS_MMAP2 222
+#define REA32_LINUX_SYS_MPROTECT 226
+#define REA32_LINUX_SYS_MADVISE 233
+#define REA32_LINUX_SYS_STATX 291
+#define REA32_LINUX_SYS_CLOCK_GETTIME64 403
+// newlib's libgloss still issues the old open call
+#define REA32_LINUX_SYS_OPEN 1024
+
+#define REA32_LINUX_AT_FDCWD 0xFFFFFF9C
+#define REA32_LINUX_AT_EMPTY_PATH 0x1000
+#define REA32_LINUX_O_ACCMODE 0x3
+#define REA32_LINUX_O_CREAT 0x40
+#define REA32_LINUX_O_EXCL 0x80
+#define REA32_LINUX_O_TRUNC 0x200
+#define REA32_LINUX_O_APPEND 0x400
+#define REA32_LINUX_MAP_FIXED 0x10
+#define REA32_LINUX_MAP_ANONYMOUS 0x20
+#define REA32_LINUX_CLOCK_REALTIME 0
+#define REA32_LINUX_CLOCK_PROCESS_CPUTIME_ID 2
+#define REA32_LINUX_CLOCK_THREAD_CPUTIME_ID 3
+#define REA32_LINUX_CLOCK_REALTIME_COARSE 5
+#define REA32_LINUX_CLOCK_TAI 11
+#define REA32_LINUX_TIOCGWINSZ 0x5413
+#define REA32_LINUX_SIGSET_SIZE 8
+#define REA32_LINUX_MAX_IOVEC_COUNT 1024
+#define REA32_LINUX_CLOCK_TICKS_PER_SECOND 100
+#define REA32_LINUX_PAGE_SIZE 0x1000
+
+#define REA32_LINUX_STAT64_SIZE 104
+#define REA32_LINUX_STATX_SIZE 256
+#define REA32_LINUX_STATX_BASIC_STATS 0x7FF
+#define REA32_LINUX_UTSNAME_FIELD_SIZE 65
+
+#define REA32_LINUX_AT_NULL 0
+#define REA32_LINUX_AT_PHDR 3
+#define REA32_LINUX_AT_PHENT 4
+#define REA32_LINUX_AT_PHNUM 5
+#define REA32_LINUX_AT_PAGESZ 6
+#define REA32_LINUX_AT_ENTRY 9
+#define REA32_LINUX_AT_UID 11
+#define REA32_LINUX_AT_EUID 12
+#define REA32_LINUX_AT_GID 13
+#define REA32_LINUX_AT_EGID 14
+#define REA32_LINUX_AT_HWCAP 16
+#define REA32_LINUX_AT_CLKTCK 17
+#define REA32_LINUX_AT_SECURE 23
+#define REA32_LINUX_AT_RANDOM 25
+#define REA32_LINUX_AT_EXECFN 31
+#define REA32_LINUX_MAX_AUXILIARY_COUNT 16
+#define REA32_LINUX_HWCAP_I (1 << ('I' - 'A'))
+
+
+// the guest sees Linux numbers whatever values the host's errno.h uses
+static uint32_t rea32_get_linux_error(int error)
+{
+	int linux_error;
+	switch (error)
+	{
+		case EPERM: linux_error = 1; break;
+		case ENOENT: linux_error = 2; break;
+		case EINTR: linux_error = 4; break;
+		case EIO: linux_error = 5; break;
+		case E2BIG: linux_error = 7; break;
+		case EBADF: linux_error = 9; break;
+		case EAGAIN: linux_error = 11; break;
+		case ENOMEM: linux_error = 12; break;
+		case EACCES: linux_error = 13; break;
+		case EFAULT: linux_error = 14; break;
+		case EBUSY: linux_error = 16; break;
+		case EEXIST: linux_error = 17; break;
+		case ENOTDIR: linux_error = 20; break;
+		case EISDIR: linux_error = 21; break;
+		case EINVAL: linux_error = 22; break;
+		case ENFILE: linux_error = 23; break;
+		case EMFILE: linux_error = 24; break;
+		case ENOTTY: linux_error = 25; break;
+		case EFBIG: linux_error = 27; break;
+		case ENOSPC: linux_error = 28; break;
+		case ESPIPE: linux_error = 29; break;
+		case EROFS: linux_error = 30; break;
+		case EPIPE: linux_error = 32; break;
+		case ERANGE: linux_error = 34; break;
+		case ENAMETOOLONG: linux_error = 36; break;
+		case ENOSYS: linux_error = 38; break;
+		case ENOTEMPTY: linux_error = 39; break;
+		case EOVERFLOW: linux_error = 75; break;
+		case ENOTSUP: linux_error = 95; break;
+		default: linux_error = 5; break;
+	}
+	return (uint32_t)-linux_error;
+}
+
+static void rea32_store_linux_word(void* address, uint32_t value)
+{
+	uint8_t* bytes = (uint8_t*)address;
+	bytes[0] = (uint8_t)value;
+	bytes[1] = (uint8_t)(value >> 8);
+	bytes[2] = (uint8_t)(value >> 16);
+	bytes[3] = (uint8_t)(value >> 24);
+}
+
+static void rea32_store_linux_double_word(void* address, uint64_t value)
+{
+	rea32_store_linux_word(address, (uint32_t)value);
+	rea32_store_linux_word((void*)((uintptr_t)address + 4), (uint32_t)(value >> 32));
+}
+
+static uint32_t rea32_load_linux_word(const void* address)
+{
+	const uint8_t* bytes = (const uint8_t*)address;
+	return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static int rea32_write_linux_data(rel32_linux_process_t* process, uint32_t address, uint32_t size, const void* data)
+{
+	void* host_address;
+	int error = rel32i_get_host_address(process->hart, address, size, REL32I_ACCESS_WRITE, &host_address);
+	if (error)
+		return EFAULT;
+	memcpy(host_address, data, size);
+	rel32i_invalidate_code(process->hart, address, size);
+	return 0;
+}
+
+static int rea32_read_linux_string(rel32_linux_process_t* process, uint32_t address, size_t buffer_size, char* buffer)
+{
+	// the string may end anywhere, so it is looked up one page at a time
+	for (size_t length = 0; length != buffer_size;)
+	{
+		uint32_t chunk_size = REA32_LINUX_PAGE_SIZE - (address & (REA32_LINUX_PAGE_SIZE - 1));
+		if (chunk_size > buffer_size - length)
+			chunk_size = (uint32_t)(buffer_size - length);
+		void* host_address;
+		if (rel32i_get_host_address(process->hart, address, chunk_size, REL32I_ACCESS_READ, &host_address))
+			return EFAULT;
+		const char* end = (const char*)memchr(host_address, 0, chunk_size);
+		size_t copy_size = end ? (size_t)((uintptr_t)end - (uintptr_t)host_address) + 1 : (size_t)chunk_size;
+		memcpy(buffer + length, host_address, copy_size);
+		if (end)
+			return 0;
+		length += copy_size;
+		address += chunk_size;
+	}
+	return ENAMETOOLONG;
+}
+
+static void* rea32_get_linux_area_host_address(rel32_linux_process_t* process, uint32_t address)
+{
+	if (!process->hart->memory)
+		return process->hart->address_space->base_address + address;
+	if (address - process->heap_address < process->heap_size)
+		return (void*)((uintptr_t)process->heap_host_address + (uintptr_t)(address - process->heap_address));
+	return (void*)((uintptr_t)process->mapping_area_host_address + (uintptr_t)(address - process->mapping_area_address));
+}
+
+// page aligned ranges inside the heap or the mapping area only
+static int rea32_set_linux_memory_access(rel32_linux_process_t* process, uint32_t address, uint32_t size, int access)
+{
+	if (!size)
+		return 0;
+	if (process->hart->memory)
+	{
+		if (!access)
+			return rel32i_unmap_memory(process->hart->memory, address, size);
+		return rel32i_map_memory(process->hart->memory, address, size, REL32I_MEMORY_RAM, access, rea32_get_linux_area_host_address(process, address));
+	}
+	return rel32i_commit_address_space(process->hart->address_space, address, size, access);
+}
+
+// released memory is cleared before it goes, so whatever maps it again starts from zero like fresh anonymous pages
+static int rea32_release_linux_memory(rel32_linux_process_t* process, uint32_t address, uint32_t size)
+{
+	int error = rea32_set_linux_memory_access(process, address, size, REL32I_ACCESS_READ | REL32I_ACCESS_WRITE);
+	if (error)
+		return error;
+	memset(rea32_get_linux_area_host_address(process, address), 0, size);
+	rel32i_invalidate_code(process->hart, address, size);
+	return rea32_set_linux_memory_access(process, address, size, 0);
+}
+
+size_t rea32_get_linux_leaf_table_count(uint32_t heap_address, uint32_t heap_size, uint32_t mapping_area_address, uint32_t mapping_area_size)
+{
+	const uint64_t leaf_size = REL32I_MEMORY_PAGE_SIZE * REL32I_MEMORY_LEAF_PAGE_COUNT;
+	size_t leaf_table_count = 0;
+	if (heap_size)
+		leaf_table_count += (size_t)(((uint64_t)heap_address + (uint64_t)heap_size + (leaf_size - 1)) / leaf_size - (uint64_t)heap_address / leaf_size);
+	if (mapping_area_size)
+		leaf_table_count += (size_t)(((uint64_t)mapping_area_address + (uint64_t)mapping_area_size + (leaf_size - 1)) / leaf_size - (uint64_t)mapping_area_address / leaf_size);
+	return leaf_table_count;
+}
+
+int rea32_create_linux_process(rel32i_hart_t* hart, uint32_t heap_address, uint32_t heap_size, uint32_t mapping_area_address, uint32_t mapping_area_size, rel32_linux_process_t** pointer_to_process)
+{
+	if (((heap_address | heap_size | mapping_area_address | mapping_area_size) & (REA32_LINUX_PAGE_SIZE - 1)) ||
+		(uint64_t)heap_address + (uint64_t)heap_size > ((uint64_t)1 << 32) || (uint64_t)mapping_area_address + (uint64_t)mapping_area_size > ((uint64_t)1 << 32))
+		return EINVAL;
+	if (!hart->memory && !hart->address_space)
+		return ENOTSUP;
+
+	rel32_linux_process_t* process = (rel32_linux_process_t*)malloc(sizeof(rel32_linux_process_t));
+	if (!process)
+		return ENOMEM;
+	process->hart = hart;
+	process->heap_address = heap_address;
+	process->heap_size = heap_size;
+	process->program_break = heap_address;
+	process->mapping_area_address = mapping_area_address;
+	process->mapping_area_size = mapping_area_size;
+	process->mapping_count = 0;
+	process->heap_host_address = 0;
+	process->mapping_area_host_address = 0;
+	process->start_time = rea_get_monotonic_time();
+	process->exit_code = 0;
+
+	if (hart->memory)
+	{
+		// large zeroed allocations are left untouched by the host until the guest uses them
+		process->heap_host_address = heap_size ? calloc(1, (size_t)heap_size) : 0;
+		process->mapping_area_host_address = mapping_area_size ? calloc(1, (size_t)mapping_area_size) : 0;
+		if ((heap_size && !process->heap_host_address) || (mapping_area_size && !process->mapping_area_host_address))
+		{
+			rea32_destroy_linux_process(process);
+			return ENOMEM;
+		}
+	}
+
+	*pointer_to_process = process;
+	return 0;
+}
+
+void rea32_destroy_linux_process(rel32_linux_process_t* process)
+{
+	free(process->heap_host_address);
+	free(process->mapping_area_host_address);
+	free(process);
+}
+
+int rea32_push_linux_arguments(rel32_linux_process_t* process, size_t argument_count, const char* const* argument_table, size_t environment_count, const char* const* environment_table, uint32_t program_header_address, size_t program_header_count, size_t program_header_size, uint32_t entry_point)
+{
+	static const uint8_t random_bytes[16] = { 0x52, 0x45, 0x41, 0x33, 0x32, 0x2D, 0x72, 0x61, 0x6E, 0x64, 0x6F, 0x6D, 0x2D, 0x69, 0x76, 0x21 };
+	uint32_t stack_pointer = process->hart->register_set->x1_x31[1];
+
+	uint64_t string_size = sizeof(random_bytes);
+	for (size_t i = 0; i != argument_count; ++i)
+		string_size += (uint64_t)strlen(argument_table[i]) + 1;
+	for (size_t i = 0; i != environment_count; ++i)
+		string_size += (uint64_t)strlen(environment_table[i]) + 1;
+
+	uint32_t auxiliary_table[REA32_LINUX_MAX_AUXILIARY_COUNT * 2];
+	size_t auxiliary_count = 0;
+#define REA32_LINUX_PUSH_AUXILIARY(type, value) do { auxiliary_table[auxiliary_count * 2] = (type); auxiliary_table[auxiliary_count * 2 + 1] = (uint32_t)(value); ++auxiliary_count; } while (0)
+	if (program_header_address)
+	{
+		REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_PHDR, program_header_address);
+		REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_PHENT, program_header_size);
+		REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_PHNUM, program_header_count);
+	}
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_PAGESZ, REA32_LINUX_PAGE_SIZE);
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_ENTRY, entry_point);
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_UID, 0);
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_EUID, 0);
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_GID, 0);
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_EGID, 0);
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_HWCAP, REA32_LINUX_HWCAP_I);
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_CLKTCK, REA32_LINUX_CLOCK_TICKS_PER_SECOND);
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_SECURE, 0);
+	size_t random_auxiliary_index = auxiliary_count;
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_RANDOM, 0);
+	size_t file_name_auxiliary_index = auxiliary_count;
+	if (argument_count)
+		REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_EXECFN, 0);
+	REA32_LINUX_PUSH_AUXILIARY(REA32_LINUX_AT_NULL, 0);
+#undef REA32_LINUX_PUSH_AUXILIARY
+
+	uint64_t vector_size = ((uint64_t)1 + (uint64_t)argument_count + 1 + (uint64_t)environment_count + 1 + (uint64_t)auxiliary_count * 2) * 4;
+	uint64_t total_size = ((string_size + 3) & ~(uint64_t)3) + vector_size;
+	if (total_size + 0xF > (uint64_t)stack_pointer)
+		return E2BIG;
+	uint32_t argument_count_address = (uint32_t)(((uint64_t)stack_pointer - total_size) & ~(uint64_t)0xF);
+	uint32_t size = stack_pointer - argument_count_address;
+	void* host_stack;
+	if (rel32i_get_host_address(process->hart, argument_count_address, size, REL32I_ACCESS_WRITE, &host_stack))
+		return E2BIG;
+
+	uint8_t* vector = (uint8_t*)host_stack;
+	uint32_t string_address = argument_count_address + (uint32_t)vector_size;
+	uint8_t* string = vector + vector_size;
+	rea32_store_linux_word(vector, (uint32_t)argument_count);
+	vector += 4;
+	for (size_t i = 0; i != argument_count; ++i, vector += 4)
+	{
+		size_t length = strlen(argument_table[i]);
+		memcpy(string, argument_table[i], length + 1);
+		rea32_store_linux_word(vector, string_address);
+		if (!i)
+			auxiliary_table[file_name_auxiliary_index * 2 + 1] = string_address;
+		string += length + 1;
+		string_address += (uint32_t)length + 1;
+	}
+	rea32_store_linux_word(vector, 0);
+	vector += 4;
+	for (size_t i = 0; i != environment_count; ++i, vector += 4)
+	{
+		size_t length = strlen(environment_table[i]);
+		memcpy(string, environment_table[i], length + 1);
+		rea32_store_linux_word(vector, string_address);
+		string += length + 1;
+		string_address += (uint32_t)length + 1;
+	}
+	rea32_store_linux_word(vector, 0);
+	vector += 4;
+	memcpy(string, random_bytes, sizeof(random_bytes));
+	auxiliary_table[random_auxiliary_index * 2 + 1] = string_address;
+	for (size_t i = 0; i != auxiliary_count * 2; ++i, vector += 4)
+		rea32_store_linux_word(vector, auxiliary_table[i]);
+
+	rel32i_invalidate_code(process->hart, argument_count_address, size);
+	process->hart->register_set->x1_x31[1] = argument_count_address;
+	return 0;
+}
+
+static int rea32_transfer_linux_data(rel32_linux_process_t* process, int write, uint32_t file_descriptor, uint32_t address, uint32_t size, uint32_t* transferred_size)
+{
+	void* host_address;
+	if (rel32i_get_host_address(process->hart, address, size, write ? REL32I_ACCESS_READ : REL32I_ACCESS_WRITE, &host_address))
+		return EFAULT;
+	if (write)
+		return rea_write_host_file((int)file_descriptor, host_address, size, transferred_size);
+	int error = rea_read_host_file((int)file_descriptor, host_address, size, transferred_size);
+	if (!error)
+		rel32i_invalidate_code(process->hart, address, *transferred_size);
+	return error;
+}
+
+static int rea32_transfer_linux_vector(rel32_linux_process_t* process, int write, const uint32_t* argument_table, uint32_t* result)
+{
+	uint32_t vector_count = argument_table[2];
+	if (vector_count > REA32_LINUX_MAX_IOVEC_COUNT)
+		return EINVAL;
+	void* host_vector;
+	if (rel32i_get_host_address(process->hart, argument_table[1], vector_count * 8, REL32I_ACCESS_READ, &host_vector))
+		return EFAULT;
+
+	// like the kernel, a failure after some data went through reports what went through
+	uint32_t total_size = 0;
+	for (uint32_t i = 0; i != vector_count; ++i)
+	{
+		uint32_t size = rea32_load_linux_word((const uint8_t*)host_vector + i * 8 + 4);
+		uint32_t transferred_size = 0;
+		int error = size ? rea32_transfer_linux_data(process, write, argument_table[0], rea32_load_linux_word((const uint8_t*)host_vector + i * 8), size, &transferred_size) : 0;
+		if (error && !total_size)
+			return error;
+		total_size += transferred_size;
+		if (error || transferred_size != size)
+			break;
+	}
+	*result = total_size;
+	return 0;
+}
+
+static int rea32_open_linux_file(rel32_linux_process_t* process, uint32_t directory, uint32_t path_address, uint32_t flags, uint32_t mode, uint32_t* result)
+{
+	char path[REA32_LINUX_MAX_PATH_SIZE];
+	int error = rea32_read_linux_string(process, path_address, sizeof(path), path);
+	if (error)
+		return error;
+	if (directory != REA32_LINUX_AT_FDCWD && path[0] != '/')
+		return ENOTSUP;
+	static const int access_table[4] = { REA_OPEN_READ, REA_OPEN_WRITE, REA_OPEN_READ | REA_OPEN_WRITE, REA_OPEN_READ | REA_OPEN_WRITE };
+	int open_flags = access_table[flags & REA32_LINUX_O_ACCMODE] |
+		((flags & REA32_LINUX_O_CREAT) ? REA_OPEN_CREATE : 0) | ((flags & REA32_LINUX_O_EXCL) ? REA_OPEN_EXCLUSIVE : 0) |
+		((flags & REA32_LINUX_O_TRUNC) ? REA_OPEN_TRUNCATE : 0) | ((flags & REA32_LINUX_O_APPEND) ? REA_OPEN_APPEND : 0);
+	int file_descriptor = -1;
+	error = rea_open_host_file(path, open_flags, mode, &file_descriptor);
+	if (!error)
+		*result = (uint32_t)file_descriptor;
+	return error;
+}
+
+static int rea32_get_linux_file_status(rel32_linux_process_t* process, uint32_t directory, uint32_t path_address, uint32_t flags, rel32_file_status_t* status)
+{
+	char path[REA32_LINUX_MAX_PATH_SIZE];
+	int error = rea32_read_linux_string(process, path_address, sizeof(path), path);
+	if (error)
+		return error;
+	if (!path[0] && (flags & REA32_LINUX_AT_EMPTY_PATH))
+		return rea_get_host_file_status((int)directory, status);
+	if (directory != REA32_LINUX_AT_FDCWD && path[0] != '/')
+		return ENOTSUP;
+	return rea_get_host_path_status(path, status);
+}
+
+// the asm-generic struct stat64 of 32-bit targets
+static int rea32_write_linux_stat64(rel32_linux_process_t* process, uint32_t address, const rel32_file_status_t* status)
+{
+	uint8_t stat64[REA32_LINUX_STAT64_SIZE];
+	memset(stat64, 0, sizeof(stat64));
+	rea32_store_linux_double_word(stat64, status->device);
+	rea32_store_linux_double_word(stat64 + 8, status->inode);
+	rea32_store_linux_word(stat64 + 16, status->mode);
+	rea32_store_linux_word(stat64 + 20, status->link_count);
+	rea32_store_linux_double_word(stat64 + 48, status->size);
+	rea32_store_linux_word(stat64 + 56, REA32_LINUX_PAGE_SIZE);
+	rea32_store_linux_double_word(stat64 + 64, (status->size + 511) / 512);
+	rea32_store_linux_word(stat64 + 72, (uint32_t)status->access_time);
+	rea32_store_linux_word(stat64 + 80, (uint32_t)status->modification_time);
+	rea32_store_linux_word(stat64 + 88, (uint32_t)status->change_time);
+	return rea32_write_linux_data(process, address, sizeof(stat64), stat64);
+}
+
+static int rea32_write_linux_statx(rel32_linux_process_t* process, uint32_t address, const rel32_file_status_t* status)
+{
+	uint8_t statx[REA32_LINUX_STATX_SIZE];
+	memset(statx, 0, sizeof(statx));
+	rea32_store_linux_word(statx, REA32_LINUX_STATX_BASIC_STATS);
+	rea32_store_linux_word(statx + 4, REA32_LINUX_PAGE_SIZE);
+	rea32_store_linux_word(statx + 16, status->link_count);
+	statx[28] = (uint8_t)status->mode;
+	statx[29] = (uint8_t)(status->mode >> 8);
+	rea32_store_linux_double_word(statx + 32, status->inode);
+	rea32_store_linux_double_word(statx + 40, status->size);
+	rea32_store_linux_double_word(statx + 48, (status->size + 511) / 512);
+	rea32_store_linux_double_word(statx + 64, (uint64_t)status->access_time);
+	rea32_store_linux_double_word(statx + 96, (uint64_t)status->change_time);
+	rea32_store_linux_double_word(statx + 112, (uint64_t)status->modification_time);
+	rea32_store_linux_word(statx + 136, (uint32_t)(status->device >> 8));
+	rea32_store_linux_word(statx + 140, (uint32_t)(status->device & 0xFF));
+	return rea32_write_linux_data(process, address, sizeof(statx), statx);
+}
+
+static int rea32_get_linux_time(rel32_linux_process_t* process, uint32_t clock, int64_t* seconds, uint32_t* nanoseconds)
+{
+	if (clock > REA32_LINUX_CLOCK_TAI)
+		return EINVAL;
+	if (clock == REA32_LINUX_CLOCK_REALTIME || clock == REA32_LINUX_CLOCK_REALTIME_COARSE || clock == REA32_LINUX_CLOCK_TAI)
+	{
+		rea_get_real_time(seconds, nanoseconds);
+		return 0;
+	}
+	// the guest is the only thread of the process, so its CPU time is taken to be the time it has been running
+	uint64_t time = rea_get_monotonic_time();
+	if (clock == REA32_LINUX_CLOCK_PROCESS_CPUTIME_ID || clock == REA32_LINUX_CLOCK_THREAD_CPUTIME_ID)
+		time -= process->start_time;
+	*seconds = (int64_t)(time / 1000000000);
+	*nanoseconds = (uint32_t)(time % 1000000000);
+	return 0;
+}
+
+static int rea32_find_linux_mapping_space(rel32_linux_process_t* process, uint32_t size, uint32_t* address)
+{
+	uint64_t free_address = process->mapping_area_address;
+	for (size_t i = 0; i <= process->mapping_count; ++i)
+	{
+		uint64_t free_end = (i != process->mapping_count) ? (uint64_t)process->mapping_table[i].address : (uint64_t)process->mapping_area_address + (uint64_t)process->mapping_area_size;
+		if (free_end - free_address >= (uint64_t)size)
+		{
+			*address = (uint32_t)free_address;
+			return 0;
+		}
+		if (i != process->mapping_count)
+			free_address = (uint64_t)process->mapping_table[i].address + (uint64_t)process->mapping_table[i].size;
+	}
+	return ENOMEM;
+}
+
+static int rea32_unmap_linux_memory(rel32_linux_process_t* process, uint32_t address, uint32_t size)
+{
+	uint64_t end = (uint64_t)address + (uint64_t)size;
+	size_t split_count = 0;
+	for (size_t i = 0; i != process->mapping_count; ++i)
+		if (process->mapping_table[i].address < address && (uint64_t)process->mapping_table[i].address + (uint64_t)process->mapping_table[i].size > end)
+			++split_count;
+	if (process->mapping_count + split_count > REA32_LINUX_MAX_MAPPING_COUNT)
+		return ENOMEM;
+
+	for (size_t i = 0; i != process->mapping_count;)
+	{
+		rel32_linux_mapping_t* mapping = process->mapping_table + i;
+		uint64_t mapping_end = (uint64_t)mapping->address + (uint64_t)mapping->size;
+		uint32_t release_address = (mapping->address > address) ? mapping->address : address;
+		uint64_t release_end = (mapping_end < end) ? mapping_end : end;
+		if (release_end <= (uint64_t)release_address)
+		{
+			++i;
+			continue;
+		}
+
+		uint32_t release_size = (uint32_t)(release_end - (uint64_t)release_address);
+		int error = rea32_release_linux_memory(process, release_address, release_size);
+		if (error)
+			return error;
+		if (release_address == mapping->address && release_end == mapping_end)
+		{
+			memmove(mapping, mapping + 1, (process->mapping_count - i - 1) * sizeof(rel32_linux_mapping_t));
+			--process->mapping_count;
+			continue;
+		}
+		if (release_address != mapping->address && release_end != mapping_end)
+		{
+			memmove(mapping + 1, mapping, (process->mapping_count - i) * sizeof(rel32_linux_mapping_t));
+			++process->mapping_count;
+			mapping[1].address = (uint32_t)release_end;
+			mapping[1].size = (uint32_t)(mapping_end - release_end);
+			++i;
+		}
+		if (release_address == mapping->address)
+		{
+			mapping->address = (uint32_t)release_end;
+			mapping->size = (uint32_t)(mapping_end - release_end);
+		}
+		else
+			mapping->size = release_address - mapping->address;
+		++i;
+	}
+	return 0;
+}
+
+static int rea32_map_linux_memory(rel32_linux_process_t* process, const uint32_t* argument_table, uint32_t* result)
+{
+	uint32_t address = argument_table[0];
+	uint32_t length = argument_table[1];
+	int access = (int)(argument_table[2] & (REL32I_ACCESS_READ | REL32I_ACCESS_WRITE | REL32I_ACCESS_EXECUTE));
+	uint32_t flags = argument_table[3];
+	uint32_t size = (length + (REA32_LINUX_PAGE_SIZE - 1)) & ~(uint32_t)(REA32_LINUX_PAGE_SIZE - 1);
+	if (!length || !size)
+		return EINVAL;
+
+	if (flags & REA32_LINUX_MAP_FIXED)
+	{
+		if ((address & (REA32_LINUX_PAGE_SIZE - 1)) || address < process->mapping_area_address || (uint64_t)address + (uint64_t)size > (uint64_t)process->mapping_area_address + (uint64_t)process->mapping_area_size)
+			return ENOMEM;
+		int error = rea32_unmap_linux_memory(process, address, size);
+		if (error)
+			return error;
+	}
+	else if (rea32_find_linux_mapping_space(process, size, &address))
+		return ENOMEM;
+	if (process->mapping_count == REA32_LINUX_MAX_MAPPING_COUNT)
+		return ENOMEM;
+
+	int error = rea32_set_linux_memory_access(process, address, size, REL32I_ACCESS_READ | REL32I_ACCESS_WRITE);
+	if (error)
+		return ENOMEM;
+	if (!(flags & REA32_LINUX_MAP_ANONYMOUS))
+	{
+		// a private copy of the file, shared mappings see no later writes to the file
+		int file_descriptor = (int)argument_table[4];
+		int64_t position = 0;
+		int64_t offset = (int64_t)argument_table[5] * REA32_LINUX_PAGE_SIZE;
+		uint32_t transferred_size = 0;
+		error = rea_seek_host_file(file_descriptor, 0, REA_SEEK_CURRENT, &position);
+		if (!error)
+			error = rea_seek_host_file(file_descriptor, offset, REA_SEEK_SET, &offset);
+		for (uint32_t mapped_size = 0; !error && mapped_size != length; mapped_size += transferred_size)
+		{
+			error = rea_read_host_file(file_descriptor, (uint8_t*)rea32_get_linux_area_host_address(process, address) + mapped_size, length - mapped_size, &transferred_size);
+			if (!transferred_size)
+				break;
+		}
+		if (!error)
+			error = rea_seek_host_file(file_descriptor, position, REA_SEEK_SET, &position);
+		if (error)
+		{
+			rea32_release_linux_memory(process, address, size);
+			return error;
+		}
+		rel32i_invalidate_code(process->hart, address, size);
+	}
+	if (access != (REL32I_ACCESS_READ | REL32I_ACCESS_WRITE))
+		rea32_set_linux_memory_access(process, address, size, access);
+
+	size_t index = 0;
+	while (index != process->mapping_count && process->mapping_table[index].address < address)
+		++index;
+	memmove(process->mapping_table + index + 1, process->mapping_table + index, (process->mapping_count - index) * sizeof(rel32_linux_mapping_t));
+	process->mapping_table[index].address = address;
+	process->mapping_table[index].size = size;
+	++process->mapping_count;
+	*result = address;
+	return 0;
+}
+
+static uint32_t rea32_set_linux_program_break(rel32_linux_process_t* process, uint32_t program_break)
+{
+	if (program_break < process->heap_address || program_break - process->heap_address > process->heap_size)
+		return process->program_break;
+
+	uint32_t end = (process->program_break + (REA32_LINUX_PAGE_SIZE - 1)) & ~(uint32_t)(REA32_LINUX_PAGE_SIZE - 1);
+	uint32_t new_end = (program_break + (REA32_LINUX_PAGE_SIZE - 1)) & ~(uint32_t)(REA32_LINUX_PAGE_SIZE - 1);
+	if (new_end > end && rea32_set_linux_memory_access(process, end, new_end - end, REL32I_ACCESS_READ | REL32I_ACCESS_WRITE))
+		return process->program_break;
+	if (program_break < process->program_break)
+	{
+		memset(rea32_get_linux_area_host_address(process, program_break), 0, end - program_break);
+		rel32i_invalidate_code(process->hart, program_break, end - program_break);
+		if (new_end != end)
+			rea32_set_linux_memory_access(process, new_end, end - new_end, 0);
+	}
+	process->program_break = program_break;
+	return program_break;
+}
+
+static void rea32_store_linux_name(uint8_t* field, const char* name)
+{
+	memcpy(field, name, strlen(name) + 1);
+}
+
+int rea32_handle_linux_system_call(rel32_linux_process_t* process)
+{
+	rel32i_register_set_t* register_set = process->hart->register_set;
+	// a0 to a7 are x10 to x17
+	uint32_t* argument_table = register_set->x1_x31 + 9;
+	uint32_t result = 0;
+	int error = 0;
+	switch (argument_table[7])
+	{
+		case REA32_LINUX_SYS_EXIT:
+		case REA32_LINUX_SYS_EXIT_GROUP:
+			process->exit_code = (int)(argument_table[0] & 0xFF);
+			return 1;
+		case REA32_LINUX_SYS_READ:
+		case REA32_LINUX_SYS_WRITE:
+			error = rea32_transfer_linux_data(process, argument_table[7] == REA32_LINUX_SYS_WRITE, argument_table[0], argument_table[1], argument_table[2], &result);
+			break;
+		case REA32_LINUX_SYS_READV:
+		case REA32_LINUX_SYS_WRITEV:
+			error = rea32_transfer_linux_vector(process, argument_table[7] == REA32_LINUX_SYS_WRITEV, argument_table, &result);
+			break;
+		case REA32_LINUX_SYS_OPENAT:
+			error = rea32_open_linux_file(process, argument_table[0], argument_table[1], argument_table[2], argument_table[3], &result);
+			break;
+		case REA32_LINUX_SYS_OPEN:
+			error = rea32_open_linux_file(process, REA32_LINUX_AT_FDCWD, argument_table[0], argument_table[1], argument_table[2], &result);
+			break;
+		case REA32_LINUX_SYS_CLOSE:
+			// the standard streams are shared with the emulator
+			if (argument_table[0] > 2)
+				error = rea_close_host_file((int)argument_table[0]);
+			break;
+		case REA32_LINUX_SYS_LSEEK:
+		{
+			// _llseek(fd, offset_high, offset_low, result, whence) on RV32, a null result pointer means libgloss's lseek(fd, offset, whence)
+			int64_t position = 0;
+			if (argument_table[3])
+			{
+				uint8_t position_data[8];
+				error = rea_seek_host_file((int)argument_table[0], (int64_t)(((uint64_t)argument_table[1] << 32) | (uint64_t)argument_table[2]), (int)argument_table[4], &position);
+				if (!error)
+				{
+					rea32_store_linux_double_word(position_data, (uint64_t)position);
+					error = rea32_write_linux_data(process, argument_table[3], sizeof(position_data), position_data);
+				}
+			}
+			else
+			{
+				error = rea_seek_host_file((int)argument_table[0], (int64_t)(int32_t)argument_table[1], (int)argument_table[2], &position);
+				if (!error && (position < 0 || position > INT32_MAX))
+					error = EOVERFLOW;
+				result = (uint32_t)position;
+			}
+			break;
+		}
+		case REA32_LINUX_SYS_FSTAT:
+		{
+			rel32_file_status_t status;
+			error = rea_get_host_file_status((int)argument_table[0], &status);
+			if (!error)
+				error = rea32_write_linux_stat64(process, argument_table[1], &status);
+			break;
+		}
+		case REA32_LINUX_SYS_FSTATAT:
+		{
+			rel32_file_status_t status;
+			error = rea32_get_linux_file_status(process, argument_table[0], argument_table[1], argument_table[3], &status);
+			if (!error)
+				error = rea32_write_linux_stat64(process, argument_table[2], &status);
+			break;
+		}
+		case REA32_LINUX_SYS_STATX:
+		{
+			rel32_file_status_t status;
+			error = rea32_get_linux_file_status(process, argument_table[0], argument_table[1], argument_table[2], &status);
+			if (!error)
+				error = rea32_write_linux_statx(process, argument_table[4], &status);
+			break;
+		}
+		case REA32_LINUX_SYS_IOCTL:
+			// only the terminal size query stdio makes to pick line buffering
+			if (argument_table[1] == REA32_LINUX_TIOCGWINSZ && rea_is_host_terminal((int)argument_table[0]))
+			{
+				static const uint8_t window_size[8] = { 24, 0, 80, 0, 0, 0, 0, 0 };
+				error = rea32_write_linux_data(process, argument_table[2], sizeof(window_size), window_size);
+			}
+			else
+				error = ENOTTY;
+			break;
+		case REA32_LINUX_SYS_CLOCK_GETTIME:
+		case REA32_LINUX_SYS_CLOCK_GETTIME64:
+		{
+			int64_t seconds;
+			uint32_t nanoseconds;
+			error = rea32_get_linux_time(process, argument_table[0], &seconds, &nanoseconds);
+			if (!error)
+			{
+				uint8_t time[16];
+				size_t time_size = 16;
+				if (argument_table[7] == REA32_LINUX_SYS_CLOCK_GETTIME64)
+				{
+					rea32_store_linux_double_word(time, (uint64_t)seconds);
+					rea32_store_linux_double_word(time + 8, (uint64_t)nanoseconds);
+				}
+				else
+				{
+					rea32_store_linux_word(time, (uint32_t)seconds);
+					rea32_store_linux_word(time + 4, nanoseconds);
+					time_size = 8;
+				}
+				error = rea32_write_linux_data(process, argument_table[1], (uint32_t)time_size, time);
+			}
+			break;
+		}
+		case REA32_LINUX_SYS_GETTIMEOFDAY:
+		{
+			int64_t seconds;
+			uint32_t nanoseconds;
+			uint8_t time[8];
+			rea_get_real_time(&seconds, &nanoseconds);
+			rea32_store_linux_word(time, (uint32_t)seconds);
+			rea32_store_linux_word(time + 4, nanoseconds / 1000);
+			if (argument_table[0])
+				error = rea32_write_linux_data(process, argument_table[0], sizeof(time), time);
+			memset(time, 0, sizeof(time));
+			if (!error && argument_table[1])
+				error = rea32_write_linux_data(process, argument_table[1], sizeof(time), time);
+			break;
+		}
+		case REA32_LINUX_SYS_TIMES:
+		{
+			uint32_t ticks = (uint32_t)((rea_get_monotonic_time() - process->start_time) / (1000000000 / REA32_LINUX_CLOCK_TICKS_PER_SECOND));
+			uint8_t times[16];
+			memset(times, 0, sizeof(times));
+			rea32_store_linux_word(times, ticks);
+			if (argument_table[0])
+				error = rea32_write_linux_data(process, argument_table[0], sizeof(times), times);
+			result = ticks;
+			break;
+		}
+		case REA32_LINUX_SYS_UNAME:
+		{
+			uint8_t name[REA32_LINUX_UTSNAME_FIELD_SIZE * 6];
+			memset(name, 0, sizeof(name));
+			rea32_store_linux_name(name, "Linux");
+			rea32_store_linux_name(name + REA32_LINUX_UTSNAME_FIELD_SIZE, "rea");
+			rea32_store_linux_name(name + REA32_LINUX_UTSNAME_FIELD_SIZE * 2, "6.1.0");
+			rea32_store_linux_name(name + REA32_LINUX_UTSNAME_FIELD_SIZE * 3, "#1");
+			rea32_store_linux_name(name + REA32_LINUX_UTSNAME_FIELD_SIZE * 4, "riscv32");
+			rea32_store_linux_name(name + REA32_LINUX_UTSNAME_FIELD_SIZE * 5, "(none)");
+			error = rea32_write_linux_data(process, argument_table[0], sizeof(name), name);
+			break;
+		}
+		case REA32_LINUX_SYS_RT_SIGACTION:
+		case REA32_LINUX_SYS_RT_SIGPROCMASK:
+		{
+			// signals are never delivered, so every handler and mask reads back as the default
+			uint8_t old_value[8 + REA32_LINUX_SIGSET_SIZE];
+			memset(old_value, 0, sizeof(old_value));
+			if (argument_table[3] != REA32_LINUX_SIGSET_SIZE)
+				error = EINVAL;
+			else if (argument_table[2])
+				error = rea32_write_linux_data(process, argument_table[2], (argument_table[7] == REA32_LINUX_SYS_RT_SIGACTION) ? (uint32_t)sizeof(old_value) : REA32_LINUX_SIGSET_SIZE, old_value);
+			break;
+		}
+		case REA32_LINUX_SYS_SET_TID_ADDRESS:
+		case REA32_LINUX_SYS_GETPID:
+		case REA32_LINUX_SYS_GETTID:
+			result = 1;
+			break;
+		case REA32_LINUX_SYS_SET_ROBUST_LIST:
+		case REA32_LINUX_SYS_GETPPID:
+		case REA32_LINUX_SYS_GETUID:
+		case REA32_LINUX_SYS_GETEUID:
+		case REA32_LINUX_SYS_GETGID:
+		case REA32_LINUX_SYS_GETEGID:
+		case REA32_LINUX_SYS_MPROTECT:
+		case REA32_LINUX_SYS_MADVISE:
+			break;
+		case REA32_LINUX_SYS_BRK:
+			result = rea32_set_linux_program_break(process, argument_table[0]);
+			break;
+		case REA32_LINUX_SYS_MMAP2:
+			error = rea32_map_linux_memory(process, argument_table, &result);
+			break;
+		case REA32_LINUX_SYS_MUNMAP:
+			if (argument_table[0] & (REA32_LINUX_PAGE_SIZE - 1))
+				error = EINVAL;
+			else
+				error = rea32_unmap_linux_memory(process, argument_table[0], (argument_table[1] + (REA32_LINUX_PAGE_SIZE - 1)) & ~(uint32_t)(REA32_LINUX_PAGE_SIZE - 1));
+			break;
+		default:
+			error = ENOSYS;
+			break;
+	}
+
+	argument_table[0] = error ? rea32_get_linux_error(error) : result;
+	register_set->pc += 4;
+	return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef REL_RISC_V_APPLICATION_LINUX_H
+#define REL_RISC_V_APPLICATION_LINUX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include "rel_risc_v_emulator.h"
+#include "rea_file.h"
+
+#define REA32_LINUX_MAX_MAPPING_COUNT 256
+#define REA32_LINUX_MAX_PATH_SIZE REA_MAX_HOST_PATH_SIZE
+
+typedef struct rel32_linux_mapping_t
+{
+	uint32_t address;
+	uint32_t size;
+} rel32_linux_mapping_t;
+
+typedef struct rel32_linux_process_t
+{
+	rel32i_hart_t* hart;
+	uint32_t heap_address;
+	uint32_t heap_size;
+	uint32_t program_break;
+	uint32_t mapping_area_address;
+	uint32_t mapping_area_size;
+	size_t mapping_count;
+	rel32_linux_mapping_t mapping_table[REA32_LINUX_MAX_MAPPING_COUNT];
+	void* heap_host_address;
+	void* mapping_area_host_address;
+	uint64_t start_time;
+	int exit_code;
+} rel32_linux_process_t;
+
+// Number of leaf tables a rel32i_memory_t needs on top of the image to back the heap and the mapping area.
+size_t rea32_get_linux_leaf_table_count(uint32_t heap_address, uint32_t heap_size, uint32_t mapping_area_address, uint32_t mapping_area_size);
+
+// brk grows from heap_address and mmap takes pages from the mapping area. Nothing there is accessible until the guest asks for it.
+// With a memory map attached to the hart, the host memory behind both ranges is allocated here.
+int rea32_create_linux_process(rel32i_hart_t* hart, uint32_t heap_address, uint32_t heap_size, uint32_t mapping_area_address, uint32_t mapping_area_size, rel32_linux_process_t** pointer_to_process);
+
+void rea32_destroy_linux_process(rel32_linux_process_t* process);
+
+// Pushes the strings, argv, envp and auxiliary vector below sp the way Linux starts a static executable and leaves sp pointing to argc.
+// A program_header_address of 0 leaves AT_PHDR out.
+int rea32_push_linux_arguments(rel32_linux_process_t* process, size_t argument_count, const char* const* argument_table, size_t environment_count, const char* const* environment_table, uint32_t program_header_address, size_t program_header_count, size_t program_header_size, uint32_t entry_point);
+
+// Services the ecall the hart stopped on with the RV32 Linux system call in a7 and moves pc past it. Errors go back to the guest as negative errno values in a0.
+// Returns nonzero when the guest called exit or exit_group, its status is then in exit_code.
+int rea32_handle_linux_system_call(rel32_linux_process_t* process);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // REL_RISC_V_APPLICATION_LINUX_H
@@ -7,12 +7,39 @@
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "stb_truetype.h"
 
+#define REA_CODE_VIEW_LINE_COUNT 28
+#define REA_CODE_VIEW_LINES_BEFORE_PC 4
+
 int rea_create_emulator_gui(rea_gui_t** gui);
 
+static void rea_update_code_view(rea_gui_t* gui, rel32_disassembly_t* disassembly, uint32_t pc)
+{
+	static char code_view_text[REA_CODE_VIEW_LINE_COUNT * REA32_DISASSEMBLY_MAX_LINE_SIZE + 1];
+
+	// only the lines around the pc are formatted, the rest of the image stays untouched
+	size_t pc_line = 0;
+	rea32_find_disassembly_line(disassembly, pc, &pc_line);
+	size_t first_line = (pc_line > REA_CODE_VIEW_LINES_BEFORE_PC) ? (pc_line - REA_CODE_VIEW_LINES_BEFORE_PC) : 0;
+	size_t line_count = disassembly->line_count - first_line;
+	if (line_count > REA_CODE_VIEW_LINE_COUNT)
+		line_count = REA_CODE_VIEW_LINE_COUNT;
+
+	size_t text_length = 0;
+	if (rea32_get_disassembly_lines(disassembly, first_line, line_count, sizeof(code_view_text) - 1, &text_length, code_view_text))
+		text_length = 0;
+	code_view_text[text_length] = 0;
+	rea_set_window_text(gui, REA_CODE_SEQUENCE_VALUE_WINDOW_ID, code_view_text);
+}
+
 int main(int argc, char** argv)
 {
 	rel32i_register_set_t register_set = { 0 };
 	rel32_binary_t* binary = 0;
+	rel32i_predecode_cache_t* predecode_cache = 0;
+	rel32_elf_t* elf = 0;
+	rel32i_memory_t* memory = 0;
+	uint32_t code_view_pc = 0;
+	int code_view_is_stale = 0;
 	rea_gui_t* gui;
 	int create_error = rea_create_emulator_gui(&gui);
 
@@ -29,26 +56,92 @@ int main(int argc, char** argv)
 					{
 						if (gui->selected_window->id == REA_EXECUTE_BOX_WINDOW_ID)
 						{
-							rel32i_step_instruction(binary->data, 0, &register_set);
+							if (memory)
+							{
+								rel32i_hart_t hart = { 0, 0, &register_set, 0, 0, 0, 0, memory, 0, 0, 0, 0 };
+								uint64_t retired_instruction_count;
+								rel32i_run(&hart, 1, 0, &retired_instruction_count);
+							}
+							else if (binary)
+							{
+								if (predecode_cache)
+									rel32i_step_predecoded_instruction(binary->data, 0, predecode_cache, &register_set);
+								else
+									rel32i_step_instruction(binary->data, 0, &register_set);
+							}
 						}
 						else if (gui->selected_window->id == REA_LOAD_BIN_WINDOW_ID)
 						{
 							rea_window_t* file_window = rea_get_window_by_id(gui, REA_TOP_FILE_BAR_TEXT_BOX_WINDOW_ID);
 							if (file_window && file_window->text)
 							{
+								rel32_elf_t* new_elf;
 								rel32_binary_t* new_binary;
-								if (!rea32_load_binary_file(REA_IGNORE_DIRECTORY, file_window->text, &new_binary))
+								int error = rea32_open_elf_file(REA_IGNORE_DIRECTORY, file_window->text, &new_elf);
+								if (!error)
+								{
+									size_t leaf_table_count = rea32_get_elf_leaf_table_count(new_elf);
+									size_t memory_size = rel32i_get_memory_size(leaf_table_count);
+									void* memory_buffer = malloc(memory_size);
+									rel32i_memory_t* new_memory;
+									if (memory_buffer && !rel32i_create_memory(leaf_table_count, memory_size, memory_buffer, &new_memory) &&
+										!rea32_map_elf_segments(new_elf, new_memory) && !rea32_disassemble_elf_file(new_elf))
+									{
+										if (binary)
+											rea32_close_binary_file(binary);
+										binary = 0;
+										if (predecode_cache)
+											free(predecode_cache);
+										predecode_cache = 0;
+										if (memory)
+											free(memory);
+										memory = new_memory;
+										if (elf)
+											rea32_close_elf_file(elf);
+										elf = new_elf;
+										memset(&register_set, 0, sizeof(rel32i_register_set_t));
+										register_set.pc = elf->entry_point;
+										code_view_is_stale = 1;
+									}
+									else
+									{
+										if (memory_buffer)
+											free(memory_buffer);
+										rea32_close_elf_file(new_elf);
+									}
+								}
+								else if (error == ENOEXEC && !rea32_load_binary_file(REA_IGNORE_DIRECTORY, file_window->text, &new_binary))
 								{
+									if (memory)
+										free(memory);
+									memory = 0;
+									if (elf)
+										rea32_close_elf_file(elf);
+									elf = 0;
 									if (binary)
-										free(binary);
+										rea32_close_binary_file(binary);
 									binary = new_binary;
-									rea_set_window_text(gui, REA_CODE_SEQUENCE_VALUE_WINDOW_ID, binary->disassembly);
+									if (predecode_cache)
+										free(predecode_cache);
+									size_t predecode_cache_size = rel32i_get_predecode_cache_size((uint32_t)binary->size);
+									void* predecode_cache_buffer = malloc(predecode_cache_size);
+									if (!predecode_cache_buffer || rel32i_create_predecode_cache((uint32_t)binary->size, predecode_cache_size, predecode_cache_buffer, &predecode_cache))
+									{
+										if (predecode_cache_buffer)
+											free(predecode_cache_buffer);
+										predecode_cache = 0;
+									}
+									else
+										rel32i_fill_predecode_cache(binary->data, predecode_cache, 0, (uint32_t)binary->size);
+									code_view_is_stale = 1;
 								}
 							}
 						}
 						else if (gui->selected_window->id == REA_RESET_BOX_WINDOW_ID)
 						{
 							memset(&register_set, 0, sizeof(rel32i_register_set_t));
+							if (elf)
+								register_set.pc = elf->entry_point;
 						}
 					}
 					break;
@@ -69,6 +162,14 @@ int main(int argc, char** argv)
 			}
 		}
 
+		rel32_disassembly_t* disassembly = elf ? elf->disassembly : (binary ? binary->disassembly : 0);
+		if (disassembly && (code_view_is_stale || code_view_pc != register_set.pc))
+		{
+			rea_update_code_view(gui, disassembly, register_set.pc);
+			code_view_pc = register_set.pc;
+			code_view_is_stale = 0;
+		}
+
 		switch (rea_get_window_by_id(gui, REA_REGISTER_FORMAT_MENU_WINDOW_ID)->paint_data.selected_item)
 		{
 			case 0:/*hex*/
@@ -112,8 +213,14 @@ int main(int argc, char** argv)
 		gui->frame_timestamp += gui->frame_duration;
 	}
 
+	if (predecode_cache)
+		free(predecode_cache);
 	if (binary)
-		free(binary);
+		rea32_close_binary_file(binary);
+	if (memory)
+		free(memory);
+	if (elf)
+		rea32_close_elf_file(elf);
 
 
 
@@ -0,0 +1,558 @@
+#include "rel_risc_v_emulator.h"
+#include "rea_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#define REA_OBJDUMP_OUTPUT_BUFFER_SIZE 0x400000
+#define REA_OBJDUMP_MAX_SYMBOL_NAME_LENGTH 0x1000
+#define REA_OBJDUMP_MAX_LINE_SIZE (REL_DISASSEMBLE_MAX_LINE_SIZE + 2 * REA_OBJDUMP_MAX_SYMBOL_NAME_LENGTH + 64)
+
+#define REA_OBJDUMP_ELF_SYMBOL_TYPE_FUNCTION 2
+#define REA_OBJDUMP_ELF_SECTION_FLAG_EXECUTE 4
+
+typedef struct rea_output_t
+{
+	FILE* file;
+	int error;
+	size_t size;
+	char* buffer;
+} rea_output_t;
+
+typedef struct rea_objdump_symbol_t
+{
+	uint32_t address;
+	int type;
+	size_t name_length;
+	const char* name;
+} rea_objdump_symbol_t;
+
+typedef struct rea_objdump_t
+{
+	int flags;
+	int objdump_syntax;
+	const char* file_format;
+	size_t range_count;
+	rel32_disassembly_range_t range_table[REA32_DISASSEMBLY_MAX_RANGE_COUNT];
+	const char* section_name_table[REA32_DISASSEMBLY_MAX_RANGE_COUNT];
+	size_t symbol_count;
+	rea_objdump_symbol_t* symbol_table;
+} rea_objdump_t;
+
+static void rea_flush_output(rea_output_t* output)
+{
+	if (output->size && !output->error && fwrite(output->buffer, 1, output->size, output->file) != output->size)
+		output->error = EIO;
+	output->size = 0;
+}
+
+// returns where the caller may write at least size bytes, the caller then advances output->size
+static char* rea_reserve_output(rea_output_t* output, size_t size)
+{
+	if (REA_OBJDUMP_OUTPUT_BUFFER_SIZE - output->size < size)
+		rea_flush_output(output);
+	return output->buffer + output->size;
+}
+
+static char* rea_print_text(char* write, const char* text, size_t length)
+{
+	memcpy(write, text, length);
+	return write + length;
+}
+
+// lowercase without leading zeros like binutils prints addresses and immediates
+static char* rea_print_lowercase_hex(char* write, uint32_t value)
+{
+	static const char hex_table[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+	int digit_count = 1;
+	while (digit_count != 8 && (value >> (digit_count << 2)))
+		++digit_count;
+	for (int i = digit_count - 1; i >= 0; --i, value >>= 4)
+		write[i] = hex_table[value & 0xF];
+	return write + digit_count;
+}
+
+static char* rea_print_padded_lowercase_hex(char* write, int digit_count, uint32_t value)
+{
+	static const char hex_table[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+	for (int i = digit_count - 1; i >= 0; --i, value >>= 4)
+		write[i] = hex_table[value & 0xF];
+	return write + digit_count;
+}
+
+static int rea_compare_symbols(const void* a, const void* b)
+{
+	const rea_objdump_symbol_t* symbol_a = (const rea_objdump_symbol_t*)a;
+	const rea_objdump_symbol_t* symbol_b = (const rea_objdump_symbol_t*)b;
+	if (symbol_a->address != symbol_b->address)
+		return (symbol_a->address < symbol_b->address) ? -1 : 1;
+	// the first symbol at an address labels it, functions win over other symbols
+	if (symbol_a->type != symbol_b->type)
+		return (symbol_a->type == REA_OBJDUMP_ELF_SYMBOL_TYPE_FUNCTION) ? -1 : ((symbol_b->type == REA_OBJDUMP_ELF_SYMBOL_TYPE_FUNCTION) ? 1 : 0);
+	return strcmp(symbol_a->name, symbol_b->name);
+}
+
+static const rel32_disassembly_range_t* rea_find_range(const rea_objdump_t* objdump, uint32_t address)
+{
+	for (size_t i = 0; i != objdump->range_count; ++i)
+		if (address - objdump->range_table[i].address < objdump->range_table[i].size)
+			return objdump->range_table + i;
+	return 0;
+}
+
+static int rea_load_elf_ranges(rea_objdump_t* objdump, const rel32_elf_t* elf)
+{
+	// executable sections like objdump -d, the executable segments when the file has no section headers
+	objdump->range_count = 0;
+	for (size_t i = 0; i != elf->section_count; ++i)
+	{
+		rel32_elf_section_t section;
+		int error = rea32_get_elf_section(elf, i, &section);
+		if (error)
+			return error;
+		if (!(section.flags & REA_OBJDUMP_ELF_SECTION_FLAG_EXECUTE) || !section.file_data || !section.size)
+			continue;
+		if (objdump->range_count == REA32_DISASSEMBLY_MAX_RANGE_COUNT)
+			return ENOBUFS;
+		rel32_disassembly_range_t* range = objdump->range_table + objdump->range_count;
+		range->base_address = (const void*)((uintptr_t)section.file_data - (uintptr_t)section.address);
+		range->address = section.address;
+		range->size = section.size;
+		range->first_line = 0;
+		objdump->section_name_table[objdump->range_count++] = section.name;
+	}
+	if (objdump->range_count)
+		return 0;
+
+	int error = rea32_get_elf_code_ranges(elf, REA32_DISASSEMBLY_MAX_RANGE_COUNT, &objdump->range_count, objdump->range_table);
+	for (size_t i = 0; i != objdump->range_count; ++i)
+		objdump->section_name_table[i] = ".text";
+	return error;
+}
+
+static int rea_load_symbols(rea_objdump_t* objdump, const rel32_elf_t* elf)
+{
+	objdump->symbol_count = 0;
+	objdump->symbol_table = (rea_objdump_symbol_t*)malloc((elf->symbol_count ? elf->symbol_count : 1) * sizeof(rea_objdump_symbol_t));
+	if (!objdump->symbol_table)
+		return ENOMEM;
+
+	// only named symbols inside the disassembled ranges can label lines or targets, mapping symbols like $x are skipped
+	for (size_t i = 0; i != elf->symbol_count; ++i)
+	{
+		rel32_elf_symbol_t symbol;
+		if (rea32_get_elf_symbol(elf, i, &symbol) || !symbol.name[0] || symbol.name[0] == '$' || symbol.type > REA_OBJDUMP_ELF_SYMBOL_TYPE_FUNCTION || !rea_find_range(objdump, symbol.address))
+			continue;
+		rea_objdump_symbol_t* objdump_symbol = objdump->symbol_table + objdump->symbol_count++;
+		objdump_symbol->address = symbol.address;
+		objdump_symbol->type = symbol.type;
+		objdump_symbol->name_length = strlen(symbol.name);
+		if (objdump_symbol->name_length > REA_OBJDUMP_MAX_SYMBOL_NAME_LENGTH)
+			objdump_symbol->name_length = REA_OBJDUMP_MAX_SYMBOL_NAME_LENGTH;
+		objdump_symbol->name = symbol.name;
+	}
+
+	qsort(objdump->symbol_table, objdump->symbol_count, sizeof(rea_objdump_symbol_t), rea_compare_symbols);
+	return 0;
+}
+
+// the closest symbol at or below the target in the same range, like objdump picks it
+static char* rea_print_target_symbol(char* write, const rea_objdump_t* objdump, uint32_t target)
+{
+	const rel32_disassembly_range_t* range = rea_find_range(objdump, target);
+	if (!range)
+		return write;
+	size_t low = 0;
+	size_t high = objdump->symbol_count;
+	while (low != high)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (objdump->symbol_table[middle].address <= target)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	if (!low)
+		return write;
+	uint32_t symbol_address = objdump->symbol_table[low - 1].address;
+	while (low > 1 && objdump->symbol_table[low - 2].address == symbol_address)
+		--low;
+	const rea_objdump_symbol_t* symbol = objdump->symbol_table + low - 1;
+	if (symbol->address < range->address)
+		return write;
+
+	write = rea_print_text(write, " <", 2);
+	write = rea_print_text(write, symbol->name, symbol->name_length);
+	if (target != symbol->address)
+	{
+		write = rea_print_text(write, "+0x", 3);
+		write = rea_print_lowercase_hex(write, target - symbol->address);
+	}
+	*write++ = '>';
+	return write;
+}
+
+static void rea_write_objdump_range(rea_output_t* output, const rea_objdump_t* objdump, size_t range_index)
+{
+	const rel32_disassembly_range_t* range = objdump->range_table + range_index;
+
+	// objdump drops the leading zeros all addresses of a section share, four digits at a time
+	char end_address_text[8];
+	rea_print_padded_lowercase_hex(end_address_text, 8, range->address + range->size);
+	int skip_digit_count = 0;
+	while (skip_digit_count != 8 && end_address_text[skip_digit_count] == '0')
+		++skip_digit_count;
+	if (skip_digit_count == 8 && range->address)
+		skip_digit_count = 0;
+	if (skip_digit_count)
+		skip_digit_count = (skip_digit_count - 1) & ~3;
+
+	char* write = rea_reserve_output(output, REA_OBJDUMP_MAX_LINE_SIZE);
+	write = rea_print_text(write, "\nDisassembly of section ", 24);
+	write = rea_print_text(write, objdump->section_name_table[range_index], strlen(objdump->section_name_table[range_index]));
+	write = rea_print_text(write, ":\n", 2);
+	output->size = (size_t)((uintptr_t)write - (uintptr_t)output->buffer);
+
+	size_t symbol_index = 0;
+	uint32_t end_address = range->address + range->size;
+	for (uint32_t address = range->address; address < end_address;)
+	{
+		const uint8_t* instruction_data = (const uint8_t*)((uintptr_t)range->base_address + (uintptr_t)address);
+		uint32_t instruction_size = ((*instruction_data & 3) == 3) ? 4 : 2;
+		if (end_address - address < instruction_size)
+			break;
+
+		write = rea_reserve_output(output, REA_OBJDUMP_MAX_LINE_SIZE);
+
+		while (symbol_index != objdump->symbol_count && objdump->symbol_table[symbol_index].address < address)
+			++symbol_index;
+		if (symbol_index != objdump->symbol_count && objdump->symbol_table[symbol_index].address == address)
+		{
+			const rea_objdump_symbol_t* symbol = objdump->symbol_table + symbol_index;
+			*write++ = '\n';
+			write = rea_print_padded_lowercase_hex(write, 8, address);
+			write = rea_print_text(write, " <", 2);
+			write = rea_print_text(write, symbol->name, symbol->name_length);
+			write = rea_print_text(write, ">:\n", 3);
+			while (symbol_index != objdump->symbol_count && objdump->symbol_table[symbol_index].address == address)
+				++symbol_index;
+		}
+
+		if (objdump->flags & REL_DISASSEMBLE_ADDRESS)
+		{
+			char address_text[8];
+			rea_print_padded_lowercase_hex(address_text, 8, address);
+			int digit = skip_digit_count;
+			while (digit != 7 && address_text[digit] == '0')
+				address_text[digit++] = ' ';
+			write = rea_print_text(write, address_text + skip_digit_count, (size_t)(8 - skip_digit_count));
+			write = rea_print_text(write, ":\t", 2);
+		}
+
+		// the library formats the rest of the line, the symbol of a jump or branch target is appended here
+		size_t line_size;
+		rel32_disassemble_instruction((objdump->flags & ~(REL_DISASSEMBLE_ADDRESS | REL_DISASSEMBLE_NEW_LINE)) | REL_DISASSEMBLE_BINUTILS_SYNTAX, range->base_address, address, REL_DISASSEMBLE_MAX_LINE_SIZE, &line_size, write);
+		write += line_size;
+		rel32_instruction_information_t info;
+		rel32_decode_instruction(instruction_data, &info);
+		if (info.instruction_index != -1 && (info.opcode == 0x6F || info.opcode == 0x63))
+			write = rea_print_target_symbol(write, objdump, address + info.intermediate);
+		*write++ = '\n';
+		output->size = (size_t)((uintptr_t)write - (uintptr_t)output->buffer);
+		address += instruction_size;
+	}
+}
+
+static void rea_write_range(rea_output_t* output, const rea_objdump_t* objdump, const rel32_disassembly_range_t* range)
+{
+	uint32_t end_address = range->address + range->size;
+	for (uint32_t address = range->address; address < end_address;)
+	{
+		char* write = rea_reserve_output(output, REL_DISASSEMBLE_MAX_LINE_SIZE);
+		uint32_t next_address;
+		size_t written;
+		rel32_disassemble_range(objdump->flags, range->base_address, address, end_address, write, REA_OBJDUMP_OUTPUT_BUFFER_SIZE - output->size, &next_address, &written);
+		output->size += written;
+		// a trailing byte that holds no whole instruction is left out
+		if (next_address == address)
+			break;
+		address = next_address;
+	}
+}
+
+static int rea_write_output_text(void* context, size_t text_length, const char* text)
+{
+	rea_output_t* output = (rea_output_t*)context;
+	rea_flush_output(output);
+	if (!output->error && fwrite(text, 1, text_length, output->file) != text_length)
+		output->error = EIO;
+	return output->error;
+}
+
+// the lines of all ranges are indexed up front and formatted in batches on a pool of threads, the text still comes out in address order
+static void rea_write_ranges_on_threads(rea_output_t* output, const rea_objdump_t* objdump, size_t thread_count)
+{
+	rel32_disassembly_t* disassembly;
+	int error = rea32_create_disassembly(objdump->flags, objdump->range_count, objdump->range_table, &disassembly);
+	if (!error)
+	{
+		error = rea32_write_disassembly(disassembly, 0, disassembly->line_count, thread_count, rea_write_output_text, output);
+		rea32_destroy_disassembly(disassembly);
+	}
+	if (error && !output->error)
+		output->error = error;
+}
+
+// every word at every byte offset of the ranges goes through each batch decoder the processor has and is compared with the scalar decoder
+static int rea_check_batch_decoders(const rea_objdump_t* objdump)
+{
+	static const char* decoder_name_table[] = { "automatic", "scalar", "sse4.1", "avx2" };
+	int mismatch_found = 0;
+	for (int decoder = REL_BATCH_DECODER_SCALAR; decoder <= REL_BATCH_DECODER_AVX2; ++decoder)
+	{
+		size_t word_count = 0;
+		size_t mismatch_count = 0;
+		int error = 0;
+		for (size_t i = 0; i != objdump->range_count && !error; ++i)
+		{
+			const rel32_disassembly_range_t* range = objdump->range_table + i;
+			for (uint32_t offset = 0; offset != 4 && offset < range->size && !error; ++offset)
+			{
+				const uint8_t* data = (const uint8_t*)((uintptr_t)range->base_address + (uintptr_t)range->address) + offset;
+				size_t count = (size_t)(range->size - offset) / 4;
+				size_t checked = 0;
+				while (checked != count)
+				{
+					size_t mismatch_index;
+					error = rel32_check_batch_decoder(decoder, data + checked * 4, count - checked, &mismatch_index);
+					if (error != EILSEQ)
+						break;
+					if (!mismatch_count++)
+						printf("%s: first mismatch at 0x%08x\n", decoder_name_table[decoder], (unsigned int)(range->address + offset + (uint32_t)((checked + mismatch_index) * 4)));
+					checked += mismatch_index + 1;
+					error = 0;
+				}
+				word_count += count;
+			}
+		}
+		if (error == ENOTSUP)
+			printf("%s: not supported\n", decoder_name_table[decoder]);
+		else
+			printf("%s: %llu words, %llu mismatches\n", decoder_name_table[decoder], (unsigned long long)word_count, (unsigned long long)mismatch_count);
+		mismatch_found |= mismatch_count != 0;
+	}
+	return mismatch_found;
+}
+
+static void rea_print_usage(FILE* file)
+{
+	fprintf(file,
+		"Usage: rea-objdump [options] file\n"
+		"Disassembles the executable segments of a RISC-V ELF32 file or a whole flat binary image.\n"
+		"  -b, --binary            Treat the file as a flat image even when it is an ELF file\n"
+		"      --adjust-vma=OFFSET Address of the first byte of a flat image\n"
+		"      --objdump           Output compatible with objdump -d -M no-aliases, or with objdump -d given -M aliases\n"
+		"      --no-addresses      Leave out the address of each instruction\n"
+		"      --no-show-raw-insn  Leave out the machine code of each instruction\n"
+		"  -e, --show-encoding     Print the encoding type before each mnemonic\n"
+		"  -M numeric              Print x0 to x31 instead of ABI register names\n"
+		"  -M aliases              Use pseudoinstructions where the disassembler knows them\n"
+		"  -M no-aliases           Print the base instructions, this is the default\n"
+		"  -j, --threads=COUNT     Format on COUNT threads, 0 is one per processor, the default is 1. Not used with --objdump\n"
+		"      --check-batch-decoder\n"
+		"                          Instead of disassembling, compare each batch decoder with the scalar decoder on every word\n"
+		"                          at all four byte offsets of the code, exits with failure on a mismatch\n"
+		"  -d, -D                  Accepted for objdump compatibility, disassembling is the only action\n"
+		"  -h, --help              Print this text\n");
+}
+
+static int rea_parse_disassembler_options(const char* options, int* flags)
+{
+	while (*options)
+	{
+		size_t length = strcspn(options, ",");
+		if (length == 7 && !memcmp(options, "numeric", 7))
+			*flags &= ~REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS;
+		else if (length == 7 && !memcmp(options, "aliases", 7))
+			*flags |= REL_DISASSEMBLE_USE_PSEUDOINSTRUCTIONS;
+		else if (length == 10 && !memcmp(options, "no-aliases", 10))
+			*flags &= ~REL_DISASSEMBLE_USE_PSEUDOINSTRUCTIONS;
+		else
+			return EINVAL;
+		options += length + (options[length] == ',');
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	rea_objdump_t objdump = { REL_DISASSEMBLE_NEW_LINE | REL_DISASSEMBLE_ADDRESS | REL_DISASSEMBLE_MACHINE_CODE | REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, 0, 0, 0, { { 0 } }, { 0 }, 0, 0 };
+	int force_binary = 0;
+	uint32_t adjust_vma = 0;
+	size_t thread_count = 1;
+	int check_batch_decoder = 0;
+	const char* file_name = 0;
+
+	for (int i = 1; i != argc; ++i)
+	{
+		const char* argument = argv[i];
+		if (!strcmp(argument, "-b") || !strcmp(argument, "--binary"))
+			force_binary = 1;
+		else if (!strncmp(argument, "--adjust-vma=", 13))
+			adjust_vma = (uint32_t)strtoul(argument + 13, 0, 0);
+		else if (!strcmp(argument, "--objdump"))
+			objdump.objdump_syntax = 1;
+		else if (!strcmp(argument, "--no-addresses"))
+			objdump.flags &= ~REL_DISASSEMBLE_ADDRESS;
+		else if (!strcmp(argument, "--no-show-raw-insn"))
+			objdump.flags &= ~REL_DISASSEMBLE_MACHINE_CODE;
+		else if (!strcmp(argument, "-e") || !strcmp(argument, "--show-encoding"))
+			objdump.flags |= REL_DISASSEMBLE_ENCODING;
+		else if (!strncmp(argument, "-M", 2))
+		{
+			const char* options = argument[2] ? argument + 2 : ((i + 1 != argc) ? argv[++i] : "");
+			if (rea_parse_disassembler_options(options, &objdump.flags))
+			{
+				fprintf(stderr, "rea-objdump: unrecognized disassembler option '%s'\n", options);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (!strncmp(argument, "--threads=", 10))
+			thread_count = (size_t)strtoul(argument + 10, 0, 0);
+		else if (!strncmp(argument, "-j", 2))
+			thread_count = (size_t)strtoul(argument[2] ? argument + 2 : ((i + 1 != argc) ? argv[++i] : "1"), 0, 0);
+		else if (!strcmp(argument, "--check-batch-decoder"))
+			check_batch_decoder = 1;
+		else if (!strcmp(argument, "-d") || !strcmp(argument, "-D"))
+			continue;
+		else if (!strcmp(argument, "-h") || !strcmp(argument, "--help"))
+		{
+			rea_print_usage(stdout);
+			return EXIT_SUCCESS;
+		}
+		else if (argument[0] == '-' || file_name)
+		{
+			rea_print_usage(stderr);
+			return EXIT_FAILURE;
+		}
+		else
+			file_name = argument;
+	}
+	if (!file_name)
+	{
+		rea_print_usage(stderr);
+		return EXIT_FAILURE;
+	}
+
+	rel32_elf_t* elf = 0;
+	size_t file_size = 0;
+	void* file_data = 0;
+	int error = force_binary ? ENOEXEC : rea32_open_elf_file(REA_IGNORE_DIRECTORY, file_name, &elf);
+	if (!error)
+	{
+		objdump.file_format = "elf32-littleriscv";
+		error = rea_load_elf_ranges(&objdump, elf);
+		if (!error)
+			error = rea_load_symbols(&objdump, elf);
+	}
+	else if (error == ENOEXEC)
+	{
+		error = rea_map_file(REA_IGNORE_DIRECTORY, file_name, &file_size, &file_data);
+		if (!error && (uint64_t)file_size > (uint64_t)UINT32_MAX - (uint64_t)adjust_vma)
+			error = EFBIG;
+		if (!error)
+		{
+			// like objdump -b binary, the whole image is one .data section with its own symbol
+			objdump.file_format = "binary";
+			objdump.range_count = file_size ? 1 : 0;
+			objdump.range_table[0].base_address = (const void*)((uintptr_t)file_data - (uintptr_t)adjust_vma);
+			objdump.range_table[0].address = adjust_vma;
+			objdump.range_table[0].size = (uint32_t)file_size;
+			objdump.range_table[0].first_line = 0;
+			objdump.section_name_table[0] = ".data";
+			objdump.symbol_table = (rea_objdump_symbol_t*)malloc(sizeof(rea_objdump_symbol_t));
+			if (objdump.symbol_table)
+			{
+				objdump.symbol_count = file_size ? 1 : 0;
+				objdump.symbol_table->address = adjust_vma;
+				objdump.symbol_table->type = 0;
+				objdump.symbol_table->name_length = 5;
+				objdump.symbol_table->name = ".data";
+			}
+			else
+				error = ENOMEM;
+		}
+	}
+
+	if (!error && check_batch_decoder)
+	{
+		int mismatch_found = rea_check_batch_decoders(&objdump);
+		free(objdump.symbol_table);
+		if (elf)
+			rea32_close_elf_file(elf);
+		rea_unmap_file(file_size, file_data);
+		return mismatch_found ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	rea_output_t output = { stdout, 0, 0, 0 };
+	if (!error)
+	{
+		output.buffer = (char*)malloc(REA_OBJDUMP_OUTPUT_BUFFER_SIZE);
+		if (!output.buffer)
+			error = ENOMEM;
+	}
+	if (error)
+	{
+		fprintf(stderr, "rea-objdump: %s: %s\n", file_name, strerror(error));
+		free(objdump.symbol_table);
+		if (elf)
+			rea32_close_elf_file(elf);
+		rea_unmap_file(file_size, file_data);
+		return EXIT_FAILURE;
+	}
+
+	// output goes out in whole buffers, stdio would only copy it again
+#ifdef _WIN32
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	setvbuf(stdout, 0, _IONBF, 0);
+
+	if (objdump.objdump_syntax)
+	{
+		char* write = rea_reserve_output(&output, REA_OBJDUMP_MAX_LINE_SIZE);
+		size_t file_name_length = strlen(file_name);
+		if (file_name_length > REA_OBJDUMP_MAX_SYMBOL_NAME_LENGTH)
+			file_name_length = REA_OBJDUMP_MAX_SYMBOL_NAME_LENGTH;
+		*write++ = '\n';
+		write = rea_print_text(write, file_name, file_name_length);
+		write = rea_print_text(write, ":     file format ", 18);
+		write = rea_print_text(write, objdump.file_format, strlen(objdump.file_format));
+		write = rea_print_text(write, "\n\n", 2);
+		output.size = (size_t)((uintptr_t)write - (uintptr_t)output.buffer);
+	}
+
+	if (!objdump.objdump_syntax && thread_count != 1)
+		rea_write_ranges_on_threads(&output, &objdump, thread_count);
+	else
+		for (size_t i = 0; i != objdump.range_count && !output.error; ++i)
+		{
+			if (objdump.objdump_syntax)
+				rea_write_objdump_range(&output, &objdump, i);
+			else
+				rea_write_range(&output, &objdump, objdump.range_table + i);
+		}
+	rea_flush_output(&output);
+
+	if (output.error)
+		fprintf(stderr, "rea-objdump: %s: %s\n", file_name, strerror(output.error));
+	free(output.buffer);
+	free(objdump.symbol_table);
+	if (elf)
+		rea32_close_elf_file(elf);
+	rea_unmap_file(file_size, file_data);
+	return output.error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,470 @@
+#include "rel_risc_v_emulator.h"
+#include "rea_file.h"
+#include "rea_linux.h"
+#include "rea_semihosting.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REA_RUN_DEFAULT_MEMORY_SIZE 0x4000000
+#define REA_RUN_STACK_SIZE 0x800000
+#define REA_RUN_STACK_TOP 0x80000000
+#define REA_RUN_HEAP_SIZE 0x10000000
+#define REA_RUN_MAPPING_AREA_SIZE 0x10000000
+#define REA_RUN_BLOCK_CACHE_INSTRUCTION_CAPACITY 0x100000
+#define REA_RUN_JIT_NATIVE_CODE_CAPACITY 0x4000000
+#define REA_RUN_DEFAULT_TIME_FREQUENCY 10000000
+#define REA_RUN_STOP_MASK (REL32I_STOP_ECALL | REL32I_STOP_EBREAK | REL32I_STOP_ILLEGAL_INSTRUCTION)
+
+#define REA_RUN_ENGINE_AUTOMATIC 0
+#define REA_RUN_ENGINE_JIT 1
+#define REA_RUN_ENGINE_BLOCKS 2
+#define REA_RUN_ENGINE_PREDECODE 3
+#define REA_RUN_ENGINE_INTERPRETER 4
+#define REA_RUN_ENGINE_PAGED 5
+
+// exit codes a shell reports for a native process killed by SIGILL, SIGTRAP and SIGSEGV
+#define REA_RUN_EXIT_ILLEGAL_INSTRUCTION 132
+#define REA_RUN_EXIT_BREAKPOINT 133
+#define REA_RUN_EXIT_FAULT 139
+
+#define REA_RUN_REGISTER(register_set, number) ((register_set)->x1_x31[(number) - 1])
+
+typedef struct rea_run_t
+{
+	int engine;
+	uint32_t code_size;
+	uint32_t stack_top;
+	uint32_t heap_address;
+	uint32_t heap_size;
+	uint32_t mapping_area_address;
+	uint32_t mapping_area_size;
+	rel32i_register_set_t register_set;
+	rel32i_hart_t hart;
+	rel32i_csr_file_t csr_file;
+	int address_space_created;
+	rel32i_address_space_t address_space;
+	rel32i_memory_t* memory;
+	size_t ram_size;
+	void* ram;
+	void* cache_buffer;
+	rel32i_jit_t* jit;
+	rel32_linux_process_t* process;
+} rea_run_t;
+
+static const char* rea_run_engine_name_table[] = { "automatic", "jit", "blocks", "predecode", "interpreter", "paged" };
+
+// the heap starts after the image, the mapping area and an ELF file's stack end at 2 GiB when that leaves room and follow the heap otherwise
+static int rea_run_plan_layout(rea_run_t* run, uint64_t image_end, int has_stack)
+{
+	uint64_t stack_size = has_stack ? REA_RUN_STACK_SIZE : 0;
+	uint64_t heap_address = (image_end + (REL32I_MEMORY_PAGE_SIZE - 1)) & ~(uint64_t)(REL32I_MEMORY_PAGE_SIZE - 1);
+	uint64_t stack_top = heap_address + REA_RUN_HEAP_SIZE + REA_RUN_MAPPING_AREA_SIZE + stack_size;
+	if (has_stack && stack_top <= REA_RUN_STACK_TOP)
+		stack_top = REA_RUN_STACK_TOP;
+	if (stack_top >= ((uint64_t)1 << 32))
+	{
+		// a flat image that fills the address space runs without brk and mmap
+		if (has_stack)
+			return ENOMEM;
+		return 0;
+	}
+	run->stack_top = (uint32_t)stack_top;
+	run->mapping_area_address = (uint32_t)(stack_top - stack_size - REA_RUN_MAPPING_AREA_SIZE);
+	run->mapping_area_size = REA_RUN_MAPPING_AREA_SIZE;
+	run->heap_address = (uint32_t)heap_address;
+	run->heap_size = run->mapping_area_address - (uint32_t)heap_address;
+	return 0;
+}
+
+static int rea_run_load_elf_into_address_space(rea_run_t* run, const rel32_elf_t* elf)
+{
+	for (size_t i = 0; i != elf->segment_count; ++i)
+	{
+		const rel32_elf_segment_t* segment = elf->segment_table + i;
+		int error = rel32i_commit_address_space(&run->address_space, segment->address, segment->size, REL32I_ACCESS_READ | REL32I_ACCESS_WRITE);
+		if (error)
+			return error;
+		memcpy(run->address_space.base_address + segment->address, segment->file_data, segment->file_backed_size);
+		if (segment->zero_fill_data)
+			memcpy(run->address_space.base_address + segment->address + segment->file_backed_size, segment->zero_fill_data, segment->size - segment->file_backed_size);
+		if ((segment->access & REL32I_ACCESS_EXECUTE) && segment->size && segment->address + segment->size > run->code_size)
+			run->code_size = segment->address + segment->size;
+	}
+
+	for (size_t i = 0; i != elf->segment_count; ++i)
+	{
+		const rel32_elf_segment_t* segment = elf->segment_table + i;
+		if (!segment->size)
+			continue;
+		// the host has to read the pages to fetch from them, segments never share a page since the loader merges those
+		int access = segment->access | ((segment->access & REL32I_ACCESS_EXECUTE) ? REL32I_ACCESS_READ : 0);
+		int error = rel32i_commit_address_space(&run->address_space, segment->address, segment->size, access);
+		if (error)
+			return error;
+	}
+
+	run->register_set.pc = elf->entry_point;
+	REA_RUN_REGISTER(&run->register_set, 2) = run->stack_top;
+	return rel32i_commit_address_space(&run->address_space, run->stack_top - REA_RUN_STACK_SIZE, REA_RUN_STACK_SIZE, REL32I_ACCESS_READ | REL32I_ACCESS_WRITE);
+}
+
+static int rea_run_load_image_into_address_space(rea_run_t* run, size_t image_size, const void* image)
+{
+	int error = rel32i_commit_address_space(&run->address_space, 0, (uint32_t)run->ram_size, REL32I_ACCESS_READ | REL32I_ACCESS_WRITE | REL32I_ACCESS_EXECUTE);
+	if (error)
+		return error;
+	memcpy(run->address_space.base_address, image, image_size);
+	run->code_size = (uint32_t)((image_size + 3) & ~(size_t)3);
+	run->register_set.pc = 0;
+	REA_RUN_REGISTER(&run->register_set, 2) = (uint32_t)(run->ram_size & ~(size_t)0xF);
+	return 0;
+}
+
+static int rea_run_create_memory(rea_run_t* run, size_t leaf_table_count)
+{
+	size_t memory_size = rel32i_get_memory_size(leaf_table_count);
+	void* memory_buffer = malloc(memory_size);
+	if (!memory_buffer)
+		return ENOMEM;
+	int error = rel32i_create_memory(leaf_table_count, memory_size, memory_buffer, &run->memory);
+	if (error)
+		free(memory_buffer);
+	return error;
+}
+
+static int rea_run_load_elf_into_memory(rea_run_t* run, const rel32_elf_t* elf)
+{
+	const size_t leaf_size = REL32I_MEMORY_PAGE_SIZE * REL32I_MEMORY_LEAF_PAGE_COUNT;
+	int error = rea_run_create_memory(run, rea32_get_elf_leaf_table_count(elf) + (REA_RUN_STACK_SIZE + leaf_size - 1) / leaf_size + 1 +
+		rea32_get_linux_leaf_table_count(run->heap_address, run->heap_size, run->mapping_area_address, run->mapping_area_size));
+	if (error)
+		return error;
+	error = rea32_map_elf_segments(elf, run->memory);
+	if (error)
+		return error;
+
+	run->ram_size = REA_RUN_STACK_SIZE;
+	run->ram = calloc(1, run->ram_size);
+	if (!run->ram)
+		return ENOMEM;
+	run->register_set.pc = elf->entry_point;
+	REA_RUN_REGISTER(&run->register_set, 2) = run->stack_top;
+	return rel32i_map_memory(run->memory, run->stack_top - REA_RUN_STACK_SIZE, REA_RUN_STACK_SIZE, REL32I_MEMORY_RAM, REL32I_ACCESS_READ | REL32I_ACCESS_WRITE, run->ram);
+}
+
+static int rea_run_load_image_into_memory(rea_run_t* run, size_t image_size, const void* image)
+{
+	const size_t leaf_size = REL32I_MEMORY_PAGE_SIZE * REL32I_MEMORY_LEAF_PAGE_COUNT;
+	int error = rea_run_create_memory(run, (run->ram_size + leaf_size - 1) / leaf_size +
+		rea32_get_linux_leaf_table_count(run->heap_address, run->heap_size, run->mapping_area_address, run->mapping_area_size));
+	if (error)
+		return error;
+
+	run->ram = calloc(1, run->ram_size);
+	if (!run->ram)
+		return ENOMEM;
+	memcpy(run->ram, image, image_size);
+	run->register_set.pc = 0;
+	REA_RUN_REGISTER(&run->register_set, 2) = (uint32_t)(run->ram_size & ~(size_t)0xF);
+	return rel32i_map_memory(run->memory, 0, (uint32_t)run->ram_size, REL32I_MEMORY_RAM, REL32I_ACCESS_READ | REL32I_ACCESS_WRITE | REL32I_ACCESS_EXECUTE, run->ram);
+}
+
+// the address space engines need the host to reserve 4 GiB, everything else falls back to the memory map
+static int rea_run_create_engine(rea_run_t* run, const rel32_elf_t* elf)
+{
+	run->hart.register_set = &run->register_set;
+	if (run->memory)
+	{
+		run->engine = REA_RUN_ENGINE_PAGED;
+		run->hart.memory = run->memory;
+		return 0;
+	}
+
+	run->hart.code_base_address = run->address_space.base_address;
+	run->hart.data_base_address = run->address_space.base_address;
+	run->hart.address_space = &run->address_space;
+	if (!run->code_size)
+		run->code_size = REL32I_MEMORY_PAGE_SIZE;
+
+	if (run->engine == REA_RUN_ENGINE_AUTOMATIC || run->engine == REA_RUN_ENGINE_JIT)
+	{
+		int error = rel32i_create_jit(run->code_size, REA_RUN_JIT_NATIVE_CODE_CAPACITY, &run->jit);
+		if (!error)
+		{
+			run->engine = REA_RUN_ENGINE_JIT;
+			run->hart.jit = run->jit;
+			return 0;
+		}
+		if (run->engine == REA_RUN_ENGINE_JIT)
+			return error;
+		run->engine = REA_RUN_ENGINE_BLOCKS;
+	}
+
+	if (run->engine == REA_RUN_ENGINE_BLOCKS)
+	{
+		size_t block_cache_size = rel32i_get_block_cache_size(run->code_size, REA_RUN_BLOCK_CACHE_INSTRUCTION_CAPACITY);
+		run->cache_buffer = malloc(block_cache_size);
+		if (!run->cache_buffer)
+			return ENOMEM;
+		return rel32i_create_block_cache(run->code_size, REA_RUN_BLOCK_CACHE_INSTRUCTION_CAPACITY, block_cache_size, run->cache_buffer, &run->hart.block_cache);
+	}
+	else if (run->engine == REA_RUN_ENGINE_PREDECODE)
+	{
+		size_t predecode_cache_size = rel32i_get_predecode_cache_size(run->code_size);
+		run->cache_buffer = malloc(predecode_cache_size);
+		if (!run->cache_buffer)
+			return ENOMEM;
+		int error = rel32i_create_predecode_cache(run->code_size, predecode_cache_size, run->cache_buffer, &run->hart.predecode_cache);
+		if (error)
+			return error;
+		// the rest of the address space may not be readable, so only the code is predecoded up front
+		if (elf)
+		{
+			for (size_t i = 0; i != elf->segment_count; ++i)
+				if (elf->segment_table[i].access & REL32I_ACCESS_EXECUTE)
+					rel32i_fill_predecode_cache(run->hart.code_base_address, run->hart.predecode_cache, elf->segment_table[i].address, elf->segment_table[i].address + elf->segment_table[i].size);
+		}
+		else
+			rel32i_fill_predecode_cache(run->hart.code_base_address, run->hart.predecode_cache, 0, run->code_size);
+	}
+	return 0;
+}
+
+// an ecall or ebreak served here completes like any other instruction
+static void rea_run_retire_trap(rea_run_t* run, uint64_t* retired_instruction_count)
+{
+	++*retired_instruction_count;
+	++run->csr_file.cycle;
+	++run->csr_file.instret;
+}
+
+static void rea_run_destroy(rea_run_t* run)
+{
+	if (run->process)
+		rea32_destroy_linux_process(run->process);
+	if (run->jit)
+		rel32i_destroy_jit(run->jit);
+	free(run->cache_buffer);
+	free(run->memory);
+	free(run->ram);
+	if (run->address_space_created)
+		rel32i_destroy_address_space(&run->address_space);
+}
+
+static void rea_print_usage(FILE* file)
+{
+	fprintf(file,
+		"Usage: rea-run [options] file [arguments]\n"
+		"Runs a RISC-V ELF32 file or a flat binary image until it exits through an exit or exit_group ecall or a semihosting SYS_EXIT.\n"
+		"Ecalls are served as RV32 Linux system calls, an ELF file starts with the arguments on its stack like a static Linux executable.\n"
+		"An ebreak between slli x0, x0, 0x1f and srai x0, x0, 7 is a semihosting call and does console and file I/O on the host.\n"
+		"The guest's exit code becomes the exit code, traps exit with 132 (illegal instruction), 133 (ebreak) or 139 (access fault).\n"
+		"  -b, --binary               Treat the file as a flat image loaded at address 0 even when it is an ELF file\n"
+		"      --memory=SIZE          Bytes of RAM from address 0 for a flat image, the stack starts at the top of it\n"
+		"      --engine=ENGINE        jit, blocks, predecode, interpreter or paged, the default is the fastest available\n"
+		"      --max-instructions=N   Stop with exit code 1 after N instructions\n"
+		"      --time-frequency=HZ    Rate of the time CSR, the default is 10 MHz, cycle and instret count retired instructions\n"
+		"  -q, --quiet                Do not print the statistics\n"
+		"  -h, --help                 Print this text\n");
+}
+
+int main(int argc, char** argv)
+{
+	rea_run_t run;
+	memset(&run, 0, sizeof(rea_run_t));
+	run.ram_size = REA_RUN_DEFAULT_MEMORY_SIZE;
+	int force_binary = 0;
+	int quiet = 0;
+	uint64_t max_instruction_count = UINT64_MAX;
+	uint64_t time_frequency = REA_RUN_DEFAULT_TIME_FREQUENCY;
+	const char* file_name = 0;
+	int guest_argument_count = 0;
+	const char* const* guest_argument_table = 0;
+
+	for (int i = 1; !file_name && i != argc; ++i)
+	{
+		const char* argument = argv[i];
+		if (!strcmp(argument, "-b") || !strcmp(argument, "--binary"))
+			force_binary = 1;
+		else if (!strncmp(argument, "--memory=", 9))
+		{
+			uint64_t memory_size = (uint64_t)strtoull(argument + 9, 0, 0);
+			if (!memory_size || memory_size > (uint64_t)UINT32_MAX + 1 - REL32I_MEMORY_PAGE_SIZE)
+			{
+				fprintf(stderr, "rea-run: invalid memory size '%s'\n", argument + 9);
+				return EXIT_FAILURE;
+			}
+			run.ram_size = (size_t)((memory_size + (REL32I_MEMORY_PAGE_SIZE - 1)) & ~(uint64_t)(REL32I_MEMORY_PAGE_SIZE - 1));
+		}
+		else if (!strncmp(argument, "--engine=", 9))
+		{
+			run.engine = -1;
+			for (int j = 0; j != (int)(sizeof(rea_run_engine_name_table) / sizeof(*rea_run_engine_name_table)); ++j)
+				if (!strcmp(argument + 9, rea_run_engine_name_table[j]))
+					run.engine = j;
+			if (run.engine == -1)
+			{
+				fprintf(stderr, "rea-run: unknown engine '%s'\n", argument + 9);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (!strncmp(argument, "--max-instructions=", 19))
+			max_instruction_count = (uint64_t)strtoull(argument + 19, 0, 0);
+		else if (!strncmp(argument, "--time-frequency=", 17))
+		{
+			time_frequency = (uint64_t)strtoull(argument + 17, 0, 0);
+			if (!time_frequency || time_frequency > 1000000000)
+			{
+				fprintf(stderr, "rea-run: invalid time frequency '%s'\n", argument + 17);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (!strcmp(argument, "-q") || !strcmp(argument, "--quiet"))
+			quiet = 1;
+		else if (!strcmp(argument, "-h") || !strcmp(argument, "--help"))
+		{
+			rea_print_usage(stdout);
+			return EXIT_SUCCESS;
+		}
+		else if (argument[0] == '-')
+		{
+			rea_print_usage(stderr);
+			return EXIT_FAILURE;
+		}
+		else
+		{
+			// everything after the file goes to the guest, with the file as its argv[0]
+			file_name = argument;
+			guest_argument_count = argc - i;
+			guest_argument_table = (const char* const*)(argv + i);
+		}
+	}
+	if (!file_name)
+	{
+		rea_print_usage(stderr);
+		return EXIT_FAILURE;
+	}
+
+	if (run.engine != REA_RUN_ENGINE_PAGED && !rel32i_create_address_space(&run.address_space))
+		run.address_space_created = 1;
+	else if (run.engine != REA_RUN_ENGINE_AUTOMATIC && run.engine != REA_RUN_ENGINE_PAGED)
+	{
+		fprintf(stderr, "rea-run: the %s engine is not supported on this host\n", rea_run_engine_name_table[run.engine]);
+		return EXIT_FAILURE;
+	}
+
+	rel32_elf_t* elf = 0;
+	size_t file_size = 0;
+	void* file_data = 0;
+	int error = force_binary ? ENOEXEC : rea32_open_elf_file(REA_IGNORE_DIRECTORY, file_name, &elf);
+	if (!error)
+	{
+		uint64_t image_end = 0;
+		for (size_t i = 0; i != elf->segment_count; ++i)
+			if ((uint64_t)elf->segment_table[i].address + (uint64_t)elf->segment_table[i].size > image_end)
+				image_end = (uint64_t)elf->segment_table[i].address + (uint64_t)elf->segment_table[i].size;
+		error = rea_run_plan_layout(&run, image_end, 1);
+		if (!error)
+			error = run.address_space_created ? rea_run_load_elf_into_address_space(&run, elf) : rea_run_load_elf_into_memory(&run, elf);
+	}
+	else if (error == ENOEXEC)
+	{
+		error = rea_map_file(REA_IGNORE_DIRECTORY, file_name, &file_size, &file_data);
+		if (!error && file_size > run.ram_size)
+			error = EFBIG;
+		if (!error)
+			error = rea_run_plan_layout(&run, (uint64_t)run.ram_size, 0);
+		if (!error)
+			error = run.address_space_created ? rea_run_load_image_into_address_space(&run, file_size, file_data) : rea_run_load_image_into_memory(&run, file_size, file_data);
+		// the image has been copied into guest memory
+		rea_unmap_file(file_size, file_data);
+	}
+	if (!error)
+		error = rea_run_create_engine(&run, elf);
+	if (!error)
+		error = rea32_create_linux_process(&run.hart, run.heap_address, run.heap_size, run.mapping_area_address, run.mapping_area_size, &run.process);
+	if (!error && elf)
+		error = rea32_push_linux_arguments(run.process, (size_t)guest_argument_count, guest_argument_table, 0, 0, elf->program_header_address, elf->program_header_count, elf->program_header_size, elf->entry_point);
+	if (error)
+	{
+		fprintf(stderr, "rea-run: %s: %s\n", file_name, strerror(error));
+		rea_run_destroy(&run);
+		if (elf)
+			rea32_close_elf_file(elf);
+		return EXIT_FAILURE;
+	}
+
+	rel32_semihosting_t semihosting;
+	rea32_initialize_semihosting(&run.hart, &semihosting);
+	rel32i_initialize_csr_file(&run.csr_file, time_frequency);
+	run.hart.csr_file = &run.csr_file;
+	int exit_code = EXIT_FAILURE;
+	int running = 1;
+	uint64_t retired_instruction_count = 0;
+	uint64_t start_time = rea_get_monotonic_time();
+	while (running)
+	{
+		uint64_t instruction_count;
+		int stop_reason = rel32i_run(&run.hart, max_instruction_count - retired_instruction_count, REA_RUN_STOP_MASK, &instruction_count);
+		retired_instruction_count += instruction_count;
+		uint32_t pc = run.register_set.pc;
+		switch (stop_reason)
+		{
+			case REL32I_STOP_ECALL:
+				rea_run_retire_trap(&run, &retired_instruction_count);
+				if (rea32_handle_linux_system_call(run.process))
+				{
+					exit_code = run.process->exit_code;
+					running = 0;
+				}
+				break;
+			case REL32I_STOP_EBREAK:
+				if (rea32_is_semihosting_call(&run.hart))
+				{
+					rea_run_retire_trap(&run, &retired_instruction_count);
+					if (rea32_handle_semihosting_call(&semihosting))
+					{
+						exit_code = semihosting.exit_code;
+						running = 0;
+					}
+					break;
+				}
+				fprintf(stderr, "rea-run: ebreak at 0x%08X\n", pc);
+				exit_code = REA_RUN_EXIT_BREAKPOINT;
+				running = 0;
+				break;
+			case REL32I_STOP_ILLEGAL_INSTRUCTION:
+				fprintf(stderr, "rea-run: illegal instruction at 0x%08X\n", pc);
+				exit_code = REA_RUN_EXIT_ILLEGAL_INSTRUCTION;
+				running = 0;
+				break;
+			case REL32I_STOP_ACCESS_FAULT:
+				fprintf(stderr, "rea-run: access fault at 0x%08X by the instruction at 0x%08X\n", run.memory ? run.memory->fault_address : run.address_space.fault_address, pc);
+				exit_code = REA_RUN_EXIT_FAULT;
+				running = 0;
+				break;
+			default:
+				if (retired_instruction_count == max_instruction_count)
+				{
+					fprintf(stderr, "rea-run: stopped after %llu instructions at 0x%08X\n", (unsigned long long)retired_instruction_count, pc);
+					exit_code = EXIT_FAILURE;
+					running = 0;
+				}
+				break;
+		}
+	}
+	uint64_t run_time = rea_get_monotonic_time() - start_time;
+
+	if (!quiet)
+	{
+		double seconds = (double)run_time / 1000000000.0;
+		fprintf(stderr, "rea-run: %llu instructions retired in %.3f s, %.1f MIPS with the %s engine\n",
+			(unsigned long long)retired_instruction_count, seconds, seconds > 0.0 ? ((double)retired_instruction_count / seconds) / 1000000.0 : 0.0, rea_run_engine_name_table[run.engine]);
+	}
+
+	rea_run_destroy(&run);
+	if (elf)
+		rea32_close_elf_file(elf);
+	return exit_code;
+}
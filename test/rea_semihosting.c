@@ -0,0 +1,245 @@
+#include "rea_semihosting.h"
+#include <string.h>
+
+#define REA32_SEMIHOSTING_SYS_OPEN 0x01
+#define REA32_SEMIHOSTING_SYS_CLOSE 0x02
+#define REA32_SEMIHOSTING_SYS_WRITEC 0x03
+#define REA32_SEMIHOSTING_SYS_WRITE0 0x04
+#define REA32_SEMIHOSTING_SYS_WRITE 0x05
+#define REA32_SEMIHOSTING_SYS_READ 0x06
+#define REA32_SEMIHOSTING_SYS_READC 0x07
+#define REA32_SEMIHOSTING_SYS_ISTTY 0x09
+#define REA32_SEMIHOSTING_SYS_SEEK 0x0A
+#define REA32_SEMIHOSTING_SYS_FLEN 0x0C
+#define REA32_SEMIHOSTING_SYS_CLOCK 0x10
+#define REA32_SEMIHOSTING_SYS_TIME 0x11
+#define REA32_SEMIHOSTING_SYS_ERRNO 0x13
+#define REA32_SEMIHOSTING_SYS_EXIT 0x18
+#define REA32_SEMIHOSTING_SYS_EXIT_EXTENDED 0x20
+
+#define REA32_SEMIHOSTING_APPLICATION_EXIT 0x20026
+#define REA32_SEMIHOSTING_PAGE_SIZE 0x1000
+#define REA32_SEMIHOSTING_MAX_OPEN_MODE 11
+
+static uint32_t rea32_load_semihosting_word(const void* address)
+{
+	const uint8_t* bytes = (const uint8_t*)address;
+	return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static int rea32_read_semihosting_parameters(rel32_semihosting_t* semihosting, uint32_t address, size_t parameter_count, uint32_t* parameter_table)
+{
+	void* host_address;
+	if (rel32i_get_host_address(semihosting->hart, address, (uint32_t)(parameter_count * 4), REL32I_ACCESS_READ, &host_address))
+		return EFAULT;
+	for (size_t i = 0; i != parameter_count; ++i)
+		parameter_table[i] = rea32_load_semihosting_word((const uint8_t*)host_address + i * 4);
+	return 0;
+}
+
+static int rea32_transfer_semihosting_data(rel32_semihosting_t* semihosting, int write, uint32_t handle, uint32_t address, uint32_t size, uint32_t* transferred_size)
+{
+	*transferred_size = 0;
+	if (!size)
+		return 0;
+	void* host_address;
+	if (rel32i_get_host_address(semihosting->hart, address, size, write ? REL32I_ACCESS_READ : REL32I_ACCESS_WRITE, &host_address))
+		return EFAULT;
+	if (write)
+		return rea_write_host_file((int)handle, host_address, size, transferred_size);
+	int error = rea_read_host_file((int)handle, host_address, size, transferred_size);
+	if (!error)
+		rel32i_invalidate_code(semihosting->hart, address, *transferred_size);
+	return error;
+}
+
+// the string goes out a page at a time, since its end is not known up front
+static int rea32_write_semihosting_string(rel32_semihosting_t* semihosting, uint32_t address)
+{
+	for (;;)
+	{
+		uint32_t chunk_size = REA32_SEMIHOSTING_PAGE_SIZE - (address & (REA32_SEMIHOSTING_PAGE_SIZE - 1));
+		void* host_address;
+		if (rel32i_get_host_address(semihosting->hart, address, chunk_size, REL32I_ACCESS_READ, &host_address))
+			return EFAULT;
+		const char* end = (const char*)memchr(host_address, 0, chunk_size);
+		uint32_t write_size = end ? (uint32_t)((uintptr_t)end - (uintptr_t)host_address) : chunk_size;
+		uint32_t transferred_size;
+		int error = write_size ? rea_write_host_file(1, host_address, write_size, &transferred_size) : 0;
+		if (error || end)
+			return error;
+		address += chunk_size;
+	}
+}
+
+static int rea32_open_semihosting_file(rel32_semihosting_t* semihosting, uint32_t parameter_address, uint32_t* handle)
+{
+	// modes 0 to 11 are fopen's "r", "rb", "r+", "r+b", "w", "wb", "w+", "w+b", "a", "ab", "a+" and "a+b"
+	static const int flags_table[3][2] = {
+		{ REA_OPEN_READ, REA_OPEN_READ | REA_OPEN_WRITE },
+		{ REA_OPEN_WRITE | REA_OPEN_CREATE | REA_OPEN_TRUNCATE, REA_OPEN_READ | REA_OPEN_WRITE | REA_OPEN_CREATE | REA_OPEN_TRUNCATE },
+		{ REA_OPEN_WRITE | REA_OPEN_CREATE | REA_OPEN_APPEND, REA_OPEN_READ | REA_OPEN_WRITE | REA_OPEN_CREATE | REA_OPEN_APPEND } };
+	uint32_t parameter_table[3];
+	int error = rea32_read_semihosting_parameters(semihosting, parameter_address, 3, parameter_table);
+	if (error)
+		return error;
+	uint32_t mode = parameter_table[1];
+	uint32_t length = parameter_table[2];
+	if (mode > REA32_SEMIHOSTING_MAX_OPEN_MODE)
+		return EINVAL;
+	if (length >= REA_MAX_HOST_PATH_SIZE)
+		return ENAMETOOLONG;
+
+	char path[REA_MAX_HOST_PATH_SIZE];
+	void* host_address;
+	if (rel32i_get_host_address(semihosting->hart, parameter_table[0], length + 1, REL32I_ACCESS_READ, &host_address))
+		return EFAULT;
+	memcpy(path, host_address, length);
+	path[length] = 0;
+
+	// ":tt" is the console, read modes get stdin, write modes stdout and append modes stderr
+	if (!strcmp(path, ":tt"))
+	{
+		*handle = mode / 4;
+		return 0;
+	}
+	int file_descriptor = -1;
+	error = rea_open_host_file(path, flags_table[mode / 4][(mode / 2) & 1], 0666, &file_descriptor);
+	if (!error)
+		*handle = (uint32_t)file_descriptor;
+	return error;
+}
+
+void rea32_initialize_semihosting(rel32i_hart_t* hart, rel32_semihosting_t* semihosting)
+{
+	semihosting->hart = hart;
+	semihosting->start_time = rea_get_monotonic_time();
+	semihosting->last_error = 0;
+	semihosting->exit_code = 0;
+}
+
+int rea32_is_semihosting_call(rel32i_hart_t* hart)
+{
+	uint32_t pc = hart->register_set->pc;
+	void* host_address;
+	if (pc < 4 || rel32i_get_host_address(hart, pc - 4, 12, REL32I_ACCESS_READ, &host_address))
+		return 0;
+	// a c.ebreak does not count, the sequence is three 32-bit instructions
+	return rea32_load_semihosting_word(host_address) == REA32_SEMIHOSTING_ENTRY_INSTRUCTION &&
+		rea32_load_semihosting_word((const uint8_t*)host_address + 4) == REA32_SEMIHOSTING_EBREAK_INSTRUCTION &&
+		rea32_load_semihosting_word((const uint8_t*)host_address + 8) == REA32_SEMIHOSTING_EXIT_INSTRUCTION;
+}
+
+int rea32_handle_semihosting_call(rel32_semihosting_t* semihosting)
+{
+	rel32i_register_set_t* register_set = semihosting->hart->register_set;
+	// a0 is x10 and a1 is x11
+	uint32_t operation = register_set->x1_x31[9];
+	uint32_t parameter = register_set->x1_x31[10];
+	uint32_t parameter_table[3];
+	uint32_t result = 0;
+	int error = 0;
+	switch (operation)
+	{
+		case REA32_SEMIHOSTING_SYS_EXIT:
+			// RV32 passes the reason itself rather than a pointer to it
+			semihosting->exit_code = parameter == REA32_SEMIHOSTING_APPLICATION_EXIT ? 0 : 1;
+			return 1;
+		case REA32_SEMIHOSTING_SYS_EXIT_EXTENDED:
+			error = rea32_read_semihosting_parameters(semihosting, parameter, 2, parameter_table);
+			if (error)
+				break;
+			semihosting->exit_code = parameter_table[0] == REA32_SEMIHOSTING_APPLICATION_EXIT ? (int)(parameter_table[1] & 0xFF) : 1;
+			return 1;
+		case REA32_SEMIHOSTING_SYS_OPEN:
+			error = rea32_open_semihosting_file(semihosting, parameter, &result);
+			break;
+		case REA32_SEMIHOSTING_SYS_CLOSE:
+			// the console handles are shared with the emulator
+			if (parameter > 2)
+				error = rea_close_host_file((int)parameter);
+			break;
+		case REA32_SEMIHOSTING_SYS_WRITEC:
+		{
+			uint32_t transferred_size;
+			error = rea32_transfer_semihosting_data(semihosting, 1, 1, parameter, 1, &transferred_size);
+			result = register_set->x1_x31[9];
+			break;
+		}
+		case REA32_SEMIHOSTING_SYS_WRITE0:
+			error = rea32_write_semihosting_string(semihosting, parameter);
+			result = register_set->x1_x31[9];
+			break;
+		case REA32_SEMIHOSTING_SYS_WRITE:
+		case REA32_SEMIHOSTING_SYS_READ:
+		{
+			// both report the number of bytes left over, so 0 is complete and the full length is end of file
+			uint32_t transferred_size = 0;
+			error = rea32_read_semihosting_parameters(semihosting, parameter, 3, parameter_table);
+			if (error)
+				break;
+			int transfer_error = rea32_transfer_semihosting_data(semihosting, operation == REA32_SEMIHOSTING_SYS_WRITE, parameter_table[0], parameter_table[1], parameter_table[2], &transferred_size);
+			if (transfer_error)
+				semihosting->last_error = (uint32_t)transfer_error;
+			result = parameter_table[2] - transferred_size;
+			break;
+		}
+		case REA32_SEMIHOSTING_SYS_READC:
+		{
+			uint8_t character;
+			uint32_t transferred_size = 0;
+			error = rea_read_host_file(0, &character, 1, &transferred_size);
+			result = (!error && transferred_size) ? (uint32_t)character : (uint32_t)-1;
+			break;
+		}
+		case REA32_SEMIHOSTING_SYS_ISTTY:
+			error = rea32_read_semihosting_parameters(semihosting, parameter, 1, parameter_table);
+			if (!error)
+				result = rea_is_host_terminal((int)parameter_table[0]) ? 1 : 0;
+			break;
+		case REA32_SEMIHOSTING_SYS_SEEK:
+		{
+			int64_t position;
+			error = rea32_read_semihosting_parameters(semihosting, parameter, 2, parameter_table);
+			if (!error)
+				error = rea_seek_host_file((int)parameter_table[0], (int64_t)parameter_table[1], REA_SEEK_SET, &position);
+			break;
+		}
+		case REA32_SEMIHOSTING_SYS_FLEN:
+		{
+			rel32_file_status_t status;
+			error = rea32_read_semihosting_parameters(semihosting, parameter, 1, parameter_table);
+			if (!error)
+				error = rea_get_host_file_status((int)parameter_table[0], &status);
+			if (!error)
+				result = status.size < 0x80000000 ? (uint32_t)status.size : 0x7FFFFFFF;
+			break;
+		}
+		case REA32_SEMIHOSTING_SYS_CLOCK:
+			result = (uint32_t)((rea_get_monotonic_time() - semihosting->start_time) / 10000000);
+			break;
+		case REA32_SEMIHOSTING_SYS_TIME:
+		{
+			int64_t seconds;
+			uint32_t nanoseconds;
+			rea_get_real_time(&seconds, &nanoseconds);
+			result = (uint32_t)seconds;
+			break;
+		}
+		case REA32_SEMIHOSTING_SYS_ERRNO:
+			result = semihosting->last_error;
+			break;
+		default:
+			error = ENOSYS;
+			break;
+	}
+	// failures are -1 with the host error kept for SYS_ERRNO
+	if (error)
+	{
+		semihosting->last_error = (uint32_t)error;
+		result = (uint32_t)-1;
+	}
+	register_set->x1_x31[9] = result;
+	register_set->pc += 4;
+	return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef REL_RISC_V_APPLICATION_SEMIHOSTING_H
+#define REL_RISC_V_APPLICATION_SEMIHOSTING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include "rel_risc_v_emulator.h"
+#include "rea_file.h"
+
+#define REA32_SEMIHOSTING_ENTRY_INSTRUCTION 0x01F01013
+#define REA32_SEMIHOSTING_EXIT_INSTRUCTION 0x40705013
+#define REA32_SEMIHOSTING_EBREAK_INSTRUCTION 0x00100073
+
+typedef struct rel32_semihosting_t
+{
+	rel32i_hart_t* hart;
+	uint64_t start_time;
+	uint32_t last_error;
+	int exit_code;
+} rel32_semihosting_t;
+
+void rea32_initialize_semihosting(rel32i_hart_t* hart, rel32_semihosting_t* semihosting);
+
+// True when the hart stopped on an uncompressed ebreak that sits between slli x0, x0, 0x1f and srai x0, x0, 7.
+int rea32_is_semihosting_call(rel32i_hart_t* hart);
+
+// Services the operation in a0 with the parameter in a1, puts the result in a0 and moves pc past the ebreak.
+// Returns nonzero when the guest called SYS_EXIT or SYS_EXIT_EXTENDED, its status is then in exit_code.
+int rea32_handle_semihosting_call(rel32_semihosting_t* semihosting);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // REL_RISC_V_APPLICATION_SEMIHOSTING_H
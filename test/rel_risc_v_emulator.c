@@ -1,5 +1,71 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
 #include "rel_risc_v_emulator.h"
 #include <assert.h>
+#include <setjmp.h>
+
+#if defined(__linux__)
+#define REL32I_ADDRESS_SPACE_SUPPORTED
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) && defined(__linux__)
+#define REL32I_JIT_SUPPORTED
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define REL32_SIMD_DECODE_SUPPORTED
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// floating-point instructions use the scalar SSE2 instructions every x86-64 host has, other hosts go through fenv.h
+#if defined(__x86_64__) || defined(_M_X64)
+#define REL32I_SSE_FLOAT_SUPPORTED
+#include <emmintrin.h>
+#else
+#include <fenv.h>
+#endif
+#include <math.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <time.h>
+#include <pthread.h>
+#endif
+
+// the lookup tables derived from instruction_table are built exactly once, whichever thread decodes first
+#if defined(_WIN32)
+typedef INIT_ONCE rel32_once_t;
+#define REL32_ONCE_INITIALIZER INIT_ONCE_STATIC_INIT
+
+static BOOL CALLBACK rel32_once_callback(PINIT_ONCE once, PVOID parameter, PVOID* context)
+{
+	(*(void (**)(void))parameter)();
+	return TRUE;
+}
+
+static void rel32_run_once(rel32_once_t* once, void (*function)(void))
+{
+	InitOnceExecuteOnce(once, rel32_once_callback, (PVOID)&function, 0);
+}
+#else
+typedef pthread_once_t rel32_once_t;
+#define REL32_ONCE_INITIALIZER PTHREAD_ONCE_INIT
+
+static void rel32_run_once(rel32_once_t* once, void (*function)(void))
+{
+	pthread_once(once, function);
+}
+#endif
 
 static const struct
 {
@@ -80,14 +146,171 @@ static const struct
 			{ "amomin.w", "a", "10000,aq,rl,rs2,rs1,010,rd,0101111", 4, 0xF800707F, 0x8000202F, REL_ENCODING_R, REL_ENCODING_R, 0x2F, 0x2, 0x80 },
 			{ "amomax.w", "a", "10100,aq,rl,rs2,rs1,010,rd,0101111", 4, 0xF800707F, 0xA000202F, REL_ENCODING_R, REL_ENCODING_R, 0x2F, 0x2, 0xA0 },
 			{ "amominu.w", "a", "11000,aq,rl,rs2,rs1,010,rd,0101111", 4, 0xF800707F, 0xC000202F, REL_ENCODING_R, REL_ENCODING_R, 0x2F, 0x2, 0xC0 },
-			{ "amomaxu.w", "a", "11100,aq,rl,rs2,rs1,010,rd,0101111", 4, 0xF800707F, 0xE000202F, REL_ENCODING_R, REL_ENCODING_R, 0x2F, 0x2, 0xE0 } };
+			{ "amomaxu.w", "a", "11100,aq,rl,rs2,rs1,010,rd,0101111", 4, 0xF800707F, 0xE000202F, REL_ENCODING_R, REL_ENCODING_R, 0x2F, 0x2, 0xE0 },
+			{ "sfence.vma", "s", "0001001,rs2,rs1,000,00000,1110011", 4, 0xFE007FFF, 0x12000073, REL_ENCODING_R, REL_ENCODING_I_ENVIROMENT, 0x73, 0x0, 0x09 },
+			{ "flw", "f", "imm[11:0],rs1,010,rd,0000111", 4, 0x0000707F, 0x00002007, REL_ENCODING_I, REL_ENCODING_I_FLOAT, 0x07, 0x2, 0x00 },
+			{ "fsw", "f", "imm[11:5],rs2,rs1,010,imm[4:0],0100111", 4, 0x0000707F, 0x00002027, REL_ENCODING_S, REL_ENCODING_S_FLOAT, 0x27, 0x2, 0x00 },
+			{ "fmadd.s", "f", "rs3,00,rs2,rs1,rm,rd,1000011", 4, 0x0600007F, 0x00000043, REL_ENCODING_R, REL_ENCODING_R4_FLOAT, 0x43, 0x0, 0x00 },
+			{ "fmsub.s", "f", "rs3,00,rs2,rs1,rm,rd,1000111", 4, 0x0600007F, 0x00000047, REL_ENCODING_R, REL_ENCODING_R4_FLOAT, 0x47, 0x0, 0x00 },
+			{ "fnmsub.s", "f", "rs3,00,rs2,rs1,rm,rd,1001011", 4, 0x0600007F, 0x0000004B, REL_ENCODING_R, REL_ENCODING_R4_FLOAT, 0x4B, 0x0, 0x00 },
+			{ "fnmadd.s", "f", "rs3,00,rs2,rs1,rm,rd,1001111", 4, 0x0600007F, 0x0000004F, REL_ENCODING_R, REL_ENCODING_R4_FLOAT, 0x4F, 0x0, 0x00 },
+			{ "fadd.s", "f", "0000000,rs2,rs1,rm,rd,1010011", 4, 0xFE00007F, 0x00000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x00 },
+			{ "fsub.s", "f", "0000100,rs2,rs1,rm,rd,1010011", 4, 0xFE00007F, 0x08000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x04 },
+			{ "fmul.s", "f", "0001000,rs2,rs1,rm,rd,1010011", 4, 0xFE00007F, 0x10000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x08 },
+			{ "fdiv.s", "f", "0001100,rs2,rs1,rm,rd,1010011", 4, 0xFE00007F, 0x18000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x0C },
+			{ "fsqrt.s", "f", "0101100,00000,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0x58000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_UNARY, 0x53, 0x0, 0x2C },
+			{ "fsgnj.s", "f", "0010000,rs2,rs1,000,rd,1010011", 4, 0xFE00707F, 0x20000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x10 },
+			{ "fsgnjn.s", "f", "0010000,rs2,rs1,001,rd,1010011", 4, 0xFE00707F, 0x20001053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x1, 0x10 },
+			{ "fsgnjx.s", "f", "0010000,rs2,rs1,010,rd,1010011", 4, 0xFE00707F, 0x20002053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x2, 0x10 },
+			{ "fmin.s", "f", "0010100,rs2,rs1,000,rd,1010011", 4, 0xFE00707F, 0x28000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x14 },
+			{ "fmax.s", "f", "0010100,rs2,rs1,001,rd,1010011", 4, 0xFE00707F, 0x28001053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x1, 0x14 },
+			{ "fcvt.w.s", "f", "1100000,00000,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0xC0000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_TO_INTEGER, 0x53, 0x0, 0x60 },
+			{ "fcvt.wu.s", "f", "1100000,00001,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0xC0100053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_TO_INTEGER, 0x53, 0x0, 0x60 },
+			{ "fmv.x.w", "f", "1110000,00000,rs1,000,rd,1010011", 4, 0xFFF0707F, 0xE0000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_TO_INTEGER, 0x53, 0x0, 0x70 },
+			{ "feq.s", "f", "1010000,rs2,rs1,010,rd,1010011", 4, 0xFE00707F, 0xA0002053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_COMPARE, 0x53, 0x2, 0x50 },
+			{ "flt.s", "f", "1010000,rs2,rs1,001,rd,1010011", 4, 0xFE00707F, 0xA0001053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_COMPARE, 0x53, 0x1, 0x50 },
+			{ "fle.s", "f", "1010000,rs2,rs1,000,rd,1010011", 4, 0xFE00707F, 0xA0000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_COMPARE, 0x53, 0x0, 0x50 },
+			{ "fclass.s", "f", "1110000,00000,rs1,001,rd,1010011", 4, 0xFFF0707F, 0xE0001053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_TO_INTEGER, 0x53, 0x1, 0x70 },
+			{ "fcvt.s.w", "f", "1101000,00000,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0xD0000053, REL_ENCODING_R, REL_ENCODING_R_INTEGER_TO_FLOAT, 0x53, 0x0, 0x68 },
+			{ "fcvt.s.wu", "f", "1101000,00001,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0xD0100053, REL_ENCODING_R, REL_ENCODING_R_INTEGER_TO_FLOAT, 0x53, 0x0, 0x68 },
+			{ "fmv.w.x", "f", "1111000,00000,rs1,000,rd,1010011", 4, 0xFFF0707F, 0xF0000053, REL_ENCODING_R, REL_ENCODING_R_INTEGER_TO_FLOAT, 0x53, 0x0, 0x78 },
+			{ "fld", "d", "imm[11:0],rs1,011,rd,0000111", 4, 0x0000707F, 0x00003007, REL_ENCODING_I, REL_ENCODING_I_FLOAT, 0x07, 0x3, 0x00 },
+			{ "fsd", "d", "imm[11:5],rs2,rs1,011,imm[4:0],0100111", 4, 0x0000707F, 0x00003027, REL_ENCODING_S, REL_ENCODING_S_FLOAT, 0x27, 0x3, 0x00 },
+			{ "fmadd.d", "d", "rs3,01,rs2,rs1,rm,rd,1000011", 4, 0x0600007F, 0x02000043, REL_ENCODING_R, REL_ENCODING_R4_FLOAT, 0x43, 0x0, 0x00 },
+			{ "fmsub.d", "d", "rs3,01,rs2,rs1,rm,rd,1000111", 4, 0x0600007F, 0x02000047, REL_ENCODING_R, REL_ENCODING_R4_FLOAT, 0x47, 0x0, 0x00 },
+			{ "fnmsub.d", "d", "rs3,01,rs2,rs1,rm,rd,1001011", 4, 0x0600007F, 0x0200004B, REL_ENCODING_R, REL_ENCODING_R4_FLOAT, 0x4B, 0x0, 0x00 },
+			{ "fnmadd.d", "d", "rs3,01,rs2,rs1,rm,rd,1001111", 4, 0x0600007F, 0x0200004F, REL_ENCODING_R, REL_ENCODING_R4_FLOAT, 0x4F, 0x0, 0x00 },
+			{ "fadd.d", "d", "0000001,rs2,rs1,rm,rd,1010011", 4, 0xFE00007F, 0x02000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x01 },
+			{ "fsub.d", "d", "0000101,rs2,rs1,rm,rd,1010011", 4, 0xFE00007F, 0x0A000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x05 },
+			{ "fmul.d", "d", "0001001,rs2,rs1,rm,rd,1010011", 4, 0xFE00007F, 0x12000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x09 },
+			{ "fdiv.d", "d", "0001101,rs2,rs1,rm,rd,1010011", 4, 0xFE00007F, 0x1A000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x0D },
+			{ "fsqrt.d", "d", "0101101,00000,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0x5A000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_UNARY, 0x53, 0x0, 0x2D },
+			{ "fsgnj.d", "d", "0010001,rs2,rs1,000,rd,1010011", 4, 0xFE00707F, 0x22000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x11 },
+			{ "fsgnjn.d", "d", "0010001,rs2,rs1,001,rd,1010011", 4, 0xFE00707F, 0x22001053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x1, 0x11 },
+			{ "fsgnjx.d", "d", "0010001,rs2,rs1,010,rd,1010011", 4, 0xFE00707F, 0x22002053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x2, 0x11 },
+			{ "fmin.d", "d", "0010101,rs2,rs1,000,rd,1010011", 4, 0xFE00707F, 0x2A000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x0, 0x15 },
+			{ "fmax.d", "d", "0010101,rs2,rs1,001,rd,1010011", 4, 0xFE00707F, 0x2A001053, REL_ENCODING_R, REL_ENCODING_R_FLOAT, 0x53, 0x1, 0x15 },
+			{ "fcvt.s.d", "d", "0100000,00001,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0x40100053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_UNARY, 0x53, 0x0, 0x20 },
+			{ "fcvt.d.s", "d", "0100001,00000,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0x42000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_UNARY, 0x53, 0x0, 0x21 },
+			{ "feq.d", "d", "1010001,rs2,rs1,010,rd,1010011", 4, 0xFE00707F, 0xA2002053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_COMPARE, 0x53, 0x2, 0x51 },
+			{ "flt.d", "d", "1010001,rs2,rs1,001,rd,1010011", 4, 0xFE00707F, 0xA2001053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_COMPARE, 0x53, 0x1, 0x51 },
+			{ "fle.d", "d", "1010001,rs2,rs1,000,rd,1010011", 4, 0xFE00707F, 0xA2000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_COMPARE, 0x53, 0x0, 0x51 },
+			{ "fclass.d", "d", "1110001,00000,rs1,001,rd,1010011", 4, 0xFFF0707F, 0xE2001053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_TO_INTEGER, 0x53, 0x1, 0x71 },
+			{ "fcvt.w.d", "d", "1100001,00000,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0xC2000053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_TO_INTEGER, 0x53, 0x0, 0x61 },
+			{ "fcvt.wu.d", "d", "1100001,00001,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0xC2100053, REL_ENCODING_R, REL_ENCODING_R_FLOAT_TO_INTEGER, 0x53, 0x0, 0x61 },
+			{ "fcvt.d.w", "d", "1101001,00000,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0xD2000053, REL_ENCODING_R, REL_ENCODING_R_INTEGER_TO_FLOAT, 0x53, 0x0, 0x69 },
+			{ "fcvt.d.wu", "d", "1101001,00001,rs1,rm,rd,1010011", 4, 0xFFF0007F, 0xD2100053, REL_ENCODING_R, REL_ENCODING_R_INTEGER_TO_FLOAT, 0x53, 0x0, 0x69 } };
 
-void rel32_copy(void* destination, const void* source, size_t size)
+#define REL32_INSTRUCTION_TABLE_SIZE (sizeof(instruction_table) / sizeof(*instruction_table))
+#define REL32_DECODE_NO_MATCH 0xFF
+#define REL32_DECODE_FUNCTION7_TABLE 0x100
+#define REL32_DECODE_MAX_FUNCTION7_TABLE_COUNT 64
+
+static rel32_once_t decode_tables_once = REL32_ONCE_INITIALIZER;
+static struct
+{
+	int function7_table_count;
+	uint16_t primary_table[32 * 8];/* indexed by opcode[6:2] and function3 */
+	uint8_t function7_table[REL32_DECODE_MAX_FUNCTION7_TABLE_COUNT][128];
+	uint8_t next_candidate[REL32_INSTRUCTION_TABLE_SIZE];
+} decode_tables;
+
+static int rel32_row_matches_fields(size_t row, uint32_t field_mask, uint32_t fields)
+{
+	return !((fields ^ instruction_table[row].constant) & instruction_table[row].constant_mask & field_mask);
+}
+
+static void rel32_insert_decode_candidate(uint8_t* head, uint8_t row)
+{
+	// candidate chains are shared between slots and always kept in table order, so the first match is the same as with a linear scan
+	if (*head == REL32_DECODE_NO_MATCH)
+	{
+		*head = row;
+		return;
+	}
+	uint8_t tail = *head;
+	while (tail != row && decode_tables.next_candidate[tail] != REL32_DECODE_NO_MATCH)
+		tail = decode_tables.next_candidate[tail];
+	assert(tail <= row);
+	if (tail != row)
+		decode_tables.next_candidate[tail] = row;
+}
+
+static void rel32_build_decode_tables(void)
+{
+	assert(REL32_INSTRUCTION_TABLE_SIZE < REL32_DECODE_NO_MATCH);
+
+	decode_tables.function7_table_count = 0;
+	for (size_t row = 0; row != REL32_INSTRUCTION_TABLE_SIZE; ++row)
+		decode_tables.next_candidate[row] = REL32_DECODE_NO_MATCH;
+
+	for (uint32_t slot = 0; slot != 32 * 8; ++slot)
+	{
+		uint32_t slot_fields = (((slot >> 3) << 2) | 0x3) | ((slot & 0x7) << 12);
+		int needs_function7_table = 0;
+		for (size_t row = 0; row != REL32_INSTRUCTION_TABLE_SIZE; ++row)
+			if (rel32_row_matches_fields(row, 0x0000707F, slot_fields) && (instruction_table[row].constant_mask & 0xFE000000))
+				needs_function7_table = 1;
+
+		if (needs_function7_table)
+		{
+			assert(decode_tables.function7_table_count != REL32_DECODE_MAX_FUNCTION7_TABLE_COUNT);
+			uint8_t* function7_table = decode_tables.function7_table[decode_tables.function7_table_count];
+			decode_tables.primary_table[slot] = (uint16_t)(REL32_DECODE_FUNCTION7_TABLE + decode_tables.function7_table_count++);
+			for (uint32_t function7 = 0; function7 != 128; ++function7)
+			{
+				function7_table[function7] = REL32_DECODE_NO_MATCH;
+				for (size_t row = 0; row != REL32_INSTRUCTION_TABLE_SIZE; ++row)
+					if (rel32_row_matches_fields(row, 0xFE00707F, slot_fields | (function7 << 25)))
+						rel32_insert_decode_candidate(function7_table + function7, (uint8_t)row);
+			}
+		}
+		else
+		{
+			uint8_t head = REL32_DECODE_NO_MATCH;
+			for (size_t row = 0; row != REL32_INSTRUCTION_TABLE_SIZE; ++row)
+				if (rel32_row_matches_fields(row, 0x0000707F, slot_fields))
+					rel32_insert_decode_candidate(&head, (uint8_t)row);
+			decode_tables.primary_table[slot] = head;
+		}
+	}
+}
+
+int rel32_find_instruction_index(uint32_t instruction)
+{
+	if ((instruction & 0x3) != 0x3)
+		return -1;
+
+	rel32_run_once(&decode_tables_once, rel32_build_decode_tables);
+
+	uint32_t entry = decode_tables.primary_table[((instruction >> 2) & 0x1F) << 3 | ((instruction >> 12) & 0x7)];
+	uint32_t row = (entry & REL32_DECODE_FUNCTION7_TABLE) ? decode_tables.function7_table[entry - REL32_DECODE_FUNCTION7_TABLE][instruction >> 25] : entry;
+	while (row != REL32_DECODE_NO_MATCH && (instruction & instruction_table[row].constant_mask) != instruction_table[row].constant)
+		row = decode_tables.next_candidate[row];
+
+	return (row != REL32_DECODE_NO_MATCH) ? (int)row : -1;
+}
+
+// moves 8 bytes without alignment requirements, compilers lower this to a single load and store
+#if defined(__GNUC__)
+#define REL32_COPY_WORD(destination, source) __builtin_memcpy((destination), (source), 8)
+#else
+#define REL32_COPY_WORD(destination, source) rel32_copy_bytes((destination), (source), 8)
+#endif
+
+static void rel32_copy_bytes(void* destination, const void* source, size_t size)
 {
 	for (const void* source_end = (const void*)((uintptr_t)source + size); source != source_end; source = (const void*)((uintptr_t)source + 1), destination = (void*)((uintptr_t)destination + 1))
 		*(uint8_t*)destination = *(const uint8_t*)source;
 }
 
+void rel32_copy(void* destination, const void* source, size_t size)
+{
+	for (; size >= 8; size -= 8, source = (const void*)((uintptr_t)source + 8), destination = (void*)((uintptr_t)destination + 8))
+		REL32_COPY_WORD(destination, source);
+	rel32_copy_bytes(destination, source, size);
+}
+
 size_t rel32_string_size(const char* string)
 {
 	const char* read_string = string;
@@ -143,38 +366,69 @@ int rel32_string_compare(const char* a, const char* b)
 	return !b_tmp;
 }
 	
+// two characters for every byte value and for every two digit decimal number
+static const char rel32_hex_pair_table[513] =
+	"000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+	"202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+	"404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+	"606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+	"808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+	"A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+	"C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+	"E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+static const char rel32_decimal_pair_table[201] =
+	"00010203040506070809101112131415161718192021222324"
+	"25262728293031323334353637383940414243444546474849"
+	"50515253545556575859606162636465666768697071727374"
+	"75767778798081828384858687888990919293949596979899";
+
 size_t rel32_print_hex(uint32_t value, char* buffer)
 {
-	static const char hex_table[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
-	for (int i = 0; i != 8; ++i)
-		buffer[i] = hex_table[(value >> ((7 - i) << 2)) & 0xF];
+	for (int i = 0; i != 4; ++i)
+	{
+		const char* pair = rel32_hex_pair_table + ((value >> ((3 - i) << 3)) & 0xFF) * 2;
+		buffer[i * 2 + 0] = pair[0];
+		buffer[i * 2 + 1] = pair[1];
+	}
 	return 8;
 }
 
 size_t rel32_print_hex_digits(int digit_count, uint32_t value, char* buffer)
 {
-	static const char hex_table[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
-	
 	int fill = 0;
-	while (digit_count > 8)
-		buffer[fill++] = hex_table[0];
+	for (; fill < digit_count - 8; ++fill)
+		buffer[fill] = '0';
 
-	for (int b = 8 - digit_count, i = b; i != 8; ++i)
-		buffer[fill + i - b] = hex_table[(value >> ((7 - i) << 2)) & 0xF];
+	for (int i = (digit_count < 8 ? digit_count : 8) - 1; i >= 0; --i, value >>= 4)
+		buffer[fill + i] = rel32_hex_pair_table[(value & 0xF) * 2 + 1];
 
 	return (size_t)digit_count;
 }
 
 size_t rel32_print_unsigned(uint32_t value, char* buffer)
 {
-	size_t size = 0;
-	do
+	size_t size = 1;
+	for (uint32_t power = 10; size != 10 && value >= power; power *= 10)
+		++size;
+
+	// digits are written from the end two at a time, so nothing has to move
+	char* write = buffer + size;
+	while (value >= 100)
 	{
-		for (char* move = buffer + size++; move != buffer; --move)
-			*move = *(move - 1);
-		*buffer = '0' + (char)(value % 10);
-		value /= 10;
-	} while (value);
+		const char* pair = rel32_decimal_pair_table + (value % 100) * 2;
+		value /= 100;
+		write -= 2;
+		write[0] = pair[0];
+		write[1] = pair[1];
+	}
+	if (value >= 10)
+	{
+		write[-2] = rel32_decimal_pair_table[value * 2 + 0];
+		write[-1] = rel32_decimal_pair_table[value * 2 + 1];
+	}
+	else
+		write[-1] = '0' + (char)value;
 	return size;// max size is 10
 }
 
@@ -183,7 +437,7 @@ size_t rel32_print_signed(int32_t value, char* buffer)
 	int is_negative = value < 0;
 	if (is_negative)
 		*buffer = '-';
-	return (size_t)is_negative + rel32_print_unsigned((uint32_t)(is_negative ? -value : value), buffer + is_negative);// max size is 11
+	return (size_t)is_negative + rel32_print_unsigned(is_negative ? (uint32_t)0 - (uint32_t)value : (uint32_t)value, buffer + is_negative);// max size is 11
 }
 
 int rel32_print_instruction_encoding_format(const char* mnemonic, char* buffer)
@@ -224,94 +478,257 @@ int rel32_print_instruction_encoding(const char* mnemonic, char* buffer)
 	return 0;
 }
 
+static inline uint32_t rel32_encode_compressed_i(uint32_t immediate, uint32_t rs1, uint32_t function3, uint32_t rd, uint32_t opcode)
+{
+	return (immediate << 20) | (rs1 << 15) | (function3 << 12) | (rd << 7) | opcode;
+}
+
+static inline uint32_t rel32_encode_compressed_s(uint32_t immediate, uint32_t rs2, uint32_t rs1, uint32_t function3, uint32_t opcode)
+{
+	return ((immediate & 0xFE0) << 20) | (rs2 << 20) | (rs1 << 15) | (function3 << 12) | ((immediate & 0x1F) << 7) | opcode;
+}
+
+static inline uint32_t rel32_encode_compressed_b(uint32_t immediate, uint32_t rs1, uint32_t function3)
+{
+	return ((immediate & 0x1000) << 19) | ((immediate & 0x7E0) << 20) | (rs1 << 15) | (function3 << 12) | ((immediate & 0x1E) << 7) | ((immediate & 0x800) >> 4) | 0x63;
+}
+
+static inline uint32_t rel32_encode_compressed_j(uint32_t immediate, uint32_t rd)
+{
+	return ((immediate & 0x100000) << 11) | ((immediate & 0x7FE) << 20) | ((immediate & 0x800) << 9) | (immediate & 0xFF000) | (rd << 7) | 0x6F;
+}
+
+static inline uint32_t rel32_encode_compressed_r(uint32_t function7, uint32_t rs2, uint32_t rs1, uint32_t function3, uint32_t rd)
+{
+	return (function7 << 25) | (rs2 << 20) | (rs1 << 15) | (function3 << 12) | (rd << 7) | 0x33;
+}
+
+static inline uint32_t rel32_sign_extend(uint32_t value, int sign_bit)
+{
+	return (value ^ ((uint32_t)1 << sign_bit)) - ((uint32_t)1 << sign_bit);
+}
+
+uint32_t rel32_expand_compressed_instruction(uint16_t compressed_instruction)
+{
+	uint32_t c = compressed_instruction;
+	// rd', rs1' and rs2' name x8 to x15
+	uint32_t rd = (c >> 7) & 0x1F;
+	uint32_t rs2 = (c >> 2) & 0x1F;
+	uint32_t rd_prime = 8 + ((c >> 2) & 7);
+	uint32_t rs1_prime = 8 + ((c >> 7) & 7);
+	uint32_t immediate6 = rel32_sign_extend(((c >> 7) & 0x20) | ((c >> 2) & 0x1F), 5);
+	switch (((c >> 11) & 0x1C) | (c & 3))
+	{
+		case 0x00:
+		{
+			uint32_t immediate = ((c >> 7) & 0x30) | ((c >> 1) & 0x3C0) | ((c >> 4) & 0x4) | ((c >> 2) & 0x8);
+			// c.addi4spn, a zero immediate makes it reserved, which includes the all zero halfword
+			return immediate ? rel32_encode_compressed_i(immediate, 2, 0, rd_prime, 0x13) : 0;
+		}
+		case 0x04:
+			// c.fld
+			return rel32_encode_compressed_i(((c >> 7) & 0x38) | ((c << 1) & 0xC0), rs1_prime, 3, rd_prime, 0x07);
+		case 0x08:
+			// c.lw
+			return rel32_encode_compressed_i(((c >> 7) & 0x38) | ((c >> 4) & 0x4) | ((c << 1) & 0x40), rs1_prime, 2, rd_prime, 0x03);
+		case 0x0C:
+			// c.flw
+			return rel32_encode_compressed_i(((c >> 7) & 0x38) | ((c >> 4) & 0x4) | ((c << 1) & 0x40), rs1_prime, 2, rd_prime, 0x07);
+		case 0x14:
+			// c.fsd
+			return rel32_encode_compressed_s(((c >> 7) & 0x38) | ((c << 1) & 0xC0), rd_prime, rs1_prime, 3, 0x27);
+		case 0x18:
+			// c.sw
+			return rel32_encode_compressed_s(((c >> 7) & 0x38) | ((c >> 4) & 0x4) | ((c << 1) & 0x40), rd_prime, rs1_prime, 2, 0x23);
+		case 0x1C:
+			// c.fsw
+			return rel32_encode_compressed_s(((c >> 7) & 0x38) | ((c >> 4) & 0x4) | ((c << 1) & 0x40), rd_prime, rs1_prime, 2, 0x27);
+		case 0x01:
+			// c.addi and c.nop
+			return rel32_encode_compressed_i(immediate6 & 0xFFF, rd, 0, rd, 0x13);
+		case 0x05:
+		case 0x15:
+		{
+			// c.jal and c.j
+			uint32_t immediate = ((c >> 1) & 0xB40) | ((c >> 7) & 0x10) | ((c << 2) & 0x400) | ((c << 1) & 0x80) | ((c >> 2) & 0xE) | ((c << 3) & 0x20);
+			return rel32_encode_compressed_j(rel32_sign_extend(immediate, 11), (c & 0x8000) ? 0 : 1);
+		}
+		case 0x09:
+			// c.li
+			return rel32_encode_compressed_i(immediate6 & 0xFFF, 0, 0, rd, 0x13);
+		case 0x0D:
+			if (rd == 2)
+			{
+				// c.addi16sp
+				uint32_t immediate = ((c >> 3) & 0x200) | ((c << 3) & 0x20) | ((c >> 2) & 0x10) | ((c << 1) & 0x40) | ((c << 4) & 0x180);
+				return immediate ? rel32_encode_compressed_i(rel32_sign_extend(immediate, 9) & 0xFFF, 2, 0, 2, 0x13) : 0;
+			}
+			// c.lui
+			return (immediate6 & 0x3F) ? ((immediate6 << 12) | (rd << 7) | 0x37) : 0;
+		case 0x11:
+			switch ((c >> 10) & 3)
+			{
+				case 0:
+					// c.srli, shift amounts of 32 and up are reserved on RV32
+					return (c & 0x1000) ? 0 : rel32_encode_compressed_i(rs2, rs1_prime, 5, rs1_prime, 0x13);
+				case 1:
+					// c.srai
+					return (c & 0x1000) ? 0 : rel32_encode_compressed_i(0x400 | rs2, rs1_prime, 5, rs1_prime, 0x13);
+				case 2:
+					// c.andi
+					return rel32_encode_compressed_i(immediate6 & 0xFFF, rs1_prime, 7, rs1_prime, 0x13);
+				default:
+				{
+					// c.sub, c.xor, c.or and c.and, the other half is RV64 only
+					static const uint8_t function3_table[4] = { 0, 4, 6, 7 };
+					uint32_t operation = (c >> 5) & 3;
+					return (c & 0x1000) ? 0 : rel32_encode_compressed_r(operation ? 0 : 0x20, rd_prime, rs1_prime, function3_table[operation], rs1_prime);
+				}
+			}
+		case 0x19:
+		case 0x1D:
+		{
+			// c.beqz and c.bnez
+			uint32_t immediate = ((c >> 4) & 0x100) | ((c >> 7) & 0x18) | ((c << 1) & 0xC0) | ((c >> 2) & 0x6) | ((c << 3) & 0x20);
+			return rel32_encode_compressed_b(rel32_sign_extend(immediate, 8), rs1_prime, (c >> 13) & 1);
+		}
+		case 0x02:
+			// c.slli
+			return (c & 0x1000) ? 0 : rel32_encode_compressed_i(rs2, rd, 1, rd, 0x13);
+		case 0x06:
+			// c.fldsp
+			return rel32_encode_compressed_i(((c >> 7) & 0x20) | ((c >> 2) & 0x18) | ((c << 4) & 0x1C0), 2, 3, rd, 0x07);
+		case 0x0A:
+			// c.lwsp
+			return rd ? rel32_encode_compressed_i(((c >> 7) & 0x20) | ((c >> 2) & 0x1C) | ((c << 4) & 0xC0), 2, 2, rd, 0x03) : 0;
+		case 0x0E:
+			// c.flwsp
+			return rel32_encode_compressed_i(((c >> 7) & 0x20) | ((c >> 2) & 0x1C) | ((c << 4) & 0xC0), 2, 2, rd, 0x07);
+		case 0x12:
+			if (!(c & 0x1000))
+			{
+				// c.jr and c.mv
+				if (rs2)
+					return rel32_encode_compressed_r(0, rs2, 0, 0, rd);
+				return rd ? rel32_encode_compressed_i(0, rd, 0, 0, 0x67) : 0;
+			}
+			// c.ebreak, c.jalr and c.add
+			if (rs2)
+				return rel32_encode_compressed_r(0, rs2, rd, 0, rd);
+			return rd ? rel32_encode_compressed_i(0, rd, 0, 1, 0x67) : 0x00100073;
+		case 0x16:
+			// c.fsdsp
+			return rel32_encode_compressed_s(((c >> 7) & 0x38) | ((c >> 1) & 0x1C0), rs2, 2, 3, 0x27);
+		case 0x1A:
+			// c.swsp
+			return rel32_encode_compressed_s(((c >> 7) & 0x3C) | ((c >> 1) & 0xC0), rs2, 2, 2, 0x23);
+		case 0x1E:
+			// c.fswsp
+			return rel32_encode_compressed_s(((c >> 7) & 0x3C) | ((c >> 1) & 0xC0), rs2, 2, 2, 0x27);
+		default:
+			return 0;
+	}
+}
+
+// fills the fields of a 32-bit instruction, compressed instructions are described by the instruction they expand to
+static void rel32_decode_instruction_fields(uint32_t instruction, rel32_instruction_information_t* information_information)
+{
+	information_information->encoding =
+		((((instruction & 0x0000007F) == 0x33) || ((instruction & 0x0000007F) == 0x2F) || ((instruction & 0x0000007F) == 0x53) || ((instruction & 0x00000073) == 0x43)) ? REL_ENCODING_R : 0) |
+		((((instruction & 0x0000007F) == 0x67) || ((instruction & 0x0000007F) == 0x73) || ((instruction & 0x0000007F) == 0x0F) || ((instruction & 0x0000007F) == 0x03) || ((instruction & 0x0000007F) == 0x13) || ((instruction & 0x0000007F) == 0x07)) ? REL_ENCODING_I : 0) |
+		((((instruction & 0x0000007F) == 0x23) || ((instruction & 0x0000007F) == 0x27)) ? REL_ENCODING_S : 0) |
+		(((instruction & 0x0000007F) == 0x63) ? REL_ENCODING_B : 0) |
+		((((instruction & 0x0000007F) == 0x37) || ((instruction & 0x0000007F) == 0x17)) ? REL_ENCODING_U : 0) |
+		(((instruction & 0x0000007F) == 0x6F) ? REL_ENCODING_J : 0);
+	information_information->opcode = (instruction >> 0) & 0x0000007F;
+	information_information->rd = (instruction >> 7) & 0x0000001F;
+	information_information->function3 = (instruction >> 12) & 0x00000007;
+	information_information->rs1 = (instruction >> 15) & 0x0000001F;
+	information_information->rs2 = (instruction >> 20) & 0x0000001F;
+	information_information->function7 = (instruction >> 25) & 0x0000007F;
+
+	switch (information_information->encoding)
+	{
+		case REL_ENCODING_X:
+			information_information->intermediate = 0;
+			break;
+		case REL_ENCODING_R:
+			information_information->intermediate = 0;
+			break;
+		case REL_ENCODING_I:
+			information_information->intermediate =
+				(((uint32_t)0 - (instruction >> 31)) & ~0x000007FF) |
+				(instruction >> 20);
+			break;
+		case REL_ENCODING_S:
+			information_information->intermediate =
+				(((uint32_t)0 - (instruction >> 31)) & ~0x000007FF) |
+				((instruction >> 20) & 0x000007E0) |
+				((instruction >> 7) & 0x0000001F);
+			break;
+		case REL_ENCODING_B:
+			information_information->intermediate =
+				(((uint32_t)0 - (instruction >> 31)) & ~0x00000FFF) |
+				((instruction << 4) & 0x00000800) |
+				((instruction >> 20) & 0x000007E0) |
+				((instruction >> 7) & 0x0000001E);
+			break;
+		case REL_ENCODING_U:
+			information_information->intermediate = instruction & 0xFFFFF000;
+			break;
+		case REL_ENCODING_J:
+			information_information->intermediate =
+				(((uint32_t)0 - (instruction >> 31)) & ~0x000FFFFF) |
+				(instruction & 0x000FF000) |
+				((instruction >> 9) & 0x00000800) |
+				((instruction >> 20) & 0x000007FE);
+			break;
+		default:
+			break;
+	}
+}
+
 void rel32_decode_instruction(const void* address_of_instruction, rel32_instruction_information_t* information_information)
 {
 	uint32_t instruction = ((uint32_t)*(uint8_t*)((uintptr_t)address_of_instruction + 0) << 0) | ((uint32_t)*(uint8_t*)((uintptr_t)address_of_instruction + 1) << 8);
 	int instruction_is_compressed = (instruction & 0x0003) != 0x0003;
+	uint32_t expanded_instruction;
 	if (instruction_is_compressed)
 	{
+		expanded_instruction = rel32_expand_compressed_instruction((uint16_t)instruction);
 		information_information->size = 2;
-		information_information->encoding = 0;
-		information_information->opcode = (instruction >> 0) & 0x0003;
-		information_information->rd = 0;
-		information_information->function3 = 0;
-		information_information->rs1 = 0;
-		information_information->rs2 = 0;
-		information_information->function7 = 0;
-		information_information->compressed_function6 = 0;
-		information_information->compressed_function4 = 0;
-		information_information->compressed_function3 = 0;
+		information_information->compressed_function6 = (instruction >> 10) & 0x3F;
+		information_information->compressed_function4 = (instruction >> 12) & 0x0F;
+		information_information->compressed_function3 = (instruction >> 13) & 0x07;
+		if (expanded_instruction)
+			rel32_decode_instruction_fields(expanded_instruction, information_information);
+		else
+		{
+			information_information->encoding = 0;
+			information_information->opcode = (instruction >> 0) & 0x0003;
+			information_information->rd = 0;
+			information_information->function3 = 0;
+			information_information->rs1 = 0;
+			information_information->rs2 = 0;
+			information_information->function7 = 0;
 
-		information_information->intermediate = 0;
+			information_information->intermediate = 0;
+		}
 	}
 	else
 	{
 		instruction |= ((uint32_t)*(uint8_t*)((uintptr_t)address_of_instruction + 2) << 16) | ((uint32_t)*(uint8_t*)((uintptr_t)address_of_instruction + 3) << 24);
+		expanded_instruction = instruction;
 
 		information_information->size = 4;
-		information_information->encoding =
-			((((instruction & 0x0000007F) == 0x33) || ((instruction & 0x0000007F) == 0x2F)) ? REL_ENCODING_R : 0) |
-			((((instruction & 0x0000007F) == 0x67) || ((instruction & 0x0000007F) == 0x73) || ((instruction & 0x0000007F) == 0x0F) || ((instruction & 0x0000007F) == 0x03) || ((instruction & 0x0000007F) == 0x13)) ? REL_ENCODING_I : 0) |
-			(((instruction & 0x0000007F) == 0x23) ? REL_ENCODING_S : 0) |
-			(((instruction & 0x0000007F) == 0x63) ? REL_ENCODING_B : 0) |
-			((((instruction & 0x0000007F) == 0x37) || ((instruction & 0x0000007F) == 0x17)) ? REL_ENCODING_U : 0) |
-			(((instruction & 0x0000007F) == 0x6F) ? REL_ENCODING_J : 0);
-		information_information->opcode = (instruction >> 0) & 0x0000007F;
-		information_information->rd = (instruction >> 7) & 0x0000001F;
-		information_information->function3 = (instruction >> 12) & 0x00000007;
-		information_information->rs1 = (instruction >> 15) & 0x0000001F;
-		information_information->rs2 = (instruction >> 20) & 0x0000001F;
-		information_information->function7 = (instruction >> 25) & 0x0000007F;
 		information_information->compressed_function6 = 0;
 		information_information->compressed_function4 = 0;
 		information_information->compressed_function3 = 0;
-
-		switch (information_information->encoding)
-		{
-			case REL_ENCODING_X:
-				information_information->intermediate = 0;
-				break;
-			case REL_ENCODING_R:
-				information_information->intermediate = 0;
-				break;
-			case REL_ENCODING_I:
-				information_information->intermediate =
-					(((uint32_t)0 - (instruction >> 31)) & ~0x000007FF) |
-					(instruction >> 20);
-				break;
-			case REL_ENCODING_S:
-				information_information->intermediate =
-					(((uint32_t)0 - (instruction >> 31)) & ~0x000007FF) |
-					((instruction >> 20) & 0x000007E0) |
-					((instruction >> 7) & 0x0000001F);
-				break;
-			case REL_ENCODING_B:
-				information_information->intermediate =
-					(((uint32_t)0 - (instruction >> 31)) & ~0x00000FFF) |
-					((instruction << 4) & 0x00000800) |
-					((instruction >> 20) & 0x000007E0) |
-					((instruction >> 7) & 0x0000001E);
-				break;
-			case REL_ENCODING_U:
-				information_information->intermediate = instruction & 0xFFFFF000;
-				break;
-			case REL_ENCODING_J:
-				information_information->intermediate =
-					(((uint32_t)0 - (instruction >> 31)) & ~0x000FFFFF) |
-					(instruction & 0x000FF000) |
-					((instruction >> 9) & 0x00000800) |
-					((instruction >> 20) & 0x000003FE);
-				break;
-			default:
-				break;
-		}
+		rel32_decode_instruction_fields(instruction, information_information);
 	}
 
-	int instruction_index = 0;
-	while (instruction_index != (sizeof(instruction_table) / sizeof(*instruction_table)) && (instruction & instruction_table[instruction_index].constant_mask) != instruction_table[instruction_index].constant)
-		++instruction_index;
-
-	if (instruction_index != (sizeof(instruction_table) / sizeof(*instruction_table)))
+	int instruction_index = expanded_instruction ? rel32_find_instruction_index(expanded_instruction) : -1;
+	if (instruction_index != -1)
 	{
 		information_information->mnemonic = instruction_table[instruction_index].mnemonic;
 		information_information->module = instruction_table[instruction_index].module;
@@ -327,6 +744,293 @@ void rel32_decode_instruction(const void* address_of_instruction, rel32_instruct
 	information_information->machine_code = instruction;
 }
 
+// every field but size may be left null, a batch that only asks for size and machine_code needs no table lookup or expansion
+static int rel32_batch_needs_decoding(const rel32_instruction_batch_t* batch)
+{
+	return batch->encoding || batch->opcode || batch->rd || batch->function3 || batch->rs1 || batch->rs2 || batch->function7 || batch->intermediate || batch->instruction_index;
+}
+
+static void rel32_decode_batch_scalar(const void* address_of_instructions, size_t first, size_t end, const rel32_instruction_batch_t* batch)
+{
+	if (!rel32_batch_needs_decoding(batch))
+	{
+		for (size_t i = first; i != end; ++i)
+		{
+			const uint8_t* bytes = (const uint8_t*)((uintptr_t)address_of_instructions + i * 4);
+			uint32_t instruction = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8);
+			batch->size[i] = ((instruction & 3) == 3) ? 4 : 2;
+			if (batch->machine_code)
+				batch->machine_code[i] = ((instruction & 3) == 3) ? (instruction | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24)) : instruction;
+		}
+		return;
+	}
+
+	for (size_t i = first; i != end; ++i)
+	{
+		rel32_instruction_information_t info;
+		rel32_decode_instruction((const void*)((uintptr_t)address_of_instructions + i * 4), &info);
+		batch->size[i] = info.size;
+		if (batch->machine_code)
+			batch->machine_code[i] = info.machine_code;
+		if (batch->encoding)
+			batch->encoding[i] = info.encoding;
+		if (batch->opcode)
+			batch->opcode[i] = info.opcode;
+		if (batch->rd)
+			batch->rd[i] = info.rd;
+		if (batch->function3)
+			batch->function3[i] = info.function3;
+		if (batch->rs1)
+			batch->rs1[i] = info.rs1;
+		if (batch->rs2)
+			batch->rs2[i] = info.rs2;
+		if (batch->function7)
+			batch->function7[i] = info.function7;
+		if (batch->intermediate)
+			batch->intermediate[i] = info.intermediate;
+		if (batch->instruction_index)
+			batch->instruction_index[i] = info.instruction_index;
+	}
+}
+
+#if defined(REL32_SIMD_DECODE_SUPPORTED)
+// the same arithmetic as rel32_decode_instruction on whole vectors of 32-bit words, compressed lanes are decoded again one at a time since they need expanding
+#define REL32_DECODE_BATCH_VECTOR(V, SET1, AND, OR, ANDNOT, SRLI, SRAI, SLLI, CMPEQ, BLENDV) \
+	V is_full = CMPEQ(AND(instruction, SET1(3)), SET1(3)); \
+	V opcode = AND(instruction, SET1(0x7F)); \
+	V is_r = OR(OR(CMPEQ(opcode, SET1(0x33)), CMPEQ(opcode, SET1(0x2F))), OR(CMPEQ(opcode, SET1(0x53)), CMPEQ(AND(opcode, SET1(0x73)), SET1(0x43)))); \
+	V is_i = OR(OR(OR(CMPEQ(opcode, SET1(0x67)), CMPEQ(opcode, SET1(0x73))), OR(OR(CMPEQ(opcode, SET1(0x0F)), CMPEQ(opcode, SET1(0x03))), CMPEQ(opcode, SET1(0x13)))), CMPEQ(opcode, SET1(0x07))); \
+	V is_s = OR(CMPEQ(opcode, SET1(0x23)), CMPEQ(opcode, SET1(0x27))); \
+	V is_b = CMPEQ(opcode, SET1(0x63)); \
+	V is_u = OR(CMPEQ(opcode, SET1(0x37)), CMPEQ(opcode, SET1(0x17))); \
+	V is_j = CMPEQ(opcode, SET1(0x6F)); \
+	V i_immediate = SRAI(instruction, 20); \
+	V s_immediate = OR(ANDNOT(SET1(0x1F), i_immediate), AND(SRLI(instruction, 7), SET1(0x1F))); \
+	V b_immediate = OR(OR(ANDNOT(SET1(0xFFF), SRAI(instruction, 19)), AND(SLLI(instruction, 4), SET1(0x800))), OR(AND(SRLI(instruction, 20), SET1(0x7E0)), AND(SRLI(instruction, 7), SET1(0x1E)))); \
+	V u_immediate = ANDNOT(SET1(0xFFF), instruction); \
+	V j_immediate = OR(OR(ANDNOT(SET1(0xFFFFF), SRAI(instruction, 11)), AND(instruction, SET1(0xFF000))), OR(AND(SRLI(instruction, 9), SET1(0x800)), AND(SRLI(instruction, 20), SET1(0x7FE)))); \
+	V machine_code = BLENDV(AND(instruction, SET1(0xFFFF)), instruction, is_full); \
+	V size = OR(AND(is_full, SET1(4)), ANDNOT(is_full, SET1(2))); \
+	V encoding = OR(OR(OR(AND(is_r, SET1(REL_ENCODING_R)), AND(is_i, SET1(REL_ENCODING_I))), OR(AND(is_s, SET1(REL_ENCODING_S)), AND(is_b, SET1(REL_ENCODING_B)))), OR(AND(is_u, SET1(REL_ENCODING_U)), AND(is_j, SET1(REL_ENCODING_J)))); \
+	V intermediate = OR(OR(AND(is_i, i_immediate), AND(is_s, s_immediate)), OR(OR(AND(is_b, b_immediate), AND(is_u, u_immediate)), AND(is_j, j_immediate))); \
+	opcode = BLENDV(AND(instruction, SET1(3)), opcode, is_full); \
+	V rd = AND(AND(SRLI(instruction, 7), SET1(0x1F)), is_full); \
+	V function3 = AND(AND(SRLI(instruction, 12), SET1(0x7)), is_full); \
+	V rs1 = AND(AND(SRLI(instruction, 15), SET1(0x1F)), is_full); \
+	V rs2 = AND(AND(SRLI(instruction, 20), SET1(0x1F)), is_full); \
+	V function7 = AND(SRLI(instruction, 25), is_full);
+
+__attribute__((target("sse4.1"))) static void rel32_store_batch_bytes_sse41(uint8_t* destination, __m128i value)
+{
+	int bytes = _mm_cvtsi128_si32(_mm_shuffle_epi8(value, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)));
+	__builtin_memcpy(destination, &bytes, 4);
+}
+
+__attribute__((target("sse4.1"))) static void rel32_decode_batch_sse41(const void* address_of_instructions, size_t instruction_count, const rel32_instruction_batch_t* batch)
+{
+	size_t vector_end = instruction_count & ~(size_t)3;
+	for (size_t i = 0; i != vector_end; i += 4)
+	{
+		__m128i instruction = _mm_loadu_si128((const __m128i*)((uintptr_t)address_of_instructions + i * 4));
+		REL32_DECODE_BATCH_VECTOR(__m128i, _mm_set1_epi32, _mm_and_si128, _mm_or_si128, _mm_andnot_si128, _mm_srli_epi32, _mm_srai_epi32, _mm_slli_epi32, _mm_cmpeq_epi32, _mm_blendv_epi8)
+		if (batch->machine_code)
+			_mm_storeu_si128((__m128i*)(batch->machine_code + i), machine_code);
+		if (batch->intermediate)
+			_mm_storeu_si128((__m128i*)(batch->intermediate + i), intermediate);
+		rel32_store_batch_bytes_sse41(batch->size + i, size);
+		if (batch->encoding)
+			rel32_store_batch_bytes_sse41(batch->encoding + i, encoding);
+		if (batch->opcode)
+			rel32_store_batch_bytes_sse41(batch->opcode + i, opcode);
+		if (batch->rd)
+			rel32_store_batch_bytes_sse41(batch->rd + i, rd);
+		if (batch->function3)
+			rel32_store_batch_bytes_sse41(batch->function3 + i, function3);
+		if (batch->rs1)
+			rel32_store_batch_bytes_sse41(batch->rs1 + i, rs1);
+		if (batch->rs2)
+			rel32_store_batch_bytes_sse41(batch->rs2 + i, rs2);
+		if (batch->function7)
+			rel32_store_batch_bytes_sse41(batch->function7 + i, function7);
+	}
+	if (rel32_batch_needs_decoding(batch))
+	{
+		for (size_t i = 0; i != vector_end; ++i)
+			if (batch->size[i] != 4)
+				rel32_decode_batch_scalar(address_of_instructions, i, i + 1, batch);
+			else if (batch->instruction_index)
+			{
+				uint32_t instruction;
+				__builtin_memcpy(&instruction, (const void*)((uintptr_t)address_of_instructions + i * 4), 4);
+				batch->instruction_index[i] = rel32_find_instruction_index(instruction);
+			}
+	}
+	rel32_decode_batch_scalar(address_of_instructions, vector_end, instruction_count, batch);
+}
+
+__attribute__((target("avx2"))) static void rel32_store_batch_bytes_avx2(uint8_t* destination, __m256i value)
+{
+	// each 128-bit lane gathers its four low bytes, then the two groups are moved next to each other
+	__m256i bytes = _mm256_shuffle_epi8(value, _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+	bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1));
+	_mm_storel_epi64((__m128i*)destination, _mm256_castsi256_si128(bytes));
+}
+
+__attribute__((target("avx2"))) static void rel32_decode_batch_avx2(const void* address_of_instructions, size_t instruction_count, const rel32_instruction_batch_t* batch)
+{
+	size_t vector_end = instruction_count & ~(size_t)7;
+	for (size_t i = 0; i != vector_end; i += 8)
+	{
+		__m256i instruction = _mm256_loadu_si256((const __m256i*)((uintptr_t)address_of_instructions + i * 4));
+		REL32_DECODE_BATCH_VECTOR(__m256i, _mm256_set1_epi32, _mm256_and_si256, _mm256_or_si256, _mm256_andnot_si256, _mm256_srli_epi32, _mm256_srai_epi32, _mm256_slli_epi32, _mm256_cmpeq_epi32, _mm256_blendv_epi8)
+		if (batch->machine_code)
+			_mm256_storeu_si256((__m256i*)(batch->machine_code + i), machine_code);
+		if (batch->intermediate)
+			_mm256_storeu_si256((__m256i*)(batch->intermediate + i), intermediate);
+		rel32_store_batch_bytes_avx2(batch->size + i, size);
+		if (batch->encoding)
+			rel32_store_batch_bytes_avx2(batch->encoding + i, encoding);
+		if (batch->opcode)
+			rel32_store_batch_bytes_avx2(batch->opcode + i, opcode);
+		if (batch->rd)
+			rel32_store_batch_bytes_avx2(batch->rd + i, rd);
+		if (batch->function3)
+			rel32_store_batch_bytes_avx2(batch->function3 + i, function3);
+		if (batch->rs1)
+			rel32_store_batch_bytes_avx2(batch->rs1 + i, rs1);
+		if (batch->rs2)
+			rel32_store_batch_bytes_avx2(batch->rs2 + i, rs2);
+		if (batch->function7)
+			rel32_store_batch_bytes_avx2(batch->function7 + i, function7);
+	}
+	if (rel32_batch_needs_decoding(batch))
+	{
+		for (size_t i = 0; i != vector_end; ++i)
+			if (batch->size[i] != 4)
+				rel32_decode_batch_scalar(address_of_instructions, i, i + 1, batch);
+			else if (batch->instruction_index)
+			{
+				uint32_t instruction;
+				__builtin_memcpy(&instruction, (const void*)((uintptr_t)address_of_instructions + i * 4), 4);
+				batch->instruction_index[i] = rel32_find_instruction_index(instruction);
+			}
+	}
+	rel32_decode_batch_scalar(address_of_instructions, vector_end, instruction_count, batch);
+}
+#endif
+
+static volatile int rel32_batch_decoder;
+
+static int rel32_is_batch_decoder_supported(int decoder)
+{
+	switch (decoder)
+	{
+		case REL_BATCH_DECODER_SCALAR:
+			return 1;
+#if defined(REL32_SIMD_DECODE_SUPPORTED)
+		case REL_BATCH_DECODER_SSE41:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse4.1");
+		case REL_BATCH_DECODER_AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		default:
+			return 0;
+	}
+}
+
+int rel32_select_batch_decoder(int decoder)
+{
+	if (decoder == REL_BATCH_DECODER_AUTOMATIC)
+	{
+		decoder = REL_BATCH_DECODER_AVX2;
+		while (!rel32_is_batch_decoder_supported(decoder))
+			--decoder;
+	}
+	else if (!rel32_is_batch_decoder_supported(decoder))
+		return ENOTSUP;
+
+	rel32_batch_decoder = decoder;
+	return 0;
+}
+
+int rel32_get_batch_decoder(void)
+{
+	if (!rel32_batch_decoder)
+		rel32_select_batch_decoder(REL_BATCH_DECODER_AUTOMATIC);
+	return rel32_batch_decoder;
+}
+
+static void rel32_decode_batch(int decoder, const void* address_of_instructions, size_t instruction_count, const rel32_instruction_batch_t* batch)
+{
+	switch (decoder)
+	{
+#if defined(REL32_SIMD_DECODE_SUPPORTED)
+		case REL_BATCH_DECODER_AVX2:
+			rel32_decode_batch_avx2(address_of_instructions, instruction_count, batch);
+			break;
+		case REL_BATCH_DECODER_SSE41:
+			rel32_decode_batch_sse41(address_of_instructions, instruction_count, batch);
+			break;
+#endif
+		default:
+			rel32_decode_batch_scalar(address_of_instructions, 0, instruction_count, batch);
+			break;
+	}
+}
+
+void rel32_decode_instruction_batch(const void* address_of_instructions, size_t instruction_count, const rel32_instruction_batch_t* batch)
+{
+	rel32_decode_batch(rel32_get_batch_decoder(), address_of_instructions, instruction_count, batch);
+}
+
+#define REL32_CHECK_BATCH_SIZE 64
+
+int rel32_check_batch_decoder(int decoder, const void* address_of_instructions, size_t instruction_count, size_t* mismatch_index)
+{
+	if (!rel32_is_batch_decoder_supported(decoder))
+		return ENOTSUP;
+
+	uint32_t machine_code[REL32_CHECK_BATCH_SIZE];
+	uint8_t size[REL32_CHECK_BATCH_SIZE];
+	uint8_t encoding[REL32_CHECK_BATCH_SIZE];
+	uint8_t opcode[REL32_CHECK_BATCH_SIZE];
+	uint8_t rd[REL32_CHECK_BATCH_SIZE];
+	uint8_t function3[REL32_CHECK_BATCH_SIZE];
+	uint8_t rs1[REL32_CHECK_BATCH_SIZE];
+	uint8_t rs2[REL32_CHECK_BATCH_SIZE];
+	uint8_t function7[REL32_CHECK_BATCH_SIZE];
+	uint32_t intermediate[REL32_CHECK_BATCH_SIZE];
+	int instruction_index[REL32_CHECK_BATCH_SIZE];
+	const rel32_instruction_batch_t batch = { machine_code, size, encoding, opcode, rd, function3, rs1, rs2, function7, intermediate, instruction_index };
+	// a batch that only asks for sizes takes its own path through the decoder
+	uint32_t size_only_machine_code[REL32_CHECK_BATCH_SIZE];
+	uint8_t size_only_size[REL32_CHECK_BATCH_SIZE];
+	const rel32_instruction_batch_t size_only_batch = { size_only_machine_code, size_only_size, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+	for (size_t first = 0; first < instruction_count; first += REL32_CHECK_BATCH_SIZE)
+	{
+		size_t count = (instruction_count - first < REL32_CHECK_BATCH_SIZE) ? (instruction_count - first) : REL32_CHECK_BATCH_SIZE;
+		const void* address = (const void*)((uintptr_t)address_of_instructions + first * 4);
+		rel32_decode_batch(decoder, address, count, &batch);
+		rel32_decode_batch(decoder, address, count, &size_only_batch);
+		for (size_t i = 0; i != count; ++i)
+		{
+			rel32_instruction_information_t info;
+			rel32_decode_instruction((const void*)((uintptr_t)address + i * 4), &info);
+			if (machine_code[i] != info.machine_code || size[i] != info.size || encoding[i] != info.encoding || opcode[i] != info.opcode ||
+				rd[i] != info.rd || function3[i] != info.function3 || rs1[i] != info.rs1 || rs2[i] != info.rs2 || function7[i] != info.function7 ||
+				intermediate[i] != info.intermediate || instruction_index[i] != info.instruction_index ||
+				size_only_machine_code[i] != info.machine_code || size_only_size[i] != info.size)
+			{
+				*mismatch_index = first + i;
+				return EILSEQ;
+			}
+		}
+	}
+	return 0;
+}
+
 int rel32_get_register_name(int context, int number, int use_abi_name, char** pointer_to_name_pointer, size_t* pointer_name_size)
 {
 	if (context == REL_REGISTER_CONTEXT_GENERAL)
@@ -381,6 +1085,58 @@ int rel32_get_register_name(int context, int number, int use_abi_name, char** po
 		else
 			return ENOENT;
 	}
+	else if (context == REL_REGISTER_CONTEXT_FLOAT)
+	{
+		static const struct { size_t register_name_size; const char* register_name; size_t abi_name_size; const char* abi_name; } float_register_table[32] = {
+			{ 2, "f0", 3, "ft0" },
+			{ 2, "f1", 3, "ft1" },
+			{ 2, "f2", 3, "ft2" },
+			{ 2, "f3", 3, "ft3" },
+			{ 2, "f4", 3, "ft4" },
+			{ 2, "f5", 3, "ft5" },
+			{ 2, "f6", 3, "ft6" },
+			{ 2, "f7", 3, "ft7" },
+			{ 2, "f8", 3, "fs0" },
+			{ 2, "f9", 3, "fs1" },
+			{ 3, "f10", 3, "fa0" },
+			{ 3, "f11", 3, "fa1" },
+			{ 3, "f12", 3, "fa2" },
+			{ 3, "f13", 3, "fa3" },
+			{ 3, "f14", 3, "fa4" },
+			{ 3, "f15", 3, "fa5" },
+			{ 3, "f16", 3, "fa6" },
+			{ 3, "f17", 3, "fa7" },
+			{ 3, "f18", 3, "fs2" },
+			{ 3, "f19", 3, "fs3" },
+			{ 3, "f20", 3, "fs4" },
+			{ 3, "f21", 3, "fs5" },
+			{ 3, "f22", 3, "fs6" },
+			{ 3, "f23", 3, "fs7" },
+			{ 3, "f24", 3, "fs8" },
+			{ 3, "f25", 3, "fs9" },
+			{ 3, "f26", 4, "fs10" },
+			{ 3, "f27", 4, "fs11" },
+			{ 3, "f28", 3, "ft8" },
+			{ 3, "f29", 3, "ft9" },
+			{ 3, "f30", 4, "ft10" },
+			{ 3, "f31", 4, "ft11" } };
+		if (number < 32)
+		{
+			if (use_abi_name)
+			{
+				*pointer_to_name_pointer = (char*)float_register_table[number].abi_name;
+				*pointer_name_size = float_register_table[number].abi_name_size;
+			}
+			else
+			{
+				*pointer_to_name_pointer = (char*)float_register_table[number].register_name;
+				*pointer_name_size = float_register_table[number].register_name_size;
+			}
+			return 0;
+		}
+		else
+			return ENOENT;
+	}
 	else if (context == REL_REGISTER_CONTEXT_PC)
 	{
 		if (!number)
@@ -396,580 +1152,4767 @@ int rel32_get_register_name(int context, int number, int use_abi_name, char** po
 		return ENOENT;
 }
 
-int rel32_disassemble_instruction(int flags, const void* base_address, uint32_t address_of_instruction, size_t assembly_buffer_size, size_t* assembly_size, char* assembly_buffer)
-{
-	rel32_instruction_information_t info;
-	rel32_decode_instruction((const void*)((uintptr_t)base_address + (uintptr_t)address_of_instruction), &info);
-
-	char* write = assembly_buffer;
-	char* write_limit = assembly_buffer + assembly_buffer_size;
-	char* register_name;
-	size_t part_size;
+#define REL32_FORMAT_MNEMONIC_SLOT_SIZE 16
+#define REL32_FORMAT_OPERAND_SLOT_SIZE 8
 
-	if (flags & REL_DISASSEMBLE_ADDRESS)
-	{
-		if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 9)
-			return ENOBUFS;
-		part_size = rel32_print_hex(address_of_instruction, write);
-		write[part_size] = ' ';
-		write += part_size + 1;
-	}
+// fixed size slots that are copied whole with the text size in the last byte, the formatter overwrites the padding as it goes
+static rel32_once_t format_tables_once = REL32_ONCE_INITIALIZER;
+static struct
+{
+	uint64_t mnemonic_table[REL32_INSTRUCTION_TABLE_SIZE + 1][REL32_FORMAT_MNEMONIC_SLOT_SIZE / 8];/* the last slot is "unknown" */
+	uint64_t register_operand_table[2][2][2][32];/* indexed by floating-point register file, abi names, separator ", " instead of " " and register number */
+} format_tables;
 
-	if (flags & REL_DISASSEMBLE_MACHINE_CODE)
+static void rel32_build_format_tables(void)
+{
+	for (size_t row = 0; row != REL32_INSTRUCTION_TABLE_SIZE + 1; ++row)
 	{
-		if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 9)
-			return ENOBUFS;
-		part_size = rel32_print_hex_digits(info.size * 2, info.machine_code, write);
-		write[part_size] = ' ';
-		write += part_size + 1;
+		const char* mnemonic = (row != REL32_INSTRUCTION_TABLE_SIZE) ? instruction_table[row].mnemonic : "unknown";
+		size_t mnemonic_size = rel32_string_size(mnemonic);
+		assert(mnemonic_size < REL32_FORMAT_MNEMONIC_SLOT_SIZE);
+		char* slot = (char*)format_tables.mnemonic_table[row];
+		rel32_copy(slot, mnemonic, mnemonic_size);
+		slot[REL32_FORMAT_MNEMONIC_SLOT_SIZE - 1] = (char)mnemonic_size;
 	}
 
-	if (info.instruction_index != -1)
-	{
-		if (flags & REL_DISASSEMBLE_ENCODING)
-		{
-			if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 4)
-				return ENOBUFS;
+	for (int is_float = 0; is_float != 2; ++is_float)
+		for (int use_abi_name = 0; use_abi_name != 2; ++use_abi_name)
+			for (int number = 0; number != 32; ++number)
+			{
+				char* register_name;
+				size_t register_name_size;
+				rel32_get_register_name(is_float ? REL_REGISTER_CONTEXT_FLOAT : REL_REGISTER_CONTEXT_GENERAL, number, use_abi_name, &register_name, &register_name_size);
+				for (int has_comma = 0; has_comma != 2; ++has_comma)
+				{
+					char* slot = (char*)&format_tables.register_operand_table[is_float][use_abi_name][has_comma][number];
+					slot[0] = ',';
+					slot[has_comma] = ' ';
+					rel32_copy(slot + 1 + has_comma, register_name, register_name_size);
+					slot[REL32_FORMAT_OPERAND_SLOT_SIZE - 1] = (char)(1 + has_comma + register_name_size);
+				}
+			}
+}
 
-			static const char encoding_types[7] = { 'x', 'r', 'i', 's', 'b', 'u', 'j' };
-			write[0] = '(';
-			write[1] = encoding_types[info.encoding];
-			write[2] = ')';
-			write[3] = ' ';
-			write += 4;
-		}
+static inline char* rel32_format_register(char* write, const uint64_t* register_operand_table, uint32_t number)
+{
+	const uint64_t* slot = register_operand_table + (number & 0x1F);
+	REL32_COPY_WORD(write, slot);
+	return write + ((const char*)slot)[REL32_FORMAT_OPERAND_SLOT_SIZE - 1];
+}
 
-		part_size = rel32_string_size(info.mnemonic);
-		if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size)
-			return ENOBUFS;
-		rel32_copy(write, info.mnemonic, part_size);
-		write += part_size;
+static inline char* rel32_format_immediate(char* write, int32_t value)
+{
+	write[0] = ',';
+	write[1] = ' ';
+	return write + 2 + rel32_print_signed(value, write + 2);
+}
 
-		switch (instruction_table[info.instruction_index].assembly_encoding)
-		{
-			case REL_ENCODING_X:
-				// unknown encoding
-				break;
-			case REL_ENCODING_R:
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rd, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 1)
-					return ENOBUFS;
-				*write = ' ';
-				rel32_copy(write + 1, register_name, part_size);
-				write += part_size + 1;
-
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rs1, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 2)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				rel32_copy(write + 2, register_name, part_size);
-				write += part_size + 2;
+static const char rel32_lowercase_hex_table[17] = "0123456789abcdef";
 
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rs2, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 2)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				rel32_copy(write + 2, register_name, part_size);
-				write += part_size + 2;
+// lowercase without leading zeros like binutils prints addresses and immediates
+static char* rel32_format_lowercase_hex(char* write, uint32_t value)
+{
+	int digit_count = 1;
+	while (digit_count != 8 && (value >> (digit_count << 2)))
+		++digit_count;
+	for (int i = digit_count - 1; i >= 0; --i, value >>= 4)
+		write[i] = rel32_lowercase_hex_table[value & 0xF];
+	return write + digit_count;
+}
 
-				break;
-			case REL_ENCODING_I:
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rd, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 1)
-					return ENOBUFS;
-				*write = ' ';
-				rel32_copy(write + 1, register_name, part_size);
-				write += part_size + 1;
-
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rs1, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 2)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				rel32_copy(write + 2, register_name, part_size);
-				write += part_size + 2;
+static char* rel32_format_text(char* write, const char* text)
+{
+	size_t size = rel32_string_size(text);
+	rel32_copy(write, text, size);
+	return write + size;
+}
 
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 13)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				part_size = rel32_print_signed(*(int32_t*)&info.intermediate, write + 2);
-				write += part_size + 2;
+static char* rel32_format_register_name(char* write, int flags, int context, uint32_t number)
+{
+	char* name;
+	size_t name_size;
+	rel32_get_register_name(context, (int)number, (flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS) ? 1 : 0, &name, &name_size);
+	rel32_copy(write, name, name_size);
+	return write + name_size;
+}
 
-				break;
-			case REL_ENCODING_S:
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rs1, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 1)
-					return ENOBUFS;
-				*write = ' ';
-				rel32_copy(write + 1, register_name, part_size);
-				write += part_size + 1;
-
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rs2, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 2)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				rel32_copy(write + 2, register_name, part_size);
-				write += part_size + 2;
+// CSR names of the privileged specification the way binutils prints them, unnamed ones as hex
+static char* rel32_format_csr(char* write, uint32_t csr)
+{
+	static const struct { uint16_t csr; const char* name; } csr_table[] = {
+		{ 0x001, "fflags" }, { 0x002, "frm" }, { 0x003, "fcsr" },
+		{ 0x100, "sstatus" }, { 0x104, "sie" }, { 0x105, "stvec" }, { 0x106, "scounteren" }, { 0x10A, "senvcfg" },
+		{ 0x140, "sscratch" }, { 0x141, "sepc" }, { 0x142, "scause" }, { 0x143, "stval" }, { 0x144, "sip" }, { 0x180, "satp" },
+		{ 0x300, "mstatus" }, { 0x301, "misa" }, { 0x302, "medeleg" }, { 0x303, "mideleg" }, { 0x304, "mie" }, { 0x305, "mtvec" }, { 0x306, "mcounteren" },
+		{ 0x30A, "menvcfg" }, { 0x310, "mstatush" }, { 0x31A, "menvcfgh" }, { 0x320, "mcountinhibit" },
+		{ 0x340, "mscratch" }, { 0x341, "mepc" }, { 0x342, "mcause" }, { 0x343, "mtval" }, { 0x344, "mip" }, { 0x34A, "mtinst" }, { 0x34B, "mtval2" },
+		{ 0x7A0, "tselect" }, { 0x7A1, "tdata1" }, { 0x7A2, "tdata2" }, { 0x7A3, "tdata3" },
+		{ 0x7B0, "dcsr" }, { 0x7B1, "dpc" }, { 0x7B2, "dscratch0" }, { 0x7B3, "dscratch1" },
+		{ 0xB00, "mcycle" }, { 0xB02, "minstret" }, { 0xB80, "mcycleh" }, { 0xB82, "minstreth" },
+		{ 0xC00, "cycle" }, { 0xC01, "time" }, { 0xC02, "instret" }, { 0xC80, "cycleh" }, { 0xC81, "timeh" }, { 0xC82, "instreth" },
+		{ 0xF11, "mvendorid" }, { 0xF12, "marchid" }, { 0xF13, "mimpid" }, { 0xF14, "mhartid" }, { 0xF15, "mconfigptr" } };
+	static const struct { uint16_t first_csr; uint16_t count; uint16_t first_number; const char* prefix; const char* suffix; } numbered_csr_table[] = {
+		{ 0x3A0, 16, 0, "pmpcfg", "" }, { 0x3B0, 64, 0, "pmpaddr", "" }, { 0x323, 29, 3, "mhpmevent", "" },
+		{ 0xB03, 29, 3, "mhpmcounter", "" }, { 0xB83, 29, 3, "mhpmcounter", "h" },
+		{ 0xC03, 29, 3, "hpmcounter", "" }, { 0xC83, 29, 3, "hpmcounter", "h" } };
 
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 13)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				part_size = rel32_print_signed(*(int32_t*)&info.intermediate, write + 2);
-				write += part_size + 2;
+	for (size_t i = 0; i != sizeof(csr_table) / sizeof(*csr_table); ++i)
+		if (csr_table[i].csr == csr)
+			return rel32_format_text(write, csr_table[i].name);
+	for (size_t i = 0; i != sizeof(numbered_csr_table) / sizeof(*numbered_csr_table); ++i)
+		if (csr - numbered_csr_table[i].first_csr < numbered_csr_table[i].count)
+		{
+			write = rel32_format_text(write, numbered_csr_table[i].prefix);
+			write += rel32_print_unsigned(csr - numbered_csr_table[i].first_csr + numbered_csr_table[i].first_number, write);
+			return rel32_format_text(write, numbered_csr_table[i].suffix);
+		}
+	write = rel32_format_text(write, "0x");
+	return rel32_format_lowercase_hex(write, csr);
+}
 
-				break;
-			case REL_ENCODING_B:
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rs1, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 1)
-					return ENOBUFS;
-				*write = ' ';
-				rel32_copy(write + 1, register_name, part_size);
-				write += part_size + 1;
-
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rs2, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 2)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				rel32_copy(write + 2, register_name, part_size);
-				write += part_size + 2;
+// the rounding mode operand is left out when it is dyn, reserved modes print the way binutils does
+static char* rel32_format_rounding_mode(char* write, uint32_t rounding_mode)
+{
+	static const char* rounding_mode_table[8] = { "rne", "rtz", "rdn", "rup", "rmm", "unknown", "unknown", 0 };
+	if (rounding_mode_table[rounding_mode])
+	{
+		*write++ = ',';
+		write = rel32_format_text(write, rounding_mode_table[rounding_mode]);
+	}
+	return write;
+}
 
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 13)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				part_size = rel32_print_signed(*(int32_t*)&info.intermediate, write + 2);
-				write += part_size + 2;
+static char* rel32_format_memory_operand(char* write, int flags, uint32_t offset, uint32_t base_register)
+{
+	write += rel32_print_signed((int32_t)offset, write);
+	*write++ = '(';
+	write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, base_register);
+	*write++ = ')';
+	return write;
+}
 
-				break;
-			case REL_ENCODING_U:
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rd, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 2)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				rel32_copy(write + 2, register_name, part_size);
-				write += part_size + 2;
+#define REL32_OPERAND_REGISTER 0
+#define REL32_OPERAND_FLOAT_REGISTER 1
+#define REL32_OPERAND_SIGNED 2
+#define REL32_OPERAND_UNSIGNED 3
+#define REL32_OPERAND_TARGET 4
+#define REL32_OPERAND_CSR 5
+#define REL32_OPERAND_MEMORY 6
 
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 13)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				part_size = rel32_print_signed(*(int32_t*)&info.intermediate, write + 2);
-				write += part_size + 2;
+typedef struct rel32_pseudoinstruction_t
+{
+	const char* mnemonic;
+	int operand_count;
+	int operand_type_table[2];
+	uint32_t operand_table[2];// a target is the offset from the instruction, a memory operand is the base register with the offset in the next entry
+} rel32_pseudoinstruction_t;
 
-				break;
-			case REL_ENCODING_J:
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rd, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 2)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				rel32_copy(write + 2, register_name, part_size);
-				write += part_size + 2;
+static int rel32_set_pseudoinstruction(rel32_pseudoinstruction_t* pseudoinstruction, const char* mnemonic, int operand_count, int first_operand_type, uint32_t first_operand, int second_operand_type, uint32_t second_operand)
+{
+	pseudoinstruction->mnemonic = mnemonic;
+	pseudoinstruction->operand_count = operand_count;
+	pseudoinstruction->operand_type_table[0] = first_operand_type;
+	pseudoinstruction->operand_table[0] = first_operand;
+	pseudoinstruction->operand_type_table[1] = second_operand_type;
+	pseudoinstruction->operand_table[1] = second_operand;
+	return 1;
+}
 
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 13)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				part_size = rel32_print_signed(*(int32_t*)&info.intermediate, write + 2);
-				write += part_size + 2;
+// the aliases binutils prints by default, a compressed instruction is matched by the instruction it expands to
+static int rel32_find_pseudoinstruction(const rel32_instruction_information_t* info, rel32_pseudoinstruction_t* pseudoinstruction)
+{
+	uint32_t immediate = info->intermediate;
+	switch (info->opcode)
+	{
+		case 0x13:
+			if (info->function3 == 0 && !info->rd && !info->rs1 && !immediate)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "nop", 0, 0, 0, 0, 0);
+			if (info->function3 == 0 && !info->rs1)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "li", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_SIGNED, immediate);
+			if (info->function3 == 0 && !immediate)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "mv", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_REGISTER, info->rs1);
+			if (info->function3 == 4 && immediate == 0xFFFFFFFF)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "not", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_REGISTER, info->rs1);
+			if (info->function3 == 3 && immediate == 1)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "seqz", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_REGISTER, info->rs1);
+			return 0;
+		case 0x33:
+			// only c.mv, which expands to an add from x0, is printed as a move
+			if (info->size == 2 && info->function7 == 0 && info->function3 == 0 && !info->rs1)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "mv", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_REGISTER, info->rs2);
+			if (info->function7 == 0x20 && info->function3 == 0 && !info->rs1)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "neg", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_REGISTER, info->rs2);
+			if (info->function7 == 0 && info->function3 == 3 && !info->rs1)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "snez", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_REGISTER, info->rs2);
+			if (info->function7 == 0 && info->function3 == 2 && !info->rs2)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "sltz", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_REGISTER, info->rs1);
+			if (info->function7 == 0 && info->function3 == 2 && !info->rs1)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "sgtz", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_REGISTER, info->rs2);
+			return 0;
+		case 0x63:
+		{
+			// a compare with x0 drops it, the name tells which side it was on
+			static const char* rs2_zero_table[8] = { "beqz", "bnez", 0, 0, "bltz", "bgez", 0, 0 };
+			static const char* rs1_zero_table[8] = { 0, 0, 0, 0, "bgtz", "blez", 0, 0 };
+			if (info->function3 == 5 && !info->rs1)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "blez", 2, REL32_OPERAND_REGISTER, info->rs2, REL32_OPERAND_TARGET, immediate);
+			if (!info->rs2 && rs2_zero_table[info->function3])
+				return rel32_set_pseudoinstruction(pseudoinstruction, rs2_zero_table[info->function3], 2, REL32_OPERAND_REGISTER, info->rs1, REL32_OPERAND_TARGET, immediate);
+			if (!info->rs1 && rs1_zero_table[info->function3])
+				return rel32_set_pseudoinstruction(pseudoinstruction, rs1_zero_table[info->function3], 2, REL32_OPERAND_REGISTER, info->rs2, REL32_OPERAND_TARGET, immediate);
+			return 0;
+		}
+		case 0x6F:
+			if (info->rd < 2)
+				return rel32_set_pseudoinstruction(pseudoinstruction, info->rd ? "jal" : "j", 1, REL32_OPERAND_TARGET, immediate, 0, 0);
+			return 0;
+		case 0x67:
+			if (info->rd > 1)
+				return immediate ? 0 : rel32_set_pseudoinstruction(pseudoinstruction, "jalr", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_REGISTER, info->rs1);
+			if (immediate)
+				return rel32_set_pseudoinstruction(pseudoinstruction, info->rd ? "jalr" : "jr", 1, REL32_OPERAND_MEMORY, info->rs1, REL32_OPERAND_SIGNED, immediate);
+			if (!info->rd && info->rs1 == 1)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "ret", 0, 0, 0, 0, 0);
+			return rel32_set_pseudoinstruction(pseudoinstruction, info->rd ? "jalr" : "jr", 1, REL32_OPERAND_REGISTER, info->rs1, 0, 0);
+		case 0x0F:
+			if (info->size == 4 && info->machine_code == 0x0FF0000F)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "fence", 0, 0, 0, 0, 0);
+			return 0;
+		case 0x53:
+		{
+			// a sign injection from the register itself moves, negates or takes the absolute value
+			static const char* single_table[3] = { "fmv.s", "fneg.s", "fabs.s" };
+			static const char* double_table[3] = { "fmv.d", "fneg.d", "fabs.d" };
+			if ((info->function7 == 0x10 || info->function7 == 0x11) && info->function3 < 3 && info->rs1 == info->rs2)
+				return rel32_set_pseudoinstruction(pseudoinstruction, ((info->function7 & 1) ? double_table : single_table)[info->function3], 2, REL32_OPERAND_FLOAT_REGISTER, info->rd, REL32_OPERAND_FLOAT_REGISTER, info->rs1);
+			return 0;
+		}
+		case 0x73:
+		{
+			uint32_t csr = immediate & 0xFFF;
+			if (!info->function3)
+			{
+				if (info->function7 == 0x09 && !info->rs2)
+					return rel32_set_pseudoinstruction(pseudoinstruction, "sfence.vma", info->rs1 ? 1 : 0, REL32_OPERAND_REGISTER, info->rs1, 0, 0);
+				return 0;
+			}
+			if (info->function3 == 1 && !info->rd && !info->rs1 && csr == 0xC00)
+				return rel32_set_pseudoinstruction(pseudoinstruction, "unimp", 0, 0, 0, 0, 0);
+			if (info->function3 == 2 && !info->rs1)
+			{
+				static const char* counter_table[3] = { "rdcycle", "rdtime", "rdinstret" };
+				static const char* high_counter_table[3] = { "rdcycleh", "rdtimeh", "rdinstreth" };
+				static const char* float_table[3] = { "frflags", "frrm", "frcsr" };
+				const char* mnemonic = (csr - 0xC00 < 3) ? counter_table[csr - 0xC00] : ((csr - 0xC80 < 3) ? high_counter_table[csr - 0xC80] : ((csr - 1 < 3) ? float_table[csr - 1] : 0));
+				if (mnemonic)
+					return rel32_set_pseudoinstruction(pseudoinstruction, mnemonic, 1, REL32_OPERAND_REGISTER, info->rd, 0, 0);
+				return rel32_set_pseudoinstruction(pseudoinstruction, "csrr", 2, REL32_OPERAND_REGISTER, info->rd, REL32_OPERAND_CSR, csr);
+			}
+			// the floating-point CSR writes keep rd when the old value is read
+			if ((info->function3 == 1 || info->function3 == 5) && csr - 1 < ((info->function3 == 1) ? 3u : 2u))
+			{
+				static const char* float_table[2][3] = { { "fsflags", "fsrm", "fscsr" }, { "fsflagsi", "fsrmi", 0 } };
+				int operand_type = (info->function3 == 5) ? REL32_OPERAND_UNSIGNED : REL32_OPERAND_REGISTER;
+				const char* mnemonic = float_table[info->function3 >> 2][csr - 1];
+				if (info->rd)
+					return rel32_set_pseudoinstruction(pseudoinstruction, mnemonic, 2, REL32_OPERAND_REGISTER, info->rd, operand_type, info->rs1);
+				return rel32_set_pseudoinstruction(pseudoinstruction, mnemonic, 1, operand_type, info->rs1, 0, 0);
+			}
+			if (!info->rd)
+			{
+				static const char* write_table[8] = { 0, "csrw", "csrs", "csrc", 0, "csrwi", "csrsi", "csrci" };
+				return rel32_set_pseudoinstruction(pseudoinstruction, write_table[info->function3], 2, REL32_OPERAND_CSR, csr, (info->function3 & 4) ? REL32_OPERAND_UNSIGNED : REL32_OPERAND_REGISTER, info->rs1);
+			}
+			return 0;
+		}
+		default:
+			return 0;
+	}
+}
 
+static char* rel32_format_pseudoinstruction(char* write, int flags, uint32_t address, const rel32_pseudoinstruction_t* pseudoinstruction)
+{
+	int is_binutils_syntax = flags & REL_DISASSEMBLE_BINUTILS_SYNTAX;
+	write = rel32_format_text(write, pseudoinstruction->mnemonic);
+	for (int i = 0; i != pseudoinstruction->operand_count; ++i)
+	{
+		if (is_binutils_syntax)
+			*write++ = i ? ',' : '\t';
+		else
+		{
+			if (i)
+				*write++ = ',';
+			*write++ = ' ';
+		}
+		uint32_t operand = pseudoinstruction->operand_table[i];
+		switch (pseudoinstruction->operand_type_table[i])
+		{
+			case REL32_OPERAND_REGISTER:
+				write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, operand);
 				break;
-			case REL_ENCODING_I_SHIFT:
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rd, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 1)
-					return ENOBUFS;
-				*write = ' ';
-				rel32_copy(write + 1, register_name, part_size);
-				write += part_size + 1;
-
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rs1, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 2)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				rel32_copy(write + 2, register_name, part_size);
-				write += part_size + 2;
-
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 4)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				part_size = rel32_print_unsigned(info.intermediate & 0x1F, write + 2);
-				write += part_size + 2;
-
+			case REL32_OPERAND_FLOAT_REGISTER:
+				write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_FLOAT, operand);
 				break;
-			case REL_ENCODING_I_FENCE:
-				// this needs more work
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rd, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 1)
-					return ENOBUFS;
-				*write = ' ';
-				rel32_copy(write + 1, register_name, part_size);
-				write += part_size + 1;
-
-				rel32_get_register_name(REL_REGISTER_CONTEXT_GENERAL, info.rs1, flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS, &register_name, &part_size);
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < part_size + 2)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				rel32_copy(write + 2, register_name, part_size);
-				write += part_size + 2;
-
-				if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 13)
-					return ENOBUFS;
-				write[0] = ',';
-				write[1] = ' ';
-				part_size = rel32_print_signed(*(int32_t*)&info.intermediate, write + 2);
-				write += part_size + 2;
-
+			case REL32_OPERAND_SIGNED:
+				write += rel32_print_signed((int32_t)operand, write);
 				break;
-			case REL_ENCODING_I_ENVIROMENT:
-				// no thing to be printed here
+			case REL32_OPERAND_UNSIGNED:
+				write += rel32_print_unsigned(operand, write);
+				break;
+			case REL32_OPERAND_TARGET:
+				// the default syntax prints branch offsets like the base instructions do
+				if (is_binutils_syntax)
+					write = rel32_format_lowercase_hex(write, address + operand);
+				else
+					write += rel32_print_signed((int32_t)operand, write);
+				break;
+			case REL32_OPERAND_CSR:
+				write = rel32_format_csr(write, operand);
+				break;
+			case REL32_OPERAND_MEMORY:
+				write = rel32_format_memory_operand(write, flags, pseudoinstruction->operand_table[i + 1], operand);
 				break;
 			default:
 				break;
 		}
 	}
-	else
+	return write;
+}
+
+// binutils names a compressed instruction itself rather than the instruction it expands to
+static char* rel32_format_binutils_compressed_instruction(char* write, int flags, uint32_t address, const rel32_instruction_information_t* info)
+{
+	uint32_t instruction = info->machine_code;
+	uint32_t quadrant = instruction & 3;
+	uint32_t function3 = info->compressed_function3;
+	// a shift by 0 is a hint binutils spells the RV128 way
+	int is_shift_by_0 = info->opcode == 0x13 && (info->function3 == 1 || info->function3 == 5) && !info->rs2;
+	const char* mnemonic = 0;
+	if (quadrant == 0 && function3 == 0)
+		mnemonic = "c.addi4spn";
+	else if (quadrant == 1 && function3 == 0 && !info->rd)
+		mnemonic = "c.nop";
+	else if (quadrant == 1 && function3 == 2)
+		mnemonic = "c.li";
+	else if (quadrant == 1 && function3 == 3)
+		mnemonic = (info->rd == 2) ? "c.addi16sp" : "c.lui";
+	else if (quadrant == 1 && (function3 == 1 || function3 == 5))
+		mnemonic = (function3 == 1) ? "c.jal" : "c.j";
+	else if (quadrant == 1 && function3 >= 6)
+		mnemonic = (function3 == 6) ? "c.beqz" : "c.bnez";
+	else if (quadrant == 2 && function3 == 4)
 	{
-		if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) < 7)
-			return ENOBUFS;
-		rel32_copy(write, "unknown", 7);
-		write += 7;
+		// bit 12 tells c.jr from c.jalr and c.mv from c.add, the expansion does not when rd is x0
+		if (info->opcode == 0x67)
+			mnemonic = (info->compressed_function4 & 1) ? "c.jalr" : "c.jr";
+		else if (info->opcode == 0x33)
+			mnemonic = (info->compressed_function4 & 1) ? "c.add" : "c.mv";
+		else
+			mnemonic = "c.ebreak";
 	}
+	else if (is_shift_by_0)
+		mnemonic = (info->function3 == 1) ? "c.slli64" : ((info->function7 & 0x20) ? "c.srai64" : "c.srli64");
 
-	if (flags & REL_DISASSEMBLE_NEW_LINE)
+	if (mnemonic)
+		write = rel32_format_text(write, mnemonic);
+	else
 	{
-		if (!(size_t)((uintptr_t)write_limit - (uintptr_t)write))
-			return ENOBUFS;
-		*write = '\n';
-		write++;
+		// the stack pointer relative loads and stores of quadrant 2 carry an sp suffix
+		write = rel32_format_text(write, "c.");
+		write = rel32_format_text(write, info->mnemonic);
+		if (quadrant == 2 && function3)
+			write = rel32_format_text(write, "sp");
 	}
 
-	*assembly_size = (size_t)((uintptr_t)write - (uintptr_t)assembly_buffer);
-	return 0;
+	if (quadrant == 1 && function3 == 0 && !info->rd)
+	{
+		// the hints with a nonzero immediate keep it
+		if (info->intermediate)
+		{
+			*write++ = '\t';
+			write += rel32_print_signed((int32_t)info->intermediate, write);
+		}
+		return write;
+	}
+	if (info->opcode == 0x73)
+		return write;
+	*write++ = '\t';
+	switch (info->opcode)
+	{
+		case 0x6F:
+			return rel32_format_lowercase_hex(write, address + info->intermediate);
+		case 0x63:
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs1);
+			*write++ = ',';
+			return rel32_format_lowercase_hex(write, address + info->intermediate);
+		case 0x67:
+			return rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs1);
+		case 0x37:
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rd);
+			write = rel32_format_text(write, ",0x");
+			return rel32_format_lowercase_hex(write, info->intermediate >> 12);
+		case 0x03:
+		case 0x23:
+		case 0x07:
+		case 0x27:
+			if (info->opcode & 0x04)
+				write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_FLOAT, (info->opcode == 0x27) ? info->rs2 : info->rd);
+			else
+				write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, (info->opcode == 0x23) ? info->rs2 : info->rd);
+			*write++ = ',';
+			return rel32_format_memory_operand(write, flags, info->intermediate, info->rs1);
+		case 0x33:
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rd);
+			*write++ = ',';
+			return rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs2);
+		default:
+			break;
+	}
+	write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rd);
+	if (is_shift_by_0)
+		return write;
+	*write++ = ',';
+	if (quadrant == 0)
+	{
+		write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs1);
+		*write++ = ',';
+	}
+	if (info->function3 == 1 || info->function3 == 5)
+	{
+		write = rel32_format_text(write, "0x");
+		return rel32_format_lowercase_hex(write, info->rs2);
+	}
+	write += rel32_print_signed((int32_t)info->intermediate, write);
+	return write;
 }
 
-void rel32i_step_instruction(const void* code_base_address, void* data_base_address, rel32i_register_set_t* register_set)
+// the operand syntax of binutils, with pseudoinstructions like its default or the base instructions like -M no-aliases
+static char* rel32_format_binutils_instruction(char* write, int flags, uint32_t address, const rel32_instruction_information_t* info)
 {
-	rel32_instruction_information_t info;
-	rel32_decode_instruction((const void*)((uintptr_t)code_base_address + (uintptr_t)register_set->pc), &info);
+	static const char* fence_set_table[16] = { "0", "w", "r", "rw", "o", "ow", "or", "orw", "i", "iw", "ir", "irw", "io", "iow", "ior", "iorw" };
+	uint32_t instruction = info->machine_code;
+
+	if (info->size == 2 && !instruction)
+		return rel32_format_text(write, (flags & REL_DISASSEMBLE_USE_PSEUDOINSTRUCTIONS) ? "unimp" : "c.unimp");
+	// binutils only takes lr.w with the rs2 field clear
+	if (info->instruction_index == -1 || (info->opcode == 0x2F && (instruction >> 27) == 0x02 && info->rs2))
+	{
+		write = rel32_format_text(write, (info->size == 4) ? ".4byte\t0x" : ".2byte\t0x");
+		return rel32_format_lowercase_hex(write, instruction);
+	}
+	// hints write x0 or shift by 0, binutils keeps them in their compressed form even with aliases
+	if (info->size == 2 && (((info->opcode == 0x13 || info->opcode == 0x33 || info->opcode == 0x37) && !info->rd && instruction != 0x0001) ||
+		(info->opcode == 0x13 && (info->function3 == 1 || info->function3 == 5) && !info->rs2)))
+		return rel32_format_binutils_compressed_instruction(write, flags, address, info);
+	if (flags & REL_DISASSEMBLE_USE_PSEUDOINSTRUCTIONS)
+	{
+		// with aliases binutils prints a compressed instruction as what it expands to
+		rel32_pseudoinstruction_t pseudoinstruction;
+		if (rel32_find_pseudoinstruction(info, &pseudoinstruction))
+			return rel32_format_pseudoinstruction(write, flags, address, &pseudoinstruction);
+	}
+	else if (info->size == 2)
+		return rel32_format_binutils_compressed_instruction(write, flags, address, info);
 
-	uint32_t rs1 = info.rs1 ? register_set->x1_x31[info.rs1 - 1] : 0;
-	uint32_t rs2 = info.rs2 ? register_set->x1_x31[info.rs2 - 1] : 0;
-	uint32_t effective_address = rs1 + info.intermediate;
-	uint32_t rd;
-	int set_rd = 0;
+	if (instruction == 0x8330000F)
+		return rel32_format_text(write, "fence.tso");
 
-	switch (info.instruction_index)
+	write = rel32_format_text(write, info->mnemonic);
+	if (info->opcode == 0x2F)
 	{
-		case 0:/*lui*/
-		{
-			rd = info.intermediate;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
-		}
-		case 1:/*auipc*/
-		{
-			rd = register_set->pc + info.intermediate;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
-		}
-		case 2:/*jal*/
-		{
-			rd = register_set->pc + 4;
-			set_rd = 1;
-			register_set->pc += info.intermediate;
-			break;
-		}
-		case 3:/*jalr*/
-		{
-			rd = register_set->pc + 4;
-			set_rd = 1;
-			register_set->pc = (rs1 + info.intermediate) & 0xFFFFFFFE;
-			break;
-		}
-		case 4:/*beq*/
-		{
-			if (rs1 == rs2)
-				register_set->pc += info.intermediate;
-			else
-				register_set->pc += 4;
+		// the aq and rl bits are part of the binutils mnemonic
+		static const char* ordering_table[4] = { "", ".rl", ".aq", ".aqrl" };
+		write = rel32_format_text(write, ordering_table[(instruction >> 25) & 3]);
+	}
+
+	switch (info->opcode)
+	{
+		case 0x37:
+		case 0x17:
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rd);
+			write = rel32_format_text(write, ",0x");
+			write = rel32_format_lowercase_hex(write, info->intermediate >> 12);
 			break;
-		}
-		case 5:/*bne*/
-		{
-			if (rs1 != rs2)
-				register_set->pc += info.intermediate;
-			else
-				register_set->pc += 4;
+		case 0x6F:
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rd);
+			*write++ = ',';
+			write = rel32_format_lowercase_hex(write, address + info->intermediate);
 			break;
-		}
-		case 6:/*blt*/
-		{
-			if (*(int32_t*)&rs1 < *(int32_t*)&rs2)
-				register_set->pc += info.intermediate;
-			else
-				register_set->pc += 4;
+		case 0x63:
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs1);
+			*write++ = ',';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs2);
+			*write++ = ',';
+			write = rel32_format_lowercase_hex(write, address + info->intermediate);
 			break;
-		}
-		case 7:/*bge*/
-		{
-			if (*(int32_t*)&rs1 > *(int32_t*)&rs2)
-				register_set->pc += info.intermediate;
-			else
-				register_set->pc += 4;
+		case 0x67:
+		case 0x03:
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rd);
+			*write++ = ',';
+			write = rel32_format_memory_operand(write, flags, info->intermediate, info->rs1);
 			break;
-		}
-		case 8:/*bltu*/
-		{
-			if (rs1 < rs2)
-				register_set->pc += info.intermediate;
-			else
-				register_set->pc += 4;
+		case 0x23:
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs2);
+			*write++ = ',';
+			write = rel32_format_memory_operand(write, flags, info->intermediate, info->rs1);
 			break;
-		}
-		case 9:/*bgeu*/
-		{
-			if (rs1 > rs2)
-				register_set->pc += info.intermediate;
+		case 0x13:
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rd);
+			*write++ = ',';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs1);
+			*write++ = ',';
+			if (info->function3 == 1 || info->function3 == 5)
+			{
+				write = rel32_format_text(write, "0x");
+				write = rel32_format_lowercase_hex(write, info->rs2);
+			}
 			else
-				register_set->pc += 4;
+				write += rel32_print_signed((int32_t)info->intermediate, write);
 			break;
-		}
-		case 10:/*lb*/
-		{
-			rd = (uint32_t)*(uint8_t*)((uintptr_t)data_base_address + (uintptr_t)effective_address);
-			rd = ((0 - (rd >> 7)) & 0xFFFFFF00) | rd;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
-		}
-		case 11:/*lh*/
-		{
-			rd = (uint32_t)*(uint16_t*)((uintptr_t)data_base_address + (uintptr_t)effective_address);
-			rd = ((0 - (rd >> 15)) & 0xFFFF0000) | rd;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
-		}
-		case 12:/*lw*/
-		{
-			rd = *(uint32_t*)((uintptr_t)data_base_address + (uintptr_t)effective_address);
-			set_rd = 1;
-			register_set->pc += 4;
+		case 0x33:
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rd);
+			*write++ = ',';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs1);
+			*write++ = ',';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs2);
 			break;
-		}
-		case 13:/*lbu*/
-		{
-			rd = (uint32_t)*(uint8_t*)((uintptr_t)data_base_address + (uintptr_t)effective_address);
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
-		}
-		case 14:/*lhu*/
-		{
-			rd = (uint32_t)*(uint16_t*)((uintptr_t)data_base_address + (uintptr_t)effective_address);
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
-		}
-		case 15:/*sb*/
-		{
-			*(uint8_t*)((uintptr_t)data_base_address + (uintptr_t)effective_address) = (uint8_t)rs2;
-			register_set->pc += 4;
+		case 0x07:
+		case 0x27:
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_FLOAT, (info->opcode == 0x27) ? info->rs2 : info->rd);
+			*write++ = ',';
+			write = rel32_format_memory_operand(write, flags, info->intermediate, info->rs1);
 			break;
-		}
-		case 16:/*sh*/
-		{
-			*(uint16_t*)((uintptr_t)data_base_address + (uintptr_t)effective_address) = (uint16_t)rs2;
-			register_set->pc += 4;
+		case 0x43:
+		case 0x47:
+		case 0x4B:
+		case 0x4F:
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_FLOAT, info->rd);
+			*write++ = ',';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_FLOAT, info->rs1);
+			*write++ = ',';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_FLOAT, info->rs2);
+			*write++ = ',';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_FLOAT, (uint32_t)info->function7 >> 2);
+			write = rel32_format_rounding_mode(write, info->function3);
 			break;
-		}
-		case 17:/*sw*/
+		case 0x53:
 		{
-			*(uint32_t*)((uintptr_t)data_base_address + (uintptr_t)effective_address) = rs2;
-			register_set->pc += 4;
+			// the upper five bits of function7 pick the operation, the lowest tells single from double
+			uint32_t function5 = (uint32_t)info->function7 >> 2;
+			int rd_is_integer = function5 == 0x14 || function5 == 0x18 || function5 == 0x1C;
+			int rs1_is_integer = function5 == 0x1A || function5 == 0x1E;
+			int has_rs2 = function5 < 0x08 || function5 == 0x14;
+			// fcvt.d.s and fcvt.d.w(u) are exact and take no rounding mode
+			int has_rounding_mode = function5 < 0x04 || function5 == 0x0B || function5 == 0x18 || (function5 == 0x08 && !(info->function7 & 1)) || (function5 == 0x1A && !(info->function7 & 1));
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, rd_is_integer ? REL_REGISTER_CONTEXT_GENERAL : REL_REGISTER_CONTEXT_FLOAT, info->rd);
+			*write++ = ',';
+			write = rel32_format_register_name(write, flags, rs1_is_integer ? REL_REGISTER_CONTEXT_GENERAL : REL_REGISTER_CONTEXT_FLOAT, info->rs1);
+			if (has_rs2)
+			{
+				*write++ = ',';
+				write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_FLOAT, info->rs2);
+			}
+			if (has_rounding_mode)
+				write = rel32_format_rounding_mode(write, info->function3);
 			break;
 		}
-		case 18:/*addi*/
-		{
-			rd = rs1 + info.intermediate;
-			set_rd = 1;
-			register_set->pc += 4;
+		case 0x2F:
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rd);
+			*write++ = ',';
+			if ((instruction >> 27) != 0x02)
+			{
+				write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs2);
+				*write++ = ',';
+			}
+			*write++ = '(';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs1);
+			*write++ = ')';
 			break;
-		}
-		case 19:/*slti*/
-		{
-			if (*(int32_t*)&rs1 < *(int32_t*)&info.intermediate)
-				rd = 1;
-			else
-				rd = 0;
-			set_rd = 1;
-			register_set->pc += 4;
+		case 0x0F:
+			if (!info->function3)
+			{
+				*write++ = '\t';
+				write = rel32_format_text(write, fence_set_table[(instruction >> 24) & 0xF]);
+				*write++ = ',';
+				write = rel32_format_text(write, fence_set_table[(instruction >> 20) & 0xF]);
+			}
 			break;
-		}
-		case 20:/*sltiu*/
-		{
-			if (rs1 < info.intermediate)
-				rd = 1;
+		case 0x73:
+			if (!info->function3)
+			{
+				if (info->function7 == 0x09)
+				{
+					*write++ = '\t';
+					write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs1);
+					*write++ = ',';
+					write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs2);
+				}
+				break;
+			}
+			*write++ = '\t';
+			write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rd);
+			*write++ = ',';
+			write = rel32_format_csr(write, instruction >> 20);
+			*write++ = ',';
+			if (info->function3 & 4)
+				write += rel32_print_unsigned(info->rs1, write);
 			else
-				rd = 0;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
-		}
-		case 21:/*xori*/
-		{
-			rd = rs1 ^ info.intermediate;
-			set_rd = 1;
-			register_set->pc += 4;
+				write = rel32_format_register_name(write, flags, REL_REGISTER_CONTEXT_GENERAL, info->rs1);
 			break;
-		}
-		case 22:/*ori*/
-		{
-			rd = rs1 | info.intermediate;
-			set_rd = 1;
-			register_set->pc += 4;
+		default:
 			break;
-		}
-		case 23:/*andi*/
+	}
+	return write;
+}
+
+static size_t rel32_format_binutils_line(int flags, uint32_t address, const rel32_instruction_information_t* info, char* assembly_buffer)
+{
+	char* write = assembly_buffer;
+
+	if (flags & REL_DISASSEMBLE_ADDRESS)
+	{
+		// objdump pads addresses with spaces rather than zeros
+		int digit_count = 1;
+		while (digit_count != 8 && (address >> (digit_count << 2)))
+			++digit_count;
+		for (int i = digit_count; i != 8; ++i)
+			*write++ = ' ';
+		write = rel32_format_lowercase_hex(write, address);
+		*write++ = ':';
+		*write++ = '\t';
+	}
+
+	if (flags & REL_DISASSEMBLE_MACHINE_CODE)
+	{
+		// the raw column is padded to 8 bytes of instruction, one chunk per instruction
+		for (int i = (int)info->size * 2 - 1; i >= 0; --i)
+			*write++ = rel32_lowercase_hex_table[(info->machine_code >> (i << 2)) & 0xF];
+		for (int i = (info->size == 4) ? 10 : 16; i; --i)
+			*write++ = ' ';
+		*write++ = '\t';
+	}
+
+	if (info->instruction_index != -1 && (flags & REL_DISASSEMBLE_ENCODING))
+	{
+		static const char encoding_types[7] = { 'x', 'r', 'i', 's', 'b', 'u', 'j' };
+		write[0] = '(';
+		write[1] = encoding_types[info->encoding];
+		write[2] = ')';
+		write[3] = ' ';
+		write += 4;
+	}
+
+	write = rel32_format_binutils_instruction(write, flags, address, info);
+
+	if (flags & REL_DISASSEMBLE_NEW_LINE)
+		*write++ = '\n';
+
+	return (size_t)((uintptr_t)write - (uintptr_t)assembly_buffer);
+}
+
+static size_t rel32_format_instruction(int flags, const void* base_address, uint32_t address_of_instruction, char* assembly_buffer)
+{
+	// the buffer must hold REL_DISASSEMBLE_MAX_LINE_SIZE bytes, which no line reaches even with the slot padding written past its end
+	rel32_run_once(&format_tables_once, rel32_build_format_tables);
+
+	rel32_instruction_information_t info;
+	rel32_decode_instruction((const void*)((uintptr_t)base_address + (uintptr_t)address_of_instruction), &info);
+
+	if (flags & REL_DISASSEMBLE_BINUTILS_SYNTAX)
+		return rel32_format_binutils_line(flags, address_of_instruction, &info, assembly_buffer);
+
+	char* write = assembly_buffer;
+
+	if (flags & REL_DISASSEMBLE_ADDRESS)
+	{
+		rel32_print_hex(address_of_instruction, write);
+		write[8] = ' ';
+		write += 9;
+	}
+
+	if (flags & REL_DISASSEMBLE_MACHINE_CODE)
+	{
+		if (info.size == 4)
 		{
-			rd = rs1 & info.intermediate;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
+			rel32_print_hex(info.machine_code, write);
+			write[8] = ' ';
+			write += 9;
 		}
-		case 24:/*slli*/
+		else
 		{
-			rd = rs1 << (info.intermediate & 0x1F);
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
+			const char* pair = rel32_hex_pair_table + ((info.machine_code >> 8) & 0xFF) * 2;
+			write[0] = pair[0];
+			write[1] = pair[1];
+			pair = rel32_hex_pair_table + (info.machine_code & 0xFF) * 2;
+			write[2] = pair[0];
+			write[3] = pair[1];
+			write[4] = ' ';
+			write += 5;
 		}
-		case 25:/*srli*/
+	}
+
+	if (info.instruction_index != -1 && (flags & REL_DISASSEMBLE_ENCODING))
+	{
+		static const char encoding_types[7] = { 'x', 'r', 'i', 's', 'b', 'u', 'j' };
+		write[0] = '(';
+		write[1] = encoding_types[info.encoding];
+		write[2] = ')';
+		write[3] = ' ';
+		write += 4;
+	}
+
+	rel32_pseudoinstruction_t pseudoinstruction;
+	if ((flags & REL_DISASSEMBLE_USE_PSEUDOINSTRUCTIONS) && info.instruction_index != -1 && rel32_find_pseudoinstruction(&info, &pseudoinstruction))
+		write = rel32_format_pseudoinstruction(write, flags, address_of_instruction, &pseudoinstruction);
+	else
+	{
+		const uint64_t* mnemonic_slot = format_tables.mnemonic_table[(info.instruction_index != -1) ? (size_t)info.instruction_index : REL32_INSTRUCTION_TABLE_SIZE];
+		REL32_COPY_WORD(write, mnemonic_slot);
+		REL32_COPY_WORD(write + 8, mnemonic_slot + 1);
+		write += ((const char*)mnemonic_slot)[REL32_FORMAT_MNEMONIC_SLOT_SIZE - 1];
+
+		const uint64_t* first_operand_table = format_tables.register_operand_table[0][(flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS) ? 1 : 0][0];
+		const uint64_t* next_operand_table = format_tables.register_operand_table[0][(flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS) ? 1 : 0][1];
+		const uint64_t* first_float_operand_table = format_tables.register_operand_table[1][(flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS) ? 1 : 0][0];
+		const uint64_t* next_float_operand_table = format_tables.register_operand_table[1][(flags & REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS) ? 1 : 0][1];
+		switch ((info.instruction_index != -1) ? instruction_table[info.instruction_index].assembly_encoding : REL_ENCODING_X)
+		{
+			case REL_ENCODING_X:
+				// unknown encoding
+				break;
+			case REL_ENCODING_R:
+				write = rel32_format_register(write, first_operand_table, info.rd);
+				write = rel32_format_register(write, next_operand_table, info.rs1);
+				write = rel32_format_register(write, next_operand_table, info.rs2);
+				break;
+			case REL_ENCODING_I:
+			case REL_ENCODING_I_FENCE:
+				// fence operands need more work
+				write = rel32_format_register(write, first_operand_table, info.rd);
+				write = rel32_format_register(write, next_operand_table, info.rs1);
+				write = rel32_format_immediate(write, (int32_t)info.intermediate);
+				break;
+			case REL_ENCODING_S:
+			case REL_ENCODING_B:
+				write = rel32_format_register(write, first_operand_table, info.rs1);
+				write = rel32_format_register(write, next_operand_table, info.rs2);
+				write = rel32_format_immediate(write, (int32_t)info.intermediate);
+				break;
+			case REL_ENCODING_U:
+			case REL_ENCODING_J:
+				write = rel32_format_register(write, next_operand_table, info.rd);
+				write = rel32_format_immediate(write, (int32_t)info.intermediate);
+				break;
+			case REL_ENCODING_I_SHIFT:
+				write = rel32_format_register(write, first_operand_table, info.rd);
+				write = rel32_format_register(write, next_operand_table, info.rs1);
+				write[0] = ',';
+				write[1] = ' ';
+				write += 2 + rel32_print_unsigned(info.intermediate & 0x1F, write + 2);
+				break;
+			case REL_ENCODING_I_ENVIROMENT:
+				// no thing to be printed here
+				break;
+			case REL_ENCODING_I_FLOAT:
+				write = rel32_format_register(write, first_float_operand_table, info.rd);
+				write = rel32_format_register(write, next_operand_table, info.rs1);
+				write = rel32_format_immediate(write, (int32_t)info.intermediate);
+				break;
+			case REL_ENCODING_S_FLOAT:
+				write = rel32_format_register(write, first_operand_table, info.rs1);
+				write = rel32_format_register(write, next_float_operand_table, info.rs2);
+				write = rel32_format_immediate(write, (int32_t)info.intermediate);
+				break;
+			case REL_ENCODING_R_FLOAT:
+			case REL_ENCODING_R4_FLOAT:
+				// rs3 is the upper five bits of function7
+				write = rel32_format_register(write, first_float_operand_table, info.rd);
+				write = rel32_format_register(write, next_float_operand_table, info.rs1);
+				write = rel32_format_register(write, next_float_operand_table, info.rs2);
+				if (instruction_table[info.instruction_index].assembly_encoding == REL_ENCODING_R4_FLOAT)
+					write = rel32_format_register(write, next_float_operand_table, (uint32_t)info.function7 >> 2);
+				break;
+			case REL_ENCODING_R_FLOAT_UNARY:
+				write = rel32_format_register(write, first_float_operand_table, info.rd);
+				write = rel32_format_register(write, next_float_operand_table, info.rs1);
+				break;
+			case REL_ENCODING_R_FLOAT_TO_INTEGER:
+				write = rel32_format_register(write, first_operand_table, info.rd);
+				write = rel32_format_register(write, next_float_operand_table, info.rs1);
+				break;
+			case REL_ENCODING_R_FLOAT_COMPARE:
+				write = rel32_format_register(write, first_operand_table, info.rd);
+				write = rel32_format_register(write, next_float_operand_table, info.rs1);
+				write = rel32_format_register(write, next_float_operand_table, info.rs2);
+				break;
+			case REL_ENCODING_R_INTEGER_TO_FLOAT:
+				write = rel32_format_register(write, first_float_operand_table, info.rd);
+				write = rel32_format_register(write, next_operand_table, info.rs1);
+				break;
+			default:
+				break;
+		}
+	}
+
+	if (flags & REL_DISASSEMBLE_NEW_LINE)
+	{
+		*write = '\n';
+		write++;
+	}
+
+	return (size_t)((uintptr_t)write - (uintptr_t)assembly_buffer);
+}
+
+int rel32_disassemble_instruction(int flags, const void* base_address, uint32_t address_of_instruction, size_t assembly_buffer_size, size_t* assembly_size, char* assembly_buffer)
+{
+	if (assembly_buffer_size >= REL_DISASSEMBLE_MAX_LINE_SIZE)
+	{
+		*assembly_size = rel32_format_instruction(flags, base_address, address_of_instruction, assembly_buffer);
+		return 0;
+	}
+
+	char line_buffer[REL_DISASSEMBLE_MAX_LINE_SIZE];
+	size_t line_size = rel32_format_instruction(flags, base_address, address_of_instruction, line_buffer);
+	if (line_size > assembly_buffer_size)
+		return ENOBUFS;
+	rel32_copy(assembly_buffer, line_buffer, line_size);
+	*assembly_size = line_size;
+	return 0;
+}
+
+int rel32_disassemble_range(int flags, const void* base_address, uint32_t start_address, uint32_t end_address, char* buffer, size_t buffer_size, uint32_t* next_address, size_t* written)
+{
+	char* write = buffer;
+	char* write_limit = buffer + buffer_size;
+	uint32_t address = start_address;
+	int buffer_is_full = 0;
+	while (address < end_address)
+	{
+		// the low two bits of the first halfword give the instruction length
+		uint32_t instruction_size = ((*(const uint8_t*)((uintptr_t)base_address + (uintptr_t)address) & 3) == 3) ? 4 : 2;
+		if (end_address - address < instruction_size)
+			break;
+
+		if ((size_t)((uintptr_t)write_limit - (uintptr_t)write) >= REL_DISASSEMBLE_MAX_LINE_SIZE)
+			write += rel32_format_instruction(flags, base_address, address, write);
+		else
+		{
+			char line_buffer[REL_DISASSEMBLE_MAX_LINE_SIZE];
+			size_t line_size = rel32_format_instruction(flags, base_address, address, line_buffer);
+			if (line_size > (size_t)((uintptr_t)write_limit - (uintptr_t)write))
+			{
+				buffer_is_full = 1;
+				break;
+			}
+			rel32_copy(write, line_buffer, line_size);
+			write += line_size;
+		}
+		address += instruction_size;
+	}
+
+	*next_address = address;
+	*written = (size_t)((uintptr_t)write - (uintptr_t)buffer);
+	return (buffer_is_full && address == start_address) ? ENOBUFS : 0;
+}
+
+// Every row is an operation of the instruction core, numbered by its row in instruction_table since that is what predecoding stores.
+// The bodies use macros each engine defines before it expands the list.
+#define REL32I_OPERATION_LIST(OPERATION) \
+	OPERATION(0, LUI, lui, REL32I_WRITE_RD(REL32I_IMMEDIATE);) \
+	OPERATION(1, AUIPC, auipc, REL32I_WRITE_RD(pc + REL32I_IMMEDIATE);) \
+	OPERATION(2, JAL, jal, REL32I_JUMP_AND_LINK(pc + REL32I_IMMEDIATE);) \
+	OPERATION(3, JALR, jalr, REL32I_JUMP_AND_LINK((REL32I_RS1 + REL32I_IMMEDIATE) & 0xFFFFFFFE);) \
+	OPERATION(4, BEQ, beq, REL32I_BRANCH(REL32I_RS1 == REL32I_RS2);) \
+	OPERATION(5, BNE, bne, REL32I_BRANCH(REL32I_RS1 != REL32I_RS2);) \
+	OPERATION(6, BLT, blt, REL32I_BRANCH((int32_t)REL32I_RS1 < (int32_t)REL32I_RS2);) \
+	OPERATION(7, BGE, bge, REL32I_BRANCH((int32_t)REL32I_RS1 >= (int32_t)REL32I_RS2);) \
+	OPERATION(8, BLTU, bltu, REL32I_BRANCH(REL32I_RS1 < REL32I_RS2);) \
+	OPERATION(9, BGEU, bgeu, REL32I_BRANCH(REL32I_RS1 >= REL32I_RS2);) \
+	OPERATION(10, LB, lb, REL32I_WRITE_RD((uint32_t)(int32_t)REL32I_LOAD(int8_t, REL32I_RS1 + REL32I_IMMEDIATE));) \
+	OPERATION(11, LH, lh, REL32I_WRITE_RD((uint32_t)(int32_t)REL32I_LOAD(int16_t, REL32I_RS1 + REL32I_IMMEDIATE));) \
+	OPERATION(12, LW, lw, REL32I_WRITE_RD(REL32I_LOAD(uint32_t, REL32I_RS1 + REL32I_IMMEDIATE));) \
+	OPERATION(13, LBU, lbu, REL32I_WRITE_RD((uint32_t)REL32I_LOAD(uint8_t, REL32I_RS1 + REL32I_IMMEDIATE));) \
+	OPERATION(14, LHU, lhu, REL32I_WRITE_RD((uint32_t)REL32I_LOAD(uint16_t, REL32I_RS1 + REL32I_IMMEDIATE));) \
+	OPERATION(15, SB, sb, REL32I_STORE(uint8_t, REL32I_RS1 + REL32I_IMMEDIATE, REL32I_RS2); REL32I_NEXT();) \
+	OPERATION(16, SH, sh, REL32I_STORE(uint16_t, REL32I_RS1 + REL32I_IMMEDIATE, REL32I_RS2); REL32I_NEXT();) \
+	OPERATION(17, SW, sw, REL32I_STORE(uint32_t, REL32I_RS1 + REL32I_IMMEDIATE, REL32I_RS2); REL32I_NEXT();) \
+	OPERATION(18, ADDI, addi, REL32I_WRITE_RD(REL32I_RS1 + REL32I_IMMEDIATE);) \
+	OPERATION(19, SLTI, slti, REL32I_WRITE_RD((uint32_t)((int32_t)REL32I_RS1 < (int32_t)REL32I_IMMEDIATE));) \
+	OPERATION(20, SLTIU, sltiu, REL32I_WRITE_RD((uint32_t)(REL32I_RS1 < REL32I_IMMEDIATE));) \
+	OPERATION(21, XORI, xori, REL32I_WRITE_RD(REL32I_RS1 ^ REL32I_IMMEDIATE);) \
+	OPERATION(22, ORI, ori, REL32I_WRITE_RD(REL32I_RS1 | REL32I_IMMEDIATE);) \
+	OPERATION(23, ANDI, andi, REL32I_WRITE_RD(REL32I_RS1 & REL32I_IMMEDIATE);) \
+	OPERATION(24, SLLI, slli, REL32I_WRITE_RD(REL32I_RS1 << (REL32I_IMMEDIATE & 0x1F));) \
+	OPERATION(25, SRLI, srli, REL32I_WRITE_RD(REL32I_RS1 >> (REL32I_IMMEDIATE & 0x1F));) \
+	OPERATION(26, SRAI, srai, REL32I_WRITE_RD(rel32i_shift_right_arithmetic(REL32I_RS1, REL32I_IMMEDIATE & 0x1F));) \
+	OPERATION(27, ADD, add, REL32I_WRITE_RD(REL32I_RS1 + REL32I_RS2);) \
+	OPERATION(28, SUB, sub, REL32I_WRITE_RD(REL32I_RS1 - REL32I_RS2);) \
+	OPERATION(29, SLL, sll, REL32I_WRITE_RD(REL32I_RS1 << (REL32I_RS2 & 0x1F));) \
+	OPERATION(30, SLT, slt, REL32I_WRITE_RD((uint32_t)((int32_t)REL32I_RS1 < (int32_t)REL32I_RS2));) \
+	OPERATION(31, SLTU, sltu, REL32I_WRITE_RD((uint32_t)(REL32I_RS1 < REL32I_RS2));) \
+	OPERATION(32, XOR, xor, REL32I_WRITE_RD(REL32I_RS1 ^ REL32I_RS2);) \
+	OPERATION(33, SRL, srl, REL32I_WRITE_RD(REL32I_RS1 >> (REL32I_RS2 & 0x1F));) \
+	OPERATION(34, SRA, sra, REL32I_WRITE_RD(rel32i_shift_right_arithmetic(REL32I_RS1, REL32I_RS2 & 0x1F));) \
+	OPERATION(35, OR, or, REL32I_WRITE_RD(REL32I_RS1 | REL32I_RS2);) \
+	OPERATION(36, AND, and, REL32I_WRITE_RD(REL32I_RS1 & REL32I_RS2);) \
+	OPERATION(37, FENCE, fence, REL32I_NEXT();) \
+	OPERATION(38, ECALL, ecall, REL32I_EVENT(REL32I_STOP_ECALL);) \
+	OPERATION(39, EBREAK, ebreak, REL32I_EVENT(REL32I_STOP_EBREAK);) \
+	OPERATION(40, FENCE_I, fence_i, REL32I_FENCE_I();) \
+	OPERATION(41, CSRRW, csrrw, REL32I_CSR();) \
+	OPERATION(42, CSRRS, csrrs, REL32I_CSR();) \
+	OPERATION(43, CSRRC, csrrc, REL32I_CSR();) \
+	OPERATION(44, CSRRWI, csrrwi, REL32I_CSR();) \
+	OPERATION(45, CSRRSI, csrrsi, REL32I_CSR();) \
+	OPERATION(46, CSRRCI, csrrci, REL32I_CSR();) \
+	OPERATION(47, MUL, mul, REL32I_WRITE_RD(REL32I_RS1 * REL32I_RS2);) \
+	OPERATION(48, MULH, mulh, REL32I_WRITE_RD((uint32_t)((uint64_t)((int64_t)(int32_t)REL32I_RS1 * (int64_t)(int32_t)REL32I_RS2) >> 32));) \
+	OPERATION(49, MULHSU, mulhsu, REL32I_WRITE_RD((uint32_t)((uint64_t)((int64_t)(int32_t)REL32I_RS1 * (int64_t)REL32I_RS2) >> 32));) \
+	OPERATION(50, MULHU, mulhu, REL32I_WRITE_RD((uint32_t)(((uint64_t)REL32I_RS1 * (uint64_t)REL32I_RS2) >> 32));) \
+	OPERATION(51, DIV, div, REL32I_WRITE_RD(rel32i_divide(REL32I_RS1, REL32I_RS2));) \
+	OPERATION(52, DIVU, divu, REL32I_WRITE_RD(rel32i_divide_unsigned(REL32I_RS1, REL32I_RS2));) \
+	OPERATION(53, REM, rem, REL32I_WRITE_RD(rel32i_remainder(REL32I_RS1, REL32I_RS2));) \
+	OPERATION(54, REMU, remu, REL32I_WRITE_RD(rel32i_remainder_unsigned(REL32I_RS1, REL32I_RS2));) \
+	OPERATION(55, LR_W, lr_w, REL32I_LOAD_RESERVED();) \
+	OPERATION(56, SC_W, sc_w, REL32I_STORE_CONDITIONAL();) \
+	OPERATION(57, AMOSWAP_W, amoswap_w, REL32I_AMO(rel32i_atomic_exchange(word, REL32I_RS2));) \
+	OPERATION(58, AMOADD_W, amoadd_w, REL32I_AMO(rel32i_atomic_fetch_add(word, REL32I_RS2));) \
+	OPERATION(59, AMOXOR_W, amoxor_w, REL32I_AMO(rel32i_atomic_fetch_xor(word, REL32I_RS2));) \
+	OPERATION(60, AMOAND_W, amoand_w, REL32I_AMO(rel32i_atomic_fetch_and(word, REL32I_RS2));) \
+	OPERATION(61, AMOOR_W, amoor_w, REL32I_AMO(rel32i_atomic_fetch_or(word, REL32I_RS2));) \
+	OPERATION(62, AMOMIN_W, amomin_w, REL32I_AMO(rel32i_atomic_fetch_select(word, REL32I_RS2, 1, 1));) \
+	OPERATION(63, AMOMAX_W, amomax_w, REL32I_AMO(rel32i_atomic_fetch_select(word, REL32I_RS2, 0, 1));) \
+	OPERATION(64, AMOMINU_W, amominu_w, REL32I_AMO(rel32i_atomic_fetch_select(word, REL32I_RS2, 1, 0));) \
+	OPERATION(65, AMOMAXU_W, amomaxu_w, REL32I_AMO(rel32i_atomic_fetch_select(word, REL32I_RS2, 0, 0));) \
+	OPERATION(67, FLW, flw, REL32I_WRITE_FD_SINGLE(REL32I_LOAD(uint32_t, REL32I_RS1 + REL32I_IMMEDIATE));) \
+	OPERATION(68, FSW, fsw, REL32I_STORE(uint32_t, REL32I_RS1 + REL32I_IMMEDIATE, (uint32_t)REL32I_FD2); REL32I_NEXT();) \
+	OPERATION(69, FMADD_S, fmadd_s, REL32I_FUSED_SINGLE(0, 0);) \
+	OPERATION(70, FMSUB_S, fmsub_s, REL32I_FUSED_SINGLE(0, 1);) \
+	OPERATION(71, FNMSUB_S, fnmsub_s, REL32I_FUSED_SINGLE(1, 0);) \
+	OPERATION(72, FNMADD_S, fnmadd_s, REL32I_FUSED_SINGLE(1, 1);) \
+	OPERATION(73, FADD_S, fadd_s, REL32I_FLOAT_SINGLE(REL32I_FLOAT_ADD);) \
+	OPERATION(74, FSUB_S, fsub_s, REL32I_FLOAT_SINGLE(REL32I_FLOAT_SUBTRACT);) \
+	OPERATION(75, FMUL_S, fmul_s, REL32I_FLOAT_SINGLE(REL32I_FLOAT_MULTIPLY);) \
+	OPERATION(76, FDIV_S, fdiv_s, REL32I_FLOAT_SINGLE(REL32I_FLOAT_DIVIDE);) \
+	OPERATION(77, FSQRT_S, fsqrt_s, REL32I_FLOAT_SINGLE(REL32I_FLOAT_SQUARE_ROOT);) \
+	OPERATION(78, FSGNJ_S, fsgnj_s, REL32I_WRITE_FD_SINGLE((uint32_t)rel32i_inject_sign(REL32I_FS1, REL32I_FS2, 0, 0));) \
+	OPERATION(79, FSGNJN_S, fsgnjn_s, REL32I_WRITE_FD_SINGLE((uint32_t)rel32i_inject_sign(REL32I_FS1, REL32I_FS2, 0, 1));) \
+	OPERATION(80, FSGNJX_S, fsgnjx_s, REL32I_WRITE_FD_SINGLE((uint32_t)rel32i_inject_sign(REL32I_FS1, REL32I_FS2, 0, 2));) \
+	OPERATION(81, FMIN_S, fmin_s, REL32I_WRITE_FD_SINGLE((uint32_t)rel32i_select_float(hart->register_set, REL32I_FS1, REL32I_FS2, 0, 0));) \
+	OPERATION(82, FMAX_S, fmax_s, REL32I_WRITE_FD_SINGLE((uint32_t)rel32i_select_float(hart->register_set, REL32I_FS1, REL32I_FS2, 0, 1));) \
+	OPERATION(83, FCVT_W_S, fcvt_w_s, REL32I_CONVERT_TO_INTEGER(rel32i_convert_single_to_double(REL32I_FS1), 0);) \
+	OPERATION(84, FCVT_WU_S, fcvt_wu_s, REL32I_CONVERT_TO_INTEGER(rel32i_convert_single_to_double(REL32I_FS1), 1);) \
+	OPERATION(85, FMV_X_W, fmv_x_w, REL32I_WRITE_RD((uint32_t)REL32I_FD1);) \
+	OPERATION(86, FEQ_S, feq_s, REL32I_WRITE_RD(rel32i_compare_float(hart->register_set, REL32I_FS1, REL32I_FS2, 0, REL32I_FLOAT_EQUAL));) \
+	OPERATION(87, FLT_S, flt_s, REL32I_WRITE_RD(rel32i_compare_float(hart->register_set, REL32I_FS1, REL32I_FS2, 0, REL32I_FLOAT_LESS));) \
+	OPERATION(88, FLE_S, fle_s, REL32I_WRITE_RD(rel32i_compare_float(hart->register_set, REL32I_FS1, REL32I_FS2, 0, REL32I_FLOAT_LESS_OR_EQUAL));) \
+	OPERATION(89, FCLASS_S, fclass_s, REL32I_WRITE_RD(rel32i_classify_float(REL32I_FS1, 0));) \
+	OPERATION(90, FCVT_S_W, fcvt_s_w, REL32I_CONVERT_TO_SINGLE((uint64_t)(int64_t)(int32_t)REL32I_RS1, 1);) \
+	OPERATION(91, FCVT_S_WU, fcvt_s_wu, REL32I_CONVERT_TO_SINGLE((uint64_t)REL32I_RS1, 1);) \
+	OPERATION(92, FMV_W_X, fmv_w_x, REL32I_WRITE_FD_SINGLE(REL32I_RS1);) \
+	OPERATION(93, FLD, fld, REL32I_LOAD_DOUBLE();) \
+	OPERATION(94, FSD, fsd, REL32I_STORE_DOUBLE();) \
+	OPERATION(95, FMADD_D, fmadd_d, REL32I_FUSED_DOUBLE(0, 0);) \
+	OPERATION(96, FMSUB_D, fmsub_d, REL32I_FUSED_DOUBLE(0, 1);) \
+	OPERATION(97, FNMSUB_D, fnmsub_d, REL32I_FUSED_DOUBLE(1, 0);) \
+	OPERATION(98, FNMADD_D, fnmadd_d, REL32I_FUSED_DOUBLE(1, 1);) \
+	OPERATION(99, FADD_D, fadd_d, REL32I_FLOAT_DOUBLE(REL32I_FLOAT_ADD);) \
+	OPERATION(100, FSUB_D, fsub_d, REL32I_FLOAT_DOUBLE(REL32I_FLOAT_SUBTRACT);) \
+	OPERATION(101, FMUL_D, fmul_d, REL32I_FLOAT_DOUBLE(REL32I_FLOAT_MULTIPLY);) \
+	OPERATION(102, FDIV_D, fdiv_d, REL32I_FLOAT_DOUBLE(REL32I_FLOAT_DIVIDE);) \
+	OPERATION(103, FSQRT_D, fsqrt_d, REL32I_FLOAT_DOUBLE(REL32I_FLOAT_SQUARE_ROOT);) \
+	OPERATION(104, FSGNJ_D, fsgnj_d, REL32I_WRITE_FD(rel32i_inject_sign(REL32I_FD1, REL32I_FD2, 1, 0));) \
+	OPERATION(105, FSGNJN_D, fsgnjn_d, REL32I_WRITE_FD(rel32i_inject_sign(REL32I_FD1, REL32I_FD2, 1, 1));) \
+	OPERATION(106, FSGNJX_D, fsgnjx_d, REL32I_WRITE_FD(rel32i_inject_sign(REL32I_FD1, REL32I_FD2, 1, 2));) \
+	OPERATION(107, FMIN_D, fmin_d, REL32I_WRITE_FD(rel32i_select_float(hart->register_set, REL32I_FD1, REL32I_FD2, 1, 0));) \
+	OPERATION(108, FMAX_D, fmax_d, REL32I_WRITE_FD(rel32i_select_float(hart->register_set, REL32I_FD1, REL32I_FD2, 1, 1));) \
+	OPERATION(109, FCVT_S_D, fcvt_s_d, REL32I_CONVERT_TO_SINGLE(REL32I_FD1, 0);) \
+	OPERATION(110, FCVT_D_S, fcvt_d_s, REL32I_ROUNDING_MODE(); REL32I_WRITE_FD(rel32i_canonicalize_nan(rel32i_convert_single_to_double(REL32I_FS1), 1));) \
+	OPERATION(111, FEQ_D, feq_d, REL32I_WRITE_RD(rel32i_compare_float(hart->register_set, REL32I_FD1, REL32I_FD2, 1, REL32I_FLOAT_EQUAL));) \
+	OPERATION(112, FLT_D, flt_d, REL32I_WRITE_RD(rel32i_compare_float(hart->register_set, REL32I_FD1, REL32I_FD2, 1, REL32I_FLOAT_LESS));) \
+	OPERATION(113, FLE_D, fle_d, REL32I_WRITE_RD(rel32i_compare_float(hart->register_set, REL32I_FD1, REL32I_FD2, 1, REL32I_FLOAT_LESS_OR_EQUAL));) \
+	OPERATION(114, FCLASS_D, fclass_d, REL32I_WRITE_RD(rel32i_classify_float(REL32I_FD1, 1));) \
+	OPERATION(115, FCVT_W_D, fcvt_w_d, REL32I_CONVERT_TO_INTEGER(REL32I_FD1, 0);) \
+	OPERATION(116, FCVT_WU_D, fcvt_wu_d, REL32I_CONVERT_TO_INTEGER(REL32I_FD1, 1);) \
+	OPERATION(117, FCVT_D_W, fcvt_d_w, REL32I_ROUNDING_MODE(); REL32I_WRITE_FD(rel32i_convert_integer_to_double((int64_t)(int32_t)REL32I_RS1));) \
+	OPERATION(118, FCVT_D_WU, fcvt_d_wu, REL32I_ROUNDING_MODE(); REL32I_WRITE_FD(rel32i_convert_integer_to_double((int64_t)REL32I_RS1));)
+
+#define REL32I_OPERATION_ENUMERATOR(index, constant, name, body) REL32I_OPERATION_##constant = index,
+enum { REL32I_OPERATION_LIST(REL32I_OPERATION_ENUMERATOR) };
+#define REL32I_OPERATION_SFENCE_VMA 66
+
+static inline void rel32i_set_predecoded_instruction(int instruction_index, uint8_t opcode, uint8_t rd, uint8_t function3, uint8_t rs1, uint8_t rs2, uint8_t function7, uint32_t intermediate, uint8_t size, rel32i_predecoded_instruction_t* predecoded_instruction)
+{
+	predecoded_instruction->operation = (instruction_index != -1) ? (uint8_t)instruction_index : REL32I_OPERATION_UNKNOWN;
+	predecoded_instruction->rd = rd;
+	predecoded_instruction->rs1 = rs1;
+	predecoded_instruction->rs2 = rs2;
+	predecoded_instruction->intermediate = intermediate;
+	// floating-point R-type instructions keep the rounding mode in bits 2:0 and rs3 above it
+	if ((opcode & 0x60) == 0x40)
+		predecoded_instruction->intermediate = function3 | ((uint32_t)(function7 >> 2) << 3);
+	predecoded_instruction->size = size;
+}
+
+void rel32i_predecode_instruction(const void* address_of_instruction, rel32i_predecoded_instruction_t* predecoded_instruction)
+{
+	rel32_instruction_information_t info;
+	rel32_decode_instruction(address_of_instruction, &info);
+	rel32i_set_predecoded_instruction(info.instruction_index, info.opcode, info.rd, info.function3, info.rs1, info.rs2, info.function7, info.intermediate, info.size, predecoded_instruction);
+}
+
+size_t rel32i_get_predecode_cache_size(uint32_t code_size)
+{
+	const size_t header_size = ((sizeof(rel32i_predecode_cache_t) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1));
+	// one entry per halfword, since compressed instructions only need to be halfword aligned
+	return header_size + (size_t)(code_size / 2) * sizeof(rel32i_predecoded_instruction_t);
+}
+
+int rel32i_create_predecode_cache(uint32_t code_size, size_t buffer_size, void* buffer, rel32i_predecode_cache_t** pointer_to_predecode_cache)
+{
+	const size_t header_size = ((sizeof(rel32i_predecode_cache_t) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1));
+	if (buffer_size < rel32i_get_predecode_cache_size(code_size))
+		return ENOBUFS;
+
+	rel32i_predecode_cache_t* predecode_cache = (rel32i_predecode_cache_t*)buffer;
+	predecode_cache->code_size = code_size;
+	predecode_cache->instruction_table = (rel32i_predecoded_instruction_t*)((uintptr_t)buffer + header_size);
+	rel32i_flush_predecode_cache(predecode_cache);
+
+	*pointer_to_predecode_cache = predecode_cache;
+	return 0;
+}
+
+void rel32i_flush_predecode_cache(rel32i_predecode_cache_t* predecode_cache)
+{
+	for (rel32i_predecoded_instruction_t* i = predecode_cache->instruction_table, * e = i + (predecode_cache->code_size / 2); i != e; ++i)
+		i->operation = REL32I_OPERATION_UNDECODED;
+}
+
+#define REL32I_PREDECODE_BATCH_SIZE 64
+
+void rel32i_fill_predecode_cache(const void* code_base_address, rel32i_predecode_cache_t* predecode_cache, uint32_t start_address, uint32_t end_address)
+{
+	uint32_t machine_code[REL32I_PREDECODE_BATCH_SIZE];
+	uint8_t size[REL32I_PREDECODE_BATCH_SIZE];
+	uint8_t encoding[REL32I_PREDECODE_BATCH_SIZE];
+	uint8_t opcode[REL32I_PREDECODE_BATCH_SIZE];
+	uint8_t rd[REL32I_PREDECODE_BATCH_SIZE];
+	uint8_t function3[REL32I_PREDECODE_BATCH_SIZE];
+	uint8_t rs1[REL32I_PREDECODE_BATCH_SIZE];
+	uint8_t rs2[REL32I_PREDECODE_BATCH_SIZE];
+	uint8_t function7[REL32I_PREDECODE_BATCH_SIZE];
+	uint32_t intermediate[REL32I_PREDECODE_BATCH_SIZE];
+	int instruction_index[REL32I_PREDECODE_BATCH_SIZE];
+	const rel32_instruction_batch_t batch = { machine_code, size, encoding, opcode, rd, function3, rs1, rs2, function7, intermediate, instruction_index };
+
+	// the same bound as the interpreter's cache lookups, and every decoded word has to be inside the range
+	uint32_t code_end = predecode_cache->code_size & ~3;
+	if (end_address > code_end)
+		end_address = code_end;
+	start_address = (start_address + 1) & ~1;
+
+	// the batch decoder steps 4 bytes, a pass from each of the first two halfwords reaches every halfword of the range
+	for (uint32_t offset = 0; offset != 4; offset += 2)
+		for (uint32_t address = start_address + offset; address < end_address && end_address - address >= 4;)
+		{
+			size_t count = (end_address - address) / 4;
+			if (count > REL32I_PREDECODE_BATCH_SIZE)
+				count = REL32I_PREDECODE_BATCH_SIZE;
+			rel32_decode_instruction_batch((const void*)((uintptr_t)code_base_address + (uintptr_t)address), count, &batch);
+			rel32i_predecoded_instruction_t* instruction = predecode_cache->instruction_table + (address >> 1);
+			for (size_t i = 0; i != count; ++i)
+				rel32i_set_predecoded_instruction(instruction_index[i], opcode[i], rd[i], function3[i], rs1[i], rs2[i], function7[i], intermediate[i], size[i], instruction + i * 2);
+			address += (uint32_t)count * 4;
+		}
+}
+
+size_t rel32i_get_block_cache_size(uint32_t code_size, size_t instruction_capacity)
+{
+	const size_t header_size = ((sizeof(rel32i_block_cache_t) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1));
+	size_t block_capacity = instruction_capacity / 4 + 1;
+	size_t hash_table_size = 1;
+	while (hash_table_size < block_capacity)
+		hash_table_size <<= 1;
+	size_t page_count = ((size_t)code_size + (REL32I_CODE_PAGE_SIZE - 1)) / REL32I_CODE_PAGE_SIZE;
+	return header_size +
+		hash_table_size * sizeof(rel32i_block_t*) +
+		block_capacity * sizeof(rel32i_block_t) +
+		instruction_capacity * sizeof(rel32i_predecoded_instruction_t) +
+		page_count;
+}
+
+int rel32i_create_block_cache(uint32_t code_size, size_t instruction_capacity, size_t buffer_size, void* buffer, rel32i_block_cache_t** pointer_to_block_cache)
+{
+	const size_t header_size = ((sizeof(rel32i_block_cache_t) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1));
+	if (instruction_capacity < REL32I_MAX_BLOCK_SIZE + 1)
+		return EINVAL;
+	if (buffer_size < rel32i_get_block_cache_size(code_size, instruction_capacity))
+		return ENOBUFS;
+
+	size_t block_capacity = instruction_capacity / 4 + 1;
+	size_t hash_table_size = 1;
+	while (hash_table_size < block_capacity)
+		hash_table_size <<= 1;
+
+	rel32i_block_cache_t* block_cache = (rel32i_block_cache_t*)buffer;
+	block_cache->code_size = code_size;
+	block_cache->hash_mask = (uint32_t)(hash_table_size - 1);
+	block_cache->hash_table = (rel32i_block_t**)((uintptr_t)buffer + header_size);
+	block_cache->block_capacity = block_capacity;
+	block_cache->block_table = (rel32i_block_t*)((uintptr_t)block_cache->hash_table + hash_table_size * sizeof(rel32i_block_t*));
+	block_cache->instruction_capacity = instruction_capacity;
+	block_cache->instruction_pool = (rel32i_predecoded_instruction_t*)((uintptr_t)block_cache->block_table + block_capacity * sizeof(rel32i_block_t));
+	block_cache->code_page_table = (uint8_t*)((uintptr_t)block_cache->instruction_pool + instruction_capacity * sizeof(rel32i_predecoded_instruction_t));
+	rel32i_flush_block_cache(block_cache);
+	block_cache->flush_count = 0;
+	block_cache->flags = REL32I_BLOCK_CACHE_FUSE_INSTRUCTIONS;
+
+	*pointer_to_block_cache = block_cache;
+	return 0;
+}
+
+void rel32i_flush_block_cache(rel32i_block_cache_t* block_cache)
+{
+	for (uint32_t i = 0; i != block_cache->hash_mask + 1; ++i)
+		block_cache->hash_table[i] = 0;
+	for (uint32_t i = 0; i != (block_cache->code_size + (REL32I_CODE_PAGE_SIZE - 1)) / REL32I_CODE_PAGE_SIZE; ++i)
+		block_cache->code_page_table[i] = 0;
+	block_cache->block_count = 0;
+	block_cache->instruction_count = 0;
+	block_cache->flush_count++;
+}
+
+static int rel32i_operation_ends_block(uint8_t operation)
+{
+	// jal, jalr, the branches, ecall, ebreak, fence.i and anything that could not be decoded
+	return (operation >= REL32I_OPERATION_JAL && operation <= REL32I_OPERATION_BGEU) || operation == REL32I_OPERATION_ECALL || operation == REL32I_OPERATION_EBREAK ||
+		operation == REL32I_OPERATION_FENCE_I || operation == REL32I_OPERATION_UNKNOWN;
+}
+
+static uint8_t rel32i_get_fused_operation(const rel32i_predecoded_instruction_t* first, const rel32i_predecoded_instruction_t* second)
+{
+	if (!first->rd)
+		return 0;
+	switch (first->operation)
+	{
+		case REL32I_OPERATION_LUI:
+			return (second->operation == REL32I_OPERATION_ADDI && second->rd == first->rd && second->rs1 == first->rd) ? REL32I_OPERATION_FUSED_LOAD_IMMEDIATE : 0;
+		case REL32I_OPERATION_AUIPC:
+			if (second->rs1 != first->rd)
+				return 0;
+			return (second->operation == REL32I_OPERATION_JALR) ? REL32I_OPERATION_FUSED_CALL : ((second->operation == REL32I_OPERATION_LW) ? REL32I_OPERATION_FUSED_LOAD_GLOBAL : 0);
+		case REL32I_OPERATION_ADDI:
+			return (first->rd == 2 && first->rs1 == 2 && second->operation == REL32I_OPERATION_SW && second->rs1 == 2) ? REL32I_OPERATION_FUSED_STACK_STORE : 0;
+		case REL32I_OPERATION_SLTI:
+		case REL32I_OPERATION_SLTIU:
+		case REL32I_OPERATION_SLT:
+		case REL32I_OPERATION_SLTU:
+			// beqz or bnez on the result of the comparison
+			if ((second->operation != REL32I_OPERATION_BEQ && second->operation != REL32I_OPERATION_BNE) || second->rs1 != first->rd || second->rs2)
+				return 0;
+			if (first->operation == REL32I_OPERATION_SLT)
+				return REL32I_OPERATION_FUSED_SLT_BRANCH;
+			if (first->operation == REL32I_OPERATION_SLTU)
+				return REL32I_OPERATION_FUSED_SLTU_BRANCH;
+			return (first->operation == REL32I_OPERATION_SLTI) ? REL32I_OPERATION_FUSED_SLTI_BRANCH : REL32I_OPERATION_FUSED_SLTIU_BRANCH;
+		default:
+			return 0;
+	}
+}
+
+static void rel32i_fuse_block(rel32i_block_t* block)
+{
+	// the second instruction of a pair keeps its own entry, fused operations read it and then continue after it
+	for (uint32_t i = 0; i + 1 < block->instruction_count; ++i)
+	{
+		uint8_t fused_operation = rel32i_get_fused_operation(block->instruction_table + i, block->instruction_table + i + 1);
+		if (fused_operation)
+			block->instruction_table[i++].operation = fused_operation;
+	}
+}
+
+static rel32i_block_t* rel32i_translate_block(rel32i_block_cache_t* block_cache, const void* code_base_address, uint32_t address)
+{
+	if (block_cache->block_count == block_cache->block_capacity || block_cache->instruction_capacity - block_cache->instruction_count < REL32I_MAX_BLOCK_SIZE + 1)
+		rel32i_flush_block_cache(block_cache);
+
+	rel32i_block_t* block = block_cache->block_table + block_cache->block_count++;
+	block->address = address;
+	block->instruction_count = 0;
+	block->successor_table[0] = 0;
+	block->successor_table[1] = 0;
+	block->instruction_table = block_cache->instruction_pool + block_cache->instruction_count;
+
+	// an instruction is only taken when all 4 bytes a 32-bit one could need are inside the code
+	uint32_t code_end = block_cache->code_size & ~3;
+	uint32_t pc = address;
+	while (block->instruction_count != REL32I_MAX_BLOCK_SIZE && code_end - pc >= 4)
+	{
+		rel32i_predecoded_instruction_t* instruction = block->instruction_table + block->instruction_count++;
+		rel32i_predecode_instruction((const void*)((uintptr_t)code_base_address + (uintptr_t)pc), instruction);
+		pc += instruction->size;
+		if (rel32i_operation_ends_block(instruction->operation))
+			break;
+	}
+	block->instruction_table[block->instruction_count].operation = REL32I_OPERATION_BLOCK_END;
+	block_cache->instruction_count += block->instruction_count + 1;
+	if (block_cache->flags & REL32I_BLOCK_CACHE_FUSE_INSTRUCTIONS)
+		rel32i_fuse_block(block);
+
+	for (uint32_t page = address / REL32I_CODE_PAGE_SIZE; page <= (pc - 1) / REL32I_CODE_PAGE_SIZE; ++page)
+		block_cache->code_page_table[page] = 1;
+
+	rel32i_block_t** bucket = block_cache->hash_table + ((address >> 1) & block_cache->hash_mask);
+	block->next = *bucket;
+	*bucket = block;
+	return block;
+}
+
+static rel32i_block_t* rel32i_get_block(rel32i_block_cache_t* block_cache, const void* code_base_address, uint32_t address)
+{
+	if ((address & 1) || (uint64_t)address + 4 > (block_cache->code_size & ~3))
+		return 0;
+	for (rel32i_block_t* block = block_cache->hash_table[(address >> 1) & block_cache->hash_mask]; block; block = block->next)
+		if (block->address == address)
+			return block;
+	return rel32i_translate_block(block_cache, code_base_address, address);
+}
+
+// the instructions of a block in front of pc, a fused pair counts as two since the second instruction keeps its entry
+static uint32_t rel32i_count_block_instructions(const rel32i_block_t* block, uint32_t pc)
+{
+	uint32_t address = block->address;
+	uint32_t instruction_count = 0;
+	while (address != pc && instruction_count != block->instruction_count)
+		address += block->instruction_table[instruction_count++].size;
+	return instruction_count;
+}
+
+int rel32i_invalidate_code(rel32i_hart_t* hart, uint32_t address, uint32_t size)
+{
+	if (!size)
+		return 0;
+
+	rel32i_predecode_cache_t* predecode_cache = hart->predecode_cache;
+	// a 32-bit instruction that starts in the halfword before the range reaches into it
+	if (predecode_cache)
+		for (uint32_t i = (address >= 2) ? ((address - 2) >> 1) : 0, e = (address + size - 1) >> 1; i <= e && i < predecode_cache->code_size / 2; ++i)
+			predecode_cache->instruction_table[i].operation = REL32I_OPERATION_UNDECODED;
+
+	int flushed = 0;
+	rel32i_block_cache_t* block_cache = hart->block_cache;
+	if (block_cache)
+		for (uint32_t page = address / REL32I_CODE_PAGE_SIZE, e = (address + size - 1) / REL32I_CODE_PAGE_SIZE; page <= e && page < (block_cache->code_size + (REL32I_CODE_PAGE_SIZE - 1)) / REL32I_CODE_PAGE_SIZE; ++page)
+			if (block_cache->code_page_table[page])
+			{
+				// blocks are chained directly to each other, so dropping only some of them would leave dangling links
+				rel32i_flush_block_cache(block_cache);
+				flushed = 1;
+				break;
+			}
+
+	rel32i_jit_t* jit = hart->jit;
+	if (jit)
+		for (uint32_t page = address / REL32I_CODE_PAGE_SIZE, e = (address + size - 1) / REL32I_CODE_PAGE_SIZE; page <= e && page < (jit->code_size + (REL32I_CODE_PAGE_SIZE - 1)) / REL32I_CODE_PAGE_SIZE; ++page)
+			if (jit->code_page_table[page])
+			{
+				rel32i_flush_jit(jit);
+				flushed = 1;
+				break;
+			}
+
+	return flushed;
+}
+
+static void rel32i_invalidate_all_code(rel32i_hart_t* hart)
+{
+	if (hart->predecode_cache)
+		rel32i_flush_predecode_cache(hart->predecode_cache);
+	if (hart->block_cache)
+		rel32i_flush_block_cache(hart->block_cache);
+	if (hart->jit)
+		rel32i_flush_jit(hart->jit);
+}
+
+static uint32_t rel32i_get_watched_code_size(const rel32i_hart_t* hart)
+{
+	uint32_t predecoded_code_size = hart->predecode_cache ? hart->predecode_cache->code_size : 0;
+	uint32_t translated_code_size = hart->block_cache ? hart->block_cache->code_size : 0;
+	uint32_t compiled_code_size = hart->jit ? hart->jit->code_size : 0;
+	if (translated_code_size < compiled_code_size)
+		translated_code_size = compiled_code_size;
+	return (predecoded_code_size > translated_code_size) ? predecoded_code_size : translated_code_size;
+}
+
+static inline uint32_t rel32i_shift_right_arithmetic(uint32_t value, uint32_t shift)
+{
+	return ((value >> shift) & (0xFFFFFFFF >> shift)) | ((0 - (value >> 31)) & ~(0xFFFFFFFF >> shift));
+}
+
+// division never traps, dividing by zero gives all ones or the dividend and the one signed overflow gives INT32_MIN or 0
+static inline uint32_t rel32i_divide(uint32_t dividend, uint32_t divisor)
+{
+	if (!divisor)
+		return 0xFFFFFFFF;
+	if (divisor == 0xFFFFFFFF)
+		return 0 - dividend;
+	return (uint32_t)((int32_t)dividend / (int32_t)divisor);
+}
+
+static inline uint32_t rel32i_divide_unsigned(uint32_t dividend, uint32_t divisor)
+{
+	return divisor ? dividend / divisor : 0xFFFFFFFF;
+}
+
+static inline uint32_t rel32i_remainder(uint32_t dividend, uint32_t divisor)
+{
+	if (!divisor)
+		return dividend;
+	if (divisor == 0xFFFFFFFF)
+		return 0;
+	return (uint32_t)((int32_t)dividend % (int32_t)divisor);
+}
+
+static inline uint32_t rel32i_remainder_unsigned(uint32_t dividend, uint32_t divisor)
+{
+	return divisor ? dividend % divisor : dividend;
+}
+
+// sequentially consistent host atomics on guest words, which covers every aq and rl combination
+static inline uint32_t rel32i_atomic_load(uint32_t* word)
+{
+#if defined(_MSC_VER)
+	return (uint32_t)_InterlockedOr((volatile long*)word, 0);
+#else
+	return __atomic_load_n(word, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline uint32_t rel32i_atomic_compare_exchange(uint32_t* word, uint32_t expected, uint32_t value)
+{
+#if defined(_MSC_VER)
+	return (uint32_t)_InterlockedCompareExchange((volatile long*)word, (long)value, (long)expected);
+#else
+	__atomic_compare_exchange_n(word, &expected, value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return expected;
+#endif
+}
+
+static inline uint32_t rel32i_atomic_exchange(uint32_t* word, uint32_t value)
+{
+#if defined(_MSC_VER)
+	return (uint32_t)_InterlockedExchange((volatile long*)word, (long)value);
+#else
+	return __atomic_exchange_n(word, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline uint32_t rel32i_atomic_fetch_add(uint32_t* word, uint32_t value)
+{
+#if defined(_MSC_VER)
+	return (uint32_t)_InterlockedExchangeAdd((volatile long*)word, (long)value);
+#else
+	return __atomic_fetch_add(word, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline uint32_t rel32i_atomic_fetch_xor(uint32_t* word, uint32_t value)
+{
+#if defined(_MSC_VER)
+	return (uint32_t)_InterlockedXor((volatile long*)word, (long)value);
+#else
+	return __atomic_fetch_xor(word, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline uint32_t rel32i_atomic_fetch_and(uint32_t* word, uint32_t value)
+{
+#if defined(_MSC_VER)
+	return (uint32_t)_InterlockedAnd((volatile long*)word, (long)value);
+#else
+	return __atomic_fetch_and(word, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline uint32_t rel32i_atomic_fetch_or(uint32_t* word, uint32_t value)
+{
+#if defined(_MSC_VER)
+	return (uint32_t)_InterlockedOr((volatile long*)word, (long)value);
+#else
+	return __atomic_fetch_or(word, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// the host has no fetch and min or max, so these retry a compare and swap until no other hart wrote in between
+static inline uint32_t rel32i_atomic_fetch_select(uint32_t* word, uint32_t value, int keep_smaller, int is_signed)
+{
+	uint32_t old_value = rel32i_atomic_load(word);
+	for (;;)
+	{
+		int value_is_smaller = is_signed ? ((int32_t)value < (int32_t)old_value) : (value < old_value);
+		uint32_t new_value = (value_is_smaller == keep_smaller) ? value : old_value;
+		uint32_t observed_value = rel32i_atomic_compare_exchange(word, old_value, new_value);
+		if (observed_value == old_value)
+			return old_value;
+		old_value = observed_value;
+	}
+}
+
+/*
+	Semantics of every instruction_table row, indexed by the row. The interpreter cores expand this list with their own definitions of
+	REL32I_WRITE_RD, REL32I_NEXT, REL32I_BRANCH, REL32I_JUMP_AND_LINK, REL32I_EVENT, REL32I_FENCE_I and REL32I_CODE_WRITTEN.
+	The body of an operation must end with one of the first six.
+*/
+#if defined(REL32I_SSE_FLOAT_SUPPORTED)
+typedef uint32_t rel32i_host_fp_environment_t;
+#else
+typedef fenv_t rel32i_host_fp_environment_t;
+#endif
+
+// the host keeps its own floating-point environment until the first floating-point instruction of a run
+#define REL32I_HOST_ROUNDING_MODE 0xFF
+
+/*
+	Execution engines record where they are at every guest memory access, so that an access fault can be turned into a precise stop.
+	The retired instruction count at pc is base_instruction_count + instruction_count plus, while a block runs, the instructions of the block in front of pc.
+*/
+typedef struct rel32i_fault_frame_t
+{
+	uint32_t* x;
+	uint32_t pc;
+	const rel32i_block_t* block;
+	uint64_t instruction_count;
+	uint64_t base_instruction_count;
+	struct rel32i_jit_context_t* jit_context;
+	uint64_t jit_max_instruction_count;
+	rel32i_hart_t* hart;
+	uint64_t fault_instruction_count;
+	int fault_stop_reason;
+	// the guest rounding mode the host FPU is set to, or REL32I_HOST_ROUNDING_MODE while the host environment is untouched
+	uint32_t fp_rounding_mode;
+	rel32i_host_fp_environment_t host_fp_environment;
+	jmp_buf jump_buffer;
+} rel32i_fault_frame_t;
+
+// keeps the compiler from holding guest registers or the checkpoint back in host registers across a guest access that may fault
+static inline void rel32i_fault_barrier(void)
+{
+#if defined(__GNUC__)
+	__asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+_Noreturn static void rel32i_raise_fault(rel32i_fault_frame_t* fault_frame, int stop_reason, uint32_t pc, uint64_t instruction_count)
+{
+	// the engine that faulted is still on the stack, so its registers can be saved before jumping back to rel32i_run
+	fault_frame->hart->register_set->pc = pc;
+	rel32_copy(fault_frame->hart->register_set->x1_x31, fault_frame->x + 1, 31 * sizeof(uint32_t));
+	fault_frame->fault_instruction_count = instruction_count;
+	fault_frame->fault_stop_reason = stop_reason;
+	longjmp(fault_frame->jump_buffer, 1);
+}
+
+size_t rel32i_get_memory_size(size_t leaf_table_capacity)
+{
+	const size_t header_size = ((sizeof(rel32i_memory_t) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1));
+	return header_size + leaf_table_capacity * REL32I_MEMORY_LEAF_PAGE_COUNT * sizeof(rel32i_memory_page_t);
+}
+
+int rel32i_create_memory(size_t leaf_table_capacity, size_t buffer_size, void* buffer, rel32i_memory_t** pointer_to_memory)
+{
+	const size_t header_size = ((sizeof(rel32i_memory_t) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1));
+	if (buffer_size < rel32i_get_memory_size(leaf_table_capacity))
+		return ENOBUFS;
+
+	rel32i_memory_t* memory = (rel32i_memory_t*)buffer;
+	for (size_t i = 0; i != sizeof(memory->directory) / sizeof(*memory->directory); ++i)
+		memory->directory[i] = 0;
+	memory->leaf_table_capacity = leaf_table_capacity;
+	memory->leaf_table_count = 0;
+	memory->leaf_table_pool = (rel32i_memory_page_t*)((uintptr_t)buffer + header_size);
+	memory->mmio_count = 0;
+	memory->fault_address = 0;
+	rel32i_flush_memory_tlb(memory);
+
+	*pointer_to_memory = memory;
+	return 0;
+}
+
+void rel32i_flush_memory_tlb(rel32i_memory_t* memory)
+{
+	// tags are page addresses, so an odd tag never matches
+	for (size_t i = 0; i != REL32I_MEMORY_TLB_SIZE; ++i)
+	{
+		memory->tlb[i].read_tag = 1;
+		memory->tlb[i].write_tag = 1;
+		memory->tlb[i].execute_tag = 1;
+		memory->tlb[i].host_offset = 0;
+	}
+}
+
+static inline rel32i_memory_page_t* rel32i_get_memory_page(const rel32i_memory_t* memory, uint32_t address)
+{
+	rel32i_memory_page_t* leaf_table = memory->directory[address / (REL32I_MEMORY_PAGE_SIZE * REL32I_MEMORY_LEAF_PAGE_COUNT)];
+	return leaf_table ? leaf_table + ((address / REL32I_MEMORY_PAGE_SIZE) & (REL32I_MEMORY_LEAF_PAGE_COUNT - 1)) : 0;
+}
+
+static int rel32i_set_memory_pages(rel32i_memory_t* memory, uint32_t address, uint32_t size, int type, int access, uintptr_t host_address, uint16_t mmio_index)
+{
+	if ((address | size) & (REL32I_MEMORY_PAGE_SIZE - 1))
+		return EINVAL;
+	if ((uint64_t)address + (uint64_t)size > ((uint64_t)1 << 32))
+		return EINVAL;
+
+	// all leaf tables are taken before anything changes, so a failed call leaves the map as it was
+	const uint32_t leaf_size = REL32I_MEMORY_PAGE_SIZE * REL32I_MEMORY_LEAF_PAGE_COUNT;
+	size_t missing_leaf_table_count = 0;
+	for (uint64_t leaf_address = address & ~(leaf_size - 1); leaf_address < (uint64_t)address + (uint64_t)size; leaf_address += leaf_size)
+		if (!memory->directory[leaf_address / leaf_size])
+			++missing_leaf_table_count;
+	if (type != REL32I_MEMORY_UNMAPPED && missing_leaf_table_count > memory->leaf_table_capacity - memory->leaf_table_count)
+		return ENOBUFS;
+
+	for (uint64_t offset = 0; offset != size; offset += REL32I_MEMORY_PAGE_SIZE)
+	{
+		uint32_t page_address = address + (uint32_t)offset;
+		if (!memory->directory[page_address / leaf_size])
+		{
+			if (type == REL32I_MEMORY_UNMAPPED)
+				continue;
+			rel32i_memory_page_t* leaf_table = memory->leaf_table_pool + memory->leaf_table_count++ * REL32I_MEMORY_LEAF_PAGE_COUNT;
+			for (size_t i = 0; i != REL32I_MEMORY_LEAF_PAGE_COUNT; ++i)
+			{
+				leaf_table[i].host_offset = 0;
+				leaf_table[i].type = REL32I_MEMORY_UNMAPPED;
+				leaf_table[i].access = 0;
+				leaf_table[i].mmio_index = 0;
+			}
+			memory->directory[page_address / leaf_size] = leaf_table;
+		}
+
+		rel32i_memory_page_t* page = rel32i_get_memory_page(memory, page_address);
+		page->host_offset = host_address - (uintptr_t)address;
+		page->type = (uint8_t)type;
+		page->access = (uint8_t)access;
+		page->mmio_index = mmio_index;
+	}
+
+	rel32i_flush_memory_tlb(memory);
+	return 0;
+}
+
+int rel32i_map_memory(rel32i_memory_t* memory, uint32_t address, uint32_t size, int type, int access, void* host_address)
+{
+	if (type != REL32I_MEMORY_RAM && type != REL32I_MEMORY_ROM)
+		return EINVAL;
+	return rel32i_set_memory_pages(memory, address, size, type, access, (uintptr_t)host_address, 0);
+}
+
+int rel32i_map_mmio(rel32i_memory_t* memory, uint32_t address, uint32_t size, int access, rel32i_mmio_read_t read, rel32i_mmio_write_t write, void* context)
+{
+	if (memory->mmio_count == REL32I_MEMORY_MAX_MMIO_COUNT)
+		return ENOBUFS;
+
+	int error = rel32i_set_memory_pages(memory, address, size, REL32I_MEMORY_MMIO, access, 0, (uint16_t)memory->mmio_count);
+	if (error)
+		return error;
+	rel32i_mmio_t* mmio = memory->mmio_table + memory->mmio_count++;
+	mmio->address = address;
+	mmio->read = read;
+	mmio->write = write;
+	mmio->context = context;
+	return 0;
+}
+
+int rel32i_unmap_memory(rel32i_memory_t* memory, uint32_t address, uint32_t size)
+{
+	return rel32i_set_memory_pages(memory, address, size, REL32I_MEMORY_UNMAPPED, 0, 0, 0);
+}
+
+static uint64_t rel32i_get_checkpoint_instruction_count(const rel32i_fault_frame_t* fault_frame)
+{
+	uint64_t instruction_count = fault_frame->base_instruction_count + fault_frame->instruction_count;
+	if (fault_frame->block)
+		instruction_count += rel32i_count_block_instructions(fault_frame->block, fault_frame->pc);
+	return instruction_count;
+}
+
+_Noreturn static void rel32i_raise_fault_at_checkpoint(rel32i_fault_frame_t* fault_frame, int stop_reason)
+{
+	rel32i_raise_fault(fault_frame, stop_reason, fault_frame->pc, rel32i_get_checkpoint_instruction_count(fault_frame));
+}
+
+_Noreturn static void rel32i_raise_memory_fault(rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address)
+{
+	memory->fault_address = address;
+	rel32i_raise_fault_at_checkpoint(fault_frame, REL32I_STOP_ACCESS_FAULT);
+}
+
+static const rel32i_memory_page_t* rel32i_check_memory_page(rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, int access)
+{
+	const rel32i_memory_page_t* page = rel32i_get_memory_page(memory, address);
+	if (!page || page->type == REL32I_MEMORY_UNMAPPED || !(page->access & access))
+		rel32i_raise_memory_fault(memory, fault_frame, address);
+
+	// only host backed pages are cached, writes to ROM always take the slow path
+	if (page->type != REL32I_MEMORY_MMIO)
+	{
+		rel32i_tlb_entry_t* entry = memory->tlb + ((address / REL32I_MEMORY_PAGE_SIZE) & (REL32I_MEMORY_TLB_SIZE - 1));
+		uint32_t page_address = address & ~(uint32_t)(REL32I_MEMORY_PAGE_SIZE - 1);
+		entry->read_tag = (page->access & REL32I_ACCESS_READ) ? page_address : 1;
+		entry->write_tag = (page->type == REL32I_MEMORY_RAM && (page->access & REL32I_ACCESS_WRITE)) ? page_address : 1;
+		entry->execute_tag = (page->access & REL32I_ACCESS_EXECUTE) ? page_address : 1;
+		entry->host_offset = page->host_offset;
+	}
+	return page;
+}
+
+static uint32_t rel32i_load_memory_slow(rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, uint32_t size)
+{
+	if ((address & (REL32I_MEMORY_PAGE_SIZE - 1)) > REL32I_MEMORY_PAGE_SIZE - size)
+	{
+		uint32_t value = 0;
+		for (uint32_t i = 0; i != size; ++i)
+			value |= rel32i_load_memory_slow(memory, fault_frame, address + i, 1) << (i * 8);
+		return value;
+	}
+
+	const rel32i_memory_page_t* page = rel32i_check_memory_page(memory, fault_frame, address, REL32I_ACCESS_READ);
+	if (page->type == REL32I_MEMORY_MMIO)
+	{
+		const rel32i_mmio_t* mmio = memory->mmio_table + page->mmio_index;
+		uint32_t value;
+		if (!mmio->read || mmio->read(mmio->context, address - mmio->address, size, &value))
+			rel32i_raise_memory_fault(memory, fault_frame, address);
+		return value;
+	}
+
+	const void* host_address = (const void*)(page->host_offset + (uintptr_t)address);
+	return (size == 1) ? *(const uint8_t*)host_address : ((size == 2) ? *(const uint16_t*)host_address : *(const uint32_t*)host_address);
+}
+
+static uintptr_t rel32i_store_memory_slow(rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, uint32_t size, uint32_t value)
+{
+	if ((address & (REL32I_MEMORY_PAGE_SIZE - 1)) > REL32I_MEMORY_PAGE_SIZE - size)
+	{
+		// both pages are checked first so that a faulting store does not write half of its value
+		rel32i_check_memory_page(memory, fault_frame, address, REL32I_ACCESS_WRITE);
+		rel32i_check_memory_page(memory, fault_frame, (address + size - 1) & ~(uint32_t)(REL32I_MEMORY_PAGE_SIZE - 1), REL32I_ACCESS_WRITE);
+		for (uint32_t i = 0; i != size; ++i)
+			rel32i_store_memory_slow(memory, fault_frame, address + i, 1, value >> (i * 8));
+		return 0;
+	}
+
+	const rel32i_memory_page_t* page = rel32i_check_memory_page(memory, fault_frame, address, REL32I_ACCESS_WRITE);
+	if (page->type == REL32I_MEMORY_MMIO)
+	{
+		const rel32i_mmio_t* mmio = memory->mmio_table + page->mmio_index;
+		if (!mmio->write || mmio->write(mmio->context, address - mmio->address, size, value))
+			rel32i_raise_memory_fault(memory, fault_frame, address);
+		return 0;
+	}
+	if (page->type == REL32I_MEMORY_ROM)
+		return 0;
+
+	void* host_address = (void*)(page->host_offset + (uintptr_t)address);
+	if (size == 1)
+		*(uint8_t*)host_address = (uint8_t)value;
+	else if (size == 2)
+		*(uint16_t*)host_address = (uint16_t)value;
+	else
+		*(uint32_t*)host_address = value;
+	return (uintptr_t)host_address;
+}
+
+// the tag compare also sends misaligned accesses to the slow path, which is what keeps accesses that cross a page out of the fast path
+static inline uint32_t rel32i_load_memory(rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, uint32_t size)
+{
+	const rel32i_tlb_entry_t* entry = memory->tlb + ((address / REL32I_MEMORY_PAGE_SIZE) & (REL32I_MEMORY_TLB_SIZE - 1));
+	if (entry->read_tag == (address & (~(uint32_t)(REL32I_MEMORY_PAGE_SIZE - 1) | (size - 1))))
+	{
+		const void* host_address = (const void*)(entry->host_offset + (uintptr_t)address);
+		return (size == 1) ? *(const uint8_t*)host_address : ((size == 2) ? *(const uint16_t*)host_address : *(const uint32_t*)host_address);
+	}
+	return rel32i_load_memory_slow(memory, fault_frame, address, size);
+}
+
+// returns the host address that was written, or 0 when the store went to a device or was discarded
+static inline uintptr_t rel32i_store_memory(rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, uint32_t size, uint32_t value)
+{
+	const rel32i_tlb_entry_t* entry = memory->tlb + ((address / REL32I_MEMORY_PAGE_SIZE) & (REL32I_MEMORY_TLB_SIZE - 1));
+	if (entry->write_tag == (address & (~(uint32_t)(REL32I_MEMORY_PAGE_SIZE - 1) | (size - 1))))
+	{
+		void* host_address = (void*)(entry->host_offset + (uintptr_t)address);
+		if (size == 1)
+			*(uint8_t*)host_address = (uint8_t)value;
+		else if (size == 2)
+			*(uint16_t*)host_address = (uint16_t)value;
+		else
+			*(uint32_t*)host_address = value;
+		return (uintptr_t)host_address;
+	}
+	return rel32i_store_memory_slow(memory, fault_frame, address, size, value);
+}
+
+static inline const void* rel32i_fetch_memory(rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t pc)
+{
+	const rel32i_tlb_entry_t* entry = memory->tlb + ((pc / REL32I_MEMORY_PAGE_SIZE) & (REL32I_MEMORY_TLB_SIZE - 1));
+	if (entry->execute_tag != (pc & (~(uint32_t)(REL32I_MEMORY_PAGE_SIZE - 1) | 1)))
+	{
+		// instructions are fetched a halfword at a time and never from devices
+		const rel32i_memory_page_t* page = rel32i_check_memory_page(memory, fault_frame, pc, REL32I_ACCESS_EXECUTE);
+		if (page->type == REL32I_MEMORY_MMIO || (pc & 1))
+			rel32i_raise_memory_fault(memory, fault_frame, pc);
+		return (const void*)(page->host_offset + (uintptr_t)pc);
+	}
+	return (const void*)(entry->host_offset + (uintptr_t)pc);
+}
+
+#define REL32I_CSR_FFLAGS 0x001
+#define REL32I_CSR_FRM 0x002
+#define REL32I_CSR_FCSR 0x003
+#define REL32I_CSR_SATP 0x180
+#define REL32I_CSR_MCYCLE 0xB00
+#define REL32I_CSR_MINSTRET 0xB02
+#define REL32I_CSR_MCYCLEH 0xB80
+#define REL32I_CSR_MINSTRETH 0xB82
+#define REL32I_CSR_CYCLE 0xC00
+#define REL32I_CSR_TIME 0xC01
+#define REL32I_CSR_INSTRET 0xC02
+#define REL32I_CSR_CYCLEH 0xC80
+#define REL32I_CSR_TIMEH 0xC81
+#define REL32I_CSR_INSTRETH 0xC82
+
+#define REL32I_SATP_MODE_SV32 0x80000000
+#define REL32I_PTE_V 0x01
+#define REL32I_PTE_R 0x02
+#define REL32I_PTE_W 0x04
+#define REL32I_PTE_X 0x08
+#define REL32I_PTE_U 0x10
+#define REL32I_PTE_G 0x20
+#define REL32I_PTE_A 0x40
+#define REL32I_PTE_D 0x80
+
+static void rel32i_flush_mmu_tlb_entry(rel32i_mmu_tlb_entry_t* entry)
+{
+	entry->read_tag = 1;
+	entry->write_tag = 1;
+	entry->execute_tag = 1;
+	entry->virtual_page = 0;
+	entry->physical_page = 0;
+	entry->asid = 0;
+	entry->superpage = 0;
+}
+
+static void rel32i_update_mmu(rel32i_mmu_t* mmu)
+{
+	mmu->asid = (uint16_t)((mmu->satp >> 22) & 0x1FF);
+	mmu->translating = (mmu->satp & REL32I_SATP_MODE_SV32) && mmu->privilege != REL32I_PRIVILEGE_MACHINE;
+}
+
+void rel32i_initialize_mmu(rel32i_mmu_t* mmu)
+{
+	mmu->satp = 0;
+	mmu->privilege = REL32I_PRIVILEGE_SUPERVISOR;
+	mmu->flags = 0;
+	mmu->fault_address = 0;
+	mmu->fault_access = 0;
+	mmu->instruction_tlb_hit_count = 0;
+	mmu->instruction_tlb_miss_count = 0;
+	mmu->data_tlb_hit_count = 0;
+	mmu->data_tlb_miss_count = 0;
+	for (size_t i = 0; i != REL32I_MMU_TLB_SIZE; ++i)
+	{
+		rel32i_flush_mmu_tlb_entry(mmu->instruction_tlb + i);
+		rel32i_flush_mmu_tlb_entry(mmu->data_tlb + i);
+	}
+	rel32i_update_mmu(mmu);
+}
+
+void rel32i_write_satp(rel32i_mmu_t* mmu, uint32_t satp)
+{
+	// entries are tagged with the ASID they were filled under, so switching address spaces does not flush anything
+	mmu->satp = satp;
+	rel32i_update_mmu(mmu);
+}
+
+void rel32i_set_mmu_privilege(rel32i_mmu_t* mmu, int privilege, int flags)
+{
+	// the tags only grant what the privilege and flags at fill time allowed
+	if (privilege != mmu->privilege || flags != mmu->flags)
+		for (size_t i = 0; i != REL32I_MMU_TLB_SIZE; ++i)
+		{
+			rel32i_flush_mmu_tlb_entry(mmu->instruction_tlb + i);
+			rel32i_flush_mmu_tlb_entry(mmu->data_tlb + i);
+		}
+	mmu->privilege = (uint8_t)privilege;
+	mmu->flags = (uint8_t)flags;
+	rel32i_update_mmu(mmu);
+}
+
+static int rel32i_mmu_tlb_entry_matches(const rel32i_mmu_tlb_entry_t* entry, uint32_t address, uint32_t asid, int flags)
+{
+	// a superpage entry caches the leaf of the whole superpage, so any address in it matches
+	if ((flags & REL32I_SFENCE_VMA_ADDRESS) && ((entry->virtual_page ^ address) & (entry->superpage ? 0xFFC00000 : 0xFFFFF000)))
+		return 0;
+	if ((flags & REL32I_SFENCE_VMA_ASID) && entry->asid != (asid & 0x1FF))
+		return 0;
+	return 1;
+}
+
+void rel32i_sfence_vma(rel32i_mmu_t* mmu, uint32_t address, uint32_t asid, int flags)
+{
+	for (size_t i = 0; i != REL32I_MMU_TLB_SIZE; ++i)
+	{
+		if (rel32i_mmu_tlb_entry_matches(mmu->instruction_tlb + i, address, asid, flags))
+			rel32i_flush_mmu_tlb_entry(mmu->instruction_tlb + i);
+		if (rel32i_mmu_tlb_entry_matches(mmu->data_tlb + i, address, asid, flags))
+			rel32i_flush_mmu_tlb_entry(mmu->data_tlb + i);
+	}
+}
+
+_Noreturn static void rel32i_raise_page_fault(rel32i_mmu_t* mmu, rel32i_fault_frame_t* fault_frame, uint32_t address, int access)
+{
+	mmu->fault_address = address;
+	mmu->fault_access = access;
+	rel32i_raise_fault_at_checkpoint(fault_frame, REL32I_STOP_PAGE_FAULT);
+}
+
+static uint32_t rel32i_translate(rel32i_mmu_t* mmu, rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, int access)
+{
+	rel32i_mmu_tlb_entry_t* entry = ((access == REL32I_ACCESS_EXECUTE) ? mmu->instruction_tlb : mmu->data_tlb) + ((address / REL32I_MEMORY_PAGE_SIZE) & (REL32I_MMU_TLB_SIZE - 1));
+	uint64_t* hit_count = (access == REL32I_ACCESS_EXECUTE) ? &mmu->instruction_tlb_hit_count : &mmu->data_tlb_hit_count;
+	uint64_t* miss_count = (access == REL32I_ACCESS_EXECUTE) ? &mmu->instruction_tlb_miss_count : &mmu->data_tlb_miss_count;
+	uint32_t page = address & ~(uint32_t)(REL32I_MEMORY_PAGE_SIZE - 1);
+	uint32_t tag = (access == REL32I_ACCESS_READ) ? entry->read_tag : ((access == REL32I_ACCESS_WRITE) ? entry->write_tag : entry->execute_tag);
+	if (tag == page && (entry->asid == mmu->asid || entry->asid == REL32I_MMU_GLOBAL_ASID))
+	{
+		++*hit_count;
+		return entry->physical_page | (address & (REL32I_MEMORY_PAGE_SIZE - 1));
+	}
+	++*miss_count;
+
+	// Sv32 walk, the page tables are read through the physical memory map like any other access
+	uint64_t table_address = (uint64_t)(mmu->satp & 0x3FFFFF) * REL32I_MEMORY_PAGE_SIZE;
+	int level = 1;
+	uint64_t entry_address;
+	uint32_t page_table_entry;
+	for (;;)
+	{
+		entry_address = table_address + ((address >> (12 + 10 * level)) & 0x3FF) * 4;
+		if (entry_address >> 32)
+			rel32i_raise_memory_fault(memory, fault_frame, (uint32_t)entry_address);
+		page_table_entry = rel32i_load_memory(memory, fault_frame, (uint32_t)entry_address, 4);
+		if (!(page_table_entry & REL32I_PTE_V) || ((page_table_entry & (REL32I_PTE_R | REL32I_PTE_W)) == REL32I_PTE_W))
+			rel32i_raise_page_fault(mmu, fault_frame, address, access);
+		if (page_table_entry & (REL32I_PTE_R | REL32I_PTE_X))
+			break;
+		if (!level)
+			rel32i_raise_page_fault(mmu, fault_frame, address, access);
+		table_address = (uint64_t)(page_table_entry >> 10) * REL32I_MEMORY_PAGE_SIZE;
+		--level;
+	}
+
+	int user_page = (page_table_entry & REL32I_PTE_U) != 0;
+	int accessible = (mmu->privilege == REL32I_PRIVILEGE_USER) ? user_page : (!user_page || (mmu->flags & REL32I_MMU_SUM));
+	int executable = (page_table_entry & REL32I_PTE_X) && ((mmu->privilege == REL32I_PRIVILEGE_USER) == user_page);
+	int readable = accessible && ((page_table_entry & REL32I_PTE_R) || ((mmu->flags & REL32I_MMU_MXR) && (page_table_entry & REL32I_PTE_X)));
+	int writable = accessible && (page_table_entry & REL32I_PTE_W);
+	if ((access == REL32I_ACCESS_READ && !readable) || (access == REL32I_ACCESS_WRITE && !writable) || (access == REL32I_ACCESS_EXECUTE && !executable))
+		rel32i_raise_page_fault(mmu, fault_frame, address, access);
+	if (level && ((page_table_entry >> 10) & 0x3FF))
+		rel32i_raise_page_fault(mmu, fault_frame, address, access);
+
+	// A and D are set here rather than faulting, which the privileged specification allows
+	uint32_t updated_page_table_entry = page_table_entry | REL32I_PTE_A | ((access == REL32I_ACCESS_WRITE) ? REL32I_PTE_D : 0);
+	if (updated_page_table_entry != page_table_entry)
+	{
+		rel32i_store_memory(memory, fault_frame, (uint32_t)entry_address, 4, updated_page_table_entry);
+		page_table_entry = updated_page_table_entry;
+	}
+
+	uint64_t physical_page = level ?
+		(((uint64_t)(page_table_entry >> 20) << 22) | (address & 0x003FF000)) :
+		((uint64_t)(page_table_entry >> 10) * REL32I_MEMORY_PAGE_SIZE);
+	if (physical_page >> 32)
+		rel32i_raise_memory_fault(memory, fault_frame, (uint32_t)physical_page);
+
+	// stores only hit entries whose page is already dirty
+	entry->virtual_page = page;
+	entry->physical_page = (uint32_t)physical_page;
+	entry->asid = (page_table_entry & REL32I_PTE_G) ? REL32I_MMU_GLOBAL_ASID : mmu->asid;
+	entry->superpage = (uint8_t)level;
+	entry->read_tag = (access != REL32I_ACCESS_EXECUTE && readable) ? page : 1;
+	entry->write_tag = (access != REL32I_ACCESS_EXECUTE && writable && (page_table_entry & REL32I_PTE_D)) ? page : 1;
+	entry->execute_tag = (access == REL32I_ACCESS_EXECUTE) ? page : 1;
+	return (uint32_t)physical_page | (address & (REL32I_MEMORY_PAGE_SIZE - 1));
+}
+
+static uint32_t rel32i_load_virtual_slow(rel32i_mmu_t* mmu, rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, uint32_t size)
+{
+	if ((address & (REL32I_MEMORY_PAGE_SIZE - 1)) > REL32I_MEMORY_PAGE_SIZE - size)
+	{
+		uint32_t value = 0;
+		for (uint32_t i = 0; i != size; ++i)
+			value |= rel32i_load_virtual_slow(mmu, memory, fault_frame, address + i, 1) << (i * 8);
+		return value;
+	}
+	return rel32i_load_memory(memory, fault_frame, rel32i_translate(mmu, memory, fault_frame, address, REL32I_ACCESS_READ), size);
+}
+
+static uintptr_t rel32i_store_virtual_slow(rel32i_mmu_t* mmu, rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, uint32_t size, uint32_t value)
+{
+	if ((address & (REL32I_MEMORY_PAGE_SIZE - 1)) > REL32I_MEMORY_PAGE_SIZE - size)
+	{
+		rel32i_translate(mmu, memory, fault_frame, address, REL32I_ACCESS_WRITE);
+		rel32i_translate(mmu, memory, fault_frame, (address + size - 1) & ~(uint32_t)(REL32I_MEMORY_PAGE_SIZE - 1), REL32I_ACCESS_WRITE);
+		for (uint32_t i = 0; i != size; ++i)
+			rel32i_store_memory(memory, fault_frame, rel32i_translate(mmu, memory, fault_frame, address + i, REL32I_ACCESS_WRITE), 1, value >> (i * 8));
+		return 0;
+	}
+	return rel32i_store_memory(memory, fault_frame, rel32i_translate(mmu, memory, fault_frame, address, REL32I_ACCESS_WRITE), size, value);
+}
+
+static inline uint32_t rel32i_load_virtual(rel32i_mmu_t* mmu, rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, uint32_t size)
+{
+	if (!mmu || !mmu->translating)
+		return rel32i_load_memory(memory, fault_frame, address, size);
+	const rel32i_mmu_tlb_entry_t* entry = mmu->data_tlb + ((address / REL32I_MEMORY_PAGE_SIZE) & (REL32I_MMU_TLB_SIZE - 1));
+	if (entry->read_tag == (address & (~(uint32_t)(REL32I_MEMORY_PAGE_SIZE - 1) | (size - 1))) && (entry->asid == mmu->asid || entry->asid == REL32I_MMU_GLOBAL_ASID))
+	{
+		++mmu->data_tlb_hit_count;
+		return rel32i_load_memory(memory, fault_frame, entry->physical_page | (address & (REL32I_MEMORY_PAGE_SIZE - 1)), size);
+	}
+	return rel32i_load_virtual_slow(mmu, memory, fault_frame, address, size);
+}
+
+static inline uintptr_t rel32i_store_virtual(rel32i_mmu_t* mmu, rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, uint32_t size, uint32_t value)
+{
+	if (!mmu || !mmu->translating)
+		return rel32i_store_memory(memory, fault_frame, address, size, value);
+	const rel32i_mmu_tlb_entry_t* entry = mmu->data_tlb + ((address / REL32I_MEMORY_PAGE_SIZE) & (REL32I_MMU_TLB_SIZE - 1));
+	if (entry->write_tag == (address & (~(uint32_t)(REL32I_MEMORY_PAGE_SIZE - 1) | (size - 1))) && (entry->asid == mmu->asid || entry->asid == REL32I_MMU_GLOBAL_ASID))
+	{
+		++mmu->data_tlb_hit_count;
+		return rel32i_store_memory(memory, fault_frame, entry->physical_page | (address & (REL32I_MEMORY_PAGE_SIZE - 1)), size, value);
+	}
+	return rel32i_store_virtual_slow(mmu, memory, fault_frame, address, size, value);
+}
+
+static inline uint32_t rel32i_translate_fetch(rel32i_mmu_t* mmu, rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t pc)
+{
+	const rel32i_mmu_tlb_entry_t* entry = mmu->instruction_tlb + ((pc / REL32I_MEMORY_PAGE_SIZE) & (REL32I_MMU_TLB_SIZE - 1));
+	if (entry->execute_tag == (pc & (~(uint32_t)(REL32I_MEMORY_PAGE_SIZE - 1) | 1)) && (entry->asid == mmu->asid || entry->asid == REL32I_MMU_GLOBAL_ASID))
+	{
+		++mmu->instruction_tlb_hit_count;
+		return entry->physical_page | (pc & (REL32I_MEMORY_PAGE_SIZE - 1));
+	}
+	return rel32i_translate(mmu, memory, fault_frame, pc, REL32I_ACCESS_EXECUTE);
+}
+
+// a 32-bit instruction in the last halfword of a page continues on the next one, its halves are put together in buffer then
+static const void* rel32i_fetch_instruction(rel32i_mmu_t* mmu, rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, int translating, uint32_t pc, uint8_t* buffer)
+{
+	const uint8_t* first_half = (const uint8_t*)rel32i_fetch_memory(memory, fault_frame, translating ? rel32i_translate_fetch(mmu, memory, fault_frame, pc) : pc);
+	if ((first_half[0] & 3) != 3 || (pc & (REL32I_MEMORY_PAGE_SIZE - 1)) != REL32I_MEMORY_PAGE_SIZE - 2)
+		return first_half;
+	const uint8_t* second_half = (const uint8_t*)rel32i_fetch_memory(memory, fault_frame, translating ? rel32i_translate_fetch(mmu, memory, fault_frame, pc + 2) : pc + 2);
+	buffer[0] = first_half[0];
+	buffer[1] = first_half[1];
+	buffer[2] = second_half[0];
+	buffer[3] = second_half[1];
+	return buffer;
+}
+
+// atomics work on the host word itself, so words on devices or ROM and words that are not aligned fault
+static uint32_t* rel32i_get_atomic_host_address(rel32i_mmu_t* mmu, rel32i_memory_t* memory, rel32i_fault_frame_t* fault_frame, uint32_t address, int access)
+{
+	uint32_t physical_address = (mmu && mmu->translating) ? rel32i_translate(mmu, memory, fault_frame, address, access) : address;
+	if (physical_address & 3)
+		rel32i_raise_memory_fault(memory, fault_frame, physical_address);
+	const rel32i_memory_page_t* page = rel32i_check_memory_page(memory, fault_frame, physical_address, REL32I_ACCESS_READ);
+	if (page->type == REL32I_MEMORY_MMIO || ((access & REL32I_ACCESS_WRITE) && (page->type != REL32I_MEMORY_RAM || !(page->access & REL32I_ACCESS_WRITE))))
+		rel32i_raise_memory_fault(memory, fault_frame, physical_address);
+	return (uint32_t*)(page->host_offset + (uintptr_t)physical_address);
+}
+
+// operand is rs1 or the immediate of the instruction
+static uint32_t rel32i_get_csr_write_value(uint8_t operation, uint32_t value, uint32_t operand)
+{
+	if (operation == REL32I_OPERATION_CSRRW || operation == REL32I_OPERATION_CSRRWI)
+		return operand;
+	return (operation == REL32I_OPERATION_CSRRS || operation == REL32I_OPERATION_CSRRSI) ? (value | operand) : (value & ~operand);
+}
+
+static void rel32i_execute_mmu_operation(rel32i_mmu_t* mmu, const rel32i_predecoded_instruction_t* instruction, uint32_t* x)
+{
+	uint8_t operation = instruction->operation;
+	if (operation == REL32I_OPERATION_SFENCE_VMA)
+	{
+		rel32i_sfence_vma(mmu, x[instruction->rs1], x[instruction->rs2], (instruction->rs1 ? REL32I_SFENCE_VMA_ADDRESS : 0) | (instruction->rs2 ? REL32I_SFENCE_VMA_ASID : 0));
+		return;
+	}
+
+	uint32_t satp = mmu->satp;
+	uint32_t operand = (operation >= REL32I_OPERATION_CSRRWI) ? instruction->rs1 : x[instruction->rs1];
+	if (operation == REL32I_OPERATION_CSRRW || operation == REL32I_OPERATION_CSRRWI || instruction->rs1)
+		rel32i_write_satp(mmu, rel32i_get_csr_write_value(operation, satp, operand));
+	if (instruction->rd)
+		x[instruction->rd] = satp;
+}
+
+static uint64_t rel32i_get_host_time(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return ((uint64_t)counter.QuadPart / (uint64_t)frequency.QuadPart) * 1000000000ull + (((uint64_t)counter.QuadPart % (uint64_t)frequency.QuadPart) * 1000000000ull) / (uint64_t)frequency.QuadPart;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+#endif
+}
+
+void rel32i_initialize_csr_file(rel32i_csr_file_t* csr_file, uint64_t time_frequency)
+{
+	csr_file->cycle = 0;
+	csr_file->instret = 0;
+	csr_file->time_frequency = time_frequency;
+	csr_file->time_origin = rel32i_get_host_time();
+	for (size_t i = 0; i != REL32I_CSR_COUNT; ++i)
+		csr_file->value_table[i] = 0;
+}
+
+static void rel32i_retire_csr_counters(rel32i_csr_file_t* csr_file, uint64_t instruction_count)
+{
+	csr_file->cycle += instruction_count;
+	csr_file->instret += instruction_count;
+}
+
+static uint64_t rel32i_read_time_csr(const rel32i_csr_file_t* csr_file)
+{
+	// whole seconds are scaled separately so that the product does not overflow
+	uint64_t elapsed_time = rel32i_get_host_time() - csr_file->time_origin;
+	return (elapsed_time / 1000000000) * csr_file->time_frequency + ((elapsed_time % 1000000000) * csr_file->time_frequency) / 1000000000;
+}
+
+#define REL32I_FFLAG_INEXACT 0x01
+#define REL32I_FFLAG_UNDERFLOW 0x02
+#define REL32I_FFLAG_OVERFLOW 0x04
+#define REL32I_FFLAG_DIVIDE_BY_ZERO 0x08
+#define REL32I_FFLAG_INVALID 0x10
+#define REL32I_ROUNDING_MODE_RMM 4
+
+#define REL32I_FLOAT_ADD 0
+#define REL32I_FLOAT_SUBTRACT 1
+#define REL32I_FLOAT_MULTIPLY 2
+#define REL32I_FLOAT_DIVIDE 3
+#define REL32I_FLOAT_SQUARE_ROOT 4
+
+// the function3 values of feq, flt and fle
+#define REL32I_FLOAT_LESS_OR_EQUAL 0
+#define REL32I_FLOAT_LESS 1
+#define REL32I_FLOAT_EQUAL 2
+
+#if defined(REL32I_SSE_FLOAT_SUPPORTED)
+static inline void rel32i_enter_host_fp_environment(rel32i_host_fp_environment_t* environment)
+{
+	// all exceptions masked and their flags clear, round to nearest and no flushing of subnormals
+	*environment = _mm_getcsr();
+	_mm_setcsr(0x1F80);
+}
+
+static inline void rel32i_leave_host_fp_environment(const rel32i_host_fp_environment_t* environment)
+{
+	_mm_setcsr(*environment);
+}
+
+static inline void rel32i_set_host_rounding_mode(uint32_t rounding_mode)
+{
+	// RNE, RTZ, RDN, RUP and RMM in MXCSR.RC, RMM rounds to nearest even and the ties away functions correct the result
+	static const uint8_t rounding_control_table[5] = { 0, 3, 1, 2, 0 };
+	_mm_setcsr((_mm_getcsr() & ~0x6000u) | ((uint32_t)rounding_control_table[rounding_mode] << 13));
+}
+
+static inline uint32_t rel32i_take_host_fp_flags(void)
+{
+	// the denormal operand flag has no guest counterpart
+	uint32_t control = _mm_getcsr();
+	_mm_setcsr(control & ~0x3Fu);
+	return ((control & 0x01) << 4) | ((control & 0x04) << 1) | ((control & 0x08) >> 1) | ((control & 0x10) >> 3) | ((control & 0x20) >> 5);
+}
+#else
+static inline void rel32i_enter_host_fp_environment(rel32i_host_fp_environment_t* environment)
+{
+	feholdexcept(environment);
+	fesetround(FE_TONEAREST);
+}
+
+static inline void rel32i_leave_host_fp_environment(const rel32i_host_fp_environment_t* environment)
+{
+	fesetenv(environment);
+}
+
+static inline void rel32i_set_host_rounding_mode(uint32_t rounding_mode)
+{
+	// like MXCSR.RC above RMM rounds to nearest even
+	static const int rounding_direction_table[5] = { FE_TONEAREST, FE_TOWARDZERO, FE_DOWNWARD, FE_UPWARD, FE_TONEAREST };
+	fesetround(rounding_direction_table[rounding_mode]);
+}
+
+static inline uint32_t rel32i_take_host_fp_flags(void)
+{
+	int exceptions = fetestexcept(FE_ALL_EXCEPT);
+	feclearexcept(FE_ALL_EXCEPT);
+	return ((exceptions & FE_INVALID) ? REL32I_FFLAG_INVALID : 0) | ((exceptions & FE_DIVBYZERO) ? REL32I_FFLAG_DIVIDE_BY_ZERO : 0) |
+		((exceptions & FE_OVERFLOW) ? REL32I_FFLAG_OVERFLOW : 0) | ((exceptions & FE_UNDERFLOW) ? REL32I_FFLAG_UNDERFLOW : 0) | ((exceptions & FE_INEXACT) ? REL32I_FFLAG_INEXACT : 0);
+}
+#endif
+
+// only called when the mode changes, so a run of instructions in the same mode never writes the host control register
+static void rel32i_set_fp_rounding_mode(rel32i_fault_frame_t* fault_frame, uint32_t rounding_mode)
+{
+	if (fault_frame->fp_rounding_mode == REL32I_HOST_ROUNDING_MODE)
+		rel32i_enter_host_fp_environment(&fault_frame->host_fp_environment);
+	rel32i_set_host_rounding_mode(rounding_mode);
+	fault_frame->fp_rounding_mode = rounding_mode;
+}
+
+static void rel32i_collect_fp_flags(const rel32i_fault_frame_t* fault_frame, rel32i_register_set_t* register_set)
+{
+	if (fault_frame->fp_rounding_mode != REL32I_HOST_ROUNDING_MODE)
+		register_set->fcsr |= rel32i_take_host_fp_flags();
+}
+
+static void rel32i_leave_fp_state(rel32i_fault_frame_t* fault_frame, rel32i_register_set_t* register_set)
+{
+	if (fault_frame->fp_rounding_mode == REL32I_HOST_ROUNDING_MODE)
+		return;
+	register_set->fcsr |= rel32i_take_host_fp_flags();
+	rel32i_leave_host_fp_environment(&fault_frame->host_fp_environment);
+	fault_frame->fp_rounding_mode = REL32I_HOST_ROUNDING_MODE;
+}
+
+static inline uint32_t rel32i_unbox_single(uint64_t value)
+{
+	// a single-precision value that is not properly NaN-boxed reads as the canonical NaN
+	return ((value >> 32) == 0xFFFFFFFF) ? (uint32_t)value : 0x7FC00000;
+}
+
+static inline uint64_t rel32i_box_single(uint32_t value)
+{
+	return 0xFFFFFFFF00000000ull | value;
+}
+
+// the bit level helpers take single-precision values in the low half and tell the formats apart by is_double
+static inline uint64_t rel32i_float_sign(int is_double)
+{
+	return is_double ? 0x8000000000000000ull : 0x80000000;
+}
+
+static inline uint64_t rel32i_float_infinity(int is_double)
+{
+	return is_double ? 0x7FF0000000000000ull : 0x7F800000;
+}
+
+static inline uint64_t rel32i_float_quiet_bit(int is_double)
+{
+	return is_double ? 0x0008000000000000ull : 0x00400000;
+}
+
+static inline int rel32i_is_nan(uint64_t value, int is_double)
+{
+	return (value & ~rel32i_float_sign(is_double)) > rel32i_float_infinity(is_double);
+}
+
+static inline int rel32i_is_signaling_nan(uint64_t value, int is_double)
+{
+	return rel32i_is_nan(value, is_double) && !(value & rel32i_float_quiet_bit(is_double));
+}
+
+static inline uint64_t rel32i_canonicalize_nan(uint64_t value, int is_double)
+{
+	return rel32i_is_nan(value, is_double) ? (is_double ? 0x7FF8000000000000ull : 0x7FC00000) : value;
+}
+
+// orders values that are not NaN, -0 comes before +0
+static int rel32i_float_less(uint64_t a, uint64_t b, int is_double)
+{
+	uint64_t sign = rel32i_float_sign(is_double);
+	if ((a ^ b) & sign)
+		return (a & sign) != 0;
+	return (a & sign) ? (a > b) : (a < b);
+}
+
+static uint32_t rel32i_compare_float(rel32i_register_set_t* register_set, uint64_t a, uint64_t b, int is_double, int comparison)
+{
+	if (rel32i_is_nan(a, is_double) || rel32i_is_nan(b, is_double))
+	{
+		// feq is a quiet comparison, flt and fle signal on any NaN
+		if (comparison != REL32I_FLOAT_EQUAL || rel32i_is_signaling_nan(a, is_double) || rel32i_is_signaling_nan(b, is_double))
+			register_set->fcsr |= REL32I_FFLAG_INVALID;
+		return 0;
+	}
+	int is_equal = a == b || !((a | b) & ~rel32i_float_sign(is_double));
+	if (comparison == REL32I_FLOAT_EQUAL)
+		return (uint32_t)is_equal;
+	return (uint32_t)((comparison == REL32I_FLOAT_LESS_OR_EQUAL && is_equal) || (!is_equal && rel32i_float_less(a, b, is_double)));
+}
+
+static uint64_t rel32i_select_float(rel32i_register_set_t* register_set, uint64_t a, uint64_t b, int is_double, int select_larger)
+{
+	if (rel32i_is_signaling_nan(a, is_double) || rel32i_is_signaling_nan(b, is_double))
+		register_set->fcsr |= REL32I_FFLAG_INVALID;
+	if (rel32i_is_nan(a, is_double))
+		return rel32i_canonicalize_nan(b, is_double);
+	if (rel32i_is_nan(b, is_double))
+		return a;
+	return (rel32i_float_less(a, b, is_double) != select_larger) ? a : b;
+}
+
+static inline uint64_t rel32i_inject_sign(uint64_t a, uint64_t b, int is_double, uint32_t function3)
+{
+	uint64_t sign = rel32i_float_sign(is_double);
+	uint64_t sign_source = (function3 == 0) ? b : ((function3 == 1) ? ~b : (a ^ b));
+	return (a & ~sign) | (sign_source & sign);
+}
+
+static uint32_t rel32i_classify_float(uint64_t value, int is_double)
+{
+	uint64_t infinity = rel32i_float_infinity(is_double);
+	uint64_t magnitude = value & ~rel32i_float_sign(is_double);
+	int is_negative = (value & rel32i_float_sign(is_double)) != 0;
+	if (magnitude > infinity)
+		return (value & rel32i_float_quiet_bit(is_double)) ? 0x200 : 0x100;
+	if (magnitude == infinity)
+		return is_negative ? 0x001 : 0x080;
+	if (!magnitude)
+		return is_negative ? 0x008 : 0x010;
+	// below the smallest normal number
+	if (magnitude < (is_double ? 0x0010000000000000ull : 0x00800000))
+		return is_negative ? 0x004 : 0x020;
+	return is_negative ? 0x002 : 0x040;
+}
+
+// the arithmetic is done by the host in the rounding mode last selected, NaN results are canonicalized by the callers
+static inline uint32_t rel32i_compute_single(int operation, uint32_t a, uint32_t b)
+{
+#if defined(REL32I_SSE_FLOAT_SUPPORTED)
+	__m128 x = _mm_castsi128_ps(_mm_cvtsi32_si128((int)a));
+	__m128 y = _mm_castsi128_ps(_mm_cvtsi32_si128((int)b));
+	switch (operation)
+	{
+		case REL32I_FLOAT_ADD:
+			x = _mm_add_ss(x, y);
+			break;
+		case REL32I_FLOAT_SUBTRACT:
+			x = _mm_sub_ss(x, y);
+			break;
+		case REL32I_FLOAT_MULTIPLY:
+			x = _mm_mul_ss(x, y);
+			break;
+		case REL32I_FLOAT_DIVIDE:
+			x = _mm_div_ss(x, y);
+			break;
+		default:
+			x = _mm_sqrt_ss(x);
+			break;
+	}
+	return (uint32_t)_mm_cvtsi128_si32(_mm_castps_si128(x));
+#else
+	union { uint32_t bits; float value; } x = { a }, y = { b };
+	switch (operation)
+	{
+		case REL32I_FLOAT_ADD:
+			x.value = x.value + y.value;
+			break;
+		case REL32I_FLOAT_SUBTRACT:
+			x.value = x.value - y.value;
+			break;
+		case REL32I_FLOAT_MULTIPLY:
+			x.value = x.value * y.value;
+			break;
+		case REL32I_FLOAT_DIVIDE:
+			x.value = x.value / y.value;
+			break;
+		default:
+			x.value = sqrtf(x.value);
+			break;
+	}
+	return x.bits;
+#endif
+}
+
+static inline uint64_t rel32i_compute_double(int operation, uint64_t a, uint64_t b)
+{
+#if defined(REL32I_SSE_FLOAT_SUPPORTED)
+	__m128d x = _mm_castsi128_pd(_mm_cvtsi64_si128((long long)a));
+	__m128d y = _mm_castsi128_pd(_mm_cvtsi64_si128((long long)b));
+	switch (operation)
+	{
+		case REL32I_FLOAT_ADD:
+			x = _mm_add_sd(x, y);
+			break;
+		case REL32I_FLOAT_SUBTRACT:
+			x = _mm_sub_sd(x, y);
+			break;
+		case REL32I_FLOAT_MULTIPLY:
+			x = _mm_mul_sd(x, y);
+			break;
+		case REL32I_FLOAT_DIVIDE:
+			x = _mm_div_sd(x, y);
+			break;
+		default:
+			x = _mm_sqrt_sd(x, x);
+			break;
+	}
+	return (uint64_t)_mm_cvtsi128_si64(_mm_castpd_si128(x));
+#else
+	union { uint64_t bits; double value; } x = { a }, y = { b };
+	switch (operation)
+	{
+		case REL32I_FLOAT_ADD:
+			x.value = x.value + y.value;
+			break;
+		case REL32I_FLOAT_SUBTRACT:
+			x.value = x.value - y.value;
+			break;
+		case REL32I_FLOAT_MULTIPLY:
+			x.value = x.value * y.value;
+			break;
+		case REL32I_FLOAT_DIVIDE:
+			x.value = x.value / y.value;
+			break;
+		default:
+			x.value = sqrt(x.value);
+			break;
+	}
+	return x.bits;
+#endif
+}
+
+// fmadd, fmsub, fnmsub and fnmadd negate the product and the addend before one fused rounding
+static uint64_t rel32i_fused_multiply_add(rel32i_register_set_t* register_set, uint64_t a, uint64_t b, uint64_t c, int is_double, int negate_product, int negate_addend)
+{
+	uint64_t sign = rel32i_float_sign(is_double);
+	uint64_t infinity = rel32i_float_infinity(is_double);
+	a ^= negate_product ? sign : 0;
+	c ^= negate_addend ? sign : 0;
+	// infinity times zero is invalid even when the addend is a quiet NaN, which IEEE 754 leaves to the implementation
+	if (rel32i_is_nan(c, is_double) && (((a & ~sign) == infinity && !(b & ~sign)) || (!(a & ~sign) && (b & ~sign) == infinity)))
+		register_set->fcsr |= REL32I_FFLAG_INVALID;
+	if (is_double)
+	{
+		union { uint64_t bits; double value; } x = { a }, y = { b }, z = { c };
+		x.value = fma(x.value, y.value, z.value);
+		return rel32i_canonicalize_nan(x.bits, 1);
+	}
+	union { uint32_t bits; float value; } x = { (uint32_t)a }, y = { (uint32_t)b }, z = { (uint32_t)c };
+	x.value = fmaf(x.value, y.value, z.value);
+	return rel32i_canonicalize_nan(x.bits, 0);
+}
+
+static inline uint64_t rel32i_convert_single_to_double(uint32_t value)
+{
+#if defined(REL32I_SSE_FLOAT_SUPPORTED)
+	return (uint64_t)_mm_cvtsi128_si64(_mm_castpd_si128(_mm_cvtss_sd(_mm_setzero_pd(), _mm_castsi128_ps(_mm_cvtsi32_si128((int)value)))));
+#else
+	union { uint32_t bits; float value; } x = { value };
+	union { double value; uint64_t bits; } y = { (double)x.value };
+	return y.bits;
+#endif
+}
+
+static inline uint32_t rel32i_convert_double_to_single(uint64_t value)
+{
+#if defined(REL32I_SSE_FLOAT_SUPPORTED)
+	return (uint32_t)_mm_cvtsi128_si32(_mm_castps_si128(_mm_cvtsd_ss(_mm_setzero_ps(), _mm_castsi128_pd(_mm_cvtsi64_si128((long long)value)))));
+#else
+	union { uint64_t bits; double value; } x = { value };
+	union { float value; uint32_t bits; } y = { (float)x.value };
+	return y.bits;
+#endif
+}
+
+// every 32-bit integer fits the 64-bit conversions, so one rounding is done for the unsigned ones as well
+static inline uint32_t rel32i_convert_integer_to_single(int64_t value)
+{
+#if defined(REL32I_SSE_FLOAT_SUPPORTED)
+	return (uint32_t)_mm_cvtsi128_si32(_mm_castps_si128(_mm_cvtsi64_ss(_mm_setzero_ps(), value)));
+#else
+	union { float value; uint32_t bits; } x = { (float)value };
+	return x.bits;
+#endif
+}
+
+static inline uint64_t rel32i_convert_integer_to_double(int64_t value)
+{
+#if defined(REL32I_SSE_FLOAT_SUPPORTED)
+	return (uint64_t)_mm_cvtsi128_si64(_mm_castpd_si128(_mm_cvtsi64_sd(_mm_setzero_pd(), value)));
+#else
+	union { double value; uint64_t bits; } x = { (double)value };
+	return x.bits;
+#endif
+}
+
+// An exact value as a signed multiple of a power of two, the significand takes up to two 64-bit words
+typedef struct rel32i_exact_value_t
+{
+	int is_negative;
+	int32_t exponent;
+	uint64_t high;
+	uint64_t low;
+} rel32i_exact_value_t;
+
+static void rel32i_unpack_float(uint64_t value, int is_double, rel32i_exact_value_t* exact_value)
+{
+	uint32_t significand_size = is_double ? 52 : 23;
+	uint32_t exponent = (uint32_t)(value >> significand_size) & (is_double ? 0x7FF : 0xFF);
+	exact_value->is_negative = (value & rel32i_float_sign(is_double)) != 0;
+	exact_value->high = 0;
+	exact_value->low = (value & (((uint64_t)1 << significand_size) - 1)) | ((uint64_t)(exponent != 0) << significand_size);
+	// subnormal numbers and zero have the exponent of the smallest normal numbers
+	exact_value->exponent = (int32_t)(exponent ? exponent : 1) - (is_double ? 1023 : 127) - (int32_t)significand_size;
+}
+
+// only the low words are multiplied, which is all the significands of the operands take
+static void rel32i_multiply_exact_values(const rel32i_exact_value_t* a, const rel32i_exact_value_t* b, rel32i_exact_value_t* product)
+{
+	uint64_t low_low = (a->low & 0xFFFFFFFF) * (b->low & 0xFFFFFFFF);
+	uint64_t low_high = (a->low & 0xFFFFFFFF) * (b->low >> 32);
+	uint64_t high_low = (a->low >> 32) * (b->low & 0xFFFFFFFF);
+	uint64_t high_high = (a->low >> 32) * (b->low >> 32);
+	uint64_t middle = (low_low >> 32) + (low_high & 0xFFFFFFFF) + (high_low & 0xFFFFFFFF);
+	product->is_negative = a->is_negative != b->is_negative;
+	product->exponent = a->exponent + b->exponent;
+	product->high = high_high + (low_high >> 32) + (high_low >> 32) + (middle >> 32);
+	product->low = (middle << 32) | (low_low & 0xFFFFFFFF);
+}
+
+// Tells whether the values add up to exactly zero. Every significand is below 2^108 and at most three values are added.
+static int rel32i_is_exact_sum_zero(rel32i_exact_value_t* value_table, int value_count)
+{
+	// with the trailing zeros shifted out, a value that is alone at the lowest exponent leaves its lowest bit in the sum
+	int32_t lowest_exponent = INT32_MAX;
+	int lowest_count = 0;
+	for (int i = 0; i != value_count; ++i)
+	{
+		rel32i_exact_value_t* value = value_table + i;
+		if (!value->high && !value->low)
+			continue;
+		while (!(value->low & 1))
+		{
+			value->low = (value->low >> 1) | (value->high << 63);
+			value->high >>= 1;
+			value->exponent++;
+		}
+		if (value->exponent < lowest_exponent)
+		{
+			lowest_exponent = value->exponent;
+			lowest_count = 0;
+		}
+		lowest_count += value->exponent == lowest_exponent;
+	}
+	if (lowest_count == 1)
+		return 0;
+
+	// the others are below 2^109 together, so a value that reaches it when lined up with them cannot cancel out
+	uint64_t sum_high = 0;
+	uint64_t sum_low = 0;
+	for (int i = 0; i != value_count; ++i)
+	{
+		rel32i_exact_value_t* value = value_table + i;
+		if (!value->high && !value->low)
+			continue;
+		for (int32_t shift = value->exponent - lowest_exponent; shift; --shift)
+		{
+			if (value->high >> 44)
+				return 0;
+			value->high = (value->high << 1) | (value->low >> 63);
+			value->low <<= 1;
+		}
+		if (value->is_negative)
+		{
+			uint64_t borrow = sum_low < value->low;
+			sum_low -= value->low;
+			sum_high -= value->high + borrow;
+		}
+		else
+		{
+			sum_low += value->low;
+			sum_high += value->high + (sum_low < value->low);
+		}
+	}
+	return !sum_high && !sum_low;
+}
+
+// RMM has the host round to nearest even, which only gives another result when the exact result lies halfway between two values and
+// the host picked the one toward zero. The value table holds the terms of the exact result and one free entry. A quotient is checked
+// as the dividend minus the divisor times the halfway value. The flags of round to nearest even are also those of RMM, the result is
+// inexact both ways, the value away from zero is never an overflow and tininess is the same.
+static uint64_t rel32i_round_ties_away(rel32i_register_set_t* register_set, uint64_t result, int is_double, rel32i_exact_value_t* value_table, int value_count, const rel32i_exact_value_t* divisor)
+{
+	uint32_t flags = rel32i_take_host_fp_flags();
+	register_set->fcsr |= flags;
+	if (!(flags & REL32I_FFLAG_INEXACT) || (result & ~rel32i_float_sign(is_double)) >= rel32i_float_infinity(is_double))
+		return result;
+
+	rel32i_exact_value_t* halfway_value = value_table + value_count;
+	rel32i_unpack_float(result, is_double, halfway_value);
+	halfway_value->is_negative = !halfway_value->is_negative;
+	halfway_value->low = halfway_value->low * 2 + 1;
+	halfway_value->exponent--;
+	if (divisor)
+		rel32i_multiply_exact_values(halfway_value, divisor, halfway_value);
+	return rel32i_is_exact_sum_zero(value_table, value_count + 1) ? result + 1 : result;
+}
+
+// the host flags so far are folded in first, so that the ones taken after the operation are its own
+static uint64_t rel32i_compute_ties_away(rel32i_register_set_t* register_set, int operation, uint64_t a, uint64_t b, int is_double)
+{
+	register_set->fcsr |= rel32i_take_host_fp_flags();
+	uint64_t result = is_double ? rel32i_compute_double(operation, a, b) : rel32i_compute_single(operation, (uint32_t)a, (uint32_t)b);
+	rel32i_exact_value_t value_table[3];
+	rel32i_unpack_float(a, is_double, value_table);
+	rel32i_unpack_float(b, is_double, value_table + 1);
+	switch (operation)
+	{
+		case REL32I_FLOAT_ADD:
+			return rel32i_round_ties_away(register_set, result, is_double, value_table, 2, 0);
+		case REL32I_FLOAT_SUBTRACT:
+			value_table[1].is_negative = !value_table[1].is_negative;
+			return rel32i_round_ties_away(register_set, result, is_double, value_table, 2, 0);
+		case REL32I_FLOAT_MULTIPLY:
+			rel32i_multiply_exact_values(value_table, value_table + 1, value_table);
+			return rel32i_round_ties_away(register_set, result, is_double, value_table, 1, 0);
+		case REL32I_FLOAT_DIVIDE:
+		{
+			// the halfway value takes the entry after the dividend
+			rel32i_exact_value_t divisor = value_table[1];
+			return rel32i_round_ties_away(register_set, result, is_double, value_table, 1, &divisor);
+		}
+		default:
+			// a square root is never halfway between two values
+			return result;
+	}
+}
+
+static uint64_t rel32i_fused_multiply_add_ties_away(rel32i_register_set_t* register_set, uint64_t a, uint64_t b, uint64_t c, int is_double, int negate_product, int negate_addend)
+{
+	register_set->fcsr |= rel32i_take_host_fp_flags();
+	uint64_t result = rel32i_fused_multiply_add(register_set, a, b, c, is_double, negate_product, negate_addend);
+	rel32i_exact_value_t value_table[3];
+	rel32i_unpack_float(a, is_double, value_table);
+	rel32i_unpack_float(b, is_double, value_table + 1);
+	rel32i_multiply_exact_values(value_table, value_table + 1, value_table);
+	value_table[0].is_negative ^= negate_product;
+	rel32i_unpack_float(c, is_double, value_table + 1);
+	value_table[1].is_negative ^= negate_addend;
+	return rel32i_round_ties_away(register_set, result, is_double, value_table, 2, 0);
+}
+
+// fcvt.s.d and fcvt.s.w(u), the other conversions to floating-point are exact
+static uint32_t rel32i_convert_to_single_ties_away(rel32i_register_set_t* register_set, uint64_t value, int is_integer)
+{
+	register_set->fcsr |= rel32i_take_host_fp_flags();
+	rel32i_exact_value_t value_table[2];
+	uint64_t result;
+	if (is_integer)
+	{
+		result = rel32i_convert_integer_to_single((int64_t)value);
+		value_table[0].is_negative = (int64_t)value < 0;
+		value_table[0].exponent = 0;
+		value_table[0].high = 0;
+		value_table[0].low = ((int64_t)value < 0) ? (0 - value) : value;
+	}
+	else
+	{
+		result = rel32i_convert_double_to_single(value);
+		rel32i_unpack_float(value, 1, value_table);
+	}
+	return (uint32_t)rel32i_round_ties_away(register_set, result, 0, value_table, 1, 0);
+}
+
+// Rounds a double-precision value to a 32-bit integer in software, which gives RMM and keeps the host from raising inexact for results that are
+// out of range. Those saturate and only raise invalid, NaN converts to the largest integer.
+static uint32_t rel32i_convert_to_integer(rel32i_register_set_t* register_set, uint64_t value, uint32_t rounding_mode, int is_unsigned)
+{
+	int is_negative = (int)(value >> 63);
+	uint32_t exponent = (uint32_t)(value >> 52) & 0x7FF;
+	uint64_t significand = value & 0x000FFFFFFFFFFFFFull;
+	if (exponent == 0x7FF && significand)
+	{
+		register_set->fcsr |= REL32I_FFLAG_INVALID;
+		return is_unsigned ? 0xFFFFFFFF : 0x7FFFFFFF;
+	}
+	if (exponent)
+		significand |= 0x0010000000000000ull;
+
+	// the value is significand * 2^(exponent - 1075), anything from 2^64 up is out of range anyway
+	uint64_t magnitude;
+	uint64_t remainder = 0;
+	uint64_t half = 1;
+	if (exponent >= 1075)
+		magnitude = (exponent - 1075 <= 11) ? (significand << (exponent - 1075)) : ~(uint64_t)0;
+	else if (1075 - exponent < 64)
+	{
+		uint32_t shift = 1075 - exponent;
+		magnitude = significand >> shift;
+		remainder = significand & (((uint64_t)1 << shift) - 1);
+		half = (uint64_t)1 << (shift - 1);
+	}
+	else
+	{
+		// below a quarter, so only whether it is zero matters
+		magnitude = 0;
+		remainder = significand != 0;
+		half = 2;
+	}
+
+	if (remainder)
+	{
+		switch (rounding_mode)
+		{
+			case 0:
+				magnitude += remainder > half || (remainder == half && (magnitude & 1));
+				break;
+			case 2:
+				magnitude += is_negative;
+				break;
+			case 3:
+				magnitude += !is_negative;
+				break;
+			case REL32I_ROUNDING_MODE_RMM:
+				magnitude += remainder >= half;
+				break;
+			default:
+				break;
+		}
+	}
+
+	uint64_t limit = is_unsigned ? (is_negative ? 0 : 0xFFFFFFFF) : (is_negative ? 0x80000000 : 0x7FFFFFFF);
+	if (magnitude > limit)
+	{
+		register_set->fcsr |= REL32I_FFLAG_INVALID;
+		return (uint32_t)(is_negative ? (is_unsigned ? 0 : 0x80000000) : (is_unsigned ? 0xFFFFFFFF : 0x7FFFFFFF));
+	}
+	if (remainder)
+		register_set->fcsr |= REL32I_FFLAG_INEXACT;
+	return (uint32_t)(is_negative ? (0 - magnitude) : magnitude);
+}
+
+// fflags, frm and fcsr are views of the fcsr in the register set, host flags are folded in first so that reads see them and writes replace them
+static uint32_t rel32i_execute_fcsr_operation(rel32i_hart_t* hart, const rel32i_fault_frame_t* fault_frame, uint8_t operation, uint32_t csr, uint32_t operand, int is_write)
+{
+	rel32i_register_set_t* register_set = hart->register_set;
+	rel32i_collect_fp_flags(fault_frame, register_set);
+	uint32_t shift = (csr == REL32I_CSR_FRM) ? 5 : 0;
+	uint32_t mask = (csr == REL32I_CSR_FFLAGS) ? 0x1F : ((csr == REL32I_CSR_FRM) ? 0x7 : 0xFF);
+	uint32_t value = (register_set->fcsr >> shift) & mask;
+	if (is_write)
+		register_set->fcsr = (register_set->fcsr & ~(mask << shift)) | ((rel32i_get_csr_write_value(operation, value, operand) & mask) << shift);
+	return value;
+}
+
+// Returns nonzero when the instruction writes to a read-only CSR. The counters in the CSR file stay at their value from the start of the run,
+// the instructions retired since then come from the count the engine keeps anyway, so there is no extra work per instruction or block.
+static int rel32i_execute_csr_operation(rel32i_hart_t* hart, const rel32i_fault_frame_t* fault_frame, const rel32i_predecoded_instruction_t* instruction, uint32_t rs1_value, uint32_t* value)
+{
+	uint8_t operation = instruction->operation;
+	uint32_t csr = instruction->intermediate & 0xFFF;
+	uint32_t operand = (operation >= REL32I_OPERATION_CSRRWI) ? instruction->rs1 : rs1_value;
+	int is_write = operation == REL32I_OPERATION_CSRRW || operation == REL32I_OPERATION_CSRRWI || instruction->rs1;
+	if (csr >= REL32I_CSR_FFLAGS && csr <= REL32I_CSR_FCSR)
+	{
+		*value = rel32i_execute_fcsr_operation(hart, fault_frame, operation, csr, operand, is_write);
+		return 0;
+	}
+
+	rel32i_csr_file_t* csr_file = hart->csr_file;
+	if (!csr_file)
+	{
+		*value = 0;
+		return 0;
+	}
+	if (is_write && (csr >> 10) == 3)
+		return 1;
+
+	uint64_t* counter;
+	switch (csr)
+	{
+		case REL32I_CSR_CYCLE:
+		case REL32I_CSR_CYCLEH:
+		case REL32I_CSR_MCYCLE:
+		case REL32I_CSR_MCYCLEH:
+			counter = &csr_file->cycle;
+			break;
+		case REL32I_CSR_INSTRET:
+		case REL32I_CSR_INSTRETH:
+		case REL32I_CSR_MINSTRET:
+		case REL32I_CSR_MINSTRETH:
+			counter = &csr_file->instret;
+			break;
+		case REL32I_CSR_TIME:
+			*value = (uint32_t)rel32i_read_time_csr(csr_file);
+			return 0;
+		case REL32I_CSR_TIMEH:
+			*value = (uint32_t)(rel32i_read_time_csr(csr_file) >> 32);
+			return 0;
+		default:
+			*value = csr_file->value_table[csr];
+			if (is_write)
+				csr_file->value_table[csr] = rel32i_get_csr_write_value(operation, *value, operand);
+			return 0;
+	}
+
+	// the high halves are 0x080 above the low ones
+	uint64_t retired_instruction_count = rel32i_get_checkpoint_instruction_count(fault_frame);
+	uint64_t count = *counter + retired_instruction_count;
+	int is_high = (csr & 0x080) != 0;
+	*value = (uint32_t)(is_high ? (count >> 32) : count);
+	if (is_write)
+	{
+		uint64_t written_value = rel32i_get_csr_write_value(operation, *value, operand);
+		count = is_high ? ((written_value << 32) | (count & 0xFFFFFFFF)) : ((count & 0xFFFFFFFF00000000ull) | written_value);
+		// the writing instruction is counted once it retires, so the next instruction reads back exactly what was written
+		*counter = count - retired_instruction_count - 1;
+	}
+	return 0;
+}
+
+#define REL32I_RS1 (x[instruction->rs1])
+#define REL32I_RS2 (x[instruction->rs2])
+#define REL32I_IMMEDIATE (instruction->intermediate)
+#define REL32I_DATA(address) (REL32I_CHECKPOINT(), (void*)((uintptr_t)data_base_address + (uintptr_t)(uint32_t)(address)))
+#define REL32I_LOAD(type, address) (*(const type*)REL32I_DATA(address))
+#define REL32I_STORE(type, address, value) \
+	do \
+	{ \
+		type* store_address = (type*)REL32I_DATA(address); \
+		*store_address = (type)(value); \
+		if ((uintptr_t)store_address - (uintptr_t)code_base_address < (uintptr_t)watched_code_size) \
+			REL32I_CODE_WRITTEN((uint32_t)((uintptr_t)store_address - (uintptr_t)code_base_address), sizeof(type)); \
+	} while (0)
+
+#define REL32I_ATOMIC_DATA(address, access) ((uint32_t*)REL32I_DATA(address))
+#define REL32I_ATOMIC_WRITTEN(word) \
+	do \
+	{ \
+		if ((uintptr_t)(word) - (uintptr_t)code_base_address < (uintptr_t)watched_code_size) \
+			REL32I_CODE_WRITTEN((uint32_t)((uintptr_t)(word) - (uintptr_t)code_base_address), 4); \
+	} while (0)
+#define REL32I_AMO(fetch) do { uint32_t* word = REL32I_ATOMIC_DATA(REL32I_RS1, REL32I_ACCESS_WRITE); uint32_t old_value = fetch; x[instruction->rd] = old_value; x[0] = 0; REL32I_ATOMIC_WRITTEN(word); REL32I_NEXT(); } while (0)
+// the reservation is kept in the register set, which outlives the temporary harts of the single step functions
+#define REL32I_LOAD_RESERVED() \
+	do \
+	{ \
+		rel32i_register_set_t* reservation = hart->register_set; \
+		uint32_t value = rel32i_atomic_load(REL32I_ATOMIC_DATA(REL32I_RS1, REL32I_ACCESS_READ)); \
+		reservation->reservation_address = REL32I_RS1; \
+		reservation->reservation_value = value; \
+		reservation->reservation_valid = 1; \
+		REL32I_WRITE_RD(value); \
+	} while (0)
+// a failed sc.w does not touch memory, like the JIT translation of it
+// The reservation is checked by comparing the word with the value lr.w loaded, no store is tracked. When another hart stores to
+// the word and it holds the loaded value again (A to B to A) the sc.w succeeds where the specification has it fail. Compare and
+// swap and the other lr/sc loops compilers emit only depend on the value, code that counts on sc.w seeing any store does not work.
+#define REL32I_STORE_CONDITIONAL() \
+	do \
+	{ \
+		rel32i_register_set_t* reservation = hart->register_set; \
+		int is_reserved = reservation->reservation_valid && reservation->reservation_address == REL32I_RS1; \
+		reservation->reservation_valid = 0; \
+		uint32_t* word = is_reserved ? REL32I_ATOMIC_DATA(REL32I_RS1, REL32I_ACCESS_WRITE) : 0; \
+		int is_stored = is_reserved && rel32i_atomic_compare_exchange(word, reservation->reservation_value, REL32I_RS2) == reservation->reservation_value; \
+		x[instruction->rd] = !is_stored; \
+		x[0] = 0; \
+		if (is_stored) \
+			REL32I_ATOMIC_WRITTEN(word); \
+		REL32I_NEXT(); \
+	} while (0)
+
+#define REL32I_CSR() \
+	do \
+	{ \
+		uint32_t csr_value; \
+		REL32I_CHECKPOINT(); \
+		if (rel32i_execute_csr_operation(hart, fault_frame, instruction, REL32I_RS1, &csr_value)) \
+			REL32I_EVENT(REL32I_STOP_ILLEGAL_INSTRUCTION); \
+		REL32I_WRITE_RD(csr_value); \
+	} while (0)
+
+#define REL32I_F (hart->register_set->f0_f31)
+#define REL32I_FS1 rel32i_unbox_single(REL32I_F[instruction->rs1])
+#define REL32I_FS2 rel32i_unbox_single(REL32I_F[instruction->rs2])
+#define REL32I_FS3 rel32i_unbox_single(REL32I_F[REL32I_IMMEDIATE >> 3])
+#define REL32I_FD1 (REL32I_F[instruction->rs1])
+#define REL32I_FD2 (REL32I_F[instruction->rs2])
+#define REL32I_FD3 (REL32I_F[REL32I_IMMEDIATE >> 3])
+#define REL32I_WRITE_FD(value) do { uint64_t fd_value = (value); REL32I_F[instruction->rd] = fd_value; REL32I_NEXT(); } while (0)
+#define REL32I_WRITE_FD_SINGLE(value) REL32I_WRITE_FD(rel32i_box_single(value))
+// rm 7 selects frm, the host only has its rounding mode changed when an instruction asks for a different one than the last
+#define REL32I_ROUNDING_MODE() \
+	do \
+	{ \
+		uint32_t rounding_mode = REL32I_IMMEDIATE & 0x7; \
+		if (rounding_mode == 7) \
+			rounding_mode = (hart->register_set->fcsr >> 5) & 0x7; \
+		if (rounding_mode != fault_frame->fp_rounding_mode) \
+		{ \
+			if (rounding_mode > REL32I_ROUNDING_MODE_RMM) \
+				REL32I_EVENT(REL32I_STOP_ILLEGAL_INSTRUCTION); \
+			rel32i_set_fp_rounding_mode(fault_frame, rounding_mode); \
+		} \
+	} while (0)
+// the host has no RMM, it rounds to nearest even in that mode and the ties away functions correct the result
+#define REL32I_IS_ROUNDING_TIES_AWAY() (fault_frame->fp_rounding_mode == REL32I_ROUNDING_MODE_RMM)
+#define REL32I_FLOAT_SINGLE(operation) \
+	do \
+	{ \
+		REL32I_ROUNDING_MODE(); \
+		uint32_t single_result = REL32I_IS_ROUNDING_TIES_AWAY() ? (uint32_t)rel32i_compute_ties_away(hart->register_set, (operation), REL32I_FS1, REL32I_FS2, 0) : rel32i_compute_single((operation), REL32I_FS1, REL32I_FS2); \
+		REL32I_WRITE_FD_SINGLE((uint32_t)rel32i_canonicalize_nan(single_result, 0)); \
+	} while (0)
+#define REL32I_FLOAT_DOUBLE(operation) \
+	do \
+	{ \
+		REL32I_ROUNDING_MODE(); \
+		uint64_t double_result = REL32I_IS_ROUNDING_TIES_AWAY() ? rel32i_compute_ties_away(hart->register_set, (operation), REL32I_FD1, REL32I_FD2, 1) : rel32i_compute_double((operation), REL32I_FD1, REL32I_FD2); \
+		REL32I_WRITE_FD(rel32i_canonicalize_nan(double_result, 1)); \
+	} while (0)
+#define REL32I_FUSED_SINGLE(negate_product, negate_addend) \
+	do \
+	{ \
+		REL32I_ROUNDING_MODE(); \
+		uint64_t fused_result = (REL32I_IS_ROUNDING_TIES_AWAY() ? rel32i_fused_multiply_add_ties_away : rel32i_fused_multiply_add)(hart->register_set, REL32I_FS1, REL32I_FS2, REL32I_FS3, 0, (negate_product), (negate_addend)); \
+		REL32I_WRITE_FD_SINGLE((uint32_t)fused_result); \
+	} while (0)
+#define REL32I_FUSED_DOUBLE(negate_product, negate_addend) \
+	do \
+	{ \
+		REL32I_ROUNDING_MODE(); \
+		uint64_t fused_result = (REL32I_IS_ROUNDING_TIES_AWAY() ? rel32i_fused_multiply_add_ties_away : rel32i_fused_multiply_add)(hart->register_set, REL32I_FD1, REL32I_FD2, REL32I_FD3, 1, (negate_product), (negate_addend)); \
+		REL32I_WRITE_FD(fused_result); \
+	} while (0)
+// from a double-precision value or a 32-bit integer extended to 64 bits
+#define REL32I_CONVERT_TO_SINGLE(value, is_integer) \
+	do \
+	{ \
+		REL32I_ROUNDING_MODE(); \
+		uint32_t single_result; \
+		if (REL32I_IS_ROUNDING_TIES_AWAY()) \
+			single_result = rel32i_convert_to_single_ties_away(hart->register_set, (value), (is_integer)); \
+		else \
+			single_result = (is_integer) ? rel32i_convert_integer_to_single((int64_t)(value)) : rel32i_convert_double_to_single(value); \
+		REL32I_WRITE_FD_SINGLE((uint32_t)rel32i_canonicalize_nan(single_result, 0)); \
+	} while (0)
+#define REL32I_CONVERT_TO_INTEGER(value, is_unsigned) do { REL32I_ROUNDING_MODE(); REL32I_WRITE_RD(rel32i_convert_to_integer(hart->register_set, (value), fault_frame->fp_rounding_mode, (is_unsigned))); } while (0)
+// the 64-bit values are loaded as two words, which is all the paged memory path takes at once
+// the store is a single access so that an engine leaving on a code write never sees half of it
+#define REL32I_LOAD_DOUBLE() \
+	do \
+	{ \
+		uint32_t load_address = REL32I_RS1 + REL32I_IMMEDIATE; \
+		uint64_t low_word = REL32I_LOAD(uint32_t, load_address); \
+		uint64_t high_word = REL32I_LOAD(uint32_t, load_address + 4); \
+		REL32I_WRITE_FD(low_word | (high_word << 32)); \
+	} while (0)
+#define REL32I_STORE_DOUBLE() \
+	do \
+	{ \
+		REL32I_STORE(uint64_t, REL32I_RS1 + REL32I_IMMEDIATE, REL32I_FD2); \
+		REL32I_NEXT(); \
+	} while (0)
+
+/*
+	Fused pairs created when blocks are translated. REL32I_SKIP moves to the second instruction of the pair, pc must be advanced past the
+	first one before that. The body then ends like the second instruction would.
+*/
+#define REL32I_FUSED_OPERATION_LIST(OPERATION) \
+	OPERATION(REL32I_OPERATION_FUSED_LOAD_IMMEDIATE, FUSED_LOAD_IMMEDIATE, fused_load_immediate, uint32_t value = REL32I_IMMEDIATE + instruction[1].intermediate; pc += instruction->size; REL32I_SKIP(); REL32I_WRITE_RD(value);) \
+	OPERATION(REL32I_OPERATION_FUSED_CALL, FUSED_CALL, fused_call, uint32_t base = pc + REL32I_IMMEDIATE; x[instruction->rd] = base; pc += instruction->size; REL32I_SKIP(); REL32I_JUMP_AND_LINK((base + REL32I_IMMEDIATE) & 0xFFFFFFFE);) \
+	OPERATION(REL32I_OPERATION_FUSED_LOAD_GLOBAL, FUSED_LOAD_GLOBAL, fused_load_global, uint32_t base = pc + REL32I_IMMEDIATE; x[instruction->rd] = base; pc += instruction->size; REL32I_SKIP(); REL32I_WRITE_RD(REL32I_LOAD(uint32_t, base + REL32I_IMMEDIATE));) \
+	OPERATION(REL32I_OPERATION_FUSED_SLT_BRANCH, FUSED_SLT_BRANCH, fused_slt_branch, uint32_t value = (uint32_t)((int32_t)REL32I_RS1 < (int32_t)REL32I_RS2); x[instruction->rd] = value; pc += instruction->size; REL32I_SKIP(); REL32I_BRANCH((instruction->operation == REL32I_OPERATION_BNE) == (value != 0));) \
+	OPERATION(REL32I_OPERATION_FUSED_SLTU_BRANCH, FUSED_SLTU_BRANCH, fused_sltu_branch, uint32_t value = (uint32_t)(REL32I_RS1 < REL32I_RS2); x[instruction->rd] = value; pc += instruction->size; REL32I_SKIP(); REL32I_BRANCH((instruction->operation == REL32I_OPERATION_BNE) == (value != 0));) \
+	OPERATION(REL32I_OPERATION_FUSED_SLTI_BRANCH, FUSED_SLTI_BRANCH, fused_slti_branch, uint32_t value = (uint32_t)((int32_t)REL32I_RS1 < (int32_t)REL32I_IMMEDIATE); x[instruction->rd] = value; pc += instruction->size; REL32I_SKIP(); REL32I_BRANCH((instruction->operation == REL32I_OPERATION_BNE) == (value != 0));) \
+	OPERATION(REL32I_OPERATION_FUSED_SLTIU_BRANCH, FUSED_SLTIU_BRANCH, fused_sltiu_branch, uint32_t value = (uint32_t)(REL32I_RS1 < REL32I_IMMEDIATE); x[instruction->rd] = value; pc += instruction->size; REL32I_SKIP(); REL32I_BRANCH((instruction->operation == REL32I_OPERATION_BNE) == (value != 0));) \
+	OPERATION(REL32I_OPERATION_FUSED_STACK_STORE, FUSED_STACK_STORE, fused_stack_store, x[2] += REL32I_IMMEDIATE; pc += instruction->size; REL32I_SKIP(); REL32I_STORE(uint32_t, REL32I_RS1 + REL32I_IMMEDIATE, REL32I_RS2); REL32I_NEXT();)
+
+// memory is null for the engines that access guest memory directly, which lets the check fold away where they inline this
+static inline int rel32i_execute_operation(rel32i_hart_t* hart, rel32i_fault_frame_t* fault_frame, rel32i_memory_t* memory, uint32_t watched_code_size, const rel32i_predecoded_instruction_t* instruction, uint32_t* x, uint32_t* pc_address)
+{
+	const void* code_base_address = hart->code_base_address;
+	void* data_base_address = hart->data_base_address;
+	rel32i_mmu_t* mmu = memory ? hart->mmu : 0;
+	uint32_t pc = *pc_address;
+
+#pragma push_macro("REL32I_LOAD")
+#pragma push_macro("REL32I_STORE")
+#pragma push_macro("REL32I_ATOMIC_DATA")
+#undef REL32I_LOAD
+#undef REL32I_STORE
+#undef REL32I_ATOMIC_DATA
+#define REL32I_ATOMIC_DATA(address, access) (memory ? (REL32I_CHECKPOINT(), rel32i_get_atomic_host_address(mmu, memory, fault_frame, (uint32_t)(address), (access))) : (uint32_t*)REL32I_DATA(address))
+#define REL32I_LOAD(type, address) (memory ? (REL32I_CHECKPOINT(), (type)rel32i_load_virtual(mmu, memory, fault_frame, (uint32_t)(address), sizeof(type))) : *(const type*)REL32I_DATA(address))
+#define REL32I_STORE(type, address, value) \
+	do \
+	{ \
+		uintptr_t store_address; \
+		if (memory) \
+		{ \
+			REL32I_CHECKPOINT(); \
+			store_address = rel32i_store_virtual(mmu, memory, fault_frame, (uint32_t)(address), sizeof(type) > 4 ? 4 : sizeof(type), (uint32_t)(type)(value)); \
+			if (sizeof(type) > 4) \
+			{ \
+				uintptr_t high_address = rel32i_store_virtual(mmu, memory, fault_frame, (uint32_t)(address) + 4, 4, (uint32_t)((uint64_t)(type)(value) >> 32)); \
+				if (high_address - (uintptr_t)code_base_address < (uintptr_t)watched_code_size) \
+					REL32I_CODE_WRITTEN((uint32_t)(high_address - (uintptr_t)code_base_address), 4); \
+			} \
+		} \
+		else \
+		{ \
+			store_address = (uintptr_t)REL32I_DATA(address); \
+			*(type*)store_address = (type)(value); \
+		} \
+		if (store_address - (uintptr_t)code_base_address < (uintptr_t)watched_code_size) \
+			REL32I_CODE_WRITTEN((uint32_t)(store_address - (uintptr_t)code_base_address), sizeof(type)); \
+	} while (0)
+
+#define REL32I_WRITE_RD(value) do { uint32_t rd_value = (value); x[instruction->rd] = rd_value; x[0] = 0; *pc_address = pc + instruction->size; return 0; } while (0)
+#define REL32I_NEXT() do { *pc_address = pc + instruction->size; return 0; } while (0)
+#define REL32I_BRANCH(condition) do { *pc_address = pc + ((condition) ? REL32I_IMMEDIATE : instruction->size); return 0; } while (0)
+#define REL32I_JUMP_AND_LINK(target) do { uint32_t jump_target = (target); x[instruction->rd] = pc + instruction->size; x[0] = 0; *pc_address = jump_target; return 0; } while (0)
+#define REL32I_EVENT(event) return (event)
+#define REL32I_FENCE_I() do { rel32i_invalidate_all_code(hart); REL32I_NEXT(); } while (0)
+#define REL32I_CODE_WRITTEN(address, size) rel32i_invalidate_code(hart, (address), (size))
+#define REL32I_SKIP() (++instruction)
+#define REL32I_CHECKPOINT() (fault_frame->pc = pc, rel32i_fault_barrier())
+#define REL32I_OPERATION_CASE(index, constant, name, body) case index: { body }
+
+	switch (instruction->operation)
+	{
+		REL32I_OPERATION_LIST(REL32I_OPERATION_CASE)
+		REL32I_FUSED_OPERATION_LIST(REL32I_OPERATION_CASE)
+		case REL32I_OPERATION_UNKNOWN:
+			return REL32I_STOP_ILLEGAL_INSTRUCTION;
+		default:
+			*pc_address = pc + instruction->size;
+			return 0;
+	}
+
+#undef REL32I_OPERATION_CASE
+#undef REL32I_CHECKPOINT
+#undef REL32I_SKIP
+#undef REL32I_CODE_WRITTEN
+#undef REL32I_FENCE_I
+#undef REL32I_EVENT
+#undef REL32I_JUMP_AND_LINK
+#undef REL32I_BRANCH
+#undef REL32I_NEXT
+#undef REL32I_WRITE_RD
+#undef REL32I_ATOMIC_DATA
+#undef REL32I_STORE
+#undef REL32I_LOAD
+#pragma pop_macro("REL32I_ATOMIC_DATA")
+#pragma pop_macro("REL32I_STORE")
+#pragma pop_macro("REL32I_LOAD")
+}
+
+static void rel32i_execute_instruction_on_hart(rel32i_hart_t* hart, const rel32i_predecoded_instruction_t* instruction)
+{
+	rel32i_register_set_t* register_set = hart->register_set;
+	uint32_t x[32];
+	x[0] = 0;
+	rel32_copy(x + 1, register_set->x1_x31, 31 * sizeof(uint32_t));
+
+	// ecall, ebreak and unknown instructions are stepped over like before
+	rel32i_fault_frame_t fault_frame;
+	fault_frame.fp_rounding_mode = REL32I_HOST_ROUNDING_MODE;
+	if (rel32i_execute_operation(hart, &fault_frame, 0, rel32i_get_watched_code_size(hart), instruction, x, &register_set->pc))
+		register_set->pc += instruction->size;
+	rel32i_leave_fp_state(&fault_frame, register_set);
+
+	rel32_copy(register_set->x1_x31, x + 1, 31 * sizeof(uint32_t));
+}
+
+void rel32i_execute_instruction(const rel32i_predecoded_instruction_t* instruction, void* data_base_address, rel32i_register_set_t* register_set)
+{
+	rel32i_hart_t hart = { 0, data_base_address, register_set, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+	rel32i_execute_instruction_on_hart(&hart, instruction);
+}
+
+void rel32i_step_instruction(const void* code_base_address, void* data_base_address, rel32i_register_set_t* register_set)
+{
+	rel32i_predecoded_instruction_t instruction;
+	rel32i_predecode_instruction((const void*)((uintptr_t)code_base_address + (uintptr_t)register_set->pc), &instruction);
+	rel32i_execute_instruction(&instruction, data_base_address, register_set);
+}
+
+void rel32i_step_predecoded_instruction(const void* code_base_address, void* data_base_address, rel32i_predecode_cache_t* predecode_cache, rel32i_register_set_t* register_set)
+{
+	rel32i_hart_t hart = { code_base_address, data_base_address, register_set, predecode_cache, 0, 0, 0, 0, 0, 0, 0, 0 };
+	uint32_t pc = register_set->pc;
+	if (!(pc & 1) && pc < (predecode_cache->code_size & ~3))
+	{
+		rel32i_predecoded_instruction_t* instruction = predecode_cache->instruction_table + (pc >> 1);
+		if (instruction->operation == REL32I_OPERATION_UNDECODED)
+			rel32i_predecode_instruction((const void*)((uintptr_t)code_base_address + (uintptr_t)pc), instruction);
+		rel32i_execute_instruction_on_hart(&hart, instruction);
+	}
+	else
+	{
+		rel32i_predecoded_instruction_t instruction;
+		rel32i_predecode_instruction((const void*)((uintptr_t)code_base_address + (uintptr_t)pc), &instruction);
+		rel32i_execute_instruction_on_hart(&hart, &instruction);
+	}
+}
+
+static int rel32i_is_breakpoint(size_t breakpoint_count, const uint32_t* breakpoint_table, uint32_t pc)
+{
+	for (size_t i = 0; i != breakpoint_count; ++i)
+		if (breakpoint_table[i] == pc)
+			return 1;
+	return 0;
+}
+
+static inline const rel32i_predecoded_instruction_t* rel32i_fetch(const void* code_base_address, rel32i_predecoded_instruction_t* predecoded_instruction_table, uint32_t predecoded_code_size, uint32_t pc, rel32i_predecoded_instruction_t* uncached_instruction, rel32i_fault_frame_t* fault_frame, uint64_t instruction_count)
+{
+	if (!(pc & 1) && pc < predecoded_code_size)
+		return predecoded_instruction_table + (pc >> 1);
+	fault_frame->pc = pc;
+	fault_frame->instruction_count = instruction_count;
+	rel32i_fault_barrier();
+	rel32i_predecode_instruction((const void*)((uintptr_t)code_base_address + (uintptr_t)pc), uncached_instruction);
+	return uncached_instruction;
+}
+
+#define REL32I_INTERPRETER_CORE_SWITCH 0
+#define REL32I_INTERPRETER_CORE_COMPUTED_GOTO 1
+#define REL32I_INTERPRETER_CORE_TAIL_CALL 2
+
+#if !defined(REL32I_MUSTTAIL) && defined(__has_attribute)
+#if __has_attribute(musttail)
+#define REL32I_MUSTTAIL __attribute__((musttail))
+#endif
+#endif
+
+#ifndef REL32I_INTERPRETER_CORE
+#if defined(__GNUC__)
+#define REL32I_INTERPRETER_CORE REL32I_INTERPRETER_CORE_COMPUTED_GOTO
+#else
+#define REL32I_INTERPRETER_CORE REL32I_INTERPRETER_CORE_SWITCH
+#endif
+#endif
+
+#if REL32I_INTERPRETER_CORE == REL32I_INTERPRETER_CORE_TAIL_CALL && !defined(REL32I_MUSTTAIL)
+#error "The tail call interpreter core requires a compiler that supports the musttail attribute"
+#endif
+
+#if REL32I_INTERPRETER_CORE == REL32I_INTERPRETER_CORE_SWITCH
+static int rel32i_run_core(rel32i_hart_t* hart, rel32i_fault_frame_t* fault_frame, uint64_t max_instruction_count, int stop_mask, uint64_t* retired_instruction_count)
+{
+	const void* code_base_address = hart->code_base_address;
+	rel32i_predecoded_instruction_t* predecoded_instruction_table = hart->predecode_cache ? hart->predecode_cache->instruction_table : 0;
+	uint32_t predecoded_code_size = hart->predecode_cache ? (hart->predecode_cache->code_size & ~3) : 0;
+	uint32_t watched_code_size = rel32i_get_watched_code_size(hart);
+	size_t breakpoint_count = (stop_mask & REL32I_STOP_BREAKPOINT) ? hart->breakpoint_count : 0;
+	const uint32_t* breakpoint_table = hart->breakpoint_table;
+	uint64_t instruction_count = 0;
+	int stop_reason = REL32I_STOP_INSTRUCTION_LIMIT;
+	rel32i_predecoded_instruction_t uncached_instruction;
+
+	uint32_t pc = hart->register_set->pc;
+	uint32_t x[32];
+	x[0] = 0;
+	rel32_copy(x + 1, hart->register_set->x1_x31, 31 * sizeof(uint32_t));
+	fault_frame->x = x;
+	fault_frame->block = 0;
+
+	while (instruction_count != max_instruction_count)
+	{
+		// the instruction the run starts from is never a breakpoint, so that a run can resume from one
+		if (breakpoint_count && instruction_count && rel32i_is_breakpoint(breakpoint_count, breakpoint_table, pc))
+		{
+			stop_reason = REL32I_STOP_BREAKPOINT;
+			break;
+		}
+
+		const rel32i_predecoded_instruction_t* instruction = rel32i_fetch(code_base_address, predecoded_instruction_table, predecoded_code_size, pc, &uncached_instruction, fault_frame, instruction_count);
+		if (instruction->operation == REL32I_OPERATION_UNDECODED)
+			rel32i_predecode_instruction((const void*)((uintptr_t)code_base_address + (uintptr_t)pc), (rel32i_predecoded_instruction_t*)instruction);
+
+		fault_frame->instruction_count = instruction_count;
+		int event = rel32i_execute_operation(hart, fault_frame, 0, watched_code_size, instruction, x, &pc);
+		if (event)
+		{
+			if (event & stop_mask)
+			{
+				stop_reason = event;
+				break;
+			}
+			pc += instruction->size;
+		}
+		++instruction_count;
+	}
+
+	hart->register_set->pc = pc;
+	rel32_copy(hart->register_set->x1_x31, x + 1, 31 * sizeof(uint32_t));
+	*retired_instruction_count = instruction_count;
+	return stop_reason;
+}
+#elif REL32I_INTERPRETER_CORE == REL32I_INTERPRETER_CORE_COMPUTED_GOTO
+static int rel32i_run_core(rel32i_hart_t* hart, rel32i_fault_frame_t* fault_frame, uint64_t max_instruction_count, int stop_mask, uint64_t* retired_instruction_count)
+{
+	// the upper half sends compressed instructions to a second copy of the handlers that advances pc by a constant 2,
+	// so the next pc never waits for the size to be loaded and the indirect branch prediction carries the size instead
+#define REL32I_OPERATION_LABEL(index, constant, name, body) [index] = &&operation_##name,
+#define REL32I_COMPRESSED_OPERATION_LABEL(index, constant, name, body) [256 + (index)] = &&compressed_operation_##name,
+#define REL32I_GET_OPERATION_LABEL(instruction) operation_label_table[(instruction)->operation | (((instruction)->size & 2) << 7)]
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+	static const void* const operation_label_table[512] = {
+		[0 ... 255] = &&operation_default,
+		REL32I_OPERATION_LIST(REL32I_OPERATION_LABEL)
+		[REL32I_OPERATION_UNKNOWN] = &&operation_unknown,
+		[REL32I_OPERATION_UNDECODED] = &&operation_undecoded,
+		[256 ... 511] = &&compressed_operation_default,
+		REL32I_OPERATION_LIST(REL32I_COMPRESSED_OPERATION_LABEL)
+		[256 + REL32I_OPERATION_UNKNOWN] = &&compressed_operation_unknown,
+		[256 + REL32I_OPERATION_UNDECODED] = &&operation_undecoded };
+#pragma GCC diagnostic pop
+#undef REL32I_COMPRESSED_OPERATION_LABEL
+#undef REL32I_OPERATION_LABEL
+
+	const void* code_base_address = hart->code_base_address;
+	void* data_base_address = hart->data_base_address;
+	rel32i_predecoded_instruction_t* predecoded_instruction_table = hart->predecode_cache ? hart->predecode_cache->instruction_table : 0;
+	uint32_t predecoded_code_size = hart->predecode_cache ? (hart->predecode_cache->code_size & ~3) : 0;
+	uint32_t watched_code_size = rel32i_get_watched_code_size(hart);
+	size_t breakpoint_count = (stop_mask & REL32I_STOP_BREAKPOINT) ? hart->breakpoint_count : 0;
+	const uint32_t* breakpoint_table = hart->breakpoint_table;
+	uint64_t instruction_count = 0;
+	int stop_reason = REL32I_STOP_INSTRUCTION_LIMIT;
+	rel32i_predecoded_instruction_t uncached_instruction;
+	const rel32i_predecoded_instruction_t* instruction;
+
+	uint32_t pc = hart->register_set->pc;
+	uint32_t x[32];
+	x[0] = 0;
+	rel32_copy(x + 1, hart->register_set->x1_x31, 31 * sizeof(uint32_t));
+	fault_frame->x = x;
+	fault_frame->block = 0;
+
+	// every handler ends in its own copy of the dispatch code, which gives each one a separate indirect branch to predict
+#define REL32I_DISPATCH() \
+	do \
+	{ \
+		if (++instruction_count == max_instruction_count) \
+			goto stop; \
+		if (breakpoint_count && rel32i_is_breakpoint(breakpoint_count, breakpoint_table, pc)) \
+		{ \
+			stop_reason = REL32I_STOP_BREAKPOINT; \
+			goto stop; \
+		} \
+		instruction = rel32i_fetch(code_base_address, predecoded_instruction_table, predecoded_code_size, pc, &uncached_instruction, fault_frame, instruction_count); \
+		goto *REL32I_GET_OPERATION_LABEL(instruction); \
+	} while (0)
+#define REL32I_WRITE_RD(value) do { uint32_t rd_value = (value); x[instruction->rd] = rd_value; x[0] = 0; pc += REL32I_INSTRUCTION_SIZE; REL32I_DISPATCH(); } while (0)
+#define REL32I_NEXT() do { pc += REL32I_INSTRUCTION_SIZE; REL32I_DISPATCH(); } while (0)
+#define REL32I_BRANCH(condition) do { pc += (condition) ? REL32I_IMMEDIATE : REL32I_INSTRUCTION_SIZE; REL32I_DISPATCH(); } while (0)
+#define REL32I_JUMP_AND_LINK(target) do { uint32_t jump_target = (target); x[instruction->rd] = pc + REL32I_INSTRUCTION_SIZE; x[0] = 0; pc = jump_target; REL32I_DISPATCH(); } while (0)
+#define REL32I_EVENT(event) do { if ((event) & stop_mask) { stop_reason = (event); goto stop; } pc += REL32I_INSTRUCTION_SIZE; REL32I_DISPATCH(); } while (0)
+#define REL32I_FENCE_I() do { rel32i_invalidate_all_code(hart); REL32I_NEXT(); } while (0)
+#define REL32I_CODE_WRITTEN(address, size) rel32i_invalidate_code(hart, (address), (size))
+#define REL32I_CHECKPOINT() (fault_frame->pc = pc, fault_frame->instruction_count = instruction_count, rel32i_fault_barrier())
+#define REL32I_OPERATION_HANDLER(index, constant, name, body) operation_##name: { body }
+
+	if (!max_instruction_count)
+		goto stop;
+	instruction = rel32i_fetch(code_base_address, predecoded_instruction_table, predecoded_code_size, pc, &uncached_instruction, fault_frame, instruction_count);
+	goto *REL32I_GET_OPERATION_LABEL(instruction);
+
+#define REL32I_INSTRUCTION_SIZE 4
+	REL32I_OPERATION_LIST(REL32I_OPERATION_HANDLER)
+operation_default:
+	REL32I_NEXT();
+operation_unknown:
+	REL32I_EVENT(REL32I_STOP_ILLEGAL_INSTRUCTION);
+#undef REL32I_INSTRUCTION_SIZE
+#undef REL32I_OPERATION_HANDLER
+
+#define REL32I_INSTRUCTION_SIZE 2
+#define REL32I_OPERATION_HANDLER(index, constant, name, body) compressed_operation_##name: { body }
+	REL32I_OPERATION_LIST(REL32I_OPERATION_HANDLER)
+compressed_operation_default:
+	REL32I_NEXT();
+compressed_operation_unknown:
+	REL32I_EVENT(REL32I_STOP_ILLEGAL_INSTRUCTION);
+#undef REL32I_INSTRUCTION_SIZE
+
+operation_undecoded:
+	rel32i_predecode_instruction((const void*)((uintptr_t)code_base_address + (uintptr_t)pc), (rel32i_predecoded_instruction_t*)instruction);
+	goto *REL32I_GET_OPERATION_LABEL(instruction);
+
+#undef REL32I_OPERATION_HANDLER
+#undef REL32I_GET_OPERATION_LABEL
+#undef REL32I_CHECKPOINT
+#undef REL32I_CODE_WRITTEN
+#undef REL32I_FENCE_I
+#undef REL32I_EVENT
+#undef REL32I_JUMP_AND_LINK
+#undef REL32I_BRANCH
+#undef REL32I_NEXT
+#undef REL32I_WRITE_RD
+#undef REL32I_DISPATCH
+
+stop:
+	hart->register_set->pc = pc;
+	rel32_copy(hart->register_set->x1_x31, x + 1, 31 * sizeof(uint32_t));
+	*retired_instruction_count = instruction_count;
+	return stop_reason;
+}
+#elif REL32I_INTERPRETER_CORE == REL32I_INTERPRETER_CORE_TAIL_CALL
+typedef struct rel32i_tail_call_state_t
+{
+	uint32_t x[32];
+	rel32i_hart_t* hart;
+	uint32_t watched_code_size;
+	const void* code_base_address;
+	void* data_base_address;
+	rel32i_predecoded_instruction_t* predecoded_instruction_table;
+	uint32_t predecoded_code_size;
+	int stop_mask;
+	uint64_t max_instruction_count;
+	size_t breakpoint_count;
+	const uint32_t* breakpoint_table;
+	rel32i_predecoded_instruction_t uncached_instruction;
+	uint32_t pc;
+	uint64_t instruction_count;
+	rel32i_fault_frame_t* fault_frame;
+} rel32i_tail_call_state_t;
+
+typedef int (*rel32i_tail_call_handler_t)(rel32i_tail_call_state_t* state, const rel32i_predecoded_instruction_t* instruction, uint32_t pc, uint64_t instruction_count);
+
+static const rel32i_tail_call_handler_t rel32i_tail_call_handler_table[256];
+
+static int rel32i_tail_call_stop(rel32i_tail_call_state_t* state, uint32_t pc, uint64_t instruction_count, int stop_reason)
+{
+	state->pc = pc;
+	state->instruction_count = instruction_count;
+	return stop_reason;
+}
+
+#define REL32I_DISPATCH() \
+	do \
+	{ \
+		if (++instruction_count == state->max_instruction_count) \
+			return rel32i_tail_call_stop(state, pc, instruction_count, REL32I_STOP_INSTRUCTION_LIMIT); \
+		if (state->breakpoint_count && rel32i_is_breakpoint(state->breakpoint_count, state->breakpoint_table, pc)) \
+			return rel32i_tail_call_stop(state, pc, instruction_count, REL32I_STOP_BREAKPOINT); \
+		instruction = rel32i_fetch(state->code_base_address, state->predecoded_instruction_table, state->predecoded_code_size, pc, &state->uncached_instruction, state->fault_frame, instruction_count); \
+		REL32I_MUSTTAIL return rel32i_tail_call_handler_table[instruction->operation](state, instruction, pc, instruction_count); \
+	} while (0)
+#define REL32I_WRITE_RD(value) do { uint32_t rd_value = (value); x[instruction->rd] = rd_value; x[0] = 0; pc += instruction->size; REL32I_DISPATCH(); } while (0)
+#define REL32I_NEXT() do { pc += instruction->size; REL32I_DISPATCH(); } while (0)
+#define REL32I_BRANCH(condition) do { pc += (condition) ? REL32I_IMMEDIATE : instruction->size; REL32I_DISPATCH(); } while (0)
+#define REL32I_JUMP_AND_LINK(target) do { uint32_t jump_target = (target); x[instruction->rd] = pc + instruction->size; x[0] = 0; pc = jump_target; REL32I_DISPATCH(); } while (0)
+#define REL32I_EVENT(event) do { if ((event) & state->stop_mask) return rel32i_tail_call_stop(state, pc, instruction_count, (event)); pc += instruction->size; REL32I_DISPATCH(); } while (0)
+#define REL32I_FENCE_I() do { rel32i_invalidate_all_code(state->hart); REL32I_NEXT(); } while (0)
+#define REL32I_CODE_WRITTEN(address, size) rel32i_invalidate_code(state->hart, (address), (size))
+#define REL32I_CHECKPOINT() (state->fault_frame->pc = pc, state->fault_frame->instruction_count = instruction_count, rel32i_fault_barrier())
+#define REL32I_TAIL_CALL_HANDLER(index, constant, name, body) \
+	static int rel32i_tail_call_##name(rel32i_tail_call_state_t* state, const rel32i_predecoded_instruction_t* instruction, uint32_t pc, uint64_t instruction_count) \
+	{ \
+		uint32_t* x = state->x; \
+		const void* code_base_address = state->code_base_address; \
+		void* data_base_address = state->data_base_address; \
+		uint32_t watched_code_size = state->watched_code_size; \
+		rel32i_hart_t* hart = state->hart; \
+		rel32i_fault_frame_t* fault_frame = state->fault_frame; \
+		(void)x; \
+		(void)code_base_address; \
+		(void)data_base_address; \
+		(void)watched_code_size; \
+		(void)hart; \
+		(void)fault_frame; \
+		body \
+	}
+
+REL32I_OPERATION_LIST(REL32I_TAIL_CALL_HANDLER)
+REL32I_TAIL_CALL_HANDLER(REL32I_OPERATION_UNKNOWN, UNKNOWN, unknown, REL32I_EVENT(REL32I_STOP_ILLEGAL_INSTRUCTION);)
+REL32I_TAIL_CALL_HANDLER(0, DEFAULT, default, REL32I_NEXT();)
+
+static int rel32i_tail_call_undecoded(rel32i_tail_call_state_t* state, const rel32i_predecoded_instruction_t* instruction, uint32_t pc, uint64_t instruction_count)
+{
+	rel32i_predecode_instruction((const void*)((uintptr_t)state->code_base_address + (uintptr_t)pc), (rel32i_predecoded_instruction_t*)instruction);
+	REL32I_MUSTTAIL return rel32i_tail_call_handler_table[instruction->operation](state, instruction, pc, instruction_count);
+}
+
+#undef REL32I_TAIL_CALL_HANDLER
+#undef REL32I_CHECKPOINT
+#undef REL32I_CODE_WRITTEN
+#undef REL32I_FENCE_I
+#undef REL32I_EVENT
+#undef REL32I_JUMP_AND_LINK
+#undef REL32I_BRANCH
+#undef REL32I_NEXT
+#undef REL32I_WRITE_RD
+#undef REL32I_DISPATCH
+
+#define REL32I_TAIL_CALL_HANDLER_ENTRY(index, constant, name, body) [index] = rel32i_tail_call_##name,
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+static const rel32i_tail_call_handler_t rel32i_tail_call_handler_table[256] = {
+	[0 ... 255] = rel32i_tail_call_default,
+	REL32I_OPERATION_LIST(REL32I_TAIL_CALL_HANDLER_ENTRY)
+	[REL32I_OPERATION_UNKNOWN] = rel32i_tail_call_unknown,
+	[REL32I_OPERATION_UNDECODED] = rel32i_tail_call_undecoded };
+#pragma GCC diagnostic pop
+#undef REL32I_TAIL_CALL_HANDLER_ENTRY
+
+static int rel32i_run_core(rel32i_hart_t* hart, rel32i_fault_frame_t* fault_frame, uint64_t max_instruction_count, int stop_mask, uint64_t* retired_instruction_count)
+{
+	rel32i_tail_call_state_t state;
+	state.x[0] = 0;
+	rel32_copy(state.x + 1, hart->register_set->x1_x31, 31 * sizeof(uint32_t));
+	state.hart = hart;
+	state.watched_code_size = rel32i_get_watched_code_size(hart);
+	state.code_base_address = hart->code_base_address;
+	state.data_base_address = hart->data_base_address;
+	state.predecoded_instruction_table = hart->predecode_cache ? hart->predecode_cache->instruction_table : 0;
+	state.predecoded_code_size = hart->predecode_cache ? (hart->predecode_cache->code_size & ~3) : 0;
+	state.stop_mask = stop_mask;
+	state.max_instruction_count = max_instruction_count;
+	state.breakpoint_count = (stop_mask & REL32I_STOP_BREAKPOINT) ? hart->breakpoint_count : 0;
+	state.breakpoint_table = hart->breakpoint_table;
+	state.pc = hart->register_set->pc;
+	state.instruction_count = 0;
+	state.fault_frame = fault_frame;
+	fault_frame->x = state.x;
+	fault_frame->block = 0;
+
+	int stop_reason = REL32I_STOP_INSTRUCTION_LIMIT;
+	if (max_instruction_count)
+	{
+		const rel32i_predecoded_instruction_t* instruction = rel32i_fetch(state.code_base_address, state.predecoded_instruction_table, state.predecoded_code_size, state.pc, &state.uncached_instruction, fault_frame, 0);
+		stop_reason = rel32i_tail_call_handler_table[instruction->operation](&state, instruction, state.pc, 0);
+	}
+
+	hart->register_set->pc = state.pc;
+	rel32_copy(hart->register_set->x1_x31, state.x + 1, 31 * sizeof(uint32_t));
+	*retired_instruction_count = state.instruction_count;
+	return stop_reason;
+}
+#endif
+
+static int rel32i_run_paged(rel32i_hart_t* hart, rel32i_fault_frame_t* fault_frame, uint64_t max_instruction_count, int stop_mask, uint64_t* retired_instruction_count)
+{
+	rel32i_memory_t* memory = hart->memory;
+	rel32i_mmu_t* mmu = hart->mmu;
+	rel32i_predecoded_instruction_t* predecoded_instruction_table = hart->predecode_cache ? hart->predecode_cache->instruction_table : 0;
+	uint32_t predecoded_code_size = hart->predecode_cache ? (hart->predecode_cache->code_size & ~3) : 0;
+	uint32_t watched_code_size = rel32i_get_watched_code_size(hart);
+	size_t breakpoint_count = (stop_mask & REL32I_STOP_BREAKPOINT) ? hart->breakpoint_count : 0;
+	const uint32_t* breakpoint_table = hart->breakpoint_table;
+	uint64_t instruction_count = 0;
+	int stop_reason = REL32I_STOP_INSTRUCTION_LIMIT;
+	rel32i_predecoded_instruction_t uncached_instruction;
+
+	uint32_t pc = hart->register_set->pc;
+	uint32_t x[32];
+	x[0] = 0;
+	rel32_copy(x + 1, hart->register_set->x1_x31, 31 * sizeof(uint32_t));
+	fault_frame->x = x;
+	fault_frame->block = 0;
+
+	while (instruction_count != max_instruction_count)
+	{
+		if (breakpoint_count && instruction_count && rel32i_is_breakpoint(breakpoint_count, breakpoint_table, pc))
 		{
-			rd = rs1 >> (info.intermediate & 0x1F);
-			set_rd = 1;
-			register_set->pc += 4;
+			stop_reason = REL32I_STOP_BREAKPOINT;
 			break;
 		}
-		case 26:/*srai*/
+
+		fault_frame->pc = pc;
+		fault_frame->instruction_count = instruction_count;
+		const rel32i_predecoded_instruction_t* instruction;
+		int translating = mmu && mmu->translating;
+		if (!(pc & 1) && pc < predecoded_code_size && !translating)
+		{
+			instruction = predecoded_instruction_table + (pc >> 1);
+			if (instruction->operation == REL32I_OPERATION_UNDECODED)
+				rel32i_predecode_instruction((const void*)((uintptr_t)hart->code_base_address + (uintptr_t)pc), (rel32i_predecoded_instruction_t*)instruction);
+		}
+		else
+		{
+			uint8_t instruction_buffer[4];
+			rel32i_predecode_instruction(rel32i_fetch_instruction(mmu, memory, fault_frame, translating, pc, instruction_buffer), &uncached_instruction);
+			instruction = &uncached_instruction;
+		}
+
+		// satp and sfence.vma only mean something with an MMU, everywhere else they run as no-ops like the other CSR instructions
+		if (mmu && (instruction->operation == REL32I_OPERATION_SFENCE_VMA ||
+			(instruction->operation >= REL32I_OPERATION_CSRRW && instruction->operation <= REL32I_OPERATION_CSRRCI && (instruction->intermediate & 0xFFF) == REL32I_CSR_SATP)))
+		{
+			rel32i_execute_mmu_operation(mmu, instruction, x);
+			pc += instruction->size;
+			++instruction_count;
+			continue;
+		}
+
+		int event = rel32i_execute_operation(hart, fault_frame, memory, watched_code_size, instruction, x, &pc);
+		if (event)
+		{
+			if (event & stop_mask)
+			{
+				stop_reason = event;
+				break;
+			}
+			pc += instruction->size;
+		}
+		++instruction_count;
+	}
+
+	hart->register_set->pc = pc;
+	rel32_copy(hart->register_set->x1_x31, x + 1, 31 * sizeof(uint32_t));
+	*retired_instruction_count = instruction_count;
+	return stop_reason;
+}
+
+static inline rel32i_block_t* rel32i_get_next_block(rel32i_block_cache_t* block_cache, const void* code_base_address, rel32i_block_t* block, uint32_t pc)
+{
+	if (block->successor_table[0] && block->successor_table[0]->address == pc)
+		return block->successor_table[0];
+	if (block->successor_table[1] && block->successor_table[1]->address == pc)
+		return block->successor_table[1];
+
+	uint64_t flush_count = block_cache->flush_count;
+	rel32i_block_t* next_block = rel32i_get_block(block_cache, code_base_address, pc);
+	if (next_block && block_cache->flush_count == flush_count)
+		block->successor_table[block->successor_table[0] ? 1 : 0] = next_block;
+	return next_block;
+}
+
+#if defined(__GNUC__)
+static int rel32i_run_blocks(rel32i_hart_t* hart, rel32i_fault_frame_t* fault_frame, uint64_t max_instruction_count, int stop_mask, uint64_t* retired_instruction_count)
+{
+#define REL32I_OPERATION_LABEL(index, constant, name, body) [index] = &&operation_##name,
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+	static const void* const operation_label_table[256] = {
+		[0 ... 255] = &&operation_default,
+		REL32I_OPERATION_LIST(REL32I_OPERATION_LABEL)
+		REL32I_FUSED_OPERATION_LIST(REL32I_OPERATION_LABEL)
+		[REL32I_OPERATION_BLOCK_END] = &&operation_block_end,
+		[REL32I_OPERATION_UNKNOWN] = &&operation_unknown };
+#pragma GCC diagnostic pop
+#undef REL32I_OPERATION_LABEL
+
+	rel32i_block_cache_t* block_cache = hart->block_cache;
+	const void* code_base_address = hart->code_base_address;
+	void* data_base_address = hart->data_base_address;
+	uint32_t watched_code_size = rel32i_get_watched_code_size(hart);
+	uint64_t instruction_count = 0;
+	int stop_reason = REL32I_STOP_INSTRUCTION_LIMIT;
+	const rel32i_predecoded_instruction_t* instruction;
+
+	uint32_t pc = hart->register_set->pc;
+	uint32_t x[32];
+	x[0] = 0;
+	rel32_copy(x + 1, hart->register_set->x1_x31, 31 * sizeof(uint32_t));
+	fault_frame->x = x;
+
+	rel32i_block_t* block = rel32i_get_block(block_cache, code_base_address, pc);
+	if (!block || block->instruction_count > max_instruction_count)
+		goto stop;
+	fault_frame->block = block;
+	fault_frame->instruction_count = instruction_count;
+	instruction = block->instruction_table;
+	goto *operation_label_table[instruction->operation];
+
+	// inside a block instructions are dispatched without any checks, the instruction count is updated at the end of the block
+	// blocks are straight-line code, so when leaving early the number of retired instructions follows from the position in the block
+#define REL32I_DISPATCH() goto *operation_label_table[(++instruction)->operation]
+#define REL32I_SKIP() (++instruction)
+#define REL32I_LEAVE_AFTER_INSTRUCTION() do { pc += instruction->size; instruction_count += (uint64_t)(instruction + 1 - block->instruction_table); goto stop; } while (0)
+#define REL32I_WRITE_RD(value) do { uint32_t rd_value = (value); x[instruction->rd] = rd_value; x[0] = 0; pc += instruction->size; REL32I_DISPATCH(); } while (0)
+#define REL32I_NEXT() do { pc += instruction->size; REL32I_DISPATCH(); } while (0)
+#define REL32I_BRANCH(condition) do { pc += (condition) ? REL32I_IMMEDIATE : instruction->size; REL32I_DISPATCH(); } while (0)
+#define REL32I_JUMP_AND_LINK(target) do { uint32_t jump_target = (target); x[instruction->rd] = pc + instruction->size; x[0] = 0; pc = jump_target; REL32I_DISPATCH(); } while (0)
+#define REL32I_EVENT(event) do { if ((event) & stop_mask) { instruction_count += (uint64_t)(instruction - block->instruction_table); stop_reason = (event); goto stop; } pc += instruction->size; REL32I_DISPATCH(); } while (0)
+#define REL32I_FENCE_I() do { rel32i_invalidate_all_code(hart); REL32I_LEAVE_AFTER_INSTRUCTION(); } while (0)
+#define REL32I_CODE_WRITTEN(address, size) do { if (rel32i_invalidate_code(hart, (address), (size))) REL32I_LEAVE_AFTER_INSTRUCTION(); } while (0)
+#define REL32I_CHECKPOINT() (fault_frame->pc = pc, rel32i_fault_barrier())
+#define REL32I_OPERATION_HANDLER(index, constant, name, body) operation_##name: { body }
+
+	REL32I_OPERATION_LIST(REL32I_OPERATION_HANDLER)
+	REL32I_FUSED_OPERATION_LIST(REL32I_OPERATION_HANDLER)
+operation_default:
+	REL32I_NEXT();
+operation_unknown:
+	REL32I_EVENT(REL32I_STOP_ILLEGAL_INSTRUCTION);
+operation_block_end:
+	instruction_count += block->instruction_count;
+	block = rel32i_get_next_block(block_cache, code_base_address, block, pc);
+	if (!block || block->instruction_count > max_instruction_count - instruction_count)
+		goto stop;
+	fault_frame->block = block;
+	fault_frame->instruction_count = instruction_count;
+	instruction = block->instruction_table;
+	goto *operation_label_table[instruction->operation];
+
+#undef REL32I_OPERATION_HANDLER
+#undef REL32I_CHECKPOINT
+#undef REL32I_CODE_WRITTEN
+#undef REL32I_FENCE_I
+#undef REL32I_EVENT
+#undef REL32I_JUMP_AND_LINK
+#undef REL32I_BRANCH
+#undef REL32I_NEXT
+#undef REL32I_WRITE_RD
+#undef REL32I_LEAVE_AFTER_INSTRUCTION
+#undef REL32I_SKIP
+#undef REL32I_DISPATCH
+
+stop:
+	hart->register_set->pc = pc;
+	rel32_copy(hart->register_set->x1_x31, x + 1, 31 * sizeof(uint32_t));
+	*retired_instruction_count = instruction_count;
+	return stop_reason;
+}
+#else
+static int rel32i_run_blocks(rel32i_hart_t* hart, rel32i_fault_frame_t* fault_frame, uint64_t max_instruction_count, int stop_mask, uint64_t* retired_instruction_count)
+{
+	rel32i_block_cache_t* block_cache = hart->block_cache;
+	const void* code_base_address = hart->code_base_address;
+	uint32_t watched_code_size = rel32i_get_watched_code_size(hart);
+	uint64_t flush_count = block_cache->flush_count;
+	uint64_t instruction_count = 0;
+	int stop_reason = REL32I_STOP_INSTRUCTION_LIMIT;
+
+	uint32_t pc = hart->register_set->pc;
+	uint32_t x[32];
+	x[0] = 0;
+	rel32_copy(x + 1, hart->register_set->x1_x31, 31 * sizeof(uint32_t));
+	fault_frame->x = x;
+
+	rel32i_block_t* block = rel32i_get_block(block_cache, code_base_address, pc);
+	while (block && block->instruction_count <= max_instruction_count - instruction_count)
+	{
+		fault_frame->block = block;
+		fault_frame->instruction_count = instruction_count;
+		for (const rel32i_predecoded_instruction_t* instruction = block->instruction_table; instruction->operation != REL32I_OPERATION_BLOCK_END; ++instruction)
+		{
+			int event = rel32i_execute_operation(hart, fault_frame, 0, watched_code_size, instruction, x, &pc);
+			if (event)
+			{
+				if (event & stop_mask)
+				{
+					instruction_count += rel32i_count_block_instructions(block, pc);
+					stop_reason = event;
+					goto stop;
+				}
+				pc += instruction->size;
+			}
+			if (block_cache->flush_count != flush_count)
+			{
+				instruction_count += rel32i_count_block_instructions(block, pc);
+				goto stop;
+			}
+			if (instruction->operation >= REL32I_OPERATION_FUSED_LOAD_IMMEDIATE && instruction->operation < REL32I_OPERATION_BLOCK_END)
+				++instruction;
+		}
+		instruction_count += block->instruction_count;
+		block = rel32i_get_next_block(block_cache, code_base_address, block, pc);
+		flush_count = block_cache->flush_count;
+	}
+
+stop:
+	hart->register_set->pc = pc;
+	rel32_copy(hart->register_set->x1_x31, x + 1, 31 * sizeof(uint32_t));
+	*retired_instruction_count = instruction_count;
+	return stop_reason;
+}
+#endif
+
+#ifdef REL32I_JIT_SUPPORTED
+#define REL32I_JIT_EXIT_BUDGET 1
+#define REL32I_JIT_EXIT_LINK 2
+#define REL32I_JIT_EXIT_INDIRECT 3
+#define REL32I_JIT_EXIT_FALLBACK 4
+#define REL32I_JIT_EXIT_CODE_WRITTEN 5
+
+#define REL32I_JIT_PROLOGUE_OFFSET 0x10
+#define REL32I_JIT_TRAMPOLINE_SIZE 0x40
+
+#define REL32I_JIT_EAX 0
+#define REL32I_JIT_ECX 1
+#define REL32I_JIT_EDX 2
+#define REL32I_JIT_ESI 6
+
+typedef struct rel32i_jit_context_t
+{
+	uint32_t x[32];
+	uint32_t pc;
+	uint32_t checkpoint_unretired_instruction_count;
+	uint64_t remaining_instruction_count;
+	uintptr_t data_base_address;
+	uintptr_t code_offset;
+	uintptr_t watched_code_size;
+	rel32i_hart_t* hart;
+	uint8_t* link_address;
+} rel32i_jit_context_t;
+
+typedef int (*rel32i_jit_entry_t)(rel32i_jit_context_t* context, const uint8_t* block_entry);
+
+static int rel32i_jit_code_written(rel32i_jit_context_t* context, uint32_t address, uint32_t size)
+{
+	return rel32i_invalidate_code(context->hart, address, size);
+}
+
+static uint8_t* rel32i_jit_emit_u32(uint8_t* write, uint32_t value)
+{
+	write[0] = (uint8_t)value;
+	write[1] = (uint8_t)(value >> 8);
+	write[2] = (uint8_t)(value >> 16);
+	write[3] = (uint8_t)(value >> 24);
+	return write + 4;
+}
+
+// generated code keeps the context in rbx, the data base address in r12 and the number of instructions it may still retire in r13
+static uint8_t* rel32i_jit_emit_context_operand(uint8_t* write, int host_register, size_t offset)
+{
+	if (offset < 0x80)
+	{
+		*write++ = (uint8_t)(0x43 | ((host_register & 7) << 3));
+		*write++ = (uint8_t)offset;
+		return write;
+	}
+	*write++ = (uint8_t)(0x83 | ((host_register & 7) << 3));
+	return rel32i_jit_emit_u32(write, (uint32_t)offset);
+}
+
+static uint8_t* rel32i_jit_emit_load_register(uint8_t* write, int host_register, uint8_t guest_register)
+{
+	if (!guest_register)
+	{
+		*write++ = 0x31;
+		*write++ = (uint8_t)(0xC0 | (host_register << 3) | host_register);
+		return write;
+	}
+	*write++ = 0x8B;
+	return rel32i_jit_emit_context_operand(write, host_register, (size_t)guest_register * 4);
+}
+
+static uint8_t* rel32i_jit_emit_store_register(uint8_t* write, int host_register, uint8_t guest_register)
+{
+	if (!guest_register)
+		return write;
+	*write++ = 0x89;
+	return rel32i_jit_emit_context_operand(write, host_register, (size_t)guest_register * 4);
+}
+
+static uint8_t* rel32i_jit_emit_move_immediate(uint8_t* write, int host_register, uint32_t value)
+{
+	*write++ = (uint8_t)(0xB8 + host_register);
+	return rel32i_jit_emit_u32(write, value);
+}
+
+static uint8_t* rel32i_jit_emit_arithmetic_immediate(uint8_t* write, int extension, int host_register, uint32_t value)
+{
+	*write++ = 0x81;
+	*write++ = (uint8_t)(0xC0 | (extension << 3) | host_register);
+	return rel32i_jit_emit_u32(write, value);
+}
+
+static uint8_t* rel32i_jit_emit_jump(uint8_t* write, const uint8_t* target)
+{
+	*write++ = 0xE9;
+	return rel32i_jit_emit_u32(write, (uint32_t)((intptr_t)target - (intptr_t)(write + 4)));
+}
+
+static uint8_t* rel32i_jit_emit_exit(uint8_t* write, const uint8_t* epilogue, uint32_t pc, int exit_reason, uint32_t unretired_instruction_count)
+{
+	if (unretired_instruction_count)
+	{
+		*write++ = 0x49;
+		*write++ = 0x81;
+		*write++ = 0xC5;
+		write = rel32i_jit_emit_u32(write, unretired_instruction_count);
+	}
+	*write++ = 0xC7;
+	write = rel32i_jit_emit_context_operand(write, 0, offsetof(rel32i_jit_context_t, pc));
+	write = rel32i_jit_emit_u32(write, pc);
+	write = rel32i_jit_emit_move_immediate(write, REL32I_JIT_EAX, (uint32_t)exit_reason);
+	return rel32i_jit_emit_jump(write, epilogue);
+}
+
+static uint8_t* rel32i_jit_emit_linked_exit(uint8_t* write, const uint8_t* epilogue, uint32_t pc)
+{
+	// the leading jump goes to the next instruction until the dispatcher patches it to go straight to the block at pc
+	uint8_t* link_address = write;
+	write = rel32i_jit_emit_jump(write, write + 5);
+	*write++ = 0xC7;
+	write = rel32i_jit_emit_context_operand(write, 0, offsetof(rel32i_jit_context_t, pc));
+	write = rel32i_jit_emit_u32(write, pc);
+	*write++ = 0x48;
+	*write++ = 0x8D;
+	*write++ = 0x05;
+	write = rel32i_jit_emit_u32(write, (uint32_t)((intptr_t)link_address - (intptr_t)(write + 4)));
+	*write++ = 0x48;
+	*write++ = 0x89;
+	write = rel32i_jit_emit_context_operand(write, REL32I_JIT_EAX, offsetof(rel32i_jit_context_t, link_address));
+	write = rel32i_jit_emit_move_immediate(write, REL32I_JIT_EAX, REL32I_JIT_EXIT_LINK);
+	return rel32i_jit_emit_jump(write, epilogue);
+}
+
+static uint8_t* rel32i_jit_emit_checkpoint(uint8_t* write, uint32_t pc, uint32_t unretired_instruction_count)
+{
+	// an access fault finds the budget left before the instruction by adding this count to r13
+	*write++ = 0xC7;
+	write = rel32i_jit_emit_context_operand(write, 0, offsetof(rel32i_jit_context_t, pc));
+	write = rel32i_jit_emit_u32(write, pc);
+	*write++ = 0xC7;
+	write = rel32i_jit_emit_context_operand(write, 0, offsetof(rel32i_jit_context_t, checkpoint_unretired_instruction_count));
+	return rel32i_jit_emit_u32(write, unretired_instruction_count + 1);
+}
+
+static uint8_t* rel32i_jit_emit_address(uint8_t* write, const rel32i_predecoded_instruction_t* instruction)
+{
+	write = rel32i_jit_emit_load_register(write, REL32I_JIT_EAX, instruction->rs1);
+	if (instruction->intermediate)
+		write = rel32i_jit_emit_arithmetic_immediate(write, 0, REL32I_JIT_EAX, instruction->intermediate);
+	return write;
+}
+
+// same check as REL32I_STORE for a store to the guest address in eax, the distance from the code base is computed in rdx
+static uint8_t* rel32i_jit_emit_code_written_check(uint8_t* write, const uint8_t* epilogue, uint32_t size, uint32_t next_pc, uint32_t unretired_instruction_count)
+{
+	*write++ = 0x48;
+	*write++ = 0x89;
+	*write++ = 0xC2;
+	*write++ = 0x48;
+	*write++ = 0x2B;
+	write = rel32i_jit_emit_context_operand(write, REL32I_JIT_EDX, offsetof(rel32i_jit_context_t, code_offset));
+	*write++ = 0x48;
+	*write++ = 0x3B;
+	write = rel32i_jit_emit_context_operand(write, REL32I_JIT_EDX, offsetof(rel32i_jit_context_t, watched_code_size));
+	*write++ = 0x73;
+	uint8_t* skip_jump = write++;
+	*write++ = 0x48;
+	*write++ = 0x89;
+	*write++ = 0xDF;
+	*write++ = 0x89;
+	*write++ = 0xD6;
+	write = rel32i_jit_emit_move_immediate(write, REL32I_JIT_EDX, size);
+	*write++ = 0x48;
+	*write++ = 0xB8;
+	uint64_t helper_address = (uint64_t)(uintptr_t)&rel32i_jit_code_written;
+	write = rel32i_jit_emit_u32(write, (uint32_t)helper_address);
+	write = rel32i_jit_emit_u32(write, (uint32_t)(helper_address >> 32));
+	*write++ = 0xFF;
+	*write++ = 0xD0;
+	*write++ = 0x85;
+	*write++ = 0xC0;
+	*write++ = 0x74;
+	uint8_t* continue_jump = write++;
+	write = rel32i_jit_emit_exit(write, epilogue, next_pc, REL32I_JIT_EXIT_CODE_WRITTEN, unretired_instruction_count);
+	*skip_jump = (uint8_t)(write - (skip_jump + 1));
+	*continue_jump = (uint8_t)(write - (continue_jump + 1));
+	return write;
+}
+
+// [rdx + disp32] with rdx holding the guest register set, where the LR/SC reservation is
+static uint8_t* rel32i_jit_emit_reservation_operand(uint8_t* write, int host_register, size_t offset)
+{
+	*write++ = (uint8_t)(0x82 | ((host_register & 7) << 3));
+	return rel32i_jit_emit_u32(write, (uint32_t)offset);
+}
+
+static uint8_t* rel32i_jit_emit_load_reservation_base(uint8_t* write)
+{
+	*write++ = 0x48;
+	*write++ = 0x8B;
+	write = rel32i_jit_emit_context_operand(write, REL32I_JIT_EDX, offsetof(rel32i_jit_context_t, hart));
+	*write++ = 0x48;
+	*write++ = 0x8B;
+	*write++ = 0x52;
+	*write++ = (uint8_t)offsetof(rel32i_hart_t, register_set);
+	return write;
+}
+
+static uint8_t* rel32i_jit_emit_trampoline(uint8_t* native_code)
+{
+	static const uint8_t epilogue[] = { 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3 };
+	static const uint8_t prologue[] = { 0x53, 0x41, 0x54, 0x41, 0x55, 0x48, 0x89, 0xFB };
+
+	uint8_t* write = native_code;
+	*write++ = 0x4C;
+	*write++ = 0x89;
+	write = rel32i_jit_emit_context_operand(write, 5, offsetof(rel32i_jit_context_t, remaining_instruction_count));
+	for (size_t i = 0; i != sizeof(epilogue); ++i)
+		*write++ = epilogue[i];
+	assert(write <= native_code + REL32I_JIT_PROLOGUE_OFFSET);
+
+	write = native_code + REL32I_JIT_PROLOGUE_OFFSET;
+	for (size_t i = 0; i != sizeof(prologue); ++i)
+		*write++ = prologue[i];
+	*write++ = 0x4C;
+	*write++ = 0x8B;
+	write = rel32i_jit_emit_context_operand(write, 4, offsetof(rel32i_jit_context_t, data_base_address));
+	*write++ = 0x4C;
+	*write++ = 0x8B;
+	write = rel32i_jit_emit_context_operand(write, 5, offsetof(rel32i_jit_context_t, remaining_instruction_count));
+	*write++ = 0xFF;
+	*write++ = 0xE6;
+	assert(write <= native_code + REL32I_JIT_TRAMPOLINE_SIZE);
+	return write;
+}
+
+static int rel32i_jit_can_translate(uint8_t operation)
+{
+	// RV32I without the system instructions and RV32MA, everything else is left to the instruction core
+	switch (operation)
+	{
+		case REL32I_OPERATION_LUI:
+		case REL32I_OPERATION_AUIPC:
+		case REL32I_OPERATION_JAL:
+		case REL32I_OPERATION_JALR:
+		case REL32I_OPERATION_BEQ:
+		case REL32I_OPERATION_BNE:
+		case REL32I_OPERATION_BLT:
+		case REL32I_OPERATION_BGE:
+		case REL32I_OPERATION_BLTU:
+		case REL32I_OPERATION_BGEU:
+		case REL32I_OPERATION_LB:
+		case REL32I_OPERATION_LH:
+		case REL32I_OPERATION_LW:
+		case REL32I_OPERATION_LBU:
+		case REL32I_OPERATION_LHU:
+		case REL32I_OPERATION_SB:
+		case REL32I_OPERATION_SH:
+		case REL32I_OPERATION_SW:
+		case REL32I_OPERATION_ADDI:
+		case REL32I_OPERATION_SLTI:
+		case REL32I_OPERATION_SLTIU:
+		case REL32I_OPERATION_XORI:
+		case REL32I_OPERATION_ORI:
+		case REL32I_OPERATION_ANDI:
+		case REL32I_OPERATION_SLLI:
+		case REL32I_OPERATION_SRLI:
+		case REL32I_OPERATION_SRAI:
+		case REL32I_OPERATION_ADD:
+		case REL32I_OPERATION_SUB:
+		case REL32I_OPERATION_SLL:
+		case REL32I_OPERATION_SLT:
+		case REL32I_OPERATION_SLTU:
+		case REL32I_OPERATION_XOR:
+		case REL32I_OPERATION_SRL:
+		case REL32I_OPERATION_SRA:
+		case REL32I_OPERATION_OR:
+		case REL32I_OPERATION_AND:
+		case REL32I_OPERATION_FENCE:
+		case REL32I_OPERATION_MUL:
+		case REL32I_OPERATION_MULH:
+		case REL32I_OPERATION_MULHSU:
+		case REL32I_OPERATION_MULHU:
+		case REL32I_OPERATION_DIV:
+		case REL32I_OPERATION_DIVU:
+		case REL32I_OPERATION_REM:
+		case REL32I_OPERATION_REMU:
+		case REL32I_OPERATION_LR_W:
+		case REL32I_OPERATION_SC_W:
+		case REL32I_OPERATION_AMOSWAP_W:
+		case REL32I_OPERATION_AMOADD_W:
+		case REL32I_OPERATION_AMOXOR_W:
+		case REL32I_OPERATION_AMOAND_W:
+		case REL32I_OPERATION_AMOOR_W:
+		case REL32I_OPERATION_AMOMIN_W:
+		case REL32I_OPERATION_AMOMAX_W:
+		case REL32I_OPERATION_AMOMINU_W:
+		case REL32I_OPERATION_AMOMAXU_W:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+static uint8_t* rel32i_jit_emit_instruction(uint8_t* write, const uint8_t* epilogue, const rel32i_predecoded_instruction_t* instruction, uint32_t pc, uint32_t unretired_instruction_count)
+{
+	static const uint8_t register_operation_table[10][2] = {
+		{ 0x01, 0xC8 }, { 0x29, 0xC8 }, { 0xD3, 0xE0 }, { 0x0F, 0x9C }, { 0x0F, 0x92 }, { 0x31, 0xC8 }, { 0xD3, 0xE8 }, { 0xD3, 0xF8 }, { 0x09, 0xC8 }, { 0x21, 0xC8 } };
+	static const uint8_t load_operation_table[5] = { 0xBE, 0xBF, 0x8B, 0xB6, 0xB7 };
+	static const uint8_t shift_operation_table[3] = { 0xE0, 0xE8, 0xF8 };
+	static const uint8_t branch_condition_table[6] = { 0x84, 0x85, 0x8C, 0x8D, 0x82, 0x83 };
+
+	uint8_t operation = instruction->operation;
+	switch (operation)
+	{
+		case REL32I_OPERATION_LUI:
+		case REL32I_OPERATION_AUIPC:
+			if (instruction->rd)
+			{
+				write = rel32i_jit_emit_move_immediate(write, REL32I_JIT_EAX, (operation == REL32I_OPERATION_AUIPC ? pc : 0) + instruction->intermediate);
+				write = rel32i_jit_emit_store_register(write, REL32I_JIT_EAX, instruction->rd);
+			}
+			return write;
+		case REL32I_OPERATION_JAL:
+			if (instruction->rd)
+			{
+				write = rel32i_jit_emit_move_immediate(write, REL32I_JIT_EAX, pc + instruction->size);
+				write = rel32i_jit_emit_store_register(write, REL32I_JIT_EAX, instruction->rd);
+			}
+			return rel32i_jit_emit_linked_exit(write, epilogue, pc + instruction->intermediate);
+		case REL32I_OPERATION_JALR:
+			write = rel32i_jit_emit_address(write, instruction);
+			*write++ = 0x83;
+			*write++ = 0xE0;
+			*write++ = 0xFE;
+			if (instruction->rd)
+			{
+				write = rel32i_jit_emit_move_immediate(write, REL32I_JIT_ECX, pc + instruction->size);
+				write = rel32i_jit_emit_store_register(write, REL32I_JIT_ECX, instruction->rd);
+			}
+			*write++ = 0x89;
+			write = rel32i_jit_emit_context_operand(write, REL32I_JIT_EAX, offsetof(rel32i_jit_context_t, pc));
+			write = rel32i_jit_emit_move_immediate(write, REL32I_JIT_EAX, REL32I_JIT_EXIT_INDIRECT);
+			return rel32i_jit_emit_jump(write, epilogue);
+		case REL32I_OPERATION_BEQ:
+		case REL32I_OPERATION_BNE:
+		case REL32I_OPERATION_BLT:
+		case REL32I_OPERATION_BGE:
+		case REL32I_OPERATION_BLTU:
+		case REL32I_OPERATION_BGEU:
 		{
-			uint32_t shift = info.intermediate & 0x1F;
-			rd = ((rs1 >> shift) & (0xFFFFFFFF >> shift)) | ((0 - (rs1 >> 31)) & ~(0xFFFFFFFF >> shift));
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_EAX, instruction->rs1);
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_ECX, instruction->rs2);
+			*write++ = 0x39;
+			*write++ = 0xC8;
+			*write++ = 0x0F;
+			*write++ = branch_condition_table[operation - REL32I_OPERATION_BEQ];
+			uint8_t* taken_jump = write;
+			write = rel32i_jit_emit_linked_exit(write + 4, epilogue, pc + instruction->size);
+			rel32i_jit_emit_u32(taken_jump, (uint32_t)((intptr_t)write - (intptr_t)(taken_jump + 4)));
+			return rel32i_jit_emit_linked_exit(write, epilogue, pc + instruction->intermediate);
 		}
-		case 27:/*add*/
+		case REL32I_OPERATION_LB:
+		case REL32I_OPERATION_LH:
+		case REL32I_OPERATION_LW:
+		case REL32I_OPERATION_LBU:
+		case REL32I_OPERATION_LHU:
+			write = rel32i_jit_emit_checkpoint(write, pc, unretired_instruction_count);
+			write = rel32i_jit_emit_address(write, instruction);
+			*write++ = 0x41;
+			if (operation != REL32I_OPERATION_LW)
+				*write++ = 0x0F;
+			*write++ = load_operation_table[operation - REL32I_OPERATION_LB];
+			*write++ = 0x04;
+			*write++ = 0x04;
+			return rel32i_jit_emit_store_register(write, REL32I_JIT_EAX, instruction->rd);
+		case REL32I_OPERATION_SB:
+		case REL32I_OPERATION_SH:
+		case REL32I_OPERATION_SW:
 		{
-			rd = rs1 + rs2;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
+			uint32_t size = (uint32_t)1 << (operation - REL32I_OPERATION_SB);
+			write = rel32i_jit_emit_checkpoint(write, pc, unretired_instruction_count);
+			write = rel32i_jit_emit_address(write, instruction);
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_ECX, instruction->rs2);
+			if (size == 2)
+				*write++ = 0x66;
+			*write++ = 0x41;
+			*write++ = (size == 1) ? 0x88 : 0x89;
+			*write++ = 0x0C;
+			*write++ = 0x04;
+			return rel32i_jit_emit_code_written_check(write, epilogue, size, pc + instruction->size, unretired_instruction_count);
 		}
-		case 28:/*sub*/
+		case REL32I_OPERATION_ADDI:
+		case REL32I_OPERATION_SLTI:
+		case REL32I_OPERATION_SLTIU:
+		case REL32I_OPERATION_XORI:
+		case REL32I_OPERATION_ORI:
+		case REL32I_OPERATION_ANDI:
 		{
-			rd = rs1 - rs2;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
+			static const uint8_t extension_table[6] = { 0, 7, 7, 6, 1, 4 };
+			if (!instruction->rd)
+				return write;
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_EAX, instruction->rs1);
+			write = rel32i_jit_emit_arithmetic_immediate(write, extension_table[operation - REL32I_OPERATION_ADDI], REL32I_JIT_EAX, instruction->intermediate);
+			if (operation == REL32I_OPERATION_SLTI || operation == REL32I_OPERATION_SLTIU)
+			{
+				*write++ = 0x0F;
+				*write++ = (operation == REL32I_OPERATION_SLTI) ? 0x9C : 0x92;
+				*write++ = 0xC0;
+				*write++ = 0x0F;
+				*write++ = 0xB6;
+				*write++ = 0xC0;
+			}
+			return rel32i_jit_emit_store_register(write, REL32I_JIT_EAX, instruction->rd);
 		}
-		case 29:/*sll*/
+		case REL32I_OPERATION_SLLI:
+		case REL32I_OPERATION_SRLI:
+		case REL32I_OPERATION_SRAI:
+			if (!instruction->rd)
+				return write;
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_EAX, instruction->rs1);
+			*write++ = 0xC1;
+			*write++ = shift_operation_table[operation - REL32I_OPERATION_SLLI];
+			*write++ = (uint8_t)(instruction->intermediate & 0x1F);
+			return rel32i_jit_emit_store_register(write, REL32I_JIT_EAX, instruction->rd);
+		case REL32I_OPERATION_ADD:
+		case REL32I_OPERATION_SUB:
+		case REL32I_OPERATION_SLL:
+		case REL32I_OPERATION_SLT:
+		case REL32I_OPERATION_SLTU:
+		case REL32I_OPERATION_XOR:
+		case REL32I_OPERATION_SRL:
+		case REL32I_OPERATION_SRA:
+		case REL32I_OPERATION_OR:
+		case REL32I_OPERATION_AND:
+			if (!instruction->rd)
+				return write;
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_EAX, instruction->rs1);
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_ECX, instruction->rs2);
+			if (operation == REL32I_OPERATION_SLT || operation == REL32I_OPERATION_SLTU)
+			{
+				*write++ = 0x39;
+				*write++ = 0xC8;
+			}
+			*write++ = register_operation_table[operation - REL32I_OPERATION_ADD][0];
+			*write++ = register_operation_table[operation - REL32I_OPERATION_ADD][1];
+			if (operation == REL32I_OPERATION_SLT || operation == REL32I_OPERATION_SLTU)
+			{
+				*write++ = 0xC0;
+				*write++ = 0x0F;
+				*write++ = 0xB6;
+				*write++ = 0xC0;
+			}
+			return rel32i_jit_emit_store_register(write, REL32I_JIT_EAX, instruction->rd);
+		case REL32I_OPERATION_MUL:
+		case REL32I_OPERATION_MULH:
+		case REL32I_OPERATION_MULHSU:
+		case REL32I_OPERATION_MULHU:
+			if (!instruction->rd)
+				return write;
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_EAX, instruction->rs1);
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_ECX, instruction->rs2);
+			if (operation == REL32I_OPERATION_MUL)
+			{
+				*write++ = 0x0F;
+				*write++ = 0xAF;
+				*write++ = 0xC1;
+				return rel32i_jit_emit_store_register(write, REL32I_JIT_EAX, instruction->rd);
+			}
+			if (operation == REL32I_OPERATION_MULHSU)
+			{
+				// rs1 sign extended times rs2 zero extended in 64 bits, the high half is then moved into edx
+				*write++ = 0x48;
+				*write++ = 0x63;
+				*write++ = 0xC0;
+				*write++ = 0x48;
+				*write++ = 0x0F;
+				*write++ = 0xAF;
+				*write++ = 0xC1;
+				*write++ = 0x48;
+				*write++ = 0x89;
+				*write++ = 0xC2;
+				*write++ = 0x48;
+				*write++ = 0xC1;
+				*write++ = 0xEA;
+				*write++ = 0x20;
+			}
+			else
+			{
+				*write++ = 0xF7;
+				*write++ = (operation == REL32I_OPERATION_MULH) ? 0xE9 : 0xE1;
+			}
+			return rel32i_jit_emit_store_register(write, REL32I_JIT_EDX, instruction->rd);
+		case REL32I_OPERATION_DIV:
+		case REL32I_OPERATION_DIVU:
+		case REL32I_OPERATION_REM:
+		case REL32I_OPERATION_REMU:
 		{
-			rd = rs1 << (rs2 & 0x1F);
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
+			// x86 division traps where RISC-V division gives a result, so a zero divisor and for the signed forms -1 are handled apart
+			int is_signed = (operation == REL32I_OPERATION_DIV || operation == REL32I_OPERATION_REM);
+			int is_remainder = (operation == REL32I_OPERATION_REM || operation == REL32I_OPERATION_REMU);
+			if (!instruction->rd)
+				return write;
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_EAX, instruction->rs1);
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_ECX, instruction->rs2);
+			*write++ = 0x85;
+			*write++ = 0xC9;
+			*write++ = 0x74;
+			uint8_t* zero_jump = write++;
+			uint8_t* minus_one_jump = 0;
+			if (is_signed)
+			{
+				*write++ = 0x83;
+				*write++ = 0xF9;
+				*write++ = 0xFF;
+				*write++ = 0x74;
+				minus_one_jump = write++;
+				*write++ = 0x99;
+				*write++ = 0xF7;
+				*write++ = 0xF9;
+			}
+			else
+			{
+				*write++ = 0x31;
+				*write++ = 0xD2;
+				*write++ = 0xF7;
+				*write++ = 0xF1;
+			}
+			*write++ = 0xEB;
+			uint8_t* done_jump = write++;
+			uint8_t* done_jump_after_minus_one = 0;
+			if (is_signed)
+			{
+				// x / -1 is -x, which wraps for INT32_MIN the same way the specification asks, and x % -1 is 0
+				*minus_one_jump = (uint8_t)(write - (minus_one_jump + 1));
+				*write++ = is_remainder ? 0x31 : 0xF7;
+				*write++ = is_remainder ? 0xD2 : 0xD8;
+				*write++ = 0xEB;
+				done_jump_after_minus_one = write++;
+			}
+			*zero_jump = (uint8_t)(write - (zero_jump + 1));
+			if (is_remainder)
+			{
+				*write++ = 0x89;
+				*write++ = 0xC2;
+			}
+			else
+			{
+				*write++ = 0x83;
+				*write++ = 0xC8;
+				*write++ = 0xFF;
+			}
+			*done_jump = (uint8_t)(write - (done_jump + 1));
+			if (done_jump_after_minus_one)
+				*done_jump_after_minus_one = (uint8_t)(write - (done_jump_after_minus_one + 1));
+			return rel32i_jit_emit_store_register(write, is_remainder ? REL32I_JIT_EDX : REL32I_JIT_EAX, instruction->rd);
 		}
-		case 30:/*slt*/
+		case REL32I_OPERATION_LR_W:
+			// a plain load is sequentially consistent on x86
+			write = rel32i_jit_emit_checkpoint(write, pc, unretired_instruction_count);
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_EAX, instruction->rs1);
+			*write++ = 0x41;
+			*write++ = 0x8B;
+			*write++ = 0x0C;
+			*write++ = 0x04;
+			write = rel32i_jit_emit_load_reservation_base(write);
+			*write++ = 0x89;
+			write = rel32i_jit_emit_reservation_operand(write, REL32I_JIT_EAX, offsetof(rel32i_register_set_t, reservation_address));
+			*write++ = 0x89;
+			write = rel32i_jit_emit_reservation_operand(write, REL32I_JIT_ECX, offsetof(rel32i_register_set_t, reservation_value));
+			*write++ = 0xC7;
+			write = rel32i_jit_emit_reservation_operand(write, 0, offsetof(rel32i_register_set_t, reservation_valid));
+			write = rel32i_jit_emit_u32(write, 1);
+			return rel32i_jit_emit_store_register(write, REL32I_JIT_ECX, instruction->rd);
+		case REL32I_OPERATION_SC_W:
 		{
-			if (*(int32_t*)&rs1 < *(int32_t*)&rs2)
-				rd = 1;
-			else
-				rd = 0;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
+			// the address goes in esi since lock cmpxchg compares with eax, ecx is the value to store
+			// the reservation is the loaded value as in REL32I_STORE_CONDITIONAL, with the same A to B to A weakness
+			write = rel32i_jit_emit_checkpoint(write, pc, unretired_instruction_count);
+			write = rel32i_jit_emit_load_reservation_base(write);
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_ESI, instruction->rs1);
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_ECX, instruction->rs2);
+			*write++ = 0x83;
+			write = rel32i_jit_emit_reservation_operand(write, 7, offsetof(rel32i_register_set_t, reservation_valid));
+			*write++ = 0x00;
+			*write++ = 0xC7;
+			write = rel32i_jit_emit_reservation_operand(write, 0, offsetof(rel32i_register_set_t, reservation_valid));
+			write = rel32i_jit_emit_u32(write, 0);
+			*write++ = 0x74;
+			uint8_t* unreserved_jump = write++;
+			*write++ = 0x3B;
+			write = rel32i_jit_emit_reservation_operand(write, REL32I_JIT_ESI, offsetof(rel32i_register_set_t, reservation_address));
+			*write++ = 0x75;
+			uint8_t* other_address_jump = write++;
+			*write++ = 0x8B;
+			write = rel32i_jit_emit_reservation_operand(write, REL32I_JIT_EAX, offsetof(rel32i_register_set_t, reservation_value));
+			*write++ = 0xF0;
+			*write++ = 0x41;
+			*write++ = 0x0F;
+			*write++ = 0xB1;
+			*write++ = 0x0C;
+			*write++ = 0x34;
+			*write++ = 0x75;
+			uint8_t* changed_jump = write++;
+			*write++ = 0x31;
+			*write++ = 0xC0;
+			*write++ = 0xEB;
+			uint8_t* done_jump = write++;
+			*unreserved_jump = (uint8_t)(write - (unreserved_jump + 1));
+			*other_address_jump = (uint8_t)(write - (other_address_jump + 1));
+			*changed_jump = (uint8_t)(write - (changed_jump + 1));
+			write = rel32i_jit_emit_move_immediate(write, REL32I_JIT_EAX, 1);
+			*done_jump = (uint8_t)(write - (done_jump + 1));
+			write = rel32i_jit_emit_store_register(write, REL32I_JIT_EAX, instruction->rd);
+			*write++ = 0x89;
+			*write++ = 0xF0;
+			return rel32i_jit_emit_code_written_check(write, epilogue, 4, pc + instruction->size, unretired_instruction_count);
 		}
-		case 31:/*sltu*/
+		case REL32I_OPERATION_AMOSWAP_W:
+		case REL32I_OPERATION_AMOADD_W:
+		case REL32I_OPERATION_AMOXOR_W:
+		case REL32I_OPERATION_AMOAND_W:
+		case REL32I_OPERATION_AMOOR_W:
+		case REL32I_OPERATION_AMOMIN_W:
+		case REL32I_OPERATION_AMOMAX_W:
+		case REL32I_OPERATION_AMOMINU_W:
+		case REL32I_OPERATION_AMOMAXU_W:
 		{
-			if (rs1 < rs2)
-				rd = 1;
+			// xchg and lock xadd return the old value in ecx, the rest retry lock cmpxchg with the old value in eax and the new one in edx
+			static const uint8_t select_operation_table[7][3] = {
+				{ 0x31, 0xCA, 0 }, { 0x21, 0xCA, 0 }, { 0x09, 0xCA, 0 }, { 0x0F, 0x4F, 0xD1 }, { 0x0F, 0x4C, 0xD1 }, { 0x0F, 0x47, 0xD1 }, { 0x0F, 0x42, 0xD1 } };
+			write = rel32i_jit_emit_checkpoint(write, pc, unretired_instruction_count);
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_ESI, instruction->rs1);
+			write = rel32i_jit_emit_load_register(write, REL32I_JIT_ECX, instruction->rs2);
+			int old_value_register = REL32I_JIT_EAX;
+			if (operation == REL32I_OPERATION_AMOSWAP_W || operation == REL32I_OPERATION_AMOADD_W)
+			{
+				if (operation == REL32I_OPERATION_AMOADD_W)
+					*write++ = 0xF0;
+				*write++ = 0x41;
+				if (operation == REL32I_OPERATION_AMOADD_W)
+					*write++ = 0x0F;
+				*write++ = (operation == REL32I_OPERATION_AMOSWAP_W) ? 0x87 : 0xC1;
+				*write++ = 0x0C;
+				*write++ = 0x34;
+				old_value_register = REL32I_JIT_ECX;
+			}
 			else
-				rd = 0;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
+			{
+				const uint8_t* select_operation = select_operation_table[operation - REL32I_OPERATION_AMOXOR_W];
+				*write++ = 0x41;
+				*write++ = 0x8B;
+				*write++ = 0x04;
+				*write++ = 0x34;
+				uint8_t* retry = write;
+				*write++ = 0x89;
+				*write++ = 0xC2;
+				if (operation >= REL32I_OPERATION_AMOMIN_W)
+				{
+					*write++ = 0x39;
+					*write++ = 0xCA;
+				}
+				*write++ = select_operation[0];
+				*write++ = select_operation[1];
+				if (select_operation[2])
+					*write++ = select_operation[2];
+				*write++ = 0xF0;
+				*write++ = 0x41;
+				*write++ = 0x0F;
+				*write++ = 0xB1;
+				*write++ = 0x14;
+				*write++ = 0x34;
+				*write++ = 0x75;
+				*write = (uint8_t)(retry - (write + 1));
+				++write;
+			}
+			write = rel32i_jit_emit_store_register(write, old_value_register, instruction->rd);
+			*write++ = 0x89;
+			*write++ = 0xF0;
+			return rel32i_jit_emit_code_written_check(write, epilogue, 4, pc + instruction->size, unretired_instruction_count);
 		}
-		case 32:/*xor*/
+		case REL32I_OPERATION_FENCE:
+			return write;
+		default:
+			// rel32i_jit_can_translate and this switch disagree
+			assert(0);
+			return write;
+	}
+}
+
+static uint8_t* rel32i_jit_translate_block(rel32i_jit_t* jit, const void* code_base_address, uint32_t address)
+{
+	rel32i_predecoded_instruction_t instruction_table[REL32I_MAX_BLOCK_SIZE];
+	uint32_t instruction_count = 0;
+	int ends_with_fallback = 0;
+	uint32_t code_end = jit->code_size & ~3;
+	for (uint32_t pc = address; instruction_count != REL32I_MAX_BLOCK_SIZE && code_end - pc >= 4; pc += instruction_table[instruction_count - 1].size)
+	{
+		rel32i_predecode_instruction((const void*)((uintptr_t)code_base_address + (uintptr_t)pc), instruction_table + instruction_count);
+		if (!rel32i_jit_can_translate(instruction_table[instruction_count].operation))
 		{
-			rd = rs1 ^ rs2;
-			set_rd = 1;
-			register_set->pc += 4;
+			ends_with_fallback = 1;
 			break;
 		}
-		case 33:/*srl*/
-		{
-			rd = rs1 >> (rs2 & 0x1F);
-			set_rd = 1;
-			register_set->pc += 4;
+		if (rel32i_operation_ends_block(instruction_table[instruction_count++].operation))
 			break;
-		}
-		case 34:/*sra*/
+	}
+	if (!instruction_count)
+		return 0;
+
+	if (jit->block_count == jit->block_capacity || jit->native_code_capacity - jit->native_code_size < REL32I_JIT_MAX_BLOCK_NATIVE_SIZE)
+		rel32i_flush_jit(jit);
+
+	const uint8_t* epilogue = jit->native_code;
+	uint8_t* entry = jit->native_code + jit->native_code_size;
+	uint8_t* write = entry;
+
+	// a block is only entered when all of it can be retired
+	*write++ = 0x49;
+	*write++ = 0x81;
+	*write++ = 0xFD;
+	write = rel32i_jit_emit_u32(write, instruction_count);
+	*write++ = 0x73;
+	uint8_t* body_jump = write++;
+	write = rel32i_jit_emit_exit(write, epilogue, address, REL32I_JIT_EXIT_BUDGET, 0);
+	*body_jump = (uint8_t)(write - (body_jump + 1));
+	*write++ = 0x49;
+	*write++ = 0x81;
+	*write++ = 0xED;
+	write = rel32i_jit_emit_u32(write, instruction_count);
+
+	uint32_t end_address = address;
+	for (uint32_t i = 0; i != instruction_count; ++i)
+	{
+		write = rel32i_jit_emit_instruction(write, epilogue, instruction_table + i, end_address, instruction_count - (i + 1));
+		end_address += instruction_table[i].size;
+	}
+
+	if (ends_with_fallback)
+		write = rel32i_jit_emit_exit(write, epilogue, end_address, REL32I_JIT_EXIT_FALLBACK, 0);
+	else if (!rel32i_operation_ends_block(instruction_table[instruction_count - 1].operation))
+		write = rel32i_jit_emit_linked_exit(write, epilogue, end_address);
+	assert((size_t)(write - entry) <= REL32I_JIT_MAX_BLOCK_NATIVE_SIZE);
+	jit->native_code_size += (size_t)(write - entry);
+
+	for (uint32_t page = address / REL32I_CODE_PAGE_SIZE; page <= (end_address - 1) / REL32I_CODE_PAGE_SIZE; ++page)
+		jit->code_page_table[page] = 1;
+
+	rel32i_jit_block_t* block = jit->block_table + jit->block_count++;
+	block->address = address;
+	block->entry = entry;
+	rel32i_jit_block_t** bucket = jit->hash_table + ((address >> 1) & jit->hash_mask);
+	block->next = *bucket;
+	*bucket = block;
+	return entry;
+}
+
+static uint8_t* rel32i_get_jit_entry(rel32i_jit_t* jit, const void* code_base_address, uint32_t address)
+{
+	if ((address & 1) || (uint64_t)address + 4 > (jit->code_size & ~3))
+		return 0;
+	for (rel32i_jit_block_t* block = jit->hash_table[(address >> 1) & jit->hash_mask]; block; block = block->next)
+		if (block->address == address)
+			return block->entry;
+	return rel32i_jit_translate_block(jit, code_base_address, address);
+}
+
+int rel32i_create_jit(uint32_t code_size, size_t native_code_capacity, rel32i_jit_t** pointer_to_jit)
+{
+	const size_t header_size = ((sizeof(rel32i_jit_t) + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1));
+	if (native_code_capacity < REL32I_JIT_TRAMPOLINE_SIZE + REL32I_JIT_MAX_BLOCK_NATIVE_SIZE)
+		return EINVAL;
+
+	size_t block_capacity = native_code_capacity / 0x100 + 1;
+	size_t hash_table_size = 1;
+	while (hash_table_size < block_capacity)
+		hash_table_size <<= 1;
+	size_t page_count = ((size_t)code_size + (REL32I_CODE_PAGE_SIZE - 1)) / REL32I_CODE_PAGE_SIZE;
+
+	size_t host_page_size = (size_t)sysconf(_SC_PAGESIZE);
+	size_t table_size = header_size + hash_table_size * sizeof(rel32i_jit_block_t*) + block_capacity * sizeof(rel32i_jit_block_t) + page_count;
+	table_size = (table_size + (host_page_size - 1)) & ~(host_page_size - 1);
+	native_code_capacity = (native_code_capacity + (host_page_size - 1)) & ~(host_page_size - 1);
+
+	void* mapping = mmap(0, table_size + native_code_capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED)
+		return ENOMEM;
+	if (mprotect((void*)((uintptr_t)mapping + table_size), native_code_capacity, PROT_READ | PROT_WRITE | PROT_EXEC))
+	{
+		int error = errno;
+		munmap(mapping, table_size + native_code_capacity);
+		return error;
+	}
+
+	rel32i_jit_t* jit = (rel32i_jit_t*)mapping;
+	jit->mapping_size = table_size + native_code_capacity;
+	jit->code_size = code_size;
+	jit->hash_mask = (uint32_t)(hash_table_size - 1);
+	jit->hash_table = (rel32i_jit_block_t**)((uintptr_t)mapping + header_size);
+	jit->block_capacity = block_capacity;
+	jit->block_table = (rel32i_jit_block_t*)((uintptr_t)jit->hash_table + hash_table_size * sizeof(rel32i_jit_block_t*));
+	jit->code_page_table = (uint8_t*)((uintptr_t)jit->block_table + block_capacity * sizeof(rel32i_jit_block_t));
+	jit->native_code_capacity = native_code_capacity;
+	jit->native_code = (uint8_t*)((uintptr_t)mapping + table_size);
+	rel32i_jit_emit_trampoline(jit->native_code);
+	rel32i_flush_jit(jit);
+	jit->flush_count = 0;
+
+	*pointer_to_jit = jit;
+	return 0;
+}
+
+void rel32i_destroy_jit(rel32i_jit_t* jit)
+{
+	munmap(jit, jit->mapping_size);
+}
+
+void rel32i_flush_jit(rel32i_jit_t* jit)
+{
+	// the bytes of flushed blocks stay intact until the next block is translated, so generated code that caused the flush can still leave normally
+	for (uint32_t i = 0; i != jit->hash_mask + 1; ++i)
+		jit->hash_table[i] = 0;
+	for (uint32_t i = 0; i != (jit->code_size + (REL32I_CODE_PAGE_SIZE - 1)) / REL32I_CODE_PAGE_SIZE; ++i)
+		jit->code_page_table[i] = 0;
+	jit->block_count = 0;
+	jit->native_code_size = REL32I_JIT_TRAMPOLINE_SIZE;
+	jit->flush_count++;
+}
+
+static int rel32i_run_jit(rel32i_hart_t* hart, rel32i_fault_frame_t* fault_frame, uint64_t max_instruction_count, int stop_mask, uint64_t* retired_instruction_count)
+{
+	rel32i_jit_t* jit = hart->jit;
+	rel32i_register_set_t* register_set = hart->register_set;
+	rel32i_jit_entry_t enter = (rel32i_jit_entry_t)(void*)(jit->native_code + REL32I_JIT_PROLOGUE_OFFSET);
+
+	rel32i_jit_context_t context;
+	context.x[0] = 0;
+	rel32_copy(context.x + 1, register_set->x1_x31, 31 * sizeof(uint32_t));
+	context.pc = register_set->pc;
+	context.data_base_address = (uintptr_t)hart->data_base_address;
+	context.code_offset = (uintptr_t)hart->code_base_address - (uintptr_t)hart->data_base_address;
+	context.watched_code_size = (uintptr_t)rel32i_get_watched_code_size(hart);
+	context.hart = hart;
+	fault_frame->x = context.x;
+
+	uint64_t instruction_count = 0;
+	int stop_reason = REL32I_STOP_INSTRUCTION_LIMIT;
+	while (instruction_count != max_instruction_count)
+	{
+		int exit_reason = REL32I_JIT_EXIT_FALLBACK;
+		const uint8_t* entry = rel32i_get_jit_entry(jit, hart->code_base_address, context.pc);
+		if (entry)
 		{
-			uint32_t shift = rs2 & 0x1F;
-			rd = ((rs1 >> shift) & (0xFFFFFFFF >> shift)) | ((0 - (rs1 >> 31)) & ~(0xFFFFFFFF >> shift));
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
+			context.remaining_instruction_count = max_instruction_count - instruction_count;
+			fault_frame->jit_context = &context;
+			fault_frame->jit_max_instruction_count = max_instruction_count;
+			exit_reason = enter(&context, entry);
+			fault_frame->jit_context = 0;
+			instruction_count = max_instruction_count - context.remaining_instruction_count;
+			if (exit_reason == REL32I_JIT_EXIT_LINK)
+			{
+				uint64_t flush_count = jit->flush_count;
+				const uint8_t* target = rel32i_get_jit_entry(jit, hart->code_base_address, context.pc);
+				if (target && jit->flush_count == flush_count)
+					rel32i_jit_emit_u32(context.link_address + 1, (uint32_t)((intptr_t)target - (intptr_t)(context.link_address + 5)));
+			}
+			if ((exit_reason != REL32I_JIT_EXIT_BUDGET && exit_reason != REL32I_JIT_EXIT_FALLBACK) || instruction_count == max_instruction_count)
+				continue;
 		}
-		case 35:/*or*/
-		{
-			rd = rs1 | rs2;
-			set_rd = 1;
-			register_set->pc += 4;
+
+		// the instruction core runs what was not translated and the tail of the budget that is too short for a whole block
+		uint64_t stepped_instruction_count;
+		register_set->pc = context.pc;
+		rel32_copy(register_set->x1_x31, context.x + 1, 31 * sizeof(uint32_t));
+		uint64_t base_instruction_count = fault_frame->base_instruction_count;
+		fault_frame->base_instruction_count = base_instruction_count + instruction_count;
+		stop_reason = rel32i_run_core(hart, fault_frame, (exit_reason == REL32I_JIT_EXIT_BUDGET) ? (max_instruction_count - instruction_count) : 1, stop_mask, &stepped_instruction_count);
+		fault_frame->base_instruction_count = base_instruction_count;
+		fault_frame->x = context.x;
+		instruction_count += stepped_instruction_count;
+		context.pc = register_set->pc;
+		rel32_copy(context.x + 1, register_set->x1_x31, 31 * sizeof(uint32_t));
+		if (stop_reason != REL32I_STOP_INSTRUCTION_LIMIT)
 			break;
-		}
-		case 36:/*and*/
+	}
+
+	register_set->pc = context.pc;
+	rel32_copy(register_set->x1_x31, context.x + 1, 31 * sizeof(uint32_t));
+	*retired_instruction_count = instruction_count;
+	return stop_reason;
+}
+#else
+int rel32i_create_jit(uint32_t code_size, size_t native_code_capacity, rel32i_jit_t** pointer_to_jit)
+{
+	return ENOSYS;
+}
+
+void rel32i_destroy_jit(rel32i_jit_t* jit)
+{
+}
+
+void rel32i_flush_jit(rel32i_jit_t* jit)
+{
+}
+#endif
+
+#ifdef REL32I_ADDRESS_SPACE_SUPPORTED
+static _Thread_local rel32i_fault_frame_t* rel32i_active_fault_frame;
+static struct sigaction rel32i_previous_fault_action;
+static int rel32i_fault_handler_installed;
+
+static void rel32i_fault_handler(int signal_number, siginfo_t* signal_information, void* signal_context)
+{
+	rel32i_fault_frame_t* fault_frame = rel32i_active_fault_frame;
+	rel32i_address_space_t* address_space = fault_frame ? fault_frame->hart->address_space : 0;
+	uintptr_t offset = (uintptr_t)signal_information->si_addr - (uintptr_t)(address_space ? address_space->base_address : 0);
+	if (address_space && offset < address_space->reservation_size)
+	{
+		address_space->fault_address = (uint32_t)offset;
+		uint32_t pc = fault_frame->pc;
+		uint64_t instruction_count = rel32i_get_checkpoint_instruction_count(fault_frame);
+#ifdef REL32I_JIT_SUPPORTED
+		if (fault_frame->jit_context)
 		{
-			rd = rs1 & rs2;
-			set_rd = 1;
-			register_set->pc += 4;
-			break;
+			uint64_t remaining_instruction_count = (uint64_t)((ucontext_t*)signal_context)->uc_mcontext.gregs[REG_R13] + fault_frame->jit_context->checkpoint_unretired_instruction_count;
+			pc = fault_frame->jit_context->pc;
+			instruction_count = fault_frame->base_instruction_count + fault_frame->jit_max_instruction_count - remaining_instruction_count;
 		}
-		case 37:/*fence*/
+#endif
+		rel32i_raise_fault(fault_frame, REL32I_STOP_ACCESS_FAULT, pc, instruction_count);
+	}
+
+	// faults that are not guest accesses go to whoever handled them before
+	if (rel32i_previous_fault_action.sa_flags & SA_SIGINFO)
+		rel32i_previous_fault_action.sa_sigaction(signal_number, signal_information, signal_context);
+	else if (rel32i_previous_fault_action.sa_handler != SIG_DFL && rel32i_previous_fault_action.sa_handler != SIG_IGN)
+		rel32i_previous_fault_action.sa_handler(signal_number);
+	else
+		sigaction(SIGSEGV, &rel32i_previous_fault_action, 0);
+}
+
+int rel32i_create_address_space(rel32i_address_space_t* address_space)
+{
+	if (!__atomic_exchange_n(&rel32i_fault_handler_installed, 1, __ATOMIC_ACQ_REL))
+	{
+		struct sigaction action = { 0 };
+		action.sa_sigaction = rel32i_fault_handler;
+		action.sa_flags = SA_SIGINFO | SA_NODEFER | SA_ONSTACK;
+		sigemptyset(&action.sa_mask);
+		if (sigaction(SIGSEGV, &action, &rel32i_previous_fault_action))
 		{
-			register_set->pc += 4;
-			break;
+			int error = errno;
+			__atomic_store_n(&rel32i_fault_handler_installed, 0, __ATOMIC_RELEASE);
+			return error;
 		}
-		case 38:/*ecall*/
+	}
+
+	// the guard after the 4 GiB catches accesses that start just below the top of the guest address space
+	size_t reservation_size = ((size_t)1 << 32) + REL32I_ADDRESS_SPACE_GUARD_SIZE;
+	void* base_address = mmap(0, reservation_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (base_address == MAP_FAILED)
+		return errno;
+
+	address_space->base_address = (uint8_t*)base_address;
+	address_space->reservation_size = reservation_size;
+	address_space->fault_address = 0;
+	return 0;
+}
+
+int rel32i_commit_address_space(rel32i_address_space_t* address_space, uint32_t address, uint32_t size, int access)
+{
+	if (!size)
+		return 0;
+	if ((uint64_t)address + (uint64_t)size > ((uint64_t)1 << 32))
+		return EINVAL;
+
+	uint64_t page_size = (uint64_t)sysconf(_SC_PAGESIZE);
+	uint64_t begin = (uint64_t)address & ~(page_size - 1);
+	uint64_t end = ((uint64_t)address + (uint64_t)size + page_size - 1) & ~(page_size - 1);
+	int protection = PROT_NONE;
+	if (access & REL32I_ACCESS_READ)
+		protection |= PROT_READ;
+	if (access & REL32I_ACCESS_WRITE)
+		protection |= PROT_READ | PROT_WRITE;
+	if (mprotect(address_space->base_address + begin, (size_t)(end - begin), protection))
+		return errno;
+
+#ifdef MADV_HUGEPAGE
+	// failing to get huge pages only costs TLB misses, so the result is ignored
+	if (protection != PROT_NONE && end - begin >= 0x200000)
+		madvise(address_space->base_address + begin, (size_t)(end - begin), MADV_HUGEPAGE);
+#endif
+	return 0;
+}
+
+void rel32i_destroy_address_space(rel32i_address_space_t* address_space)
+{
+	munmap(address_space->base_address, address_space->reservation_size);
+}
+
+// the address space does not record what is committed, so every page is touched under a fault frame the way a guest access would be
+static int rel32i_probe_address_space(rel32i_hart_t* hart, uint32_t address, uint32_t size, int access)
+{
+	uint32_t x[32];
+	x[0] = 0;
+	rel32_copy(x + 1, hart->register_set->x1_x31, 31 * sizeof(uint32_t));
+	rel32i_fault_frame_t fault_frame;
+	fault_frame.x = x;
+	fault_frame.pc = hart->register_set->pc;
+	fault_frame.block = 0;
+	fault_frame.instruction_count = 0;
+	fault_frame.base_instruction_count = 0;
+	fault_frame.jit_context = 0;
+	fault_frame.hart = hart;
+
+	rel32i_fault_frame_t* previous_fault_frame = rel32i_active_fault_frame;
+	rel32i_active_fault_frame = &fault_frame;
+	if (setjmp(fault_frame.jump_buffer))
+	{
+		rel32i_active_fault_frame = previous_fault_frame;
+		return EFAULT;
+	}
+
+	uint64_t page_size = (uint64_t)sysconf(_SC_PAGESIZE);
+	uint64_t end = (uint64_t)address + (uint64_t)size;
+	for (uint64_t page = (uint64_t)address & ~(page_size - 1); page < end; page += page_size)
+	{
+		uint8_t* byte = hart->address_space->base_address + ((page > (uint64_t)address) ? page : (uint64_t)address);
+		// adding zero is a write the host checks without changing the byte
+		if (access & REL32I_ACCESS_WRITE)
+			__atomic_fetch_add(byte, 0, __ATOMIC_RELAXED);
+		else
+			(void)*(volatile uint8_t*)byte;
+	}
+
+	rel32i_active_fault_frame = previous_fault_frame;
+	return 0;
+}
+#else
+int rel32i_create_address_space(rel32i_address_space_t* address_space)
+{
+	return ENOSYS;
+}
+
+int rel32i_commit_address_space(rel32i_address_space_t* address_space, uint32_t address, uint32_t size, int access)
+{
+	return ENOSYS;
+}
+
+void rel32i_destroy_address_space(rel32i_address_space_t* address_space)
+{
+}
+#endif
+
+int rel32i_get_host_address(rel32i_hart_t* hart, uint32_t address, uint32_t size, int access, void** host_address)
+{
+	if (hart->mmu && hart->mmu->translating)
+		return ENOTSUP;
+	if ((uint64_t)address + (uint64_t)size > ((uint64_t)1 << 32))
+		return EFAULT;
+
+	if (hart->memory)
+	{
+		int type = (access & REL32I_ACCESS_WRITE) ? REL32I_MEMORY_RAM : REL32I_MEMORY_ROM;
+		const rel32i_memory_page_t* first_page = rel32i_get_memory_page(hart->memory, address);
+		if (!first_page)
+			return EFAULT;
+		for (uint64_t page_address = (uint64_t)address & ~(uint64_t)(REL32I_MEMORY_PAGE_SIZE - 1); page_address < (uint64_t)address + (uint64_t)size; page_address += REL32I_MEMORY_PAGE_SIZE)
 		{
-			register_set->pc += 4;
-			break;
+			const rel32i_memory_page_t* page = rel32i_get_memory_page(hart->memory, (uint32_t)page_address);
+			if (!page || (page->type != REL32I_MEMORY_RAM && page->type != type) || (page->access & access) != access || page->host_offset != first_page->host_offset)
+				return EFAULT;
 		}
-		case 39:/*ebreak*/
+		*host_address = (void*)(first_page->host_offset + (uintptr_t)address);
+		return 0;
+	}
+
+#ifdef REL32I_ADDRESS_SPACE_SUPPORTED
+	if (hart->address_space)
+	{
+		int error = size ? rel32i_probe_address_space(hart, address, size, access) : 0;
+		if (error)
+			return error;
+		*host_address = hart->address_space->base_address + address;
+		return 0;
+	}
+#endif
+
+	*host_address = (void*)((uintptr_t)hart->data_base_address + (uintptr_t)address);
+	return 0;
+}
+
+int rel32i_run(rel32i_hart_t* hart, uint64_t max_instruction_count, int stop_mask, uint64_t* retired_instruction_count)
+{
+	uint64_t instruction_count = 0;
+	rel32i_fault_frame_t fault_frame;
+	fault_frame.base_instruction_count = 0;
+	fault_frame.jit_context = 0;
+	fault_frame.hart = hart;
+	fault_frame.fp_rounding_mode = REL32I_HOST_ROUNDING_MODE;
+
+#ifdef REL32I_ADDRESS_SPACE_SUPPORTED
+	rel32i_fault_frame_t* previous_fault_frame = rel32i_active_fault_frame;
+	if (hart->address_space)
+		rel32i_active_fault_frame = &fault_frame;
+#endif
+	if (hart->address_space || hart->memory)
+	{
+		if (setjmp(fault_frame.jump_buffer))
 		{
-			register_set->pc += 4;
-			break;
+			// pc and the registers have already been stored where the fault was raised
+#ifdef REL32I_ADDRESS_SPACE_SUPPORTED
+			rel32i_active_fault_frame = previous_fault_frame;
+#endif
+			rel32i_leave_fp_state(&fault_frame, hart->register_set);
+			if (hart->csr_file)
+				rel32i_retire_csr_counters(hart->csr_file, fault_frame.fault_instruction_count);
+			if (retired_instruction_count)
+				*retired_instruction_count = fault_frame.fault_instruction_count;
+			return fault_frame.fault_stop_reason;
 		}
-		default:
+	}
+
+	// declared after setjmp so that it is never live across a longjmp
+	int stop_reason = REL32I_STOP_INSTRUCTION_LIMIT;
+	if (hart->memory)
+		stop_reason = rel32i_run_paged(hart, &fault_frame, max_instruction_count, stop_mask, &instruction_count);
+	else
+#ifdef REL32I_JIT_SUPPORTED
+	if (hart->jit && !((stop_mask & REL32I_STOP_BREAKPOINT) && hart->breakpoint_count))
+		stop_reason = rel32i_run_jit(hart, &fault_frame, max_instruction_count, stop_mask, &instruction_count);
+	else
+#endif
+	if (hart->block_cache && !((stop_mask & REL32I_STOP_BREAKPOINT) && hart->breakpoint_count))
+	{
+		// whatever can not be run as a whole block is stepped with the instruction core
+		while (instruction_count != max_instruction_count)
 		{
-			register_set->pc += 4;
-			break;
+			uint64_t block_instruction_count;
+			fault_frame.base_instruction_count = instruction_count;
+			stop_reason = rel32i_run_blocks(hart, &fault_frame, max_instruction_count - instruction_count, stop_mask, &block_instruction_count);
+			instruction_count += block_instruction_count;
+			if (stop_reason != REL32I_STOP_INSTRUCTION_LIMIT || instruction_count == max_instruction_count)
+				break;
+
+			uint64_t stepped_instruction_count;
+			fault_frame.base_instruction_count = instruction_count;
+			stop_reason = rel32i_run_core(hart, &fault_frame, 1, stop_mask, &stepped_instruction_count);
+			instruction_count += stepped_instruction_count;
+			if (stop_reason != REL32I_STOP_INSTRUCTION_LIMIT)
+				break;
 		}
 	}
+	else
+		stop_reason = rel32i_run_core(hart, &fault_frame, max_instruction_count, stop_mask, &instruction_count);
+
+#ifdef REL32I_ADDRESS_SPACE_SUPPORTED
+	rel32i_active_fault_frame = previous_fault_frame;
+#endif
 
-	if (set_rd && info.rd)
-		register_set->x1_x31[info.rd - 1] = rd;
+	rel32i_leave_fp_state(&fault_frame, hart->register_set);
+	if (hart->csr_file)
+		rel32i_retire_csr_counters(hart->csr_file, instruction_count);
+	if (retired_instruction_count)
+		*retired_instruction_count = instruction_count;
+	return stop_reason;
 }
@@ -19,6 +19,14 @@ extern "C" {
 #define REL_ENCODING_I_SHIFT 7
 #define REL_ENCODING_I_FENCE 8
 #define REL_ENCODING_I_ENVIROMENT 9
+#define REL_ENCODING_I_FLOAT 10
+#define REL_ENCODING_S_FLOAT 11
+#define REL_ENCODING_R_FLOAT 12
+#define REL_ENCODING_R4_FLOAT 13
+#define REL_ENCODING_R_FLOAT_UNARY 14
+#define REL_ENCODING_R_FLOAT_TO_INTEGER 15
+#define REL_ENCODING_R_FLOAT_COMPARE 16
+#define REL_ENCODING_R_INTEGER_TO_FLOAT 17
 
 #define REL_DISASSEMBLE_NEW_LINE 0x01
 #define REL_DISASSEMBLE_ADDRESS 0x02
@@ -26,14 +34,81 @@ extern "C" {
 #define REL_DISASSEMBLE_ENCODING 0x08
 #define REL_DISASSEMBLE_ABI_REGISTER_MNEMONICS 0x10
 #define REL_DISASSEMBLE_USE_PSEUDOINSTRUCTIONS 0x20
+// binutils objdump columns and operand syntax, with USE_PSEUDOINSTRUCTIONS like its default and without like -M no-aliases
+#define REL_DISASSEMBLE_BINUTILS_SYNTAX 0x40
+#define REL_DISASSEMBLE_MAX_LINE_SIZE 128
+
+#define REL_BATCH_DECODER_AUTOMATIC 0
+#define REL_BATCH_DECODER_SCALAR 1
+#define REL_BATCH_DECODER_SSE41 2
+#define REL_BATCH_DECODER_AVX2 3
 
 #define REL_REGISTER_CONTEXT_GENERAL 0
 #define REL_REGISTER_CONTEXT_PC 1
+#define REL_REGISTER_CONTEXT_FLOAT 2
+
+#define REL32I_OPERATION_FUSED_LOAD_IMMEDIATE 0xF0
+#define REL32I_OPERATION_FUSED_CALL 0xF1
+#define REL32I_OPERATION_FUSED_LOAD_GLOBAL 0xF2
+#define REL32I_OPERATION_FUSED_SLT_BRANCH 0xF3
+#define REL32I_OPERATION_FUSED_SLTU_BRANCH 0xF4
+#define REL32I_OPERATION_FUSED_SLTI_BRANCH 0xF5
+#define REL32I_OPERATION_FUSED_SLTIU_BRANCH 0xF6
+#define REL32I_OPERATION_FUSED_STACK_STORE 0xF7
+#define REL32I_OPERATION_BLOCK_END 0xFD
+#define REL32I_OPERATION_UNKNOWN 0xFE
+#define REL32I_OPERATION_UNDECODED 0xFF
+
+#define REL32I_STOP_INSTRUCTION_LIMIT 0x00
+#define REL32I_STOP_ECALL 0x01
+#define REL32I_STOP_EBREAK 0x02
+#define REL32I_STOP_ILLEGAL_INSTRUCTION 0x04
+#define REL32I_STOP_BREAKPOINT 0x08
+#define REL32I_STOP_ACCESS_FAULT 0x10
+#define REL32I_STOP_PAGE_FAULT 0x20
+
+#define REL32I_MAX_BLOCK_SIZE 64
+#define REL32I_CODE_PAGE_SIZE 0x1000
+#define REL32I_BLOCK_CACHE_FUSE_INSTRUCTIONS 0x01
+#define REL32I_JIT_MAX_BLOCK_NATIVE_SIZE 0x4000
+
+#define REL32I_ACCESS_READ 0x01
+#define REL32I_ACCESS_WRITE 0x02
+#define REL32I_ACCESS_EXECUTE 0x04
+#define REL32I_ADDRESS_SPACE_GUARD_SIZE 0x10000
+
+#define REL32I_MEMORY_UNMAPPED 0
+#define REL32I_MEMORY_RAM 1
+#define REL32I_MEMORY_ROM 2
+#define REL32I_MEMORY_MMIO 3
+#define REL32I_MEMORY_PAGE_SIZE 0x1000
+#define REL32I_MEMORY_LEAF_PAGE_COUNT 0x400
+#define REL32I_MEMORY_TLB_SIZE 0x100
+#define REL32I_MEMORY_MAX_MMIO_COUNT 0x10
+
+#define REL32I_PRIVILEGE_USER 0
+#define REL32I_PRIVILEGE_SUPERVISOR 1
+#define REL32I_PRIVILEGE_MACHINE 3
+#define REL32I_MMU_SUM 0x01
+#define REL32I_MMU_MXR 0x02
+#define REL32I_MMU_TLB_SIZE 0x40
+#define REL32I_MMU_GLOBAL_ASID 0xFFFF
+#define REL32I_SFENCE_VMA_ADDRESS 0x01
+#define REL32I_SFENCE_VMA_ASID 0x02
+#define REL32I_CSR_COUNT 0x1000
 
 typedef struct rel32i_register_set_t
 {
 	uint32_t pc;
 	uint32_t x1_x31[31];
+	// the word lr.w reserved and the value it read there, sc.w stores only if the word still holds that value
+	uint32_t reservation_address;
+	uint32_t reservation_value;
+	uint32_t reservation_valid;
+	// single-precision values are NaN-boxed, the upper half of the register is all ones
+	uint64_t f0_f31[32];
+	// frm is in bits 7:5 and fflags in bits 4:0
+	uint32_t fcsr;
 } rel32i_register_set_t;
 
 typedef struct rel32_instruction_information_t
@@ -56,6 +131,187 @@ typedef struct rel32_instruction_information_t
 	uint32_t intermediate;
 } rel32_instruction_information_t;
 
+// One array per field of rel32_instruction_information_t, element i describes the i-th word of a batch. Every array but size
+// may be null when the caller does not need it, compressed words are only expanded when one of the fields after size is wanted.
+typedef struct rel32_instruction_batch_t
+{
+	uint32_t* machine_code;
+	uint8_t* size;
+	uint8_t* encoding;
+	uint8_t* opcode;
+	uint8_t* rd;
+	uint8_t* function3;
+	uint8_t* rs1;
+	uint8_t* rs2;
+	uint8_t* function7;
+	uint32_t* intermediate;
+	int* instruction_index;
+} rel32_instruction_batch_t;
+
+typedef struct rel32i_predecoded_instruction_t
+{
+	uint8_t operation;
+	uint8_t rd;
+	uint8_t rs1;
+	uint8_t rs2;
+	uint32_t intermediate;
+	uint8_t size;// 2 for a compressed instruction, which is predecoded as the instruction it expands to
+} rel32i_predecoded_instruction_t;
+
+typedef struct rel32i_predecode_cache_t
+{
+	uint32_t code_size;
+	rel32i_predecoded_instruction_t* instruction_table;
+} rel32i_predecode_cache_t;
+
+typedef struct rel32i_block_t
+{
+	uint32_t address;
+	uint32_t instruction_count;
+	struct rel32i_block_t* next;
+	struct rel32i_block_t* successor_table[2];
+	rel32i_predecoded_instruction_t* instruction_table;
+} rel32i_block_t;
+
+typedef struct rel32i_block_cache_t
+{
+	uint32_t code_size;
+	uint32_t hash_mask;
+	rel32i_block_t** hash_table;
+	size_t block_capacity;
+	size_t block_count;
+	rel32i_block_t* block_table;
+	size_t instruction_capacity;
+	size_t instruction_count;
+	rel32i_predecoded_instruction_t* instruction_pool;
+	uint8_t* code_page_table;
+	uint64_t flush_count;
+	int flags;
+} rel32i_block_cache_t;
+
+typedef struct rel32i_jit_block_t
+{
+	uint32_t address;
+	struct rel32i_jit_block_t* next;
+	uint8_t* entry;
+} rel32i_jit_block_t;
+
+typedef struct rel32i_jit_t
+{
+	size_t mapping_size;
+	uint32_t code_size;
+	uint32_t hash_mask;
+	rel32i_jit_block_t** hash_table;
+	size_t block_capacity;
+	size_t block_count;
+	rel32i_jit_block_t* block_table;
+	uint8_t* code_page_table;
+	size_t native_code_capacity;
+	size_t native_code_size;
+	uint8_t* native_code;
+	uint64_t flush_count;
+} rel32i_jit_t;
+
+typedef struct rel32i_address_space_t
+{
+	uint8_t* base_address;
+	size_t reservation_size;
+	uint32_t fault_address;
+} rel32i_address_space_t;
+
+typedef int (*rel32i_mmio_read_t)(void* context, uint32_t offset, uint32_t size, uint32_t* value);
+
+typedef int (*rel32i_mmio_write_t)(void* context, uint32_t offset, uint32_t size, uint32_t value);
+
+typedef struct rel32i_memory_page_t
+{
+	uintptr_t host_offset;
+	uint8_t type;
+	uint8_t access;
+	uint16_t mmio_index;
+} rel32i_memory_page_t;
+
+typedef struct rel32i_mmio_t
+{
+	uint32_t address;
+	rel32i_mmio_read_t read;
+	rel32i_mmio_write_t write;
+	void* context;
+} rel32i_mmio_t;
+
+typedef struct rel32i_tlb_entry_t
+{
+	uint32_t read_tag;
+	uint32_t write_tag;
+	uint32_t execute_tag;
+	uintptr_t host_offset;
+} rel32i_tlb_entry_t;
+
+typedef struct rel32i_memory_t
+{
+	rel32i_memory_page_t* directory[0x100000000ull / (REL32I_MEMORY_PAGE_SIZE * REL32I_MEMORY_LEAF_PAGE_COUNT)];
+	size_t leaf_table_capacity;
+	size_t leaf_table_count;
+	rel32i_memory_page_t* leaf_table_pool;
+	size_t mmio_count;
+	rel32i_mmio_t mmio_table[REL32I_MEMORY_MAX_MMIO_COUNT];
+	rel32i_tlb_entry_t tlb[REL32I_MEMORY_TLB_SIZE];
+	uint32_t fault_address;
+} rel32i_memory_t;
+
+typedef struct rel32i_mmu_tlb_entry_t
+{
+	uint32_t read_tag;
+	uint32_t write_tag;
+	uint32_t execute_tag;
+	uint32_t virtual_page;
+	uint32_t physical_page;
+	uint16_t asid;
+	uint8_t superpage;
+} rel32i_mmu_tlb_entry_t;
+
+typedef struct rel32i_mmu_t
+{
+	uint32_t satp;
+	uint16_t asid;
+	uint8_t privilege;
+	uint8_t flags;
+	int translating;
+	uint32_t fault_address;
+	int fault_access;
+	uint64_t instruction_tlb_hit_count;
+	uint64_t instruction_tlb_miss_count;
+	uint64_t data_tlb_hit_count;
+	uint64_t data_tlb_miss_count;
+	rel32i_mmu_tlb_entry_t instruction_tlb[REL32I_MMU_TLB_SIZE];
+	rel32i_mmu_tlb_entry_t data_tlb[REL32I_MMU_TLB_SIZE];
+} rel32i_mmu_t;
+
+typedef struct rel32i_csr_file_t
+{
+	uint64_t cycle;
+	uint64_t instret;
+	uint64_t time_frequency;
+	uint64_t time_origin;
+	uint32_t value_table[REL32I_CSR_COUNT];
+} rel32i_csr_file_t;
+
+typedef struct rel32i_hart_t
+{
+	const void* code_base_address;
+	void* data_base_address;
+	rel32i_register_set_t* register_set;
+	rel32i_predecode_cache_t* predecode_cache;
+	rel32i_block_cache_t* block_cache;
+	rel32i_jit_t* jit;
+	rel32i_address_space_t* address_space;
+	rel32i_memory_t* memory;
+	rel32i_mmu_t* mmu;
+	size_t breakpoint_count;
+	const uint32_t* breakpoint_table;
+	rel32i_csr_file_t* csr_file;
+} rel32i_hart_t;
+
 void rel32_copy(void* destination, const void* source, size_t size);
 
 size_t rel32_string_size(const char* string);
@@ -80,14 +336,123 @@ int rel32_print_instruction_encoding_format(const char* mnemonic, char* buffer);
 
 int rel32_print_instruction_encoding(const char* mnemonic, char* buffer);
 
+int rel32_find_instruction_index(uint32_t instruction);
+
+// Returns the 32-bit instruction an RV32C instruction stands for, or 0 when the halfword is reserved or not a compressed instruction.
+uint32_t rel32_expand_compressed_instruction(uint16_t compressed_instruction);
+
+// A compressed instruction is described by the instruction it expands to, only size, machine_code and the compressed_function fields come from the halfword itself.
 void rel32_decode_instruction(const void* address_of_instruction, rel32_instruction_information_t* information_information);
 
+// Decodes the words at 4 byte steps from address_of_instructions, each exactly as rel32_decode_instruction decodes the same address.
+void rel32_decode_instruction_batch(const void* address_of_instructions, size_t instruction_count, const rel32_instruction_batch_t* batch);
+
+// Picks the implementation behind rel32_decode_instruction_batch, the automatic choice is the widest one the processor supports.
+// Returns ENOTSUP when the requested one is not built in or not supported by the processor.
+int rel32_select_batch_decoder(int decoder);
+
+int rel32_get_batch_decoder(void);
+
+// Runs the given batch decoder over the words and compares every field with what rel32_decode_instruction gives for the same address.
+// Returns EILSEQ with the first differing word in mismatch_index, or ENOTSUP when the decoder is not built in or not supported by the processor.
+int rel32_check_batch_decoder(int decoder, const void* address_of_instructions, size_t instruction_count, size_t* mismatch_index);
+
 int rel32_get_register_name(int context, int number, int use_abi_name, char** pointer_to_name_pointer, size_t* pointer_name_size);
 
 int rel32_disassemble_instruction(int flags, const void* base_address, uint32_t address_of_instruction, size_t assembly_buffer_size, size_t* assembly_size, char* assembly_buffer);
 
+// Fills the buffer with as many whole lines from [start_address, end_address) as fit and sets next_address to where to resume.
+// An instruction cut off by end_address is not formatted. ENOBUFS is returned only when not even one line fits.
+int rel32_disassemble_range(int flags, const void* base_address, uint32_t start_address, uint32_t end_address, char* buffer, size_t buffer_size, uint32_t* next_address, size_t* written);
+
+void rel32i_predecode_instruction(const void* address_of_instruction, rel32i_predecoded_instruction_t* predecoded_instruction);
+
+size_t rel32i_get_predecode_cache_size(uint32_t code_size);
+
+int rel32i_create_predecode_cache(uint32_t code_size, size_t buffer_size, void* buffer, rel32i_predecode_cache_t** pointer_to_predecode_cache);
+
+void rel32i_flush_predecode_cache(rel32i_predecode_cache_t* predecode_cache);
+
+// Predecodes every halfword of [start_address, end_address) with the batch decoder ahead of execution, instead of one instruction
+// at a time the first time each is reached. Only call it for code, the cache then describes the memory at the code base address.
+void rel32i_fill_predecode_cache(const void* code_base_address, rel32i_predecode_cache_t* predecode_cache, uint32_t start_address, uint32_t end_address);
+
+size_t rel32i_get_block_cache_size(uint32_t code_size, size_t instruction_capacity);
+
+int rel32i_create_block_cache(uint32_t code_size, size_t instruction_capacity, size_t buffer_size, void* buffer, rel32i_block_cache_t** pointer_to_block_cache);
+
+void rel32i_flush_block_cache(rel32i_block_cache_t* block_cache);
+
+// Only available on x86-64 Linux, elsewhere ENOSYS is returned. The native code is placed in memory mapped by the JIT itself.
+int rel32i_create_jit(uint32_t code_size, size_t native_code_capacity, rel32i_jit_t** pointer_to_jit);
+
+void rel32i_destroy_jit(rel32i_jit_t* jit);
+
+void rel32i_flush_jit(rel32i_jit_t* jit);
+
+// Reserves the whole 32-bit guest address space plus a guard area without committing any memory. Only available on Linux, elsewhere ENOSYS is returned.
+int rel32i_create_address_space(rel32i_address_space_t* address_space);
+
+// Makes the given range accessible, access is a combination of REL32I_ACCESS_* flags. Large ranges are backed with transparent huge pages when the host has them.
+int rel32i_commit_address_space(rel32i_address_space_t* address_space, uint32_t address, uint32_t size, int access);
+
+void rel32i_destroy_address_space(rel32i_address_space_t* address_space);
+
+// Each leaf table describes REL32I_MEMORY_LEAF_PAGE_COUNT pages, leaf_table_capacity limits how much of the guest address space can be mapped.
+size_t rel32i_get_memory_size(size_t leaf_table_capacity);
+
+int rel32i_create_memory(size_t leaf_table_capacity, size_t buffer_size, void* buffer, rel32i_memory_t** pointer_to_memory);
+
+// Maps page aligned RAM or ROM backed by host memory. Writes to ROM pages are discarded when access allows writing and fault otherwise.
+int rel32i_map_memory(rel32i_memory_t* memory, uint32_t address, uint32_t size, int type, int access, void* host_address);
+
+// The callbacks get the offset from address. A nonzero return or a missing callback makes the access fault.
+int rel32i_map_mmio(rel32i_memory_t* memory, uint32_t address, uint32_t size, int access, rel32i_mmio_read_t read, rel32i_mmio_write_t write, void* context);
+
+int rel32i_unmap_memory(rel32i_memory_t* memory, uint32_t address, uint32_t size);
+
+void rel32i_flush_memory_tlb(rel32i_memory_t* memory);
+
+// Starts in supervisor mode with satp cleared, so addresses are not translated until satp selects Sv32.
+void rel32i_initialize_mmu(rel32i_mmu_t* mmu);
+
+void rel32i_write_satp(rel32i_mmu_t* mmu, uint32_t satp);
+
+// Translation applies below machine mode, flags is a combination of REL32I_MMU_SUM and REL32I_MMU_MXR. Changing either flushes both TLBs.
+void rel32i_set_mmu_privilege(rel32i_mmu_t* mmu, int privilege, int flags);
+
+// Same as sfence.vma, flags tells which of address and asid are given.
+void rel32i_sfence_vma(rel32i_mmu_t* mmu, uint32_t address, uint32_t asid, int flags);
+
+// Drops everything the hart's caches have derived from code in the given range. Returns nonzero if translated blocks were discarded.
+int rel32i_invalidate_code(rel32i_hart_t* hart, uint32_t address, uint32_t size);
+
+// Gives where guest memory [address, address + size) is on the host, for services such as ecall handlers that read or write guest buffers.
+// Returns EFAULT when part of the range does not allow access, the REL32I_ACCESS_* flags, or is not contiguous on the host, and ENOTSUP while an MMU translates.
+// Probing an address space overwrites its fault_address. The caller invalidates code it writes with rel32i_invalidate_code.
+int rel32i_get_host_address(rel32i_hart_t* hart, uint32_t address, uint32_t size, int access, void** host_address);
+
+// cycle and instret count the instructions retired by rel32i_run, which adds them when it returns, time counts time_frequency ticks per second
+// of the host monotonic clock from this call on. Writing to a read-only CSR is an illegal instruction, the other CSRs read back what was written.
+void rel32i_initialize_csr_file(rel32i_csr_file_t* csr_file, uint64_t time_frequency);
+
+void rel32i_execute_instruction(const rel32i_predecoded_instruction_t* instruction, void* data_base_address, rel32i_register_set_t* register_set);
+
 void rel32i_step_instruction(const void* code_base_address, void* data_base_address, rel32i_register_set_t* register_set);
 
+void rel32i_step_predecoded_instruction(const void* code_base_address, void* data_base_address, rel32i_predecode_cache_t* predecode_cache, rel32i_register_set_t* register_set);
+
+// Returns the REL32I_STOP_* event that stopped execution. The instruction that caused the event is not retired and pc is left pointing to it.
+// With an address space attached to the hart, accesses outside its committed ranges stop with REL32I_STOP_ACCESS_FAULT and the guest address in fault_address.
+// With a memory map attached, all fetches, loads and stores go through it and the block cache and JIT are not used. Accesses the map does not permit stop the same way.
+// Guest addresses below the predecode cache's code size are then fetched from the cache, which must describe the code mapped there.
+// An MMU attached next to the memory map translates through Sv32 page tables in that memory. Page faults stop with REL32I_STOP_PAGE_FAULT,
+// the virtual address in the MMU's fault_address and the REL32I_ACCESS_* kind in fault_access. Accesses to satp and sfence.vma are handled there as well.
+// Without a CSR file attached to the hart, CSR instructions read zero and writes are ignored, except for fflags, frm and fcsr which always live in the register set.
+// Floating-point instructions run on the host FPU under the guest rounding mode and the host's own mode and flags are restored on return.
+// RMM rounds to nearest even on the host, conversions to integers are exact in every mode.
+int rel32i_run(rel32i_hart_t* hart, uint64_t max_instruction_count, int stop_mask, uint64_t* retired_instruction_count);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus